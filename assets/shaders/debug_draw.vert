@@ -0,0 +1,16 @@
+#version 450
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec4 in_color;
+
+// World to clip space for lines and triangles, pixels to clip space for the overlay.
+layout(push_constant) uniform push_constants {
+    mat4 transform;
+} push;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+    out_color = in_color;
+    gl_Position = push.transform * vec4(in_position, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec2 in_texcoord;
+layout(location = 1) in vec4 in_color;
+
+// The debug font atlas: 1 where glyphs are set, and over the whole solid cell.
+layout(set = 0, binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+    out_color = vec4(in_color.rgb, in_color.a * texture(atlas, in_texcoord).r);
+}
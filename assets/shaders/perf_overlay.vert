@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec2 in_texcoord;
+layout(location = 2) in vec4 in_color;
+
+// Pixels to clip space.
+layout(push_constant) uniform push_constants {
+    mat4 transform;
+} push;
+
+layout(location = 0) out vec2 out_texcoord;
+layout(location = 1) out vec4 out_color;
+
+void main() {
+    out_texcoord = in_texcoord;
+    out_color = in_color;
+    gl_Position = push.transform * vec4(in_position, 0.0, 1.0);
+}
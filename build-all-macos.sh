@@ -20,4 +20,12 @@ if [ $ERRORLEVEL -ne 0 ]; then
 fi
 popd
 
+pushd tools
+source build-macos.sh
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]; then
+    echo "Error: Tools build failed" && exit $ERRORLEVEL
+fi
+popd
+
 echo "All assemblies built successfully for macOS."
\ No newline at end of file
@@ -14,4 +14,9 @@ CALL build.bat
 POPD
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
 
+PUSHD tools
+CALL build.bat
+POPD
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
 ECHO "All assemblies built successfully."
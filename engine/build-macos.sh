@@ -4,6 +4,15 @@ set -e
 
 mkdir -p ../bin
 
+# Shaders are compiled to SPIR-V beside their sources, when the Vulkan SDK's compiler is present.
+if command -v glslc > /dev/null
+then
+    for shader in ../assets/shaders/*.vert ../assets/shaders/*.frag
+    do
+        glslc "$shader" -o "$shader.spv"
+    done
+fi
+
 cFilenames=$(find . -type f \( -name "*.c" -o -name "*.m" \))
 assembly="engine"
 compilerFlags="-g -shared -fPIC -mmacosx-version-min=10.15"
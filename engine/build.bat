@@ -2,6 +2,11 @@ REM Build script for engine
 @ECHO OFF
 SetLocal EnableDelayedExpansion
 
+REM Shaders are compiled to SPIR-V beside their sources.
+FOR %%s in (..\assets\shaders\*.vert ..\assets\shaders\*.frag) do (
+    %VULKAN_SDK%\bin\glslc.exe %%s -o %%s.spv
+)
+
 REM Get a list of all the .c files.
 SET cFilenames=
 FOR /R %%f in (*.c) do (
@@ -4,6 +4,43 @@ set echo on
 
 mkdir -p ../bin
 
+defines="-D_DEBUG -DKEXPORT -DVK_USE_PLATFORM_XCB_KHR"
+linkerFlags="-lvulkan -lxcb -lX11 -lX11-xcb -lxkbcommon -ldl -lpthread -lm -L$VULKAN_SDK/lib -L/usr/X11R6/lib"
+
+# Wayland support is optional and only built when its development files are present.
+# The xdg-shell client code is generated from the wayland-protocols package.
+if pkg-config --exists wayland-client wayland-protocols xkbcommon && command -v wayland-scanner > /dev/null
+then
+    protocolDir=$(pkg-config --variable=pkgdatadir wayland-protocols)
+    generatedDir=src/platform/generated
+    mkdir -p $generatedDir
+    wayland-scanner client-header $protocolDir/stable/xdg-shell/xdg-shell.xml $generatedDir/xdg-shell-client-protocol.h
+    wayland-scanner private-code $protocolDir/stable/xdg-shell/xdg-shell.xml $generatedDir/xdg-shell-protocol.c
+    defines="$defines -DKOHI_WAYLAND=1 -DVK_USE_PLATFORM_WAYLAND_KHR"
+    linkerFlags="$linkerFlags -lwayland-client"
+fi
+
+# Archive compression is optional and only built when the libraries are present.
+if pkg-config --exists liblz4
+then
+    defines="$defines -DKOHI_USE_LZ4=1"
+    linkerFlags="$linkerFlags -llz4"
+fi
+if pkg-config --exists libzstd
+then
+    defines="$defines -DKOHI_USE_ZSTD=1"
+    linkerFlags="$linkerFlags -lzstd"
+fi
+
+# Shaders are compiled to SPIR-V beside their sources, when the Vulkan SDK's compiler is present.
+if command -v glslc > /dev/null
+then
+    for shader in ../assets/shaders/*.vert ../assets/shaders/*.frag
+    do
+        glslc "$shader" -o "$shader.spv"
+    done
+fi
+
 # Get a list of all the .c files.
 cFilenames=$(find . -type f -name "*.c")
 
@@ -14,11 +51,9 @@ compilerFlags="-g -shared -fdeclspec -fPIC"
 # -fms-extensions 
 # -Wall -Werror
 includeFlags="-Isrc -I$VULKAN_SDK/include"
-linkerFlags="-lvulkan -lxcb -lX11 -lX11-xcb -lxkbcommon -L$VULKAN_SDK/lib -L/usr/X11R6/lib"
-defines="-D_DEBUG -DKEXPORT"
 
 echo "Building $assembly..."
-clang $cFilenames $compilerFlags -o ../bin/lib$assembly.so $defines $includeFlags $
+clang $cFilenames $compilerFlags -o ../bin/lib$assembly.so $defines $includeFlags $linkerFlags
 
 
 # #!/bin/bash
@@ -0,0 +1,120 @@
+#include "audio_device.h"
+
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#define WAV_HEADER_SIZE 44
+
+// Sleeps until no more than a millisecond of sound is ahead of the wall clock.
+static void device_pace(audio_device* device) {
+    f64 ahead = device->start_time + (f64)device->frames_written / device->sample_rate - clock_get_current_time();
+    if (ahead > 0.001) {
+        platform_sleep((u64)(ahead * 1000.0));
+    }
+}
+
+static b8 null_device_write(audio_device* device, const i16* frames, u32 frame_count) {
+    device->frames_written += frame_count;
+    if (device->paced) {
+        device_pace(device);
+    }
+    return TRUE;
+}
+
+static void null_device_close(audio_device* device) {
+}
+
+static void write_u16(u8* p, u16 value) {
+    p[0] = (u8)value;
+    p[1] = (u8)(value >> 8);
+}
+
+static void write_u32(u8* p, u32 value) {
+    write_u16(p, (u16)value);
+    write_u16(p + 2, (u16)(value >> 16));
+}
+
+// A 16-bit stereo PCM header, with the sizes of data_size bytes of samples.
+static void wav_header(u8* header, u32 sample_rate, u32 data_size) {
+    write_u32(header + 0, 0x46464952);  // "RIFF"
+    write_u32(header + 4, WAV_HEADER_SIZE - 8 + data_size);
+    write_u32(header + 8, 0x45564157);  // "WAVE"
+    write_u32(header + 12, 0x20746D66);  // "fmt "
+    write_u32(header + 16, 16);
+    write_u16(header + 20, 1);
+    write_u16(header + 22, 2);
+    write_u32(header + 24, sample_rate);
+    write_u32(header + 28, sample_rate * 4);
+    write_u16(header + 32, 4);
+    write_u16(header + 34, 16);
+    write_u32(header + 36, 0x61746164);  // "data"
+    write_u32(header + 40, data_size);
+}
+
+static b8 wav_device_write(audio_device* device, const i16* frames, u32 frame_count) {
+    // Stop at what a WAV file can hold, rather than wrap its sizes.
+    if ((device->frames_written + frame_count) * 4 > 0xFFFFFFFF - WAV_HEADER_SIZE) {
+        return FALSE;
+    }
+    u64 written = 0;
+    if (!filesystem_write(&device->file, (u64)frame_count * 4, frames, &written)) {
+        return FALSE;
+    }
+    device->frames_written += frame_count;
+    if (device->paced) {
+        device_pace(device);
+    }
+    return TRUE;
+}
+
+static void wav_device_close(audio_device* device) {
+    // The sizes are only known now.
+    u8 header[WAV_HEADER_SIZE];
+    wav_header(header, device->sample_rate, (u32)(device->frames_written * 4));
+    u64 written = 0;
+    if (!filesystem_seek(&device->file, 0) || !filesystem_write(&device->file, WAV_HEADER_SIZE, header, &written)) {
+        KERROR("Unable to finish the WAV file the audio device wrote.");
+    }
+    filesystem_close(&device->file);
+}
+
+b8 audio_device_create(const audio_device_config* config, audio_device* out_device) {
+    kzero_memory(out_device, sizeof(audio_device));
+    out_device->type = config->type;
+    out_device->sample_rate = config->sample_rate;
+    out_device->paced = config->paced;
+    out_device->start_time = clock_get_current_time();
+
+    if (config->type == AUDIO_DEVICE_TYPE_NULL) {
+        out_device->write = null_device_write;
+        out_device->close = null_device_close;
+        return TRUE;
+    } else if (config->type == AUDIO_DEVICE_TYPE_WAV_FILE) {
+        if (!config->wav_path || !filesystem_open(config->wav_path, FILE_MODE_WRITE, TRUE, &out_device->file)) {
+            KERROR("audio_device_create - Unable to open '%s' for the WAV file device.", config->wav_path ? config->wav_path : "");
+            return FALSE;
+        }
+        // Sizes of zero until close.
+        u8 header[WAV_HEADER_SIZE];
+        wav_header(header, config->sample_rate, 0);
+        u64 written = 0;
+        if (!filesystem_write(&out_device->file, WAV_HEADER_SIZE, header, &written)) {
+            filesystem_close(&out_device->file);
+            return FALSE;
+        }
+        out_device->write = wav_device_write;
+        out_device->close = wav_device_close;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+void audio_device_destroy(audio_device* device) {
+    if (device->close) {
+        device->close(device);
+    }
+    kzero_memory(device, sizeof(audio_device));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+
+/*
+Where the mixed sound goes. No device here talks to a sound card: the null
+device throws the sound away and the WAV file device records it, so the
+audio system runs the same with no sound hardware, in tests or on a server.
+Either can be paced to real time, taking as long to accept a block as it
+would take to play, as a real device's buffer would.
+*/
+
+typedef enum audio_device_type {
+    AUDIO_DEVICE_TYPE_NULL,
+    AUDIO_DEVICE_TYPE_WAV_FILE
+} audio_device_type;
+
+typedef struct audio_device_config {
+    audio_device_type type;
+    u32 sample_rate;
+    // Whether write blocks until the sound already written would have played. Otherwise writes return at once.
+    b8 paced;
+    // The file the WAV file device writes to.
+    const char* wav_path;
+} audio_device_config;
+
+typedef struct audio_device {
+    audio_device_type type;
+    u32 sample_rate;
+    b8 paced;
+    f64 start_time;
+    u64 frames_written;
+    file_handle file;
+
+    // Takes frames of interleaved 16-bit stereo samples. Called only from the mixing thread.
+    b8 (*write)(struct audio_device* device, const i16* frames, u32 frame_count);
+    void (*close)(struct audio_device* device);
+} audio_device;
+
+b8 audio_device_create(const audio_device_config* config, audio_device* out_device);
+void audio_device_destroy(audio_device* device);
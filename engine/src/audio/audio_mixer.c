@@ -0,0 +1,147 @@
+#include "audio_mixer.h"
+
+#include "math/math_types.h"
+
+void audio_mix_scalar(const f32* source, u32 channel_count, audio_mix_params* params, u32 count, f32* out) {
+    f64 position = params->position;
+    f32 gain_left = params->gain[0];
+    f32 gain_right = params->gain[1];
+    for (u32 n = 0; n < count; ++n) {
+        u32 index = (u32)position;
+        f32 t = (f32)(position - index);
+        const f32* a = source + (u64)index * channel_count;
+        const f32* b = a + channel_count;
+        f32 left = a[0] + (b[0] - a[0]) * t;
+        f32 right = channel_count == 2 ? a[1] + (b[1] - a[1]) * t : left;
+        out[n * 2 + 0] += left * gain_left;
+        out[n * 2 + 1] += right * gain_right;
+        gain_left += params->gain_step[0];
+        gain_right += params->gain_step[1];
+        position += params->step;
+    }
+    params->position = position;
+    params->gain[0] = gain_left;
+    params->gain[1] = gain_right;
+}
+
+void audio_convert_to_i16_scalar(const f32* samples, u32 count, i16* out) {
+    for (u32 i = 0; i < count; ++i) {
+        f32 s = KCLAMP(samples[i], -1.0f, 1.0f) * 32767.0f;
+        out[i] = (i16)(s < 0 ? s - 0.5f : s + 0.5f);
+    }
+}
+
+// The vector paths gather the two source frames around each of 4 output
+// frames one at a time, as they are rarely next to each other, then
+// interpolate, apply the gains and accumulate 4 frames at once. Positions
+// stay in doubles, which a single precision lane would round off within
+// minutes of sound.
+
+void audio_mix(const f32* source, u32 channel_count, audio_mix_params* params, u32 count, f32* out) {
+#if KMATH_SSE || KMATH_NEON
+    u32 n = 0;
+    KMATH_ALIGN(16) f32 a[2][4];
+    KMATH_ALIGN(16) f32 b[2][4];
+    KMATH_ALIGN(16) f32 t[4];
+    f64 position = params->position;
+    f64 step = params->step;
+    f32 gain_step_left = params->gain_step[0];
+    f32 gain_step_right = params->gain_step[1];
+#if KMATH_SSE
+    __m128 ramp = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 gain_left = _mm_add_ps(_mm_set1_ps(params->gain[0]), _mm_mul_ps(ramp, _mm_set1_ps(gain_step_left)));
+    __m128 gain_right = _mm_add_ps(_mm_set1_ps(params->gain[1]), _mm_mul_ps(ramp, _mm_set1_ps(gain_step_right)));
+    __m128 advance_left = _mm_set1_ps(gain_step_left * 4.0f);
+    __m128 advance_right = _mm_set1_ps(gain_step_right * 4.0f);
+#else
+    const f32 ramp_values[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t ramp = vld1q_f32(ramp_values);
+    float32x4_t gain_left = vmlaq_f32(vdupq_n_f32(params->gain[0]), ramp, vdupq_n_f32(gain_step_left));
+    float32x4_t gain_right = vmlaq_f32(vdupq_n_f32(params->gain[1]), ramp, vdupq_n_f32(gain_step_right));
+    float32x4_t advance_left = vdupq_n_f32(gain_step_left * 4.0f);
+    float32x4_t advance_right = vdupq_n_f32(gain_step_right * 4.0f);
+#endif
+    u32 right_channel = channel_count == 2 ? 1 : 0;
+    for (; n + 4 <= count; n += 4) {
+        for (u32 i = 0; i < 4; ++i) {
+            f64 p = position + step * i;
+            u32 index = (u32)p;
+            const f32* frame = source + (u64)index * channel_count;
+            t[i] = (f32)(p - index);
+            a[0][i] = frame[0];
+            a[1][i] = frame[right_channel];
+            b[0][i] = frame[channel_count];
+            b[1][i] = frame[channel_count + right_channel];
+        }
+        position += step * 4;
+        f32* o = out + n * 2;
+#if KMATH_SSE
+        __m128 frac = _mm_load_ps(t);
+        __m128 a0 = _mm_load_ps(a[0]);
+        __m128 a1 = _mm_load_ps(a[1]);
+        __m128 left = _mm_add_ps(a0, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(b[0]), a0), frac));
+        __m128 right = _mm_add_ps(a1, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(b[1]), a1), frac));
+        left = _mm_mul_ps(left, gain_left);
+        right = _mm_mul_ps(right, gain_right);
+        // Interleave back to left, right pairs.
+        _mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_unpacklo_ps(left, right)));
+        _mm_storeu_ps(o + 4, _mm_add_ps(_mm_loadu_ps(o + 4), _mm_unpackhi_ps(left, right)));
+        gain_left = _mm_add_ps(gain_left, advance_left);
+        gain_right = _mm_add_ps(gain_right, advance_right);
+#else
+        float32x4_t frac = vld1q_f32(t);
+        float32x4_t a0 = vld1q_f32(a[0]);
+        float32x4_t a1 = vld1q_f32(a[1]);
+        float32x4_t left = vmlaq_f32(a0, vsubq_f32(vld1q_f32(b[0]), a0), frac);
+        float32x4_t right = vmlaq_f32(a1, vsubq_f32(vld1q_f32(b[1]), a1), frac);
+        float32x4x2_t sum = vld2q_f32(o);
+        sum.val[0] = vmlaq_f32(sum.val[0], left, gain_left);
+        sum.val[1] = vmlaq_f32(sum.val[1], right, gain_right);
+        vst2q_f32(o, sum);
+        gain_left = vaddq_f32(gain_left, advance_left);
+        gain_right = vaddq_f32(gain_right, advance_right);
+#endif
+    }
+    // The lowest lanes hold the gains of the next frame.
+    params->position = position;
+#if KMATH_SSE
+    params->gain[0] = _mm_cvtss_f32(gain_left);
+    params->gain[1] = _mm_cvtss_f32(gain_right);
+#else
+    params->gain[0] = vgetq_lane_f32(gain_left, 0);
+    params->gain[1] = vgetq_lane_f32(gain_right, 0);
+#endif
+    if (n < count) {
+        audio_mix_scalar(source, channel_count, params, count - n, out + n * 2);
+    }
+#else
+    audio_mix_scalar(source, channel_count, params, count, out);
+#endif
+}
+
+void audio_convert_to_i16(const f32* samples, u32 count, i16* out) {
+    u32 i = 0;
+#if KMATH_SSE
+    __m128 lo = _mm_set1_ps(-1.0f);
+    __m128 hi = _mm_set1_ps(1.0f);
+    __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= count; i += 8) {
+        // Clamped first, as out of range conversions give INT_MIN rather than saturating.
+        __m128 s0 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), lo), hi), scale);
+        __m128 s1 = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i + 4), lo), hi), scale);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(s0), _mm_cvtps_epi32(s1));
+        _mm_storeu_si128((__m128i*)(out + i), packed);
+    }
+#elif KMATH_NEON
+    float32x4_t lo = vdupq_n_f32(-1.0f);
+    float32x4_t hi = vdupq_n_f32(1.0f);
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t s0 = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(samples + i), lo), hi), 32767.0f);
+        float32x4_t s1 = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(samples + i + 4), lo), hi), 32767.0f);
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(s0)), vqmovn_s32(vcvtnq_s32_f32(s1))));
+    }
+#endif
+    if (i < count) {
+        audio_convert_to_i16_scalar(samples + i, count - i, out + i);
+    }
+}
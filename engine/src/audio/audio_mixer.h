@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+The kernels the audio system mixes with. Voices are resampled by linear
+interpolation and added into a stereo buffer of interleaved floats, 4
+frames at a time with SSE or NEON, and the sum is converted to 16-bit
+samples for the device.
+*/
+
+typedef struct audio_mix_params {
+    // The position in the source, in frames, of the first frame mixed.
+    f64 position;
+    // Source frames advanced per output frame: the source rate over the output rate, times the pitch.
+    f64 step;
+    // The left and right gain of the first frame mixed.
+    f32 gain[2];
+    // Added to the gains after each frame, so volume changes ramp rather than click.
+    f32 gain_step[2];
+} audio_mix_params;
+
+/**
+ * Resamples frames of a mono or stereo source and adds them into out,
+ * leaving position and gain in params where the next call carries on.
+ * The frame after the last one read is read too, to interpolate towards,
+ * so the source must hold frame (u32)(position + step * (count - 1)) + 1.
+ * @param source Interleaved frames of channel_count floats.
+ * @param out Interleaved stereo frames. Room for count.
+ */
+KAPI void audio_mix(const f32* source, u32 channel_count, audio_mix_params* params, u32 count, f32* out);
+
+// Converts interleaved floats to 16-bit samples, clipping anything past -1 to 1.
+KAPI void audio_convert_to_i16(const f32* samples, u32 count, i16* out);
+
+// The scalar fallbacks of the kernels, built on every path for comparison.
+KAPI void audio_mix_scalar(const f32* source, u32 channel_count, audio_mix_params* params, u32 count, f32* out);
+KAPI void audio_convert_to_i16_scalar(const f32* samples, u32 count, i16* out);
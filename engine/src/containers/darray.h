@@ -7,12 +7,14 @@ Memory layout
 u64 capacity = number elements that can be held
 u64 length = number of elements currently contained
 u64 stride = size of each element in bytes
+u64 padding = unused, so elements stay 16-byte aligned for SIMD types (vec4, mat4)
 void* elements
 */
 enum {
     DARRAY_CAPACITY,
     DARRAY_LENGTH,
     DARRAY_STRIDE,
+    DARRAY_PADDING,
     DARRAY_FIELD_LENGTH
 };
 
@@ -0,0 +1,51 @@
+#include "containers/spsc_queue.h"
+
+#include "core/kmemory.h"
+
+b8 spsc_queue_create(u32 stride, u32 capacity, spsc_queue* out_queue) {
+    kzero_memory(out_queue, sizeof(spsc_queue));
+    if (stride == 0 || capacity == 0 || capacity > 0x80000000) {
+        return FALSE;
+    }
+    u32 rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    out_queue->stride = stride;
+    out_queue->capacity = rounded;
+    out_queue->items = kallocate((u64)stride * rounded, MEMORY_TAG_RING_QUEUE);
+    return TRUE;
+}
+
+void spsc_queue_destroy(spsc_queue* queue) {
+    if (queue->items) {
+        kfree(queue->items, (u64)queue->stride * queue->capacity, MEMORY_TAG_RING_QUEUE);
+    }
+    kzero_memory(queue, sizeof(spsc_queue));
+}
+
+// Positions count up forever and wrap at 2^32, so tail - head is the length even across the wrap.
+
+b8 spsc_queue_push(spsc_queue* queue, const void* item) {
+    u32 tail = queue->tail;
+    u32 head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (tail - head == queue->capacity) {
+        return FALSE;
+    }
+    kcopy_memory(queue->items + (u64)(tail & (queue->capacity - 1)) * queue->stride, item, queue->stride);
+    // Publishes the item with the new tail.
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return TRUE;
+}
+
+b8 spsc_queue_pop(spsc_queue* queue, void* out_item) {
+    u32 head = queue->head;
+    u32 tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return FALSE;
+    }
+    kcopy_memory(out_item, queue->items + (u64)(head & (queue->capacity - 1)) * queue->stride, queue->stride);
+    // The slot may be reused once the new head is seen.
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return TRUE;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+A fixed size queue between exactly one thread pushing and one popping,
+without locks, so neither ever waits on the other. Items are copied in and
+out. Pushing to a full queue fails rather than blocking.
+*/
+
+typedef struct spsc_queue {
+    u32 stride;
+    // A power of two, so positions wrap with a mask.
+    u32 capacity;
+    u8* items;
+    // Only the consumer writes head and only the producer writes tail. Each is
+    // on its own cache line, so the two threads do not contend for it.
+    u8 padding0[48];
+    u32 head;
+    u8 padding1[60];
+    u32 tail;
+    u8 padding2[60];
+} spsc_queue;
+
+/**
+ * Creates a queue.
+ * @param stride The size of an item in bytes.
+ * @param capacity The most items held at once. Rounded up to a power of two.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 spsc_queue_create(u32 stride, u32 capacity, spsc_queue* out_queue);
+
+KAPI void spsc_queue_destroy(spsc_queue* queue);
+
+// Copies an item onto the back of the queue. Producer only. Returns FALSE if the queue is full.
+KAPI b8 spsc_queue_push(spsc_queue* queue, const void* item);
+
+// Copies the item at the front of the queue out and removes it. Consumer only. Returns FALSE if the queue is empty.
+KAPI b8 spsc_queue_pop(spsc_queue* queue, void* out_item);
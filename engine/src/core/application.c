@@ -4,11 +4,32 @@
 #include "logger.h"
 
 #include "platform/platform.h"
+#include "platform/async_io.h"
 #include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/kstring.h"
 #include "core/event.h"
 #include "core/input.h"
 #include "core/clock.h"
+#include "core/game_module.h"
+#include "core/profiler.h"
 #include "renderer/renderer_frontend.h"
+#include "systems/audio_system.h"
+#include "systems/config_system.h"
+#include "systems/ecs_scheduler.h"
+#include "systems/ecs_system.h"
+#include "systems/job_system.h"
+#include "systems/material_system.h"
+#include "systems/resource_system.h"
+#include "systems/scene_system.h"
+#include "systems/transform_system.h"
+
+// How long the window size must stay unchanged before a resize is applied.
+// Dragging a window edge produces a continuous stream of sizes; waiting for
+// it to settle avoids recreating the swapchain on every one of them.
+#define RESIZE_DEBOUNCE_SECONDS 0.1
+
+#define APPLICATION_CONFIG_BINDING_COUNT 9
 
 typedef struct application_state {
     game* game_inst;
@@ -19,11 +40,41 @@ typedef struct application_state {
     i16 height;
     f64 last_time;
     clock clock;
+
+    // A resize which has been reported by the platform but not yet applied.
+    b8 resize_pending;
+    u16 pending_width;
+    u16 pending_height;
+    f64 last_resize_time;
+
+    // The window name, which the config file may override.
+    char window_name[128];
+    b8 config_watched;
+    u32 config_id;
+    config_binding config_bindings[APPLICATION_CONFIG_BINDING_COUNT];
 } application_state;
 
+static const char* present_mode_names[RENDERER_PRESENT_MODE_COUNT] = {"fifo", "mailbox", "immediate"};
+
+static void application_apply_pending_resize();
+static b8 application_on_config_reloaded(u16 code, void* sender, void* listener_inst, event_context context);
+
 static b8 initialized = FALSE;
 static application_state app_state;
 
+static void application_bind_config(application_config* config) {
+    config_binding* b = app_state.config_bindings;
+    b[0] = (config_binding){"window", "x", CONFIG_VALUE_I16, &config->start_pos_x};
+    b[1] = (config_binding){"window", "y", CONFIG_VALUE_I16, &config->start_pos_y};
+    b[2] = (config_binding){"window", "width", CONFIG_VALUE_I16, &config->start_width};
+    b[3] = (config_binding){"window", "height", CONFIG_VALUE_I16, &config->start_height};
+    b[4] = (config_binding){"window", "name", CONFIG_VALUE_STRING, app_state.window_name, sizeof(app_state.window_name)};
+    b[5] = (config_binding){"renderer", "present_mode", CONFIG_VALUE_ENUM, &config->renderer.present_mode, 0, present_mode_names, RENDERER_PRESENT_MODE_COUNT};
+    b[6] = (config_binding){"renderer", "frames_in_flight", CONFIG_VALUE_U32, &config->renderer.max_frames_in_flight};
+    b[7] = (config_binding){"renderer", "require_discrete_gpu", CONFIG_VALUE_BOOL, &config->renderer.require_discrete_gpu};
+    b[8] = (config_binding){"renderer", "device", CONFIG_VALUE_STRING, config->renderer.device_name, sizeof(config->renderer.device_name)};
+}
+
 b8 application_create(game* game_inst) {
     if (initialized) {
         KERROR("application_create called more than once.");
@@ -31,8 +82,6 @@ b8 application_create(game* game_inst) {
     }
 
     app_state.game_inst = game_inst;
-    app_state.width = game_inst->app_config.start_width;
-    app_state.height = game_inst->app_config.start_height;
 
     // Initialize subsystems.
     initialize_logging();
@@ -46,13 +95,93 @@ b8 application_create(game* game_inst) {
     KDEBUG("A test message: %f", 3.14f);
     KDEBUG("A test message: %f", 3.14f);
 
+    if (!kname_system_initialize()) {
+        KERROR("Name pool failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    if (!profiler_initialize()) {
+        KERROR("Profiler failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
     // event_shutdown();
     if (!event_initialize()) {
         KERROR("Event system failed initialization. Application cannot continue.");
         return FALSE;
     }
+
+    if (!config_system_initialize()) {
+        KERROR("Config system failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    // The config file overrides the game's settings, so it is read before anything uses them.
+    application_config* app_config = &game_inst->app_config;
+    string_format(app_state.window_name, sizeof(app_state.window_name), "%s", app_config->name ? app_config->name : "");
+    if (app_config->config_path) {
+        application_bind_config(app_config);
+        app_state.config_watched = TRUE;
+        if (!config_watch(app_config->config_path, app_state.config_bindings, APPLICATION_CONFIG_BINDING_COUNT, &app_state.config_id)) {
+            KWARN("Config file '%s' could not be loaded, using defaults.", app_config->config_path);
+        }
+        event_register(EVENT_CODE_CONFIG_RELOADED, 0, application_on_config_reloaded);
+    }
+    app_config->name = app_state.window_name;
+    app_state.width = app_config->start_width;
+    app_state.height = app_config->start_height;
+
+    if (!async_io_initialize()) {
+        KERROR("Async I/O failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    // Spare cores, up to 15, run jobs.
+    if (!job_system_initialize(15)) {
+        KERROR("Job system failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    if (!transform_system_initialize(16384)) {
+        KERROR("Transform system failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    if (!ecs_system_initialize(65536)) {
+        KERROR("ECS failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    if (!ecs_scheduler_initialize()) {
+        KERROR("ECS scheduler failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    if (!scene_system_initialize(16384)) {
+        KERROR("Scene system failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    resource_system_config resource_config;
+    resource_config.max_resource_count = 4096;
+    resource_config.asset_base_path = "../assets";
+    resource_config.archive_path = "../assets.kpak";
+    resource_config.finalize_budget_seconds = 0.002;
+    if (!resource_system_initialize(resource_config)) {
+        KERROR("Resource system failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
+    if (!material_system_initialize(16384)) {
+        KERROR("Material system failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
     app_state.is_running = TRUE;
     app_state.is_suspended = FALSE;
+    app_state.resize_pending = FALSE;
+
+    event_register(EVENT_CODE_RESIZED, 0, application_on_resized);
 
     if (!platform_startup(
             &app_state.platform,
@@ -64,13 +193,32 @@ b8 application_create(game* game_inst) {
         return FALSE;
     }
 
-    // Renderer startup
-    if (!renderer_initialize(game_inst->app_config.name, &app_state.platform)) {
+    // Renderer startup. Without a window there is nothing to present to.
+    renderer_backend_type renderer_type = RENDERER_BACKEND_TYPE_VULKAN;
+    if (platform_is_headless(&app_state.platform)) {
+        renderer_type = RENDERER_BACKEND_TYPE_NULL;
+    }
+    if (!renderer_initialize(renderer_type, game_inst->app_config.name, &app_state.platform, &game_inst->app_config.renderer)) {
         KFATAL("Failed to initialize renderer. Aborting application.");
         return FALSE;
     }
     // Initialize clock system with platform state
     clock_set_platform_state(&app_state.platform);
+
+    // The audio device is paced by the clock, so it starts after it.
+    audio_system_config audio_config = {};
+    audio_config.device.type = game_inst->app_config.audio_capture_path ? AUDIO_DEVICE_TYPE_WAV_FILE : AUDIO_DEVICE_TYPE_NULL;
+    audio_config.device.sample_rate = 48000;
+    audio_config.device.paced = TRUE;
+    audio_config.device.wav_path = game_inst->app_config.audio_capture_path;
+    audio_config.frames_per_block = 512;
+    audio_config.max_voices = 64;
+    audio_config.stream_base_path = "../assets/sounds";
+    if (!audio_system_initialize(audio_config)) {
+        KERROR("Audio system failed initialization. Application cannot continue.");
+        return FALSE;
+    }
+
     // Initialize the game.
     if (!app_state.game_inst->initialize(app_state.game_inst)) {
         KFATAL("Game failed to initialize.");
@@ -79,6 +227,9 @@ b8 application_create(game* game_inst) {
 
     app_state.game_inst->on_resize(app_state.game_inst, app_state.width, app_state.height);
 
+    // Now that events can be delivered, watch the game library (if any) for rebuilds.
+    game_module_watch();
+
     initialized = TRUE;
 
     return TRUE;
@@ -98,6 +249,22 @@ b8 application_run() {
             app_state.is_running = FALSE;
         }
 
+        // Deliver any file reads which finished since the last frame.
+        async_io_update();
+        job_system_update();
+        // Finish loaded resources, within this frame's budget.
+        resource_system_update();
+        // Free finished voices and keep streamed sounds read ahead.
+        audio_system_update();
+
+        // Checked regardless of suspension so a minimized window can be restored.
+        if (app_state.resize_pending) {
+            f64 since_last_resize = clock_get_absolute_time(&app_state.platform) - app_state.last_resize_time;
+            if (since_last_resize >= RESIZE_DEBOUNCE_SECONDS) {
+                application_apply_pending_resize();
+            }
+        }
+
         if (!app_state.is_suspended) {
             clock_update(&app_state.clock);
             f64 current_time = app_state.clock.elapsed;
@@ -110,6 +277,12 @@ b8 application_run() {
                 break;
             }
 
+            // Systems registered by the game run after its own update.
+            ecs_scheduler_run((f32)delta);
+
+            // World matrices reflect this frame's moves before anything renders.
+            transform_system_update();
+
             // Call the game's render routine.
             if (!app_state.game_inst->render(app_state.game_inst, (f32)delta)) {
                 KFATAL("Game render failed, shutting down.");
@@ -117,15 +290,16 @@ b8 application_run() {
                 break;
             }
 
-            // TODO: refactor packet creation
+            // Built from what the game submitted while rendering.
             render_packet packet;
-            packet.delta_time = delta;
+            renderer_build_packet((f32)delta, &packet);
             renderer_draw_frame(&packet);
 
             // Figure out how long the frame took and, if below
             f64 frame_end_time = clock_get_absolute_time(&app_state.platform);
             f64 frame_elapsed_time = frame_end_time - frame_start_time;
             running_time += frame_elapsed_time;
+            profiler_frame_end(frame_elapsed_time);
             f64 remaining_seconds = target_frame_seconds - frame_elapsed_time;
 
             if (remaining_seconds > 0) {
@@ -156,10 +330,30 @@ b8 application_run() {
     event_unregister(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
+    event_unregister(EVENT_CODE_RESIZED, 0, application_on_resized);
+    game_module_unload();
+    // Before the resource system and async I/O, which its sounds are loaded and streamed with.
+    audio_system_shutdown();
+    scene_system_shutdown();
+    material_system_shutdown();
+    ecs_scheduler_shutdown();
+    ecs_system_shutdown();
+    transform_system_shutdown();
+    // Jobs first, so nothing is still loading when the resource system shuts down.
+    job_system_shutdown();
+    resource_system_shutdown();
+    async_io_shutdown();
+    if (app_state.config_watched) {
+        event_unregister(EVENT_CODE_CONFIG_RELOADED, 0, application_on_config_reloaded);
+        config_unwatch(app_state.config_id);
+    }
+    config_system_shutdown();
     event_shutdown();
     input_shutdown();
     renderer_shutdown();
     platform_shutdown(&app_state.platform);
+    profiler_shutdown();
+    kname_system_shutdown();
 
     return TRUE;
 }
@@ -217,3 +411,64 @@ b8 application_on_key(u16 code, void* sender, void* listener_inst, event_context
     }
     return FALSE;
 }
+
+b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_context context) {
+    if (code == EVENT_CODE_RESIZED) {
+        // Only record the size here. It is applied once it stops changing.
+        app_state.pending_width = context.data.u16[0];
+        app_state.pending_height = context.data.u16[1];
+        app_state.last_resize_time = clock_get_absolute_time(&app_state.platform);
+        app_state.resize_pending = TRUE;
+
+        // Minimizing is not something to wait on, suspend right away.
+        if (app_state.pending_width == 0 || app_state.pending_height == 0) {
+            application_apply_pending_resize();
+        }
+    }
+
+    // Event purposely not handled to allow other listeners to get this.
+    return FALSE;
+}
+
+static b8 application_on_config_reloaded(u16 code, void* sender, void* listener_inst, event_context context) {
+    if (code != EVENT_CODE_CONFIG_RELOADED || context.data.u32[0] != app_state.config_id) {
+        return FALSE;
+    }
+
+    renderer_apply_config(&app_state.game_inst->app_config.renderer);
+    KINFO("Config reloaded. Window settings take effect on the next start.");
+
+    // Purposely not handled so other listeners get the event too.
+    return FALSE;
+}
+
+static void application_apply_pending_resize() {
+    app_state.resize_pending = FALSE;
+
+    u16 width = app_state.pending_width;
+    u16 height = app_state.pending_height;
+
+    // Handle minimization
+    if (width == 0 || height == 0) {
+        KINFO("Window minimized, suspending application.");
+        app_state.is_suspended = TRUE;
+        return;
+    }
+
+    if (app_state.is_suspended) {
+        KINFO("Window restored, resuming application.");
+        app_state.is_suspended = FALSE;
+    }
+
+    // Nothing to do if the window settled back on the size already in use.
+    if (width == app_state.width && height == app_state.height) {
+        return;
+    }
+
+    app_state.width = width;
+    app_state.height = height;
+    KDEBUG("Window resize: %i, %i", width, height);
+
+    app_state.game_inst->on_resize(app_state.game_inst, width, height);
+    renderer_on_resized(width, height);
+}
@@ -2,6 +2,7 @@
 
 #include "defines.h"
 #include "core/event.h"
+#include "renderer/renderer_types.inl"
 
 struct game;
 
@@ -21,6 +22,15 @@ typedef struct application_config {
 
     // The application name used in windowing, if applicable.
     char* name;
+
+    // Renderer settings.
+    renderer_config renderer;
+
+    // Optional config file overriding the settings above. Reloaded when it is written.
+    const char* config_path;
+
+    // A WAV file the game's sound is recorded to. Optional; without one, sound is mixed and discarded.
+    const char* audio_capture_path;
 } application_config;
 
 KAPI b8 application_create(struct game* game_inst);
@@ -28,4 +38,5 @@ KAPI b8 application_create(struct game* game_inst);
 KAPI b8 application_run();
 void application_get_framebuffer_size(u32* width, u32* height);
 b8 application_on_event(u16 code, void* sender, void* listener_inst, event_context context);
-b8 application_on_key(u16 code, void* sender, void* listener_inst, event_context context);
\ No newline at end of file
+b8 application_on_key(u16 code, void* sender, void* listener_inst, event_context context);
+b8 application_on_resized(u16 code, void* sender, void* listener_inst, event_context context);
\ No newline at end of file
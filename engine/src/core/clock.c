@@ -26,3 +26,7 @@ void clock_stop(clock* clock) {
 f64 clock_get_absolute_time(platform_state* plat_state) {
     return platform_get_absolute_time(plat_state);
 }
+
+f64 clock_get_current_time() {
+    return platform_get_absolute_time(g_platform_state);
+}
@@ -23,3 +23,7 @@ void clock_set_platform_state(platform_state* plat_state);
 
 // Gets the absolute time from the platform
 f64 clock_get_absolute_time(platform_state* plat_state);
+
+// Gets the absolute time, using the platform state given to clock_set_platform_state.
+// Safe to call from any thread.
+KAPI f64 clock_get_current_time();
@@ -107,5 +107,32 @@ typedef enum system_event_code {
      */
     EVENT_CODE_RESIZED = 0x08,
 
+    // A file being watched with platform_watch_file has been written to.
+    /* Context usage:
+     * u32 watch_id = data.data.u32[0];
+     */
+    EVENT_CODE_WATCHED_FILE_WRITTEN = 0x09,
+
+    // A read submitted with async_io_submit_reads has finished.
+    /* Context usage:
+     * u64 user_data = data.data.u64[0];
+     * u32 bytes_read = data.data.u32[2];
+     * i32 error = data.data.i32[3]; // 0 on success, otherwise a platform error code.
+     */
+    EVENT_CODE_ASYNC_READ_COMPLETED = 0x0A,
+
+    // A config file watched with config_watch has been reloaded.
+    /* Context usage:
+     * u32 config_id = data.data.u32[0];
+     */
+    EVENT_CODE_CONFIG_RELOADED = 0x0B,
+
+    // A voice of the audio system has finished playing, or been stopped.
+    /* Context usage:
+     * u32 voice_index = data.data.u32[0];
+     * u32 voice_generation = data.data.u32[1];
+     */
+    EVENT_CODE_SOUND_FINISHED = 0x0C,
+
     MAX_EVENT_CODE = 0xFF
 } system_event_code;
\ No newline at end of file
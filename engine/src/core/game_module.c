@@ -0,0 +1,155 @@
+#include "core/game_module.h"
+
+#include "game_types.h"
+#include "core/event.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+typedef void (*PFN_game_on_module_reload)(game* game_inst);
+
+typedef struct game_module_state {
+    b8 loaded;
+    game* game_inst;
+    // The library name without prefix or extension.
+    char name[128];
+    // The library as built. This is the file which gets watched.
+    char source_path[256];
+    // The library is never loaded from source_path directly, but from one of
+    // two alternating copies of it. This leaves the build free to overwrite
+    // the source at any time, and lets a new copy be loaded and verified
+    // before the old one is released.
+    dynamic_library library;
+    u32 copy_index;
+    b8 watching;
+    u32 watch_id;
+} game_module_state;
+
+static game_module_state state;
+
+static b8 game_module_on_file_written(u16 code, void* sender, void* listener_inst, event_context context);
+
+static b8 load_copy(u32 copy_index, dynamic_library* out_library) {
+    char copy_path[256];
+    string_format(copy_path, sizeof(copy_path), "./%s%s_loaded%u%s",
+             platform_dynamic_library_prefix(), state.name, copy_index, platform_dynamic_library_extension());
+
+    if (!platform_copy_file(state.source_path, copy_path, TRUE)) {
+        return FALSE;
+    }
+    return platform_dynamic_library_load(copy_path, out_library);
+}
+
+static b8 assign_functions(dynamic_library* library, game* game_inst) {
+    void* initialize = platform_dynamic_library_load_function(library, "game_initialize");
+    void* update = platform_dynamic_library_load_function(library, "game_update");
+    void* render = platform_dynamic_library_load_function(library, "game_render");
+    void* on_resize = platform_dynamic_library_load_function(library, "game_on_resize");
+    if (!initialize || !update || !render || !on_resize) {
+        KERROR("Game library '%s' is missing one or more required functions.", library->path);
+        return FALSE;
+    }
+
+    // Only assign once everything has been found, so a bad library never leaves the game half-swapped.
+    game_inst->initialize = initialize;
+    game_inst->update = update;
+    game_inst->render = render;
+    game_inst->on_resize = on_resize;
+    return TRUE;
+}
+
+b8 game_module_load(const char* name, game* game_inst) {
+    if (state.loaded) {
+        KERROR("game_module_load called more than once.");
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(game_module_state));
+    string_format(state.name, sizeof(state.name), "%s", name);
+    string_format(state.source_path, sizeof(state.source_path), "./%s%s%s",
+             platform_dynamic_library_prefix(), name, platform_dynamic_library_extension());
+
+    if (!load_copy(state.copy_index, &state.library)) {
+        KERROR("Failed to load game library '%s'.", state.source_path);
+        return FALSE;
+    }
+
+    if (!assign_functions(&state.library, game_inst)) {
+        platform_dynamic_library_unload(&state.library);
+        return FALSE;
+    }
+
+    state.game_inst = game_inst;
+    state.loaded = TRUE;
+    KINFO("Game library '%s' loaded.", state.source_path);
+    return TRUE;
+}
+
+void game_module_watch() {
+#if KOHI_HOT_RELOAD
+    if (!state.loaded || state.watching) {
+        return;
+    }
+
+    if (!platform_watch_file(state.source_path, &state.watch_id)) {
+        KWARN("Unable to watch game library '%s', hot-reload is disabled.", state.source_path);
+        return;
+    }
+
+    event_register(EVENT_CODE_WATCHED_FILE_WRITTEN, state.game_inst, game_module_on_file_written);
+    state.watching = TRUE;
+    KINFO("Hot-reload enabled for game library '%s'.", state.source_path);
+#endif
+}
+
+void game_module_unload() {
+    if (!state.loaded) {
+        return;
+    }
+
+    if (state.watching) {
+        event_unregister(EVENT_CODE_WATCHED_FILE_WRITTEN, state.game_inst, game_module_on_file_written);
+        platform_unwatch_file(state.watch_id);
+        state.watching = FALSE;
+    }
+
+    platform_dynamic_library_unload(&state.library);
+    state.loaded = FALSE;
+}
+
+static b8 game_module_on_file_written(u16 code, void* sender, void* listener_inst, event_context context) {
+    if (code != EVENT_CODE_WATCHED_FILE_WRITTEN || context.data.u32[0] != state.watch_id) {
+        return FALSE;
+    }
+
+    // NOTE: This runs from platform_pump_messages, so no game code is on the stack.
+    KINFO("Game library '%s' changed, hot-reloading...", state.source_path);
+
+    u32 next_copy = (state.copy_index + 1) % 2;
+    dynamic_library new_library = {};
+    if (!load_copy(next_copy, &new_library)) {
+        KERROR("Hot-reload failed, keeping the currently loaded game library.");
+        return FALSE;
+    }
+
+    if (!assign_functions(&new_library, state.game_inst)) {
+        KERROR("Hot-reload failed, keeping the currently loaded game library.");
+        platform_dynamic_library_unload(&new_library);
+        return FALSE;
+    }
+
+    platform_dynamic_library_unload(&state.library);
+    state.library = new_library;
+    state.copy_index = next_copy;
+
+    PFN_game_on_module_reload on_reload = platform_dynamic_library_load_function(&state.library, "game_on_module_reload");
+    if (on_reload) {
+        on_reload(state.game_inst);
+    }
+
+    KINFO("Game library hot-reloaded.");
+
+    // Purposely not handled so other watchers get the event too.
+    return FALSE;
+}
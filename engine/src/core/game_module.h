@@ -0,0 +1,36 @@
+#pragma once
+
+#include "defines.h"
+
+struct game;
+
+/*
+ * Loads a game's functions from a dynamic library instead of linking them
+ * into the executable. The library must export game_initialize,
+ * game_update, game_render and game_on_resize with the signatures found in
+ * game_types.h, and may export game_on_module_reload, which is called after
+ * every hot-reload.
+ *
+ * With KOHI_HOT_RELOAD enabled, the library file is watched once the
+ * application has started and reloaded between frames whenever it is
+ * rebuilt. game->state is owned by the executable, so it survives reloads;
+ * changing the layout of the state still requires a restart.
+ */
+
+/**
+ * Loads the game library with the given name and assigns the game's function pointers.
+ * @param name The library name without platform prefix or extension, i.e. "testbed_lib".
+ * @param game_inst A pointer to the game whose functions should be assigned.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 game_module_load(const char* name, struct game* game_inst);
+
+/**
+ * Starts watching the loaded game library for changes. Called by the
+ * application once the event system is running. Does nothing if the game
+ * was not loaded through game_module_load.
+ */
+void game_module_watch();
+
+// Stops watching and unloads the game library, if one was loaded.
+void game_module_unload();
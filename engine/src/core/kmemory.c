@@ -4,10 +4,6 @@
 #include "platform/platform.h"
 #include "core/kstring.h"
 
-// TODO: Custom string lib
-#include <string.h>
-#include <stdio.h>
-
 struct memory_stats {
     u64 total_allocated;
     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
@@ -30,7 +26,11 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "TRANSFORM  ",
     "ENTITY     ",
     "ENTITY_NODE",
-    "SCENE      "};
+    "SCENE      ",
+    "RESOURCE   ",
+    "MESH       ",
+    "SHADER     ",
+    "AUDIO      "};
 
 static struct memory_stats stats;
 
@@ -46,8 +46,9 @@ KAPI void* kallocate(u64 size, memory_tag tag) {
         KWARN("kallocate called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
     }
 
-    stats.total_allocated += size;
-    stats.tagged_allocations[tag] += size;
+    // Allocations may come from job threads, so the counters are updated atomically.
+    __atomic_fetch_add(&stats.total_allocated, size, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats.tagged_allocations[tag], size, __ATOMIC_RELAXED);
 
     // TODO: Memory alignment
     void* block = platform_allocate(size, false);
@@ -60,8 +61,8 @@ KAPI void kfree(void* block, u64 size, memory_tag tag) {
         KWARN("kfree called using MEMORY_TAG_UNKNOWN. Re-class this allocation.");
     }
 
-    stats.total_allocated -= size;
-    stats.tagged_allocations[tag] -= size;
+    __atomic_fetch_sub(&stats.total_allocated, size, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&stats.tagged_allocations[tag], size, __ATOMIC_RELAXED);
 
     // TODO: Memory alignment
     platform_free(block, false);
@@ -79,13 +80,24 @@ KAPI void* kset_memory(void* dest, i32 value, u64 size) {
     return platform_set_memory(dest, value, size);
 }
 
+KAPI u64 memory_usage_get(memory_tag tag) {
+    if (tag >= MEMORY_TAG_MAX_TAGS) {
+        return __atomic_load_n(&stats.total_allocated, __ATOMIC_RELAXED);
+    }
+    return __atomic_load_n(&stats.tagged_allocations[tag], __ATOMIC_RELAXED);
+}
+
+KAPI const char* memory_tag_name(memory_tag tag) {
+    return tag < MEMORY_TAG_MAX_TAGS ? memory_tag_strings[tag] : "UNKNOWN    ";
+}
+
 KAPI char* get_memory_usage_str() {
     const u64 gib = 1024 * 1024 * 1024;
     const u64 mib = 1024 * 1024;
     const u64 kib = 1024;
 
     char buffer[8000] = "System memory use (tagged):\n";
-    u64 offset = strlen(buffer);
+    u64 offset = string_length(buffer);
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
         char unit[4] = "XiB";
         float amount = 1.0f;
@@ -104,8 +116,8 @@ KAPI char* get_memory_usage_str() {
             amount = (float)stats.tagged_allocations[i];
         }
 
-        i32 length = snprintf(buffer + offset, 8000 - offset, "  %s: %.2f%s\n",
-                              memory_tag_strings[i], amount, unit);
+        u64 length = string_format(buffer + offset, 8000 - offset, "  %s: %.2f%s\n",
+                                   memory_tag_strings[i], amount, unit);
         offset += length;
     }
 
@@ -21,6 +21,10 @@ typedef enum memory_tag {
     MEMORY_TAG_ENTITY,
     MEMORY_TAG_ENTITY_NODE,
     MEMORY_TAG_SCENE,
+    MEMORY_TAG_RESOURCE,
+    MEMORY_TAG_MESH,
+    MEMORY_TAG_SHADER,
+    MEMORY_TAG_AUDIO,
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
@@ -37,4 +41,10 @@ KAPI void* kcopy_memory(void* dest, const void* source, u64 size);
 
 KAPI void* kset_memory(void* dest, i32 value, u64 size);
 
-KAPI char* get_memory_usage_str();
\ No newline at end of file
+KAPI char* get_memory_usage_str();
+
+// Bytes currently allocated under a tag, or under every tag for MEMORY_TAG_MAX_TAGS. Does not allocate.
+KAPI u64 memory_usage_get(memory_tag tag);
+
+// A tag's name, padded to the width of the longest.
+KAPI const char* memory_tag_name(memory_tag tag);
\ No newline at end of file
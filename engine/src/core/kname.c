@@ -0,0 +1,226 @@
+#include "core/kname.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/kmutex.h"
+#include "core/logger.h"
+
+// Strings are copied into arena chunks of this size, and never move, so the
+// pointers handed out stay valid. Longer strings get a chunk to themselves.
+#define KNAME_ARENA_CHUNK_SIZE (64 * 1024)
+
+// Entries live in fixed pages which are never reallocated, which is what lets
+// readers resolve IDs without taking the lock while other threads intern.
+#define KNAME_PAGE_SHIFT 12
+#define KNAME_PAGE_SIZE (1 << KNAME_PAGE_SHIFT)
+#define KNAME_MAX_PAGES 1024
+
+#define KNAME_INITIAL_INDEX_CAPACITY 4096
+
+typedef struct kname_entry {
+    const char* str;
+    u64 length;
+    u64 hash;
+} kname_entry;
+
+typedef struct kname_chunk {
+    char* memory;
+    u64 size;
+} kname_chunk;
+
+typedef struct kname_system_state {
+    kmutex lock;
+    kname_entry* pages[KNAME_MAX_PAGES];
+    // Including the unused entry of KNAME_NONE. Published after the entry is written.
+    u32 count;
+
+    // Open addressing from hash to ID. 0 marks an empty slot. Only used under the lock.
+    kname* index;
+    u32 index_capacity;
+
+    // darray of every arena chunk.
+    kname_chunk* chunks;
+    u64 chunk_used;
+} kname_system_state;
+
+static b8 is_initialized = FALSE;
+static kname_system_state state;
+
+static kname_entry* get_entry(kname name) {
+    return &state.pages[name >> KNAME_PAGE_SHIFT][name & (KNAME_PAGE_SIZE - 1)];
+}
+
+b8 kname_system_initialize() {
+    if (is_initialized) {
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(kname_system_state));
+    if (!kmutex_create(&state.lock)) {
+        KERROR("Failed to create the name pool lock.");
+        return FALSE;
+    }
+    state.index_capacity = KNAME_INITIAL_INDEX_CAPACITY;
+    state.index = kallocate(sizeof(kname) * state.index_capacity, MEMORY_TAG_STRING);
+    state.chunks = darray_create(kname_chunk);
+
+    // Reserve KNAME_NONE as the empty string.
+    state.pages[0] = kallocate(sizeof(kname_entry) * KNAME_PAGE_SIZE, MEMORY_TAG_STRING);
+    state.pages[0][0].str = "";
+    state.count = 1;
+
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void kname_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+
+    for (u32 i = 0; i < KNAME_MAX_PAGES && state.pages[i]; ++i) {
+        kfree(state.pages[i], sizeof(kname_entry) * KNAME_PAGE_SIZE, MEMORY_TAG_STRING);
+    }
+    u64 chunk_count = darray_length(state.chunks);
+    for (u64 i = 0; i < chunk_count; ++i) {
+        kfree(state.chunks[i].memory, state.chunks[i].size, MEMORY_TAG_STRING);
+    }
+    darray_destroy(state.chunks);
+    kfree(state.index, sizeof(kname) * state.index_capacity, MEMORY_TAG_STRING);
+    kmutex_destroy(&state.lock);
+
+    kzero_memory(&state, sizeof(kname_system_state));
+    is_initialized = FALSE;
+}
+
+// Finds the slot holding the view, or the empty slot it would go in. Call with the lock held.
+static u32 index_find_slot(kstring_view view, u64 hash) {
+    u32 mask = state.index_capacity - 1;
+    for (u32 slot = (u32)hash & mask;; slot = (slot + 1) & mask) {
+        kname name = state.index[slot];
+        if (name == KNAME_NONE) {
+            return slot;
+        }
+        kname_entry* entry = get_entry(name);
+        if (entry->hash == hash && string_views_equal(string_view_from(entry->str, entry->length), view)) {
+            return slot;
+        }
+    }
+}
+
+// Doubles the index once it is half full. Call with the lock held.
+static void index_grow() {
+    kname* old_index = state.index;
+    u32 old_capacity = state.index_capacity;
+    state.index_capacity *= 2;
+    state.index = kallocate(sizeof(kname) * state.index_capacity, MEMORY_TAG_STRING);
+
+    u32 mask = state.index_capacity - 1;
+    for (u32 i = 0; i < old_capacity; ++i) {
+        kname name = old_index[i];
+        if (name != KNAME_NONE) {
+            u32 slot = (u32)get_entry(name)->hash & mask;
+            while (state.index[slot] != KNAME_NONE) {
+                slot = (slot + 1) & mask;
+            }
+            state.index[slot] = name;
+        }
+    }
+    kfree(old_index, sizeof(kname) * old_capacity, MEMORY_TAG_STRING);
+}
+
+// Copies a string into the arena. Call with the lock held.
+static const char* arena_store(kstring_view view) {
+    u64 size = view.length + 1;
+    u64 chunk_count = darray_length(state.chunks);
+    if (chunk_count == 0 || state.chunk_used + size > state.chunks[chunk_count - 1].size) {
+        kname_chunk chunk;
+        chunk.size = size > KNAME_ARENA_CHUNK_SIZE ? size : KNAME_ARENA_CHUNK_SIZE;
+        chunk.memory = kallocate(chunk.size, MEMORY_TAG_STRING);
+        darray_push(state.chunks, chunk);
+        chunk_count++;
+        state.chunk_used = 0;
+    }
+
+    char* str = state.chunks[chunk_count - 1].memory + state.chunk_used;
+    kcopy_memory(str, view.str, view.length);
+    str[view.length] = 0;
+    state.chunk_used += size;
+    return str;
+}
+
+kname kname_intern_view(kstring_view view) {
+    if (!is_initialized || view.length == 0) {
+        return KNAME_NONE;
+    }
+
+    u64 hash = string_view_hash(view);
+    kmutex_lock(&state.lock);
+
+    u32 slot = index_find_slot(view, hash);
+    kname name = state.index[slot];
+    if (name != KNAME_NONE) {
+        kmutex_unlock(&state.lock);
+        return name;
+    }
+
+    name = state.count;
+    if ((name >> KNAME_PAGE_SHIFT) >= KNAME_MAX_PAGES) {
+        kmutex_unlock(&state.lock);
+        KERROR("The name pool is full, unable to intern '%.*s'.", KSV_ARG(view));
+        return KNAME_NONE;
+    }
+    if (!state.pages[name >> KNAME_PAGE_SHIFT]) {
+        state.pages[name >> KNAME_PAGE_SHIFT] = kallocate(sizeof(kname_entry) * KNAME_PAGE_SIZE, MEMORY_TAG_STRING);
+    }
+
+    kname_entry* entry = get_entry(name);
+    entry->str = arena_store(view);
+    entry->length = view.length;
+    entry->hash = hash;
+    state.index[slot] = name;
+    // Publish the entry to lock-free readers only once it is complete.
+    __atomic_store_n(&state.count, name + 1, __ATOMIC_RELEASE);
+
+    if (state.count * 2 > state.index_capacity) {
+        index_grow();
+    }
+
+    kmutex_unlock(&state.lock);
+    return name;
+}
+
+kname kname_intern(const char* str) {
+    return str ? kname_intern_view(string_view(str)) : KNAME_NONE;
+}
+
+kname kname_find(kstring_view view) {
+    if (!is_initialized || view.length == 0) {
+        return KNAME_NONE;
+    }
+
+    u64 hash = string_view_hash(view);
+    kmutex_lock(&state.lock);
+    kname name = state.index[index_find_slot(view, hash)];
+    kmutex_unlock(&state.lock);
+    return name;
+}
+
+const char* kname_string(kname name) {
+    if (!is_initialized || name >= __atomic_load_n(&state.count, __ATOMIC_ACQUIRE)) {
+        return "";
+    }
+    return get_entry(name)->str;
+}
+
+kstring_view kname_view(kname name) {
+    if (!is_initialized || name >= __atomic_load_n(&state.count, __ATOMIC_ACQUIRE)) {
+        return string_view_from("", 0);
+    }
+    kname_entry* entry = get_entry(name);
+    return string_view_from(entry->str, entry->length);
+}
+
+u32 kname_count() {
+    return is_initialized ? __atomic_load_n(&state.count, __ATOMIC_ACQUIRE) - 1 : 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "defines.h"
+#include "core/kstring.h"
+
+/**
+ * An interned string. Each distinct string interned gets its own ID, which
+ * stays the same until shutdown, so names can be compared and hashed as
+ * integers and the string fetched back only when it is needed, e.g. for
+ * logging.
+ */
+typedef u32 kname;
+
+// The ID of no name. Resolves to an empty string.
+#define KNAME_NONE 0
+
+b8 kname_system_initialize();
+void kname_system_shutdown();
+
+/**
+ * Interns a string, returning the ID it already had or a new one. Safe to
+ * call from any thread.
+ * @returns The string's ID, or KNAME_NONE if the pool is full.
+ */
+KAPI kname kname_intern(const char* str);
+KAPI kname kname_intern_view(kstring_view view);
+
+/**
+ * Returns the ID of an already interned string without interning it.
+ * @returns The string's ID, or KNAME_NONE if it was never interned.
+ */
+KAPI kname kname_find(kstring_view view);
+
+/**
+ * Resolves an ID back to its string. Lock-free, and the string stays valid
+ * until shutdown.
+ * @returns The terminated string, or "" for KNAME_NONE or an unknown ID.
+ */
+KAPI const char* kname_string(kname name);
+KAPI kstring_view kname_view(kname name);
+
+// The number of names interned so far.
+KAPI u32 kname_count();
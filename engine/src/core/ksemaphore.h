@@ -0,0 +1,40 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * A counting semaphore. Waiting decrements the count, blocking while
+ * it is zero; signalling increments it, waking a single waiter.
+ */
+typedef struct ksemaphore {
+    void* internal_data;
+} ksemaphore;
+
+/**
+ * Creates a semaphore.
+ * @param out_semaphore A pointer to hold the created semaphore.
+ * @param start_count The count the semaphore starts with.
+ * @returns TRUE if created successfully; otherwise FALSE.
+ */
+KAPI b8 ksemaphore_create(ksemaphore* out_semaphore, u32 start_count);
+
+/**
+ * Destroys the provided semaphore.
+ * @param semaphore A pointer to the semaphore to be destroyed.
+ */
+KAPI void ksemaphore_destroy(ksemaphore* semaphore);
+
+/**
+ * Increments the semaphore's count, waking one waiter if there is any.
+ * @param semaphore A pointer to the semaphore.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 ksemaphore_signal(ksemaphore* semaphore);
+
+/**
+ * Waits until the semaphore's count is above zero, then decrements it.
+ * @param semaphore A pointer to the semaphore.
+ * @param timeout_ms The maximum time to wait in milliseconds. 0 waits forever.
+ * @returns TRUE if the count was taken; FALSE on timeout or error.
+ */
+KAPI b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms);
@@ -1,10 +1,66 @@
 #include "core/kstring.h"
 #include "core/kmemory.h"
 
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 
-u64 string_length(const char* str) {
+// The vector paths. SSE2 is part of x86-64, so it is always there; AVX2 is
+// only used when the compiler targets it (e.g. -mavx2).
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KSTRING_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define KSTRING_SSE2 1
+#endif
+
+#if defined(__clang__) || defined(__GNUC__)
+#define first_set_bit(mask) (u32) __builtin_ctz(mask)
+#define last_set_bit(mask) (u32)(31 - __builtin_clz(mask))
+#else
+#include <intrin.h>
+static u32 first_set_bit(u32 mask) {
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (u32)index;
+}
+static u32 last_set_bit(u32 mask) {
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return (u32)index;
+}
+#endif
+
+// The aligned over-read in string_length is safe, but AddressSanitizer cannot know that.
+#if defined(__clang__) || defined(__GNUC__)
+#define KSTRING_NO_ASAN __attribute__((no_sanitize("address")))
+#else
+#define KSTRING_NO_ASAN
+#endif
+
+KSTRING_NO_ASAN u64 string_length(const char* str) {
+#if KSTRING_SSE2
+    // Aligned loads never cross a page, so reading past the terminator within
+    // the block is safe. Bytes before the string in the first block are masked off.
+    const char* block = (const char*)((u64)str & ~(u64)15);
+    u32 skip = (u32)(str - block);
+    __m128i zero = _mm_setzero_si128();
+    u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), zero)) >> skip;
+    if (mask) {
+        return first_set_bit(mask);
+    }
+    for (;;) {
+        block += 16;
+        mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)block), zero));
+        if (mask) {
+            return (u64)(block - str) + first_set_bit(mask);
+        }
+    }
+#else
     return strlen(str);
+#endif
 }
 
 char* string_duplicate(const char* str) {
@@ -18,3 +74,287 @@ char* string_duplicate(const char* str) {
 b8 strings_equal(const char* str0, const char* str1) {
     return strcmp(str0, str1) == 0;
 }
+
+kstring_view string_view(const char* str) {
+    kstring_view view = {str, str ? string_length(str) : 0};
+    return view;
+}
+
+kstring_view string_view_from(const char* str, u64 length) {
+    kstring_view view = {str, length};
+    return view;
+}
+
+// Compares two equally long ranges.
+static b8 bytes_equal(const char* a, const char* b, u64 length) {
+    u64 i = 0;
+#if KSTRING_AVX2
+    for (; i + 32 <= length; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        if ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != 0xFFFFFFFF) {
+            return FALSE;
+        }
+    }
+#endif
+#if KSTRING_SSE2
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) {
+            return FALSE;
+        }
+    }
+#endif
+    for (; i < length; ++i) {
+        if (a[i] != b[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+b8 string_views_equal(kstring_view a, kstring_view b) {
+    return a.length == b.length && bytes_equal(a.str, b.str, a.length);
+}
+
+b8 string_view_equals_cstr(kstring_view view, const char* str) {
+    // Terminated strings only need walking as far as the view is long.
+    for (u64 i = 0; i < view.length; ++i) {
+        if (str[i] != view.str[i] || str[i] == 0) {
+            return FALSE;
+        }
+    }
+    return str[view.length] == 0;
+}
+
+b8 string_view_starts_with(kstring_view view, kstring_view prefix) {
+    return view.length >= prefix.length && bytes_equal(view.str, prefix.str, prefix.length);
+}
+
+b8 string_view_ends_with(kstring_view view, kstring_view suffix) {
+    return view.length >= suffix.length && bytes_equal(view.str + view.length - suffix.length, suffix.str, suffix.length);
+}
+
+i64 string_view_find_char(kstring_view view, char c) {
+    u64 i = 0;
+#if KSTRING_AVX2
+    __m256i wide = _mm256_set1_epi8(c);
+    for (; i + 32 <= view.length; i += 32) {
+        u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(view.str + i)), wide));
+        if (mask) {
+            return (i64)(i + first_set_bit(mask));
+        }
+    }
+#endif
+#if KSTRING_SSE2
+    __m128i needle = _mm_set1_epi8(c);
+    for (; i + 16 <= view.length; i += 16) {
+        u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(view.str + i)), needle));
+        if (mask) {
+            return (i64)(i + first_set_bit(mask));
+        }
+    }
+#endif
+    for (; i < view.length; ++i) {
+        if (view.str[i] == c) {
+            return (i64)i;
+        }
+    }
+    return -1;
+}
+
+i64 string_view_find_last_char(kstring_view view, char c) {
+    u64 end = view.length;
+#if KSTRING_SSE2
+    __m128i needle = _mm_set1_epi8(c);
+    while (end >= 16) {
+        u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(view.str + end - 16)), needle));
+        if (mask) {
+            return (i64)(end - 16 + last_set_bit(mask));
+        }
+        end -= 16;
+    }
+#endif
+    while (end > 0) {
+        end--;
+        if (view.str[end] == c) {
+            return (i64)end;
+        }
+    }
+    return -1;
+}
+
+i64 string_view_find(kstring_view view, kstring_view needle) {
+    if (needle.length == 0) {
+        return 0;
+    }
+    if (needle.length > view.length) {
+        return -1;
+    }
+    if (needle.length == 1) {
+        return string_view_find_char(view, needle.str[0]);
+    }
+
+    u64 last_start = view.length - needle.length;
+    u64 i = 0;
+#if KSTRING_SSE2
+    // Compare the needle's first and last characters against 16 candidate
+    // positions at once, and only check the rest where both match.
+    __m128i first = _mm_set1_epi8(needle.str[0]);
+    __m128i last = _mm_set1_epi8(needle.str[needle.length - 1]);
+    for (; i + 16 <= last_start + 1; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i*)(view.str + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i*)(view.str + i + needle.length - 1));
+        u32 mask = (u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+        while (mask) {
+            u32 bit = first_set_bit(mask);
+            if (bytes_equal(view.str + i + bit + 1, needle.str + 1, needle.length - 2)) {
+                return (i64)(i + bit);
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i <= last_start; ++i) {
+        if (view.str[i] == needle.str[0] && bytes_equal(view.str + i, needle.str, needle.length)) {
+            return (i64)i;
+        }
+    }
+    return -1;
+}
+
+kstring_view string_view_substring(kstring_view view, u64 start, u64 length) {
+    if (start > view.length) {
+        start = view.length;
+    }
+    if (length > view.length - start) {
+        length = view.length - start;
+    }
+    return string_view_from(view.str + start, length);
+}
+
+static b8 is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+kstring_view string_view_trim(kstring_view view) {
+    u64 start = 0;
+    u64 end = view.length;
+    while (start < end && is_space(view.str[start])) {
+        start++;
+    }
+    while (end > start && is_space(view.str[end - 1])) {
+        end--;
+    }
+    return string_view_from(view.str + start, end - start);
+}
+
+// wyhash (final version 4), by Wang Yi. Public domain.
+
+static const u64 wyhash_secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+static void wyhash_multiply(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static u64 wyhash_mix(u64 a, u64 b) {
+    wyhash_multiply(&a, &b);
+    return a ^ b;
+}
+
+static u64 read_u64(const u8* p) {
+    u64 v;
+    kcopy_memory(&v, p, 8);
+    return v;
+}
+
+static u64 read_u32(const u8* p) {
+    u32 v;
+    kcopy_memory(&v, p, 4);
+    return v;
+}
+
+u64 string_hash_bytes(const void* data, u64 length, u64 seed) {
+    const u8* p = (const u8*)data;
+    seed ^= wyhash_mix(seed ^ wyhash_secret[0], wyhash_secret[1]);
+    u64 a, b;
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (read_u32(p) << 32) | read_u32(p + ((length >> 3) << 2));
+            b = (read_u32(p + length - 4) << 32) | read_u32(p + length - 4 - ((length >> 3) << 2));
+        } else if (length > 0) {
+            a = ((u64)p[0] << 16) | ((u64)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        u64 i = length;
+        if (i > 48) {
+            u64 see1 = seed, see2 = seed;
+            do {
+                seed = wyhash_mix(read_u64(p) ^ wyhash_secret[1], read_u64(p + 8) ^ seed);
+                see1 = wyhash_mix(read_u64(p + 16) ^ wyhash_secret[2], read_u64(p + 24) ^ see1);
+                see2 = wyhash_mix(read_u64(p + 32) ^ wyhash_secret[3], read_u64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wyhash_mix(read_u64(p) ^ wyhash_secret[1], read_u64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read_u64(p + i - 16);
+        b = read_u64(p + i - 8);
+    }
+    a ^= wyhash_secret[1];
+    b ^= seed;
+    wyhash_multiply(&a, &b);
+    return wyhash_mix(a ^ wyhash_secret[0] ^ length, b ^ wyhash_secret[1]);
+}
+
+u64 string_view_hash(kstring_view view) {
+    return string_hash_bytes(view.str, view.length, 0);
+}
+
+u64 string_hash(const char* str) {
+    return string_hash_bytes(str, string_length(str), 0);
+}
+
+u64 string_format(char* dest, u64 dest_size, const char* format, ...) {
+    // See log_output for why this is __builtin_va_list.
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    u64 written = string_format_v(dest, dest_size, format, &arg_ptr);
+    va_end(arg_ptr);
+    return written;
+}
+
+u64 string_format_v(char* dest, u64 dest_size, const char* format, void* va_listp) {
+    if (!dest || dest_size == 0) {
+        return 0;
+    }
+    i32 length = vsnprintf(dest, dest_size, format, *(__builtin_va_list*)va_listp);
+    if (length < 0) {
+        dest[0] = 0;
+        return 0;
+    }
+    return (u64)length < dest_size ? (u64)length : dest_size - 1;
+}
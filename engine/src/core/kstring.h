@@ -8,4 +8,53 @@ KAPI u64 string_length(const char* str);
 KAPI char* string_duplicate(const char* str);
 
 // Case-sensitive string comparison. True if the same, otherwise false.
-KAPI b8 strings_equal(const char* str0, const char* str1);
\ No newline at end of file
+KAPI b8 strings_equal(const char* str0, const char* str1);
+
+/**
+ * A length-prefixed, non-owning view of characters. Not necessarily
+ * null-terminated, so print one with "%.*s" and KSV_ARG.
+ */
+typedef struct kstring_view {
+    const char* str;
+    u64 length;
+} kstring_view;
+
+#define KSV_ARG(view) (i32)(view).length, (view).str
+
+// Views a null-terminated string, measuring it once.
+KAPI kstring_view string_view(const char* str);
+KAPI kstring_view string_view_from(const char* str, u64 length);
+
+KAPI b8 string_views_equal(kstring_view a, kstring_view b);
+KAPI b8 string_view_equals_cstr(kstring_view view, const char* str);
+KAPI b8 string_view_starts_with(kstring_view view, kstring_view prefix);
+KAPI b8 string_view_ends_with(kstring_view view, kstring_view suffix);
+
+// Returns the index of the first c in the view, or -1.
+KAPI i64 string_view_find_char(kstring_view view, char c);
+// Returns the index of the last c in the view, or -1.
+KAPI i64 string_view_find_last_char(kstring_view view, char c);
+// Returns the index of the first occurrence of needle in the view, or -1. An empty needle is found at 0.
+KAPI i64 string_view_find(kstring_view view, kstring_view needle);
+
+// Returns up to length characters from start, clamped to the view.
+KAPI kstring_view string_view_substring(kstring_view view, u64 start, u64 length);
+// Returns the view without leading and trailing spaces, tabs and line breaks.
+KAPI kstring_view string_view_trim(kstring_view view);
+
+/**
+ * Hashes bytes with a wyhash-style 64-bit hash. Fast and well distributed,
+ * but not cryptographic: never use it where an attacker picks the input and
+ * collisions matter.
+ */
+KAPI u64 string_hash_bytes(const void* data, u64 length, u64 seed);
+KAPI u64 string_view_hash(kstring_view view);
+KAPI u64 string_hash(const char* str);
+
+/**
+ * Formats into a caller-provided buffer, without allocating. Output which
+ * does not fit is truncated, and the buffer is always terminated.
+ * @returns The number of characters written, not counting the terminator.
+ */
+KAPI u64 string_format(char* dest, u64 dest_size, const char* format, ...);
+KAPI u64 string_format_v(char* dest, u64 dest_size, const char* format, void* va_list);
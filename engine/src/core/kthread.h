@@ -0,0 +1,35 @@
+#pragma once
+
+#include "defines.h"
+
+// A function to be invoked on a new thread. The return value is the thread's exit code.
+typedef u32 (*pfn_thread_start)(void* params);
+
+/**
+ * Represents a process thread in the system to be used for work.
+ * Generally should not be created directly in user code.
+ */
+typedef struct kthread {
+    void* internal_data;
+    u64 thread_id;
+} kthread;
+
+/**
+ * Creates a new thread, immediately calling the function pointed to.
+ * @param start_function_ptr The pointer to the function to be invoked immediately.
+ * @param params A pointer to any data to be passed to the start function. Optional.
+ * @param out_thread A pointer to hold the created thread.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread);
+
+/**
+ * Blocks until the given thread has exited, then releases it.
+ * @param thread A pointer to the thread to wait on.
+ */
+KAPI void kthread_wait(kthread* thread);
+
+/**
+ * Returns the identifier of the thread this is called from.
+ */
+KAPI u64 kthread_get_current_id();
@@ -0,0 +1,122 @@
+#include "profiler.h"
+
+#include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/logger.h"
+
+// The weight of each frame in the running averages.
+#define PROFILER_AVERAGE_WEIGHT 0.05
+
+typedef struct profiler_scope {
+    kname name;
+    // Accumulated by profiler_record during the current frame.
+    u64 frame_nanoseconds;
+    u32 frame_samples;
+    profiler_scope_stats stats;
+} profiler_scope;
+
+typedef struct profiler_state {
+    profiler_scope scopes[PROFILER_MAX_SCOPES];
+    u32 scope_count;
+
+    f32 frame_ms[PROFILER_FRAME_HISTORY];
+    // Where the next frame duration goes.
+    u32 frame_head;
+    u32 frame_count;
+} profiler_state;
+
+static b8 is_initialized = FALSE;
+static profiler_state* state = 0;
+
+b8 profiler_initialize() {
+    if (is_initialized) {
+        return FALSE;
+    }
+    state = kallocate(sizeof(profiler_state), MEMORY_TAG_APPLICATION);
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void profiler_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    kfree(state, sizeof(profiler_state), MEMORY_TAG_APPLICATION);
+    state = 0;
+    is_initialized = FALSE;
+}
+
+void profiler_frame_end(f64 frame_seconds) {
+    if (!is_initialized) {
+        return;
+    }
+    for (u32 i = 0; i < state->scope_count; ++i) {
+        profiler_scope* scope = &state->scopes[i];
+        u64 nanoseconds = __atomic_exchange_n(&scope->frame_nanoseconds, 0, __ATOMIC_RELAXED);
+        u32 samples = __atomic_exchange_n(&scope->frame_samples, 0, __ATOMIC_RELAXED);
+        scope->stats.last_ms = nanoseconds / 1000000.0;
+        scope->stats.sample_count = samples;
+        scope->stats.average_ms += (scope->stats.last_ms - scope->stats.average_ms) * PROFILER_AVERAGE_WEIGHT;
+    }
+
+    state->frame_ms[state->frame_head] = (f32)(frame_seconds * 1000.0);
+    state->frame_head = (state->frame_head + 1) % PROFILER_FRAME_HISTORY;
+    if (state->frame_count < PROFILER_FRAME_HISTORY) {
+        state->frame_count++;
+    }
+}
+
+u32 profiler_scope_register(const char* name) {
+    if (!is_initialized) {
+        return INVALID_ID;
+    }
+    kname id = kname_intern(name);
+    for (u32 i = 0; i < state->scope_count; ++i) {
+        if (state->scopes[i].name == id) {
+            return i;
+        }
+    }
+    if (state->scope_count == PROFILER_MAX_SCOPES) {
+        KWARN("profiler_scope_register: no room for scope '%s', the limit is %u.", name, PROFILER_MAX_SCOPES);
+        return INVALID_ID;
+    }
+    profiler_scope* scope = &state->scopes[state->scope_count];
+    kzero_memory(scope, sizeof(profiler_scope));
+    scope->name = id;
+    scope->stats.name = kname_string(id);
+    return state->scope_count++;
+}
+
+void profiler_record(u32 scope, f64 seconds) {
+    if (!is_initialized || scope >= state->scope_count) {
+        return;
+    }
+    u64 nanoseconds = seconds > 0 ? (u64)(seconds * 1000000000.0) : 0;
+    __atomic_add_fetch(&state->scopes[scope].frame_nanoseconds, nanoseconds, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&state->scopes[scope].frame_samples, 1, __ATOMIC_RELAXED);
+}
+
+u32 profiler_scope_count() {
+    return is_initialized ? state->scope_count : 0;
+}
+
+b8 profiler_scope_get(u32 scope, profiler_scope_stats* out_stats) {
+    if (!is_initialized || scope >= state->scope_count) {
+        return FALSE;
+    }
+    *out_stats = state->scopes[scope].stats;
+    return TRUE;
+}
+
+u32 profiler_frame_history(f32* out_ms, u32 max_count) {
+    if (!is_initialized) {
+        return 0;
+    }
+    u32 count = state->frame_count < max_count ? state->frame_count : max_count;
+    // The newest count entries, ending just before frame_head.
+    u32 start = (state->frame_head + PROFILER_FRAME_HISTORY - count) % PROFILER_FRAME_HISTORY;
+    for (u32 i = 0; i < count; ++i) {
+        out_ms[i] = state->frame_ms[(start + i) % PROFILER_FRAME_HISTORY];
+    }
+    return count;
+}
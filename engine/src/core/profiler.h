@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Collects how long named scopes of work take each frame. Samples may be
+recorded from any thread; at the end of each frame they are summed per
+scope, and the frame's duration is kept in a short history, e.g. for
+drawing a frame time graph.
+*/
+
+// The most scopes which can be registered.
+#define PROFILER_MAX_SCOPES 128
+// The number of frame durations kept.
+#define PROFILER_FRAME_HISTORY 128
+
+typedef struct profiler_scope_stats {
+    const char* name;
+    // Time spent in the scope during the last frame, summed over every sample.
+    f64 last_ms;
+    // A running average of last_ms.
+    f64 average_ms;
+    // The number of samples recorded during the last frame.
+    u32 sample_count;
+} profiler_scope_stats;
+
+b8 profiler_initialize();
+void profiler_shutdown();
+
+/**
+ * Closes the current frame, publishing its samples and duration, and starts
+ * the next. Called once per frame by the application.
+ * @param frame_seconds How long the frame took.
+ */
+void profiler_frame_end(f64 frame_seconds);
+
+/**
+ * Registers a scope, or finds the one already registered under the name.
+ * Main thread only.
+ * @returns The scope's ID, or INVALID_ID if no more can be registered.
+ */
+KAPI u32 profiler_scope_register(const char* name);
+
+/**
+ * Adds a sample to a scope for the current frame. Safe to call from any thread.
+ * @param seconds How long the sample took, e.g. the difference of two clock_get_current_time calls.
+ */
+KAPI void profiler_record(u32 scope, f64 seconds);
+
+KAPI u32 profiler_scope_count();
+
+// Gets the stats of a scope as of the last frame_end. Returns FALSE for an unknown scope.
+KAPI b8 profiler_scope_get(u32 scope, profiler_scope_stats* out_stats);
+
+/**
+ * Copies the most recent frame durations, oldest first.
+ * @param out_ms Filled with up to max_count durations, in milliseconds.
+ * @returns The number copied.
+ */
+KAPI u32 profiler_frame_history(f32* out_ms, u32 max_count);
@@ -0,0 +1,460 @@
+#include "kmath.h"
+
+#include <math.h>
+
+#if KMATH_AVX_DISPATCH
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+f32 ksin(f32 x) {
+    return sinf(x);
+}
+
+f32 kcos(f32 x) {
+    return cosf(x);
+}
+
+f32 ktan(f32 x) {
+    return tanf(x);
+}
+
+f32 kacos(f32 x) {
+    return acosf(x);
+}
+
+f32 ksqrt(f32 x) {
+    return sqrtf(x);
+}
+
+f32 kabs(f32 x) {
+    return fabsf(x);
+}
+
+mat4 mat4_inverse(mat4 m) {
+    const f32* a = m.data;
+    mat4 out;
+    f32* o = out.data;
+
+    // Cofactors, via the 2x2 determinants of the top and bottom row pairs.
+    f32 s0 = a[0] * a[5] - a[1] * a[4];
+    f32 s1 = a[0] * a[6] - a[2] * a[4];
+    f32 s2 = a[0] * a[7] - a[3] * a[4];
+    f32 s3 = a[1] * a[6] - a[2] * a[5];
+    f32 s4 = a[1] * a[7] - a[3] * a[5];
+    f32 s5 = a[2] * a[7] - a[3] * a[6];
+    f32 c5 = a[10] * a[15] - a[11] * a[14];
+    f32 c4 = a[9] * a[15] - a[11] * a[13];
+    f32 c3 = a[9] * a[14] - a[10] * a[13];
+    f32 c2 = a[8] * a[15] - a[11] * a[12];
+    f32 c1 = a[8] * a[14] - a[10] * a[12];
+    f32 c0 = a[8] * a[13] - a[9] * a[12];
+
+    f32 determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (kabs(determinant) < K_FLOAT_EPSILON * K_FLOAT_EPSILON) {
+        return mat4_identity();
+    }
+    f32 inv = 1.0f / determinant;
+
+    o[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * inv;
+    o[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * inv;
+    o[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * inv;
+    o[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * inv;
+    o[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * inv;
+    o[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * inv;
+    o[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * inv;
+    o[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * inv;
+    o[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * inv;
+    o[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * inv;
+    o[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * inv;
+    o[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * inv;
+    o[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * inv;
+    o[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * inv;
+    o[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * inv;
+    o[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * inv;
+    return out;
+}
+
+quat quat_slerp(quat a, quat b, f32 t) {
+    f32 cos_theta = quat_dot(a, b);
+    // q and -q are the same rotation; negating one of them takes the shorter arc.
+    if (cos_theta < 0.0f) {
+        b = vec4_mul_scalar(b, -1.0f);
+        cos_theta = -cos_theta;
+    }
+
+    // Nearly parallel, where sin(theta) would vanish. A normalized lerp is as good here.
+    if (cos_theta > 0.9995f) {
+        return quat_normalized(vec4_add(a, vec4_mul_scalar(vec4_sub(b, a), t)));
+    }
+
+    f32 theta = kacos(cos_theta);
+    f32 sin_theta = ksin(theta);
+    f32 weight_a = ksin((1.0f - t) * theta) / sin_theta;
+    f32 weight_b = ksin(t * theta) / sin_theta;
+    return vec4_add(vec4_mul_scalar(a, weight_a), vec4_mul_scalar(b, weight_b));
+}
+
+#if KMATH_AVX_DISPATCH
+// Whether the CPU has AVX and the OS saves the YMM registers, so AVX code may run. Checked once.
+static b8 cpu_has_avx() {
+    static i32 has_avx = -1;
+    if (has_avx < 0) {
+        u32 a, b, c, d;
+        has_avx = 0;
+        if (__get_cpuid(1, &a, &b, &c, &d) && (c & bit_AVX) && (c & bit_OSXSAVE)) {
+            u32 xcr0_low, xcr0_high;
+            __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+            // XMM and YMM state.
+            has_avx = (xcr0_low & 0x6) == 0x6;
+        }
+    }
+    return has_avx;
+}
+#endif
+
+const char* kmath_simd_path() {
+#if KMATH_AVX
+    return "avx";
+#elif KMATH_AVX_DISPATCH
+    return cpu_has_avx() ? "sse+avx" : "sse";
+#elif KMATH_SSE
+    return "sse";
+#elif KMATH_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+frustum frustum_from_matrix(mat4 view_projection) {
+    // Row vectors are transformed, so clip coordinates are dot products with the columns.
+    const f32* m = view_projection.data;
+    vec4 x = vec4_create(m[0], m[4], m[8], m[12]);
+    vec4 y = vec4_create(m[1], m[5], m[9], m[13]);
+    vec4 z = vec4_create(m[2], m[6], m[10], m[14]);
+    vec4 w = vec4_create(m[3], m[7], m[11], m[15]);
+
+    frustum out;
+    out.planes[0] = vec4_add(w, x);
+    out.planes[1] = vec4_sub(w, x);
+    out.planes[2] = vec4_add(w, y);
+    out.planes[3] = vec4_sub(w, y);
+    out.planes[4] = vec4_add(w, z);
+    out.planes[5] = vec4_sub(w, z);
+    for (u32 i = 0; i < 6; ++i) {
+        vec4* p = &out.planes[i];
+        f32 length = ksqrt(p->x * p->x + p->y * p->y + p->z * p->z);
+        if (length > K_FLOAT_EPSILON) {
+            *p = vec4_mul_scalar(*p, 1.0f / length);
+        }
+    }
+    return out;
+}
+
+// ------------------------------------------
+// Scalar batches
+// ------------------------------------------
+
+void mat4_mul_batch_scalar(const mat4* a, const mat4* b, mat4* out, u32 count) {
+    for (u32 n = 0; n < count; ++n) {
+        const f32* l = a[n].data;
+        const f32* r = b[n].data;
+        f32 result[16];
+        for (u32 i = 0; i < 4; ++i) {
+            for (u32 j = 0; j < 4; ++j) {
+                result[i * 4 + j] = l[i * 4 + 0] * r[0 + j] +
+                                    l[i * 4 + 1] * r[4 + j] +
+                                    l[i * 4 + 2] * r[8 + j] +
+                                    l[i * 4 + 3] * r[12 + j];
+            }
+        }
+        for (u32 i = 0; i < 16; ++i) {
+            out[n].data[i] = result[i];
+        }
+    }
+}
+
+void mat4_transform_vec4_batch_scalar(const mat4* m, const vec4* in, vec4* out, u32 count) {
+    const f32* d = m->data;
+    for (u32 n = 0; n < count; ++n) {
+        f32 x = in[n].x, y = in[n].y, z = in[n].z, w = in[n].w;
+        for (u32 j = 0; j < 4; ++j) {
+            out[n].elements[j] = x * d[j] + y * d[4 + j] + z * d[8 + j] + w * d[12 + j];
+        }
+    }
+}
+
+void mat4_transform_point_batch_scalar(const mat4* m, const vec3* points, vec3* out, u32 count) {
+    const f32* d = m->data;
+    for (u32 n = 0; n < count; ++n) {
+        f32 x = points[n].x, y = points[n].y, z = points[n].z;
+        for (u32 j = 0; j < 3; ++j) {
+            out[n].elements[j] = x * d[j] + y * d[4 + j] + z * d[8 + j] + d[12 + j];
+        }
+    }
+}
+
+u32 frustum_cull_spheres_scalar(const frustum* f, const f32* xs, const f32* ys, const f32* zs, const f32* radii, u32 count, u32 base, u32* out_indices) {
+    u32 visible = 0;
+    for (u32 n = 0; n < count; ++n) {
+        b8 inside = TRUE;
+        for (u32 i = 0; i < 6 && inside; ++i) {
+            const vec4* p = &f->planes[i];
+            inside = p->x * xs[n] + p->y * ys[n] + p->z * zs[n] + p->w >= -radii[n];
+        }
+        if (inside) {
+            out_indices[visible++] = base + n;
+        }
+    }
+    return visible;
+}
+
+// ------------------------------------------
+// Vector batches
+// ------------------------------------------
+
+// The kernels below work on the arrays directly rather than through the
+// by-value inline functions, so each matrix is loaded once and never copied.
+// Every row of a result is computed before any is stored, as out may alias.
+// Arrays are only 16-byte aligned, so 256-bit accesses are unaligned ones.
+
+void mat4_mul_batch(const mat4* a, const mat4* b, mat4* out, u32 count) {
+#if KMATH_AVX
+    for (u32 n = 0; n < count; ++n) {
+        __m256 b0 = _mm256_broadcast_ps(&b[n].rows[0].data);
+        __m256 b1 = _mm256_broadcast_ps(&b[n].rows[1].data);
+        __m256 b2 = _mm256_broadcast_ps(&b[n].rows[2].data);
+        __m256 b3 = _mm256_broadcast_ps(&b[n].rows[3].data);
+        __m256 rows01 = _mm256_loadu_ps(&a[n].data[0]);
+        __m256 rows23 = _mm256_loadu_ps(&a[n].data[8]);
+        __m256 r01 = _mm256_mul_ps(_mm256_permute_ps(rows01, 0x00), b0);
+        __m256 r23 = _mm256_mul_ps(_mm256_permute_ps(rows23, 0x00), b0);
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(rows01, 0x55), b1));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(rows23, 0x55), b1));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(rows01, 0xAA), b2));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(rows23, 0xAA), b2));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(rows01, 0xFF), b3));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(rows23, 0xFF), b3));
+        _mm256_storeu_ps(&out[n].data[0], r01);
+        _mm256_storeu_ps(&out[n].data[8], r23);
+    }
+#elif KMATH_SSE
+    for (u32 n = 0; n < count; ++n) {
+        __m128 b0 = b[n].rows[0].data;
+        __m128 b1 = b[n].rows[1].data;
+        __m128 b2 = b[n].rows[2].data;
+        __m128 b3 = b[n].rows[3].data;
+        const f32* l = a[n].data;
+        __m128 r[4];
+        for (u32 i = 0; i < 4; ++i) {
+            __m128 row = _mm_load_ps(&l[i * 4]);
+            __m128 v = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+            r[i] = _mm_add_ps(v, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+        }
+        for (u32 i = 0; i < 4; ++i) {
+            out[n].rows[i].data = r[i];
+        }
+    }
+#elif KMATH_NEON
+    for (u32 n = 0; n < count; ++n) {
+        float32x4_t b0 = b[n].rows[0].data;
+        float32x4_t b1 = b[n].rows[1].data;
+        float32x4_t b2 = b[n].rows[2].data;
+        float32x4_t b3 = b[n].rows[3].data;
+        float32x4_t r[4];
+        for (u32 i = 0; i < 4; ++i) {
+            float32x4_t row = a[n].rows[i].data;
+            float32x4_t v = vmulq_laneq_f32(b0, row, 0);
+            v = vfmaq_laneq_f32(v, b1, row, 1);
+            v = vfmaq_laneq_f32(v, b2, row, 2);
+            r[i] = vfmaq_laneq_f32(v, b3, row, 3);
+        }
+        for (u32 i = 0; i < 4; ++i) {
+            out[n].rows[i].data = r[i];
+        }
+    }
+#else
+    mat4_mul_batch_scalar(a, b, out, count);
+#endif
+}
+
+void mat4_transform_vec4_batch(const mat4* m, const vec4* in, vec4* out, u32 count) {
+    u32 n = 0;
+#if KMATH_AVX
+    // Two vectors at a time, one per 128-bit lane.
+    __m256 r0 = _mm256_broadcast_ps(&m->rows[0].data);
+    __m256 r1 = _mm256_broadcast_ps(&m->rows[1].data);
+    __m256 r2 = _mm256_broadcast_ps(&m->rows[2].data);
+    __m256 r3 = _mm256_broadcast_ps(&m->rows[3].data);
+    for (; n + 2 <= count; n += 2) {
+        __m256 v = _mm256_loadu_ps(in[n].elements);
+        __m256 r = _mm256_mul_ps(_mm256_permute_ps(v, 0x00), r0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(v, 0x55), r1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(v, 0xAA), r2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(v, 0xFF), r3));
+        _mm256_storeu_ps(out[n].elements, r);
+    }
+#endif
+#if KMATH_SSE
+    __m128 s0 = m->rows[0].data;
+    __m128 s1 = m->rows[1].data;
+    __m128 s2 = m->rows[2].data;
+    __m128 s3 = m->rows[3].data;
+    for (; n < count; ++n) {
+        __m128 v = in[n].data;
+        __m128 r = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), s0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), s1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), s2));
+        out[n].data = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), s3));
+    }
+#elif KMATH_NEON
+    float32x4_t s0 = m->rows[0].data;
+    float32x4_t s1 = m->rows[1].data;
+    float32x4_t s2 = m->rows[2].data;
+    float32x4_t s3 = m->rows[3].data;
+    for (; n < count; ++n) {
+        float32x4_t v = in[n].data;
+        float32x4_t r = vmulq_laneq_f32(s0, v, 0);
+        r = vfmaq_laneq_f32(r, s1, v, 1);
+        r = vfmaq_laneq_f32(r, s2, v, 2);
+        out[n].data = vfmaq_laneq_f32(r, s3, v, 3);
+    }
+#else
+    mat4_transform_vec4_batch_scalar(m, in + n, out + n, count - n);
+#endif
+}
+
+void mat4_transform_point_batch(const mat4* m, const vec3* points, vec3* out, u32 count) {
+#if KMATH_SSE
+    __m128 r0 = m->rows[0].data;
+    __m128 r1 = m->rows[1].data;
+    __m128 r2 = m->rows[2].data;
+    __m128 r3 = m->rows[3].data;
+    for (u32 n = 0; n < count; ++n) {
+        __m128 r = _mm_add_ps(r3, _mm_mul_ps(_mm_set1_ps(points[n].x), r0));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(points[n].y), r1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(points[n].z), r2));
+        // vec3s are packed, so store exactly 12 bytes.
+        _mm_storel_pi((__m64*)out[n].elements, r);
+        _mm_store_ss(&out[n].z, _mm_movehl_ps(r, r));
+    }
+#elif KMATH_NEON
+    float32x4_t r0 = m->rows[0].data;
+    float32x4_t r1 = m->rows[1].data;
+    float32x4_t r2 = m->rows[2].data;
+    float32x4_t r3 = m->rows[3].data;
+    for (u32 n = 0; n < count; ++n) {
+        float32x4_t r = vmlaq_n_f32(r3, r0, points[n].x);
+        r = vmlaq_n_f32(r, r1, points[n].y);
+        r = vmlaq_n_f32(r, r2, points[n].z);
+        vst1_f32(out[n].elements, vget_low_f32(r));
+        out[n].z = vgetq_lane_f32(r, 2);
+    }
+#else
+    mat4_transform_point_batch_scalar(m, points, out, count);
+#endif
+}
+
+// A sphere is culled once it is wholly behind any plane: dot(normal, center) + distance < -radius.
+#if KMATH_AVX || KMATH_AVX_DISPATCH
+// 8 spheres at a time. Stops at the last full 8, returning how many it tested in out_tested.
+#if KMATH_AVX_DISPATCH
+__attribute__((target("avx")))
+#endif
+static u32 frustum_cull_spheres_avx(const frustum* f, const f32* xs, const f32* ys, const f32* zs, const f32* radii, u32 count, u32 base, u32* out_indices, u32* out_tested) {
+    u32 n = 0;
+    u32 visible = 0;
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (u32 i = 0; i < 6; ++i) {
+        px[i] = _mm256_set1_ps(f->planes[i].x);
+        py[i] = _mm256_set1_ps(f->planes[i].y);
+        pz[i] = _mm256_set1_ps(f->planes[i].z);
+        pw[i] = _mm256_set1_ps(f->planes[i].w);
+    }
+    for (; n + 8 <= count; n += 8) {
+        __m256 x = _mm256_loadu_ps(xs + n);
+        __m256 y = _mm256_loadu_ps(ys + n);
+        __m256 z = _mm256_loadu_ps(zs + n);
+        __m256 negative_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radii + n));
+        __m256 keep = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (u32 i = 0; i < 6; ++i) {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(x, px[i]), pw[i]);
+            d = _mm256_add_ps(d, _mm256_mul_ps(y, py[i]));
+            d = _mm256_add_ps(d, _mm256_mul_ps(z, pz[i]));
+            keep = _mm256_and_ps(keep, _mm256_cmp_ps(d, negative_radius, _CMP_GE_OQ));
+        }
+        // Append the survivors' indices, lowest first.
+        u32 mask = (u32)_mm256_movemask_ps(keep);
+        while (mask) {
+            out_indices[visible++] = base + n + (u32)__builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    *out_tested = n;
+    return visible;
+}
+#endif
+
+u32 frustum_cull_spheres(const frustum* f, const f32* xs, const f32* ys, const f32* zs, const f32* radii, u32 count, u32 base, u32* out_indices) {
+    u32 n = 0;
+    u32 visible = 0;
+#if KMATH_AVX
+    visible = frustum_cull_spheres_avx(f, xs, ys, zs, radii, count, base, out_indices, &n);
+#elif KMATH_AVX_DISPATCH
+    if (cpu_has_avx()) {
+        visible = frustum_cull_spheres_avx(f, xs, ys, zs, radii, count, base, out_indices, &n);
+    }
+#endif
+#if KMATH_SSE
+    __m128 sx[6], sy[6], sz[6], sw[6];
+    for (u32 i = 0; i < 6; ++i) {
+        sx[i] = _mm_set1_ps(f->planes[i].x);
+        sy[i] = _mm_set1_ps(f->planes[i].y);
+        sz[i] = _mm_set1_ps(f->planes[i].z);
+        sw[i] = _mm_set1_ps(f->planes[i].w);
+    }
+    for (; n + 4 <= count; n += 4) {
+        __m128 x = _mm_loadu_ps(xs + n);
+        __m128 y = _mm_loadu_ps(ys + n);
+        __m128 z = _mm_loadu_ps(zs + n);
+        __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radii + n));
+        __m128 keep = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (u32 i = 0; i < 6; ++i) {
+            __m128 d = _mm_add_ps(_mm_mul_ps(x, sx[i]), sw[i]);
+            d = _mm_add_ps(d, _mm_mul_ps(y, sy[i]));
+            d = _mm_add_ps(d, _mm_mul_ps(z, sz[i]));
+            keep = _mm_and_ps(keep, _mm_cmpge_ps(d, negative_radius));
+        }
+        u32 mask = (u32)_mm_movemask_ps(keep);
+        while (mask) {
+            out_indices[visible++] = base + n + (u32)__builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+#elif KMATH_NEON
+    for (; n + 4 <= count; n += 4) {
+        float32x4_t x = vld1q_f32(xs + n);
+        float32x4_t y = vld1q_f32(ys + n);
+        float32x4_t z = vld1q_f32(zs + n);
+        float32x4_t negative_radius = vnegq_f32(vld1q_f32(radii + n));
+        uint32x4_t keep = vdupq_n_u32(0xFFFFFFFF);
+        for (u32 i = 0; i < 6; ++i) {
+            float32x4_t d = vfmaq_n_f32(vdupq_n_f32(f->planes[i].w), x, f->planes[i].x);
+            d = vfmaq_n_f32(d, y, f->planes[i].y);
+            d = vfmaq_n_f32(d, z, f->planes[i].z);
+            keep = vandq_u32(keep, vcgeq_f32(d, negative_radius));
+        }
+        u32 lanes[4];
+        vst1q_u32(lanes, keep);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            if (lanes[lane]) {
+                out_indices[visible++] = base + n + lane;
+            }
+        }
+    }
+#endif
+    return visible + frustum_cull_spheres_scalar(f, xs + n, ys + n, zs + n, radii + n, count - n, base + n, out_indices + visible);
+}
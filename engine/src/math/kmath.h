@@ -0,0 +1,596 @@
+#pragma once
+
+#include "math_types.h"
+
+#define K_PI 3.14159265358979323846f
+#define K_2PI (2.0f * K_PI)
+#define K_HALF_PI (0.5f * K_PI)
+#define K_DEG2RAD_MULTIPLIER (K_PI / 180.0f)
+#define K_RAD2DEG_MULTIPLIER (180.0f / K_PI)
+#define K_FLOAT_EPSILON 1.192092896e-07f
+#define K_INFINITY (1e30f * 1e30f)
+
+// ------------------------------------------
+// Scalar
+// ------------------------------------------
+
+KAPI f32 ksin(f32 x);
+KAPI f32 kcos(f32 x);
+KAPI f32 ktan(f32 x);
+KAPI f32 kacos(f32 x);
+KAPI f32 ksqrt(f32 x);
+KAPI f32 kabs(f32 x);
+
+KINLINE f32 deg_to_rad(f32 degrees) {
+    return degrees * K_DEG2RAD_MULTIPLIER;
+}
+
+KINLINE f32 rad_to_deg(f32 radians) {
+    return radians * K_RAD2DEG_MULTIPLIER;
+}
+
+KINLINE f32 kmin(f32 a, f32 b) {
+    return a < b ? a : b;
+}
+
+KINLINE f32 kmax(f32 a, f32 b) {
+    return a > b ? a : b;
+}
+
+KINLINE f32 klerp(f32 a, f32 b, f32 t) {
+    return a + (b - a) * t;
+}
+
+// ------------------------------------------
+// Vector 2
+// ------------------------------------------
+
+KINLINE vec2 vec2_create(f32 x, f32 y) {
+    return (vec2){{x, y}};
+}
+
+KINLINE vec2 vec2_zero() {
+    return (vec2){{0.0f, 0.0f}};
+}
+
+KINLINE vec2 vec2_add(vec2 a, vec2 b) {
+    return (vec2){{a.x + b.x, a.y + b.y}};
+}
+
+KINLINE vec2 vec2_sub(vec2 a, vec2 b) {
+    return (vec2){{a.x - b.x, a.y - b.y}};
+}
+
+KINLINE vec2 vec2_mul_scalar(vec2 v, f32 scalar) {
+    return (vec2){{v.x * scalar, v.y * scalar}};
+}
+
+KINLINE f32 vec2_dot(vec2 a, vec2 b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+KINLINE f32 vec2_length_squared(vec2 v) {
+    return v.x * v.x + v.y * v.y;
+}
+
+KINLINE f32 vec2_length(vec2 v) {
+    return ksqrt(vec2_length_squared(v));
+}
+
+KINLINE vec2 vec2_normalized(vec2 v) {
+    f32 length = vec2_length(v);
+    return length > 0.0f ? vec2_mul_scalar(v, 1.0f / length) : v;
+}
+
+// ------------------------------------------
+// Vector 3
+// ------------------------------------------
+
+KINLINE vec3 vec3_create(f32 x, f32 y, f32 z) {
+    return (vec3){{x, y, z}};
+}
+
+KINLINE vec3 vec3_zero() {
+    return (vec3){{0.0f, 0.0f, 0.0f}};
+}
+
+KINLINE vec3 vec3_one() {
+    return (vec3){{1.0f, 1.0f, 1.0f}};
+}
+
+KINLINE vec3 vec3_up() {
+    return (vec3){{0.0f, 1.0f, 0.0f}};
+}
+
+KINLINE vec3 vec3_add(vec3 a, vec3 b) {
+    return (vec3){{a.x + b.x, a.y + b.y, a.z + b.z}};
+}
+
+KINLINE vec3 vec3_sub(vec3 a, vec3 b) {
+    return (vec3){{a.x - b.x, a.y - b.y, a.z - b.z}};
+}
+
+// Component-wise.
+KINLINE vec3 vec3_mul(vec3 a, vec3 b) {
+    return (vec3){{a.x * b.x, a.y * b.y, a.z * b.z}};
+}
+
+KINLINE vec3 vec3_mul_scalar(vec3 v, f32 scalar) {
+    return (vec3){{v.x * scalar, v.y * scalar, v.z * scalar}};
+}
+
+KINLINE vec3 vec3_min(vec3 a, vec3 b) {
+    return (vec3){{kmin(a.x, b.x), kmin(a.y, b.y), kmin(a.z, b.z)}};
+}
+
+KINLINE vec3 vec3_max(vec3 a, vec3 b) {
+    return (vec3){{kmax(a.x, b.x), kmax(a.y, b.y), kmax(a.z, b.z)}};
+}
+
+KINLINE f32 vec3_dot(vec3 a, vec3 b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+KINLINE vec3 vec3_cross(vec3 a, vec3 b) {
+    return (vec3){{a.y * b.z - a.z * b.y,
+                   a.z * b.x - a.x * b.z,
+                   a.x * b.y - a.y * b.x}};
+}
+
+KINLINE f32 vec3_length_squared(vec3 v) {
+    return vec3_dot(v, v);
+}
+
+KINLINE f32 vec3_length(vec3 v) {
+    return ksqrt(vec3_length_squared(v));
+}
+
+KINLINE vec3 vec3_normalized(vec3 v) {
+    f32 length = vec3_length(v);
+    return length > 0.0f ? vec3_mul_scalar(v, 1.0f / length) : v;
+}
+
+KINLINE f32 vec3_distance(vec3 a, vec3 b) {
+    return vec3_length(vec3_sub(a, b));
+}
+
+KINLINE vec3 vec3_lerp(vec3 a, vec3 b, f32 t) {
+    return (vec3){{klerp(a.x, b.x, t), klerp(a.y, b.y, t), klerp(a.z, b.z, t)}};
+}
+
+// ------------------------------------------
+// Vector 4
+// ------------------------------------------
+
+KINLINE vec4 vec4_create(f32 x, f32 y, f32 z, f32 w) {
+    vec4 out;
+#if KMATH_SSE
+    out.data = _mm_setr_ps(x, y, z, w);
+#else
+    out.x = x;
+    out.y = y;
+    out.z = z;
+    out.w = w;
+#endif
+    return out;
+}
+
+KINLINE vec4 vec4_zero() {
+    return vec4_create(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+KINLINE vec4 vec4_from_vec3(vec3 v, f32 w) {
+    return vec4_create(v.x, v.y, v.z, w);
+}
+
+KINLINE vec3 vec4_to_vec3(vec4 v) {
+    return (vec3){{v.x, v.y, v.z}};
+}
+
+KINLINE vec4 vec4_add(vec4 a, vec4 b) {
+    vec4 out;
+#if KMATH_SSE
+    out.data = _mm_add_ps(a.data, b.data);
+#elif KMATH_NEON
+    out.data = vaddq_f32(a.data, b.data);
+#else
+    for (u32 i = 0; i < 4; ++i) {
+        out.elements[i] = a.elements[i] + b.elements[i];
+    }
+#endif
+    return out;
+}
+
+KINLINE vec4 vec4_sub(vec4 a, vec4 b) {
+    vec4 out;
+#if KMATH_SSE
+    out.data = _mm_sub_ps(a.data, b.data);
+#elif KMATH_NEON
+    out.data = vsubq_f32(a.data, b.data);
+#else
+    for (u32 i = 0; i < 4; ++i) {
+        out.elements[i] = a.elements[i] - b.elements[i];
+    }
+#endif
+    return out;
+}
+
+// Component-wise.
+KINLINE vec4 vec4_mul(vec4 a, vec4 b) {
+    vec4 out;
+#if KMATH_SSE
+    out.data = _mm_mul_ps(a.data, b.data);
+#elif KMATH_NEON
+    out.data = vmulq_f32(a.data, b.data);
+#else
+    for (u32 i = 0; i < 4; ++i) {
+        out.elements[i] = a.elements[i] * b.elements[i];
+    }
+#endif
+    return out;
+}
+
+KINLINE vec4 vec4_mul_scalar(vec4 v, f32 scalar) {
+    vec4 out;
+#if KMATH_SSE
+    out.data = _mm_mul_ps(v.data, _mm_set1_ps(scalar));
+#elif KMATH_NEON
+    out.data = vmulq_n_f32(v.data, scalar);
+#else
+    for (u32 i = 0; i < 4; ++i) {
+        out.elements[i] = v.elements[i] * scalar;
+    }
+#endif
+    return out;
+}
+
+KINLINE f32 vec4_dot(vec4 a, vec4 b) {
+#if KMATH_SSE
+    __m128 m = _mm_mul_ps(a.data, b.data);
+    __m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    return _mm_cvtss_f32(s);
+#elif KMATH_NEON
+    return vaddvq_f32(vmulq_f32(a.data, b.data));
+#else
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+#endif
+}
+
+KINLINE f32 vec4_length(vec4 v) {
+    return ksqrt(vec4_dot(v, v));
+}
+
+KINLINE vec4 vec4_normalized(vec4 v) {
+    f32 length = vec4_length(v);
+    return length > 0.0f ? vec4_mul_scalar(v, 1.0f / length) : v;
+}
+
+// ------------------------------------------
+// Matrix 4
+// ------------------------------------------
+
+KINLINE mat4 mat4_identity() {
+    mat4 out = {0};
+    out.data[0] = 1.0f;
+    out.data[5] = 1.0f;
+    out.data[10] = 1.0f;
+    out.data[15] = 1.0f;
+    return out;
+}
+
+// Transforms a row vector: v * m.
+KINLINE vec4 mat4_mul_vec4(mat4 m, vec4 v) {
+    vec4 out;
+#if KMATH_SSE
+    __m128 r = _mm_mul_ps(_mm_set1_ps(v.x), m.rows[0].data);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.y), m.rows[1].data));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.z), m.rows[2].data));
+    out.data = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.w), m.rows[3].data));
+#elif KMATH_NEON
+    float32x4_t r = vmulq_n_f32(m.rows[0].data, v.x);
+    r = vmlaq_n_f32(r, m.rows[1].data, v.y);
+    r = vmlaq_n_f32(r, m.rows[2].data, v.z);
+    out.data = vmlaq_n_f32(r, m.rows[3].data, v.w);
+#else
+    for (u32 j = 0; j < 4; ++j) {
+        out.elements[j] = v.x * m.data[j] + v.y * m.data[4 + j] + v.z * m.data[8 + j] + v.w * m.data[12 + j];
+    }
+#endif
+    return out;
+}
+
+// Transforms a point, with w taken as 1. No perspective divide is done.
+KINLINE vec3 mat4_mul_point(mat4 m, vec3 p) {
+    return vec4_to_vec3(mat4_mul_vec4(m, vec4_from_vec3(p, 1.0f)));
+}
+
+// Transforms a direction, with w taken as 0, so translation is ignored.
+KINLINE vec3 mat4_mul_direction(mat4 m, vec3 d) {
+    return vec4_to_vec3(mat4_mul_vec4(m, vec4_from_vec3(d, 0.0f)));
+}
+
+// a * b, which applies a first, then b.
+KINLINE mat4 mat4_mul(mat4 a, mat4 b) {
+    mat4 out;
+#if KMATH_AVX
+    // Two rows at a time. Each 128-bit lane holds one row of a, and the
+    // in-lane permutes broadcast its elements.
+    __m256 b0 = _mm256_broadcast_ps(&b.rows[0].data);
+    __m256 b1 = _mm256_broadcast_ps(&b.rows[1].data);
+    __m256 b2 = _mm256_broadcast_ps(&b.rows[2].data);
+    __m256 b3 = _mm256_broadcast_ps(&b.rows[3].data);
+    for (u32 i = 0; i < 16; i += 8) {
+        __m256 rows = _mm256_loadu_ps(&a.data[i]);
+        __m256 r = _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0x55), b1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0xAA), b2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0xFF), b3));
+        _mm256_storeu_ps(&out.data[i], r);
+    }
+#else
+    for (u32 i = 0; i < 4; ++i) {
+        out.rows[i] = mat4_mul_vec4(b, a.rows[i]);
+    }
+#endif
+    return out;
+}
+
+KINLINE mat4 mat4_transposed(mat4 m) {
+    mat4 out;
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 j = 0; j < 4; ++j) {
+            out.data[i * 4 + j] = m.data[j * 4 + i];
+        }
+    }
+    return out;
+}
+
+KINLINE mat4 mat4_translation(vec3 position) {
+    mat4 out = mat4_identity();
+    out.data[12] = position.x;
+    out.data[13] = position.y;
+    out.data[14] = position.z;
+    return out;
+}
+
+KINLINE mat4 mat4_scale(vec3 scale) {
+    mat4 out = mat4_identity();
+    out.data[0] = scale.x;
+    out.data[5] = scale.y;
+    out.data[10] = scale.z;
+    return out;
+}
+
+KINLINE mat4 mat4_orthographic(f32 left, f32 right, f32 bottom, f32 top, f32 near_clip, f32 far_clip) {
+    mat4 out = mat4_identity();
+    f32 lr = 1.0f / (left - right);
+    f32 bt = 1.0f / (bottom - top);
+    f32 nf = 1.0f / (near_clip - far_clip);
+    out.data[0] = -2.0f * lr;
+    out.data[5] = -2.0f * bt;
+    out.data[10] = 2.0f * nf;
+    out.data[12] = (left + right) * lr;
+    out.data[13] = (top + bottom) * bt;
+    out.data[14] = (far_clip + near_clip) * nf;
+    return out;
+}
+
+KINLINE mat4 mat4_perspective(f32 fov_radians, f32 aspect_ratio, f32 near_clip, f32 far_clip) {
+    f32 half_tan_fov = ktan(fov_radians * 0.5f);
+    mat4 out = {0};
+    out.data[0] = 1.0f / (aspect_ratio * half_tan_fov);
+    out.data[5] = 1.0f / half_tan_fov;
+    out.data[10] = -((far_clip + near_clip) / (far_clip - near_clip));
+    out.data[11] = -1.0f;
+    out.data[14] = -((2.0f * far_clip * near_clip) / (far_clip - near_clip));
+    return out;
+}
+
+KINLINE mat4 mat4_look_at(vec3 position, vec3 target, vec3 up) {
+    vec3 z_axis = vec3_normalized(vec3_sub(target, position));
+    vec3 x_axis = vec3_normalized(vec3_cross(z_axis, up));
+    vec3 y_axis = vec3_cross(x_axis, z_axis);
+
+    mat4 out;
+    out.data[0] = x_axis.x;
+    out.data[1] = y_axis.x;
+    out.data[2] = -z_axis.x;
+    out.data[3] = 0.0f;
+    out.data[4] = x_axis.y;
+    out.data[5] = y_axis.y;
+    out.data[6] = -z_axis.y;
+    out.data[7] = 0.0f;
+    out.data[8] = x_axis.z;
+    out.data[9] = y_axis.z;
+    out.data[10] = -z_axis.z;
+    out.data[11] = 0.0f;
+    out.data[12] = -vec3_dot(x_axis, position);
+    out.data[13] = -vec3_dot(y_axis, position);
+    out.data[14] = vec3_dot(z_axis, position);
+    out.data[15] = 1.0f;
+    return out;
+}
+
+// The general inverse. Returns identity if m is not invertible.
+KAPI mat4 mat4_inverse(mat4 m);
+
+// ------------------------------------------
+// Quaternion
+// ------------------------------------------
+
+KINLINE quat quat_identity() {
+    return vec4_create(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+KINLINE quat quat_normalized(quat q) {
+    return vec4_normalized(q);
+}
+
+KINLINE quat quat_conjugate(quat q) {
+    return vec4_create(-q.x, -q.y, -q.z, q.w);
+}
+
+KINLINE f32 quat_dot(quat a, quat b) {
+    return vec4_dot(a, b);
+}
+
+KINLINE quat quat_inverse(quat q) {
+    f32 length_squared = quat_dot(q, q);
+    return length_squared > 0.0f ? vec4_mul_scalar(quat_conjugate(q), 1.0f / length_squared) : q;
+}
+
+// Rotates by b, then by a.
+KINLINE quat quat_mul(quat a, quat b) {
+    return vec4_create(
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+// The axis must be normalized.
+KINLINE quat quat_from_axis_angle(vec3 axis, f32 angle_radians) {
+    f32 half_angle = 0.5f * angle_radians;
+    f32 s = ksin(half_angle);
+    return vec4_create(axis.x * s, axis.y * s, axis.z * s, kcos(half_angle));
+}
+
+KINLINE vec3 quat_rotate_vec3(quat q, vec3 v) {
+    vec3 u = {{q.x, q.y, q.z}};
+    vec3 t = vec3_mul_scalar(vec3_cross(u, v), 2.0f);
+    return vec3_add(vec3_add(v, vec3_mul_scalar(t, q.w)), vec3_cross(u, t));
+}
+
+// The rotation matrix of a normalized quaternion.
+KINLINE mat4 quat_to_mat4(quat q) {
+    f32 xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    f32 xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    f32 wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    mat4 out = mat4_identity();
+    out.data[0] = 1.0f - 2.0f * (yy + zz);
+    out.data[1] = 2.0f * (xy + wz);
+    out.data[2] = 2.0f * (xz - wy);
+    out.data[4] = 2.0f * (xy - wz);
+    out.data[5] = 1.0f - 2.0f * (xx + zz);
+    out.data[6] = 2.0f * (yz + wx);
+    out.data[8] = 2.0f * (xz + wy);
+    out.data[9] = 2.0f * (yz - wx);
+    out.data[10] = 1.0f - 2.0f * (xx + yy);
+    return out;
+}
+
+// Interpolates along the shorter arc.
+KAPI quat quat_slerp(quat a, quat b, f32 t);
+
+// Scales, then rotates, then translates.
+KINLINE mat4 mat4_from_trs(vec3 translation, quat rotation, vec3 scale) {
+    mat4 out = quat_to_mat4(rotation);
+    out.rows[0] = vec4_mul_scalar(out.rows[0], scale.x);
+    out.rows[1] = vec4_mul_scalar(out.rows[1], scale.y);
+    out.rows[2] = vec4_mul_scalar(out.rows[2], scale.z);
+    out.rows[3] = vec4_from_vec3(translation, 1.0f);
+    return out;
+}
+
+// ------------------------------------------
+// Bounds
+// ------------------------------------------
+
+KINLINE aabb aabb_union(aabb a, aabb b) {
+    return (aabb){vec3_min(a.min, b.min), vec3_max(a.max, b.max)};
+}
+
+KINLINE aabb aabb_expanded(aabb box, f32 margin) {
+    vec3 m = vec3_create(margin, margin, margin);
+    return (aabb){vec3_sub(box.min, m), vec3_add(box.max, m)};
+}
+
+// Whether outer contains inner entirely.
+KINLINE b8 aabb_contains(aabb outer, aabb inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+KINLINE b8 aabb_overlaps(aabb a, aabb b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+KINLINE f32 aabb_surface_area(aabb box) {
+    vec3 d = vec3_sub(box.max, box.min);
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+/**
+ * Intersects a ray with a box, using the reciprocal of its direction so
+ * axis-parallel rays need no special case.
+ * @param out_t Set to the distance along the ray at which it enters the box, or 0 if it starts inside.
+ * @returns TRUE if the ray enters the box within max_t.
+ */
+KINLINE b8 aabb_intersects_ray(aabb box, vec3 origin, vec3 inverse_direction, f32 max_t, f32* out_t) {
+    f32 t_min = 0.0f;
+    f32 t_max = max_t;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 t0 = (box.min.elements[axis] - origin.elements[axis]) * inverse_direction.elements[axis];
+        f32 t1 = (box.max.elements[axis] - origin.elements[axis]) * inverse_direction.elements[axis];
+        t_min = kmax(t_min, kmin(t0, t1));
+        t_max = kmin(t_max, kmax(t0, t1));
+    }
+    *out_t = t_min;
+    return t_min <= t_max;
+}
+
+/**
+ * Extracts the planes of a view-projection matrix, made with
+ * mat4_perspective or mat4_orthographic, so clip space depth is -w to w.
+ */
+KAPI frustum frustum_from_matrix(mat4 view_projection);
+
+// Whether any part of the box may be inside. Boxes near a corner may be kept when just outside.
+KINLINE b8 frustum_intersects_aabb(const frustum* f, aabb box) {
+    for (u32 i = 0; i < 6; ++i) {
+        const vec4* p = &f->planes[i];
+        // The corner furthest along the plane's normal.
+        f32 x = p->x >= 0 ? box.max.x : box.min.x;
+        f32 y = p->y >= 0 ? box.max.y : box.min.y;
+        f32 z = p->z >= 0 ? box.max.z : box.min.z;
+        if (p->x * x + p->y * y + p->z * z + p->w < 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// ------------------------------------------
+// Batches
+// ------------------------------------------
+
+// The path the batches take: "avx", "sse", "sse+avx" (SSE, with sphere culling on AVX), "neon" or "scalar".
+KAPI const char* kmath_simd_path();
+
+// out[i] = a[i] * b[i]. out may be a or b.
+KAPI void mat4_mul_batch(const mat4* a, const mat4* b, mat4* out, u32 count);
+
+// out[i] = in[i] * m. out may be in.
+KAPI void mat4_transform_vec4_batch(const mat4* m, const vec4* in, vec4* out, u32 count);
+
+// Transforms points, as mat4_mul_point does. out may be points.
+KAPI void mat4_transform_point_batch(const mat4* m, const vec3* points, vec3* out, u32 count);
+
+/**
+ * Tests bounding spheres, held as separate arrays of center coordinates and
+ * radii, against a frustum, 8 at a time with AVX or 4 with SSE or NEON.
+ * SSE builds use AVX here anyway when the CPU has it.
+ * @param base Added to the index of each sphere written out.
+ * @param out_indices Receives base + the index of each sphere which may be visible, in order. Room for count.
+ * @returns The number of indices written.
+ */
+KAPI u32 frustum_cull_spheres(const frustum* f, const f32* xs, const f32* ys, const f32* zs, const f32* radii, u32 count, u32 base, u32* out_indices);
+
+// The scalar fallbacks of the batches, built on every path for comparison.
+KAPI void mat4_mul_batch_scalar(const mat4* a, const mat4* b, mat4* out, u32 count);
+KAPI void mat4_transform_vec4_batch_scalar(const mat4* m, const vec4* in, vec4* out, u32 count);
+KAPI void mat4_transform_point_batch_scalar(const mat4* m, const vec3* points, vec3* out, u32 count);
+KAPI u32 frustum_cull_spheres_scalar(const frustum* f, const f32* xs, const f32* ys, const f32* zs, const f32* radii, u32 count, u32 base, u32* out_indices);
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+SIMD path selection, at compile time:
+- KMATH_SSE: x86-64, where SSE2 is always available.
+- KMATH_AVX: additionally, when the compiler targets AVX (e.g. -mavx).
+- KMATH_AVX_DISPATCH: SSE builds by GCC or Clang without -mavx, which the
+  build scripts produce. Sphere culling, the hottest batch, is also built
+  for AVX and picked at runtime when the CPU has it; the rest stays SSE.
+- KMATH_NEON: 64-bit ARM, e.g. Apple silicon.
+- None of these: the scalar fallback.
+Define KMATH_FORCE_SCALAR to build the scalar fallback anywhere. The types
+have the same size and alignment on every path.
+*/
+#if !defined(KMATH_FORCE_SCALAR)
+#if defined(__SSE2__) || defined(_M_X64)
+#define KMATH_SSE 1
+#if defined(__AVX__)
+#define KMATH_AVX 1
+#elif defined(__GNUC__) && defined(__x86_64__)
+#define KMATH_AVX_DISPATCH 1
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define KMATH_NEON 1
+#endif
+#endif
+
+#if KMATH_AVX
+#include <immintrin.h>
+#elif KMATH_SSE
+#include <emmintrin.h>
+#elif KMATH_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#define KMATH_ALIGN(n) __declspec(align(n))
+#else
+#define KMATH_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
+typedef union vec2_u {
+    f32 elements[2];
+    struct {
+        union {
+            f32 x, r, s, u;
+        };
+        union {
+            f32 y, g, t, v;
+        };
+    };
+} vec2;
+
+typedef union vec3_u {
+    f32 elements[3];
+    struct {
+        union {
+            f32 x, r, s, u;
+        };
+        union {
+            f32 y, g, t, v;
+        };
+        union {
+            f32 z, b, p, w;
+        };
+    };
+} vec3;
+
+typedef union KMATH_ALIGN(16) vec4_u {
+#if KMATH_SSE
+    __m128 data;
+#elif KMATH_NEON
+    float32x4_t data;
+#endif
+    f32 elements[4];
+    struct {
+        union {
+            f32 x, r, s;
+        };
+        union {
+            f32 y, g, t;
+        };
+        union {
+            f32 z, b, p;
+        };
+        union {
+            f32 w, a, q;
+        };
+    };
+} vec4;
+
+// A rotation, as x, y, z and w.
+typedef vec4 quat;
+
+/*
+Matrices are row-major and transform row vectors: a point p becomes p * M,
+and translation is in data[12], data[13] and data[14]. So mat4_mul(a, b)
+applies a first, then b.
+*/
+typedef union KMATH_ALIGN(16) mat4_u {
+    f32 data[16];
+    vec4 rows[4];
+} mat4;
+
+// An axis-aligned bounding box.
+typedef struct aabb {
+    vec3 min;
+    vec3 max;
+} aabb;
+
+/*
+Six planes, as (normal, distance) with normals pointing inwards: a point p
+is inside a plane when dot(normal, p) + distance >= 0. Ordered left, right,
+bottom, top, near, far.
+*/
+typedef struct frustum {
+    vec4 planes[6];
+} frustum;
+
+STATIC_ASSERT(sizeof(vec4) == 16, "Expected vec4 to be 16 bytes.");
+STATIC_ASSERT(sizeof(mat4) == 64, "Expected mat4 to be 64 bytes.");
@@ -0,0 +1,442 @@
+#include "async_io.h"
+
+#include "core/event.h"
+#include "core/kmemory.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+
+#include "async_io_uring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if KPLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// How many reads can be outstanding (queued, in flight or awaiting delivery) at once.
+#define ASYNC_IO_MAX_OUTSTANDING 4096
+// The io_uring submission queue depth. Reads beyond this wait in the queue.
+#define ASYNC_IO_URING_DEPTH 256
+// Worker threads used when io_uring is not available.
+#define ASYNC_IO_WORKER_COUNT 4
+// Completions delivered per batch while not holding the lock.
+#define ASYNC_IO_DELIVERY_BATCH 64
+
+typedef struct async_read_op {
+    u64 handle;
+    u64 offset;
+    u32 size;
+    void* buffer;
+    u64 user_data;
+    // Bytes already read by earlier, short, reads of this request. offset, size and buffer cover the rest.
+    u32 bytes_done;
+} async_read_op;
+
+typedef struct async_read_result {
+    u64 user_data;
+    u32 bytes_read;
+    i32 error;
+} async_read_result;
+
+// Fixed-capacity FIFOs. Never full, since the number of outstanding reads is capped.
+typedef struct op_queue {
+    async_read_op ops[ASYNC_IO_MAX_OUTSTANDING];
+    u32 head;
+    u32 count;
+} op_queue;
+
+typedef struct result_queue {
+    async_read_result results[ASYNC_IO_MAX_OUTSTANDING];
+    u32 head;
+    u32 count;
+} result_queue;
+
+typedef struct async_io_state {
+    // Reads submitted but not yet delivered. Only touched on the main thread.
+    u32 outstanding;
+    // Reads waiting for a free io_uring slot or a worker.
+    op_queue pending;
+
+#if KPLATFORM_LINUX
+    b8 use_uring;
+    async_uring ring;
+    // The in-flight reads, indexed by the io_uring user_data.
+    async_read_op slots[ASYNC_IO_URING_DEPTH * 2];
+    u32 free_slots[ASYNC_IO_URING_DEPTH * 2];
+    u32 free_slot_count;
+#endif
+
+    // Thread pool fallback. pending and completed are shared with the workers under the mutex.
+    kthread workers[ASYNC_IO_WORKER_COUNT];
+    u32 worker_count;
+    kmutex mutex;
+    ksemaphore work_semaphore;
+    result_queue completed;
+    b8 shutting_down;
+} async_io_state;
+
+static b8 is_initialized = FALSE;
+static async_io_state state;
+
+static void op_queue_push(op_queue* queue, const async_read_op* op) {
+    queue->ops[(queue->head + queue->count) % ASYNC_IO_MAX_OUTSTANDING] = *op;
+    queue->count++;
+}
+
+static async_read_op* op_queue_front(op_queue* queue) {
+    return &queue->ops[queue->head];
+}
+
+static void op_queue_pop(op_queue* queue) {
+    queue->head = (queue->head + 1) % ASYNC_IO_MAX_OUTSTANDING;
+    queue->count--;
+}
+
+static void deliver(u64 user_data, u32 bytes_read, i32 error) {
+    state.outstanding--;
+    event_context context;
+    context.data.u64[0] = user_data;
+    context.data.u32[2] = bytes_read;
+    context.data.i32[3] = error;
+    event_fire(EVENT_CODE_ASYNC_READ_COMPLETED, 0, context);
+}
+
+// A positional blocking read, looping over short reads until size bytes or end of file.
+static i32 read_at(u64 handle, u64 offset, u32 size, void* buffer, u32* out_bytes_read) {
+    u32 total = 0;
+    while (total < size) {
+#if KPLATFORM_WINDOWS
+        OVERLAPPED overlapped;
+        kzero_memory(&overlapped, sizeof(overlapped));
+        u64 position = offset + total;
+        overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+        overlapped.OffsetHigh = (DWORD)(position >> 32);
+        DWORD read = 0;
+        if (!ReadFile((HANDLE)handle, (u8*)buffer + total, size - total, &read, &overlapped)) {
+            DWORD error = GetLastError();
+            if (error == ERROR_HANDLE_EOF) {
+                break;
+            }
+            *out_bytes_read = total;
+            return (i32)error;
+        }
+#else
+        ssize_t read = pread((i32)handle, (u8*)buffer + total, size - total, offset + total);
+        if (read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *out_bytes_read = total;
+            return errno;
+        }
+#endif
+        if (read == 0) {
+            break;
+        }
+        total += (u32)read;
+    }
+    *out_bytes_read = total;
+    return 0;
+}
+
+static u32 async_io_worker(void* params) {
+    for (;;) {
+        ksemaphore_wait(&state.work_semaphore, 0);
+
+        kmutex_lock(&state.mutex);
+        if (state.pending.count == 0) {
+            b8 done = state.shutting_down;
+            kmutex_unlock(&state.mutex);
+            if (done) {
+                break;
+            }
+            continue;
+        }
+        async_read_op op = *op_queue_front(&state.pending);
+        op_queue_pop(&state.pending);
+        kmutex_unlock(&state.mutex);
+
+        async_read_result result;
+        result.user_data = op.user_data;
+        result.error = read_at(op.handle, op.offset, op.size, op.buffer, &result.bytes_read);
+
+        kmutex_lock(&state.mutex);
+        state.completed.results[(state.completed.head + state.completed.count) % ASYNC_IO_MAX_OUTSTANDING] = result;
+        state.completed.count++;
+        kmutex_unlock(&state.mutex);
+    }
+    return 0;
+}
+
+static b8 start_thread_pool() {
+    if (!kmutex_create(&state.mutex)) {
+        return FALSE;
+    }
+    if (!ksemaphore_create(&state.work_semaphore, 0)) {
+        kmutex_destroy(&state.mutex);
+        return FALSE;
+    }
+    for (u32 i = 0; i < ASYNC_IO_WORKER_COUNT; ++i) {
+        if (!kthread_create(async_io_worker, 0, &state.workers[i])) {
+            break;
+        }
+        state.worker_count++;
+    }
+    if (state.worker_count == 0) {
+        ksemaphore_destroy(&state.work_semaphore);
+        kmutex_destroy(&state.mutex);
+        return FALSE;
+    }
+    KINFO("Async I/O using a pool of %u reader threads.", state.worker_count);
+    return TRUE;
+}
+
+#if KPLATFORM_LINUX
+// Moves queued reads into io_uring while there are free slots, then submits them all at once.
+static b8 uring_flush(u32 wait_count) {
+    while (state.pending.count > 0 && state.free_slot_count > 0 && async_uring_space(&state.ring) > 0) {
+        async_read_op* op = op_queue_front(&state.pending);
+        u32 slot = state.free_slots[--state.free_slot_count];
+        state.slots[slot] = *op;
+        async_uring_push_read(&state.ring, (i32)op->handle, op->offset, op->size, op->buffer, slot);
+        op_queue_pop(&state.pending);
+    }
+    return async_uring_submit(&state.ring, wait_count);
+}
+
+/**
+ * Returns completed reads to the free list, delivering their events if asked
+ * to. Like read_at, a read which comes up short of end of file is queued again
+ * for the rest, unless events are not wanted, which is only while shutting down.
+ */
+static u32 uring_reap(b8 fire_events) {
+    async_uring_completion completions[ASYNC_IO_DELIVERY_BATCH];
+    u32 total = 0;
+    u32 count;
+    while ((count = async_uring_reap(&state.ring, completions, ASYNC_IO_DELIVERY_BATCH)) > 0) {
+        for (u32 i = 0; i < count; ++i) {
+            u32 slot = (u32)completions[i].user_data;
+            async_read_op op = state.slots[slot];
+            state.free_slots[state.free_slot_count++] = slot;
+
+            i32 result = completions[i].result;
+            if (fire_events && (result == -EINTR || result == -EAGAIN)) {
+                op_queue_push(&state.pending, &op);
+            } else if (fire_events && result > 0 && (u32)result < op.size) {
+                op.offset += (u32)result;
+                op.size -= (u32)result;
+                op.buffer = (u8*)op.buffer + result;
+                op.bytes_done += (u32)result;
+                op_queue_push(&state.pending, &op);
+            } else if (fire_events) {
+                deliver(op.user_data, op.bytes_done + (result > 0 ? (u32)result : 0), result < 0 ? -result : 0);
+            } else {
+                state.outstanding--;
+            }
+        }
+        total += count;
+    }
+    return total;
+}
+#endif
+
+b8 async_io_initialize() {
+    if (is_initialized) {
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(state));
+
+    const char* requested = getenv("KOHI_ASYNC_IO");
+    b8 force_threads = requested && strcmp(requested, "threads") == 0;
+
+#if KPLATFORM_LINUX
+    if (!force_threads && async_uring_create(ASYNC_IO_URING_DEPTH, &state.ring)) {
+        state.use_uring = TRUE;
+        // Never have more in flight than the completion queue can hold, so no completion is dropped.
+        u32 slot_count = state.ring.cq_entries < ASYNC_IO_URING_DEPTH * 2 ? state.ring.cq_entries : ASYNC_IO_URING_DEPTH * 2;
+        for (u32 i = 0; i < slot_count; ++i) {
+            state.free_slots[i] = slot_count - 1 - i;
+        }
+        state.free_slot_count = slot_count;
+        KINFO("Async I/O using io_uring (%u submission entries).", state.ring.sq_entries);
+        is_initialized = TRUE;
+        return TRUE;
+    }
+#endif
+
+    (void)force_threads;
+    if (!start_thread_pool()) {
+        KERROR("Failed to start the async I/O thread pool.");
+        return FALSE;
+    }
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void async_io_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+
+    // The buffers belong to the callers and must not be written after this returns,
+    // so everything still outstanding is finished first. Their events are dropped.
+#if KPLATFORM_LINUX
+    if (state.use_uring) {
+        // Queued reads which never reached the kernel can simply be dropped.
+        state.outstanding -= state.pending.count;
+        state.pending.count = 0;
+        while (state.outstanding > 0) {
+            if (!async_uring_submit(&state.ring, 1)) {
+                break;
+            }
+            uring_reap(FALSE);
+        }
+        async_uring_destroy(&state.ring);
+        is_initialized = FALSE;
+        return;
+    }
+#endif
+
+    kmutex_lock(&state.mutex);
+    state.shutting_down = TRUE;
+    kmutex_unlock(&state.mutex);
+    for (u32 i = 0; i < state.worker_count; ++i) {
+        ksemaphore_signal(&state.work_semaphore);
+    }
+    for (u32 i = 0; i < state.worker_count; ++i) {
+        kthread_wait(&state.workers[i]);
+    }
+    ksemaphore_destroy(&state.work_semaphore);
+    kmutex_destroy(&state.mutex);
+    is_initialized = FALSE;
+}
+
+void async_io_update() {
+    if (!is_initialized || state.outstanding == 0) {
+        return;
+    }
+
+#if KPLATFORM_LINUX
+    if (state.use_uring) {
+        uring_reap(TRUE);
+        // Completions free up slots for reads which are still queued.
+        uring_flush(0);
+        return;
+    }
+#endif
+
+    // Events are fired outside the lock, since handlers may well submit more reads.
+    async_read_result batch[ASYNC_IO_DELIVERY_BATCH];
+    for (;;) {
+        kmutex_lock(&state.mutex);
+        u32 count = 0;
+        while (state.completed.count > 0 && count < ASYNC_IO_DELIVERY_BATCH) {
+            batch[count++] = state.completed.results[state.completed.head];
+            state.completed.head = (state.completed.head + 1) % ASYNC_IO_MAX_OUTSTANDING;
+            state.completed.count--;
+        }
+        kmutex_unlock(&state.mutex);
+
+        if (count == 0) {
+            break;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            deliver(batch[i].user_data, batch[i].bytes_read, batch[i].error);
+        }
+    }
+}
+
+b8 async_io_open(const char* path, async_file* out_file) {
+    out_file->is_valid = FALSE;
+    out_file->handle = 0;
+
+#if KPLATFORM_WINDOWS
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (handle == INVALID_HANDLE_VALUE) {
+        KERROR("async_io_open unable to open '%s'. Error: %lu", path, GetLastError());
+        return FALSE;
+    }
+    out_file->handle = (u64)handle;
+#else
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        KERROR("async_io_open unable to open '%s': %s", path, strerror(errno));
+        return FALSE;
+    }
+    out_file->handle = (u64)fd;
+#endif
+
+    out_file->is_valid = TRUE;
+    return TRUE;
+}
+
+void async_io_close(async_file* file) {
+    if (!file->is_valid) {
+        return;
+    }
+#if KPLATFORM_WINDOWS
+    CloseHandle((HANDLE)file->handle);
+#else
+    close((i32)file->handle);
+#endif
+    file->handle = 0;
+    file->is_valid = FALSE;
+}
+
+b8 async_io_submit_reads(u32 count, const async_read_request* requests) {
+    if (!is_initialized) {
+        KERROR("async_io_submit_reads called before async_io_initialize.");
+        return FALSE;
+    }
+    if (count == 0) {
+        return TRUE;
+    }
+    if (state.outstanding + count > ASYNC_IO_MAX_OUTSTANDING) {
+        KERROR("async_io_submit_reads: batch of %u reads would exceed the limit of %u outstanding reads.", count, ASYNC_IO_MAX_OUTSTANDING);
+        return FALSE;
+    }
+    for (u32 i = 0; i < count; ++i) {
+        if (!requests[i].file.is_valid || !requests[i].buffer || requests[i].size > 0xFFFFFFFF) {
+            KERROR("async_io_submit_reads: request %u is invalid.", i);
+            return FALSE;
+        }
+    }
+
+#if KPLATFORM_LINUX
+    if (state.use_uring) {
+        for (u32 i = 0; i < count; ++i) {
+            async_read_op op = {requests[i].file.handle, requests[i].offset, (u32)requests[i].size, requests[i].buffer, requests[i].user_data, 0};
+            op_queue_push(&state.pending, &op);
+        }
+        state.outstanding += count;
+        // The reads are queued now, and will complete, so the batch counts as submitted even if
+        // the kernel refused it. Whatever it did not take is handed over again by async_io_update.
+        uring_flush(0);
+        return TRUE;
+    }
+#endif
+
+    kmutex_lock(&state.mutex);
+    for (u32 i = 0; i < count; ++i) {
+        async_read_op op = {requests[i].file.handle, requests[i].offset, (u32)requests[i].size, requests[i].buffer, requests[i].user_data, 0};
+        op_queue_push(&state.pending, &op);
+    }
+    kmutex_unlock(&state.mutex);
+    state.outstanding += count;
+
+    for (u32 i = 0; i < count; ++i) {
+        ksemaphore_signal(&state.work_semaphore);
+    }
+    return TRUE;
+}
+
+u32 async_io_outstanding_count() {
+    return state.outstanding;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Asynchronous file reads. Reads are queued in batches into caller-provided
+ * buffers and complete in the background; each completion is delivered on
+ * the main thread as an EVENT_CODE_ASYNC_READ_COMPLETED event during
+ * async_io_update.
+ *
+ * On Linux the reads are issued through io_uring, so a whole batch costs a
+ * single system call. Elsewhere, or when io_uring is unavailable, a small
+ * pool of worker threads performs positional blocking reads instead.
+ * Setting the KOHI_ASYNC_IO environment variable to "threads" forces the
+ * thread pool.
+ */
+
+// A file opened for asynchronous reads.
+typedef struct async_file {
+    // The platform file descriptor or handle.
+    u64 handle;
+    b8 is_valid;
+} async_file;
+
+typedef struct async_read_request {
+    // The file to read from. Must stay open until the read completes.
+    async_file file;
+    // The offset in the file to read from, in bytes.
+    u64 offset;
+    // The number of bytes to read. Must fit in 32 bits.
+    u64 size;
+    // Where the data is written. Must stay valid until the read completes.
+    void* buffer;
+    // Returned with the completion event, to tell requests apart.
+    u64 user_data;
+} async_read_request;
+
+b8 async_io_initialize();
+void async_io_shutdown();
+
+/**
+ * Delivers the completion events of every read finished since the last call
+ * and issues any queued reads which did not fit in flight yet. Called once
+ * per frame by the application.
+ */
+void async_io_update();
+
+/**
+ * Opens a file for asynchronous reads.
+ * @param path The path of the file to open.
+ * @param out_file A pointer to hold the opened file.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 async_io_open(const char* path, async_file* out_file);
+
+/**
+ * Closes a file opened with async_io_open. Any reads still in flight on it must have completed.
+ */
+KAPI void async_io_close(async_file* file);
+
+/**
+ * Queues a batch of reads. Either the whole batch is queued or none of it is.
+ * @param count The number of requests.
+ * @param requests An array of count requests. Copied, so it need not outlive this call.
+ * @returns TRUE if the batch was queued; otherwise FALSE.
+ */
+KAPI b8 async_io_submit_reads(u32 count, const async_read_request* requests);
+
+/**
+ * Returns the number of reads which have been submitted but whose completion has not been delivered yet.
+ */
+KAPI u32 async_io_outstanding_count();
@@ -0,0 +1,190 @@
+#include "async_io_uring.h"
+
+#if KPLATFORM_LINUX
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+// Older libc headers may not have these yet; the numbers are the same on every architecture.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+// The kernel updates the ring indices from other cores, so they need ordered access.
+#define RING_LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define RING_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+b8 async_uring_create(u32 entries, async_uring* out_ring) {
+    kzero_memory(out_ring, sizeof(async_uring));
+    out_ring->ring_fd = -1;
+
+    struct io_uring_params params;
+    kzero_memory(&params, sizeof(params));
+    i32 fd = (i32)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        KINFO("io_uring is unavailable: %s", strerror(errno));
+        return FALSE;
+    }
+
+    // IORING_OP_READ arrived in the same kernel as this feature flag.
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        KINFO("io_uring is too old to support IORING_OP_READ.");
+        close(fd);
+        return FALSE;
+    }
+
+    out_ring->ring_fd = fd;
+    out_ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    out_ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    // Newer kernels share one mapping between both queues.
+    b8 single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        if (out_ring->cq_ring_size > out_ring->sq_ring_size) {
+            out_ring->sq_ring_size = out_ring->cq_ring_size;
+        }
+        out_ring->cq_ring_size = out_ring->sq_ring_size;
+    }
+
+    out_ring->sq_ring = mmap(0, out_ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (out_ring->sq_ring == MAP_FAILED) {
+        out_ring->sq_ring = 0;
+        async_uring_destroy(out_ring);
+        return FALSE;
+    }
+
+    if (single_mmap) {
+        out_ring->cq_ring = out_ring->sq_ring;
+    } else {
+        out_ring->cq_ring = mmap(0, out_ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (out_ring->cq_ring == MAP_FAILED) {
+            out_ring->cq_ring = 0;
+            async_uring_destroy(out_ring);
+            return FALSE;
+        }
+    }
+
+    out_ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    out_ring->sqes = mmap(0, out_ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (out_ring->sqes == MAP_FAILED) {
+        out_ring->sqes = 0;
+        async_uring_destroy(out_ring);
+        return FALSE;
+    }
+
+    u8* sq = out_ring->sq_ring;
+    out_ring->sq_head = (u32*)(sq + params.sq_off.head);
+    out_ring->sq_tail = (u32*)(sq + params.sq_off.tail);
+    out_ring->sq_mask = (u32*)(sq + params.sq_off.ring_mask);
+    out_ring->sq_array = (u32*)(sq + params.sq_off.array);
+    out_ring->sq_entries = params.sq_entries;
+
+    u8* cq = out_ring->cq_ring;
+    out_ring->cq_head = (u32*)(cq + params.cq_off.head);
+    out_ring->cq_tail = (u32*)(cq + params.cq_off.tail);
+    out_ring->cq_mask = (u32*)(cq + params.cq_off.ring_mask);
+    out_ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    out_ring->cq_entries = params.cq_entries;
+
+    return TRUE;
+}
+
+void async_uring_destroy(async_uring* ring) {
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->ring_fd >= 0) {
+        close(ring->ring_fd);
+    }
+    kzero_memory(ring, sizeof(async_uring));
+    ring->ring_fd = -1;
+}
+
+u32 async_uring_space(async_uring* ring) {
+    // Only this side moves the tail, so it needs no barrier.
+    u32 tail = *ring->sq_tail;
+    u32 head = RING_LOAD_ACQUIRE(ring->sq_head);
+    return ring->sq_entries - (tail - head);
+}
+
+b8 async_uring_push_read(async_uring* ring, i32 fd, u64 offset, u32 size, void* buffer, u64 user_data) {
+    if (async_uring_space(ring) == 0) {
+        return FALSE;
+    }
+
+    u32 tail = *ring->sq_tail;
+    u32 index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    kzero_memory(sqe, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = (u64)buffer;
+    sqe->len = size;
+    sqe->user_data = user_data;
+
+    ring->sq_array[index] = index;
+    // Publish the entry before the kernel can see the new tail.
+    RING_STORE_RELEASE(ring->sq_tail, tail + 1);
+    ring->unsubmitted++;
+    return TRUE;
+}
+
+b8 async_uring_submit(async_uring* ring, u32 wait_count) {
+    if (ring->unsubmitted == 0 && wait_count == 0) {
+        return TRUE;
+    }
+
+    u32 flags = wait_count ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        i32 result = (i32)syscall(__NR_io_uring_enter, ring->ring_fd, ring->unsubmitted, wait_count, flags, 0, 0);
+        if (result >= 0) {
+            ring->unsubmitted -= (u32)result;
+            return TRUE;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        // EAGAIN/EBUSY: the kernel is out of room for now. What was not taken stays queued for the next call.
+        if (errno == EAGAIN || errno == EBUSY) {
+            return TRUE;
+        }
+        KERROR("io_uring_enter failed: %s", strerror(errno));
+        return FALSE;
+    }
+}
+
+u32 async_uring_reap(async_uring* ring, async_uring_completion* out_completions, u32 max_count) {
+    // Only this side moves the head, so it needs no barrier.
+    u32 head = *ring->cq_head;
+    u32 tail = RING_LOAD_ACQUIRE(ring->cq_tail);
+    u32 count = 0;
+    while (head != tail && count < max_count) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        out_completions[count].user_data = cqe->user_data;
+        out_completions[count].result = cqe->res;
+        count++;
+        head++;
+    }
+    // Hand the consumed entries back to the kernel.
+    RING_STORE_RELEASE(ring->cq_head, head);
+    return count;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+// A minimal io_uring submission/completion ring, used by async_io on Linux.
+// Talks to the kernel directly rather than through liburing, so there is
+// nothing extra to install or link. Not for use outside of the platform layer.
+
+#include "defines.h"
+
+#if KPLATFORM_LINUX
+
+typedef struct async_uring {
+    i32 ring_fd;
+
+    // Submission queue, shared with the kernel.
+    u32* sq_head;
+    u32* sq_tail;
+    u32* sq_mask;
+    u32* sq_array;
+    u32 sq_entries;
+    struct io_uring_sqe* sqes;
+    // Entries pushed but not yet handed to the kernel.
+    u32 unsubmitted;
+
+    // Completion queue, shared with the kernel.
+    u32* cq_head;
+    u32* cq_tail;
+    u32* cq_mask;
+    struct io_uring_cqe* cqes;
+    u32 cq_entries;
+
+    // The mappings, kept for unmapping.
+    void* sq_ring;
+    u64 sq_ring_size;
+    void* cq_ring;
+    u64 cq_ring_size;
+    u64 sqes_size;
+} async_uring;
+
+typedef struct async_uring_completion {
+    u64 user_data;
+    // Bytes read, or a negated errno.
+    i32 result;
+} async_uring_completion;
+
+/**
+ * Creates a ring with room for at least the given number of submissions.
+ * Fails if the kernel has no io_uring or it lacks IORING_OP_READ (5.6+).
+ */
+b8 async_uring_create(u32 entries, async_uring* out_ring);
+void async_uring_destroy(async_uring* ring);
+
+// Returns how many more reads can be pushed before the submission queue is full.
+u32 async_uring_space(async_uring* ring);
+
+// Queues a read. Nothing reaches the kernel until async_uring_submit.
+b8 async_uring_push_read(async_uring* ring, i32 fd, u64 offset, u32 size, void* buffer, u64 user_data);
+
+/**
+ * Hands every pushed read to the kernel with a single system call.
+ * @param wait_count The number of completions to block for. 0 does not block.
+ */
+b8 async_uring_submit(async_uring* ring, u32 wait_count);
+
+// Copies out up to max_count completions, returning how many there were.
+u32 async_uring_reap(async_uring* ring, async_uring_completion* out_completions, u32 max_count);
+
+#endif
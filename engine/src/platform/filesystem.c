@@ -0,0 +1,159 @@
+#include "filesystem.h"
+
+#include "core/logger.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if KPLATFORM_WINDOWS
+#define file_tell _ftelli64
+#define file_seek _fseeki64
+#else
+#define file_tell ftello
+#define file_seek fseeko
+#endif
+
+b8 filesystem_exists(const char* path) {
+#if KPLATFORM_WINDOWS
+    struct _stat buffer;
+    return _stat(path, &buffer) == 0;
+#else
+    struct stat buffer;
+    return stat(path, &buffer) == 0;
+#endif
+}
+
+b8 filesystem_open(const char* path, file_modes mode, b8 binary, file_handle* out_handle) {
+    out_handle->is_valid = FALSE;
+    out_handle->handle = 0;
+    const char* mode_str;
+
+    if ((mode & FILE_MODE_READ) != 0 && (mode & FILE_MODE_WRITE) != 0) {
+        mode_str = binary ? "w+b" : "w+";
+    } else if ((mode & FILE_MODE_READ) != 0 && (mode & FILE_MODE_WRITE) == 0) {
+        mode_str = binary ? "rb" : "r";
+    } else if ((mode & FILE_MODE_READ) == 0 && (mode & FILE_MODE_WRITE) != 0) {
+        mode_str = binary ? "wb" : "w";
+    } else {
+        KERROR("Invalid mode passed while trying to open file: '%s'", path);
+        return FALSE;
+    }
+
+    // Attempt to open the file.
+    FILE* file = fopen(path, mode_str);
+    if (!file) {
+        KERROR("Error opening file: '%s'", path);
+        return FALSE;
+    }
+
+    out_handle->handle = file;
+    out_handle->is_valid = TRUE;
+
+    return TRUE;
+}
+
+void filesystem_close(file_handle* handle) {
+    if (handle->handle) {
+        fclose((FILE*)handle->handle);
+        handle->handle = 0;
+        handle->is_valid = FALSE;
+    }
+}
+
+b8 filesystem_size(file_handle* handle, u64* out_size) {
+    if (!handle->handle) {
+        return FALSE;
+    }
+
+    // Measure from the end, then put the read position back where it was.
+    FILE* file = (FILE*)handle->handle;
+    i64 position = file_tell(file);
+    if (position < 0 || file_seek(file, 0, SEEK_END) != 0) {
+        return FALSE;
+    }
+    i64 size = file_tell(file);
+    file_seek(file, position, SEEK_SET);
+    if (size < 0) {
+        return FALSE;
+    }
+
+    *out_size = (u64)size;
+    return TRUE;
+}
+
+b8 filesystem_seek(file_handle* handle, u64 offset) {
+    if (!handle->handle) {
+        return FALSE;
+    }
+    return file_seek((FILE*)handle->handle, (i64)offset, SEEK_SET) == 0;
+}
+
+b8 filesystem_read_line(file_handle* handle, u64 max_length, char* line_buf, u64* out_line_length) {
+    if (!handle->handle || !line_buf || !out_line_length || max_length == 0) {
+        return FALSE;
+    }
+
+    if (fgets(line_buf, (int)max_length, (FILE*)handle->handle) == 0) {
+        return FALSE;
+    }
+
+    *out_line_length = strlen(line_buf);
+    return TRUE;
+}
+
+b8 filesystem_write_line(file_handle* handle, const char* text) {
+    if (!handle->handle) {
+        return FALSE;
+    }
+
+    i32 result = fputs(text, (FILE*)handle->handle);
+    if (result != EOF) {
+        result = fputc('\n', (FILE*)handle->handle);
+    }
+
+    // Make sure to flush the stream so it is written to the file immediately.
+    // This prevents data loss in the event of a crash.
+    fflush((FILE*)handle->handle);
+    return result != EOF;
+}
+
+b8 filesystem_read(file_handle* handle, u64 data_size, void* out_data, u64* out_bytes_read) {
+    if (!handle->handle || !out_data) {
+        return FALSE;
+    }
+
+    // Reaching the end of the file early is not an error; out_bytes_read says how much there was.
+    *out_bytes_read = fread(out_data, 1, data_size, (FILE*)handle->handle);
+    return !ferror((FILE*)handle->handle);
+}
+
+b8 filesystem_read_all_bytes(file_handle* handle, u8* out_bytes, u64* out_bytes_read) {
+    if (!handle->handle || !out_bytes) {
+        return FALSE;
+    }
+
+    FILE* file = (FILE*)handle->handle;
+    i64 position = file_tell(file);
+    u64 size = 0;
+    if (position < 0 || !filesystem_size(handle, &size)) {
+        return FALSE;
+    }
+
+    u64 remaining = size - (u64)position;
+    *out_bytes_read = fread(out_bytes, 1, remaining, file);
+    return *out_bytes_read == remaining;
+}
+
+b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written) {
+    if (!handle->handle) {
+        return FALSE;
+    }
+
+    *out_bytes_written = fwrite(data, 1, data_size, (FILE*)handle->handle);
+    if (*out_bytes_written != data_size) {
+        return FALSE;
+    }
+    fflush((FILE*)handle->handle);
+    return TRUE;
+}
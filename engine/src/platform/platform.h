@@ -7,6 +7,34 @@ typedef struct platform_state {
     void* internal_state;
 } platform_state;
 
+// Access pattern hints for mapped files. May be combined.
+typedef enum file_map_hint {
+    FILE_MAP_HINT_NONE = 0x0,
+    // The file will be read front to back; read ahead aggressively.
+    FILE_MAP_HINT_SEQUENTIAL = 0x1,
+    // The file will be read in no particular order; do not read ahead.
+    FILE_MAP_HINT_RANDOM = 0x2,
+    // The whole file will be needed soon; start paging it in now.
+    FILE_MAP_HINT_WILLNEED = 0x4,
+} file_map_hint;
+
+// A read-only view of a whole file, mapped from the OS page cache.
+typedef struct mapped_file {
+    // The file contents. Read-only. 0 for an empty file.
+    const void* data;
+    // The size of the file in bytes.
+    u64 size;
+    // Platform-specific mapping handle, if any.
+    void* internal;
+} mapped_file;
+
+typedef struct dynamic_library {
+    // The path the library was loaded from.
+    char path[256];
+    // Platform-specific handle.
+    void* handle;
+} dynamic_library;
+
 b8 platform_startup(
     platform_state* plat_state,
     const char* application_name,
@@ -19,6 +47,10 @@ void platform_shutdown(platform_state* plat_state);
 
 b8 platform_pump_messages(platform_state* plat_state);
 
+// Indicates if the platform was started without a window (see platform_null.h).
+// A headless platform cannot present, so the null renderer backend should be used.
+b8 platform_is_headless(platform_state* plat_state);
+
 KAPI void* platform_allocate(u64 size, b8 aligned);
 KAPI void platform_free(void* block, b8 aligned);
 void* platform_zero_memory(void* block, u64 size);
@@ -30,10 +62,92 @@ void platform_console_write_error(const char* message, u8 colour);
 
 f64 platform_get_absolute_time(platform_state* plat_state);
 
+/**
+ * Maps a file read-only into memory. No data is copied: pages are faulted in
+ * from the page cache as they are touched, so the contents can be parsed in
+ * place. The mapping stays valid until platform_unmap_file.
+ * @param path The path of the file to map.
+ * @param hints A combination of file_map_hint flags describing how the data will be read.
+ * @param out_file A pointer to hold the mapping.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 platform_map_file(const char* path, u32 hints, mapped_file* out_file);
+
+/**
+ * Releases a mapping created by platform_map_file. Any pointers into it become invalid.
+ */
+KAPI void platform_unmap_file(mapped_file* file);
+
+/**
+ * Asks the OS to start paging in the given range of a mapped file, i.e.
+ * just before parsing one entry of a larger file.
+ * @param file The mapped file.
+ * @param offset The offset of the range in bytes.
+ * @param size The size of the range in bytes.
+ */
+KAPI void platform_mapped_file_prefetch(mapped_file* file, u64 offset, u64 size);
+
+/**
+ * Loads the dynamic library at the given path.
+ * @param path The path to the library file, including prefix and extension.
+ * @param out_library A pointer to hold the loaded library.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 platform_dynamic_library_load(const char* path, dynamic_library* out_library);
+
+/**
+ * Unloads the given library. Any function pointers obtained from it become invalid.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 platform_dynamic_library_unload(dynamic_library* library);
+
+/**
+ * Looks up an exported function by name. Missing functions are not logged,
+ * since some exports may be optional.
+ * @returns A pointer to the function if found; otherwise 0.
+ */
+KAPI void* platform_dynamic_library_load_function(dynamic_library* library, const char* name);
+
+// The file extension used by dynamic libraries on this platform, i.e. ".so".
+KAPI const char* platform_dynamic_library_extension();
+
+// The file name prefix used by dynamic libraries on this platform, i.e. "lib".
+KAPI const char* platform_dynamic_library_prefix();
+
+/**
+ * Copies a file.
+ * @param source The path of the file to copy.
+ * @param dest The path to copy to.
+ * @param overwrite_if_exists Indicates if an existing file at dest should be replaced.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 platform_copy_file(const char* source, const char* dest, b8 overwrite_if_exists);
+
+/**
+ * Starts watching a file for changes. Whenever the file is written (or
+ * replaced), EVENT_CODE_WATCHED_FILE_WRITTEN is fired from
+ * platform_pump_messages with the returned id.
+ * @param file_path The path of the file to watch.
+ * @param out_watch_id A pointer to hold the id of the watch.
+ * @returns TRUE on success; FALSE on failure or if unsupported on this platform.
+ */
+KAPI b8 platform_watch_file(const char* file_path, u32* out_watch_id);
+
+/**
+ * Stops watching the file with the given watch id.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 platform_unwatch_file(u32 watch_id);
+
 // sleep on thread for the provided ms. this blocks the main thread.
 // Should only be used for giving time back to the OS for unsused update power
 // therefore it is not exported.
 void platform_sleep(u64 ms);
+
+/**
+ * Returns the number of logical processor cores available to the process.
+ */
+KAPI i32 platform_get_processor_count();
 b8 platform_create_vulkan_surface(
     platform_state* plat_state,
     vulkan_context* context);
\ No newline at end of file
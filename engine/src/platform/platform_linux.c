@@ -1,4 +1,6 @@
 #include "platform.h"
+#include "platform_linux.h"
+#include "platform_null.h"
 
 // Linux platform layer.
 #if KPLATFORM_LINUX
@@ -23,13 +25,25 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 // for surface creation
-#include "VK_USE_PLATFORM_XCB_KHR"
+// VK_USE_PLATFORM_XCB_KHR is defined by the build script.
 #include <vulkan/vulkan.h>
 #include "renderer/vulkan/vulkan_types.inl"
 
 #include "containers/darray.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
 typedef struct internal_state {
     Display* display;
     xcb_connection_t* connection;
@@ -38,12 +52,179 @@ typedef struct internal_state {
     xcb_atom_t wm_protocols;
     xcb_atom_t wm_delete_win;
     VkSurfaceKHR surface;
+    // The last window size reported to the event system.
+    u16 width;
+    u16 height;
 } internal_state;
 
-// Key translation
-keys translate_keycode(u32 x_keycode);
+// The maximum number of files which can be watched at once.
+#define LINUX_MAX_FILE_WATCHES 64
+
+typedef struct linux_file_watch {
+    b8 in_use;
+    // Set when a write was seen during the current pump.
+    b8 written;
+    // inotify watch descriptor of the containing directory.
+    i32 wd;
+    char file_name[256];
+} linux_file_watch;
+
+// Files are watched through their directory, since tools commonly replace a
+// file (write to a temp file and rename) rather than writing it in place,
+// which would silently drop a watch on the file itself.
+static i32 inotify_fd = -1;
+static linux_file_watch file_watches[LINUX_MAX_FILE_WATCHES];
+
+static void platform_process_file_watches();
+
+// The window system picked in platform_startup. Everything that touches the
+// window or Vulkan surface is routed through this.
+static linux_window_system window_system = LINUX_WINDOW_SYSTEM_XCB;
+
+static b8 platform_xcb_startup(
+    platform_state* plat_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height);
+static void platform_xcb_shutdown(platform_state* plat_state);
+static b8 platform_xcb_pump_messages(platform_state* plat_state);
+static b8 platform_xcb_create_vulkan_surface(platform_state* plat_state, vulkan_context* context);
+static void platform_xcb_get_required_extension_names(const char*** names__darray);
+
+/**
+ * Picks the window system to use. KOHI_PLATFORM may be set to "x11",
+ * "wayland" or "null" (no window at all) to force one. Otherwise Wayland is preferred whenever it has
+ * been compiled in and a compositor is advertised through WAYLAND_DISPLAY.
+ */
+static linux_window_system select_window_system(b8* out_forced) {
+    *out_forced = FALSE;
+    const char* requested = getenv("KOHI_PLATFORM");
+    if (requested && requested[0]) {
+        if (strcasecmp(requested, "wayland") == 0) {
+            *out_forced = TRUE;
+            return LINUX_WINDOW_SYSTEM_WAYLAND;
+        }
+        if (strcasecmp(requested, "x11") == 0 || strcasecmp(requested, "xcb") == 0) {
+            *out_forced = TRUE;
+            return LINUX_WINDOW_SYSTEM_XCB;
+        }
+        if (strcasecmp(requested, "null") == 0 || strcasecmp(requested, "headless") == 0) {
+            *out_forced = TRUE;
+            return LINUX_WINDOW_SYSTEM_NULL;
+        }
+        KWARN("Unknown KOHI_PLATFORM '%s', using the default window system.", requested);
+    }
+
+#if KOHI_WAYLAND
+    const char* wayland_display = getenv("WAYLAND_DISPLAY");
+    if (wayland_display && wayland_display[0]) {
+        return LINUX_WINDOW_SYSTEM_WAYLAND;
+    }
+#endif
+    return LINUX_WINDOW_SYSTEM_XCB;
+}
 
 b8 platform_startup(
+    platform_state* plat_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height) {
+    b8 forced = FALSE;
+    window_system = select_window_system(&forced);
+
+    if (window_system == LINUX_WINDOW_SYSTEM_NULL) {
+        return platform_null_startup(plat_state, application_name, x, y, width, height);
+    }
+
+    if (window_system == LINUX_WINDOW_SYSTEM_WAYLAND) {
+#if KOHI_WAYLAND
+        if (platform_wayland_startup(plat_state, application_name, x, y, width, height)) {
+            KINFO("Linux platform started using Wayland.");
+            return TRUE;
+        }
+        if (forced) {
+            KFATAL("Wayland was requested but could not be started.");
+            return FALSE;
+        }
+        KWARN("Failed to start Wayland platform, falling back to X11.");
+#else
+        KFATAL("Wayland was requested but the engine was built without Wayland support.");
+        return FALSE;
+#endif
+    }
+
+    window_system = LINUX_WINDOW_SYSTEM_XCB;
+    if (!platform_xcb_startup(plat_state, application_name, x, y, width, height)) {
+        return FALSE;
+    }
+    KINFO("Linux platform started using X11/XCB.");
+    return TRUE;
+}
+
+void platform_shutdown(platform_state* plat_state) {
+    if (window_system == LINUX_WINDOW_SYSTEM_NULL) {
+        platform_null_shutdown(plat_state);
+        return;
+    }
+#if KOHI_WAYLAND
+    if (window_system == LINUX_WINDOW_SYSTEM_WAYLAND) {
+        platform_wayland_shutdown(plat_state);
+        return;
+    }
+#endif
+    platform_xcb_shutdown(plat_state);
+}
+
+b8 platform_pump_messages(platform_state* plat_state) {
+    // File watches are independent of the window system.
+    platform_process_file_watches();
+
+    if (window_system == LINUX_WINDOW_SYSTEM_NULL) {
+        return platform_null_pump_messages(plat_state);
+    }
+#if KOHI_WAYLAND
+    if (window_system == LINUX_WINDOW_SYSTEM_WAYLAND) {
+        return platform_wayland_pump_messages(plat_state);
+    }
+#endif
+    return platform_xcb_pump_messages(plat_state);
+}
+
+b8 platform_create_vulkan_surface(platform_state* plat_state, vulkan_context* context) {
+    if (window_system == LINUX_WINDOW_SYSTEM_NULL) {
+        return platform_null_create_vulkan_surface(plat_state, context);
+    }
+#if KOHI_WAYLAND
+    if (window_system == LINUX_WINDOW_SYSTEM_WAYLAND) {
+        return platform_wayland_create_vulkan_surface(plat_state, context);
+    }
+#endif
+    return platform_xcb_create_vulkan_surface(plat_state, context);
+}
+
+void platform_get_required_extension_names(const char*** names__darray) {
+    if (window_system == LINUX_WINDOW_SYSTEM_NULL) {
+        platform_null_get_required_extension_names(names__darray);
+        return;
+    }
+#if KOHI_WAYLAND
+    if (window_system == LINUX_WINDOW_SYSTEM_WAYLAND) {
+        platform_wayland_get_required_extension_names(names__darray);
+        return;
+    }
+#endif
+    platform_xcb_get_required_extension_names(names__darray);
+}
+
+b8 platform_is_headless(platform_state* plat_state) {
+    return window_system == LINUX_WINDOW_SYSTEM_NULL;
+}
+
+static b8 platform_xcb_startup(
     platform_state* plat_state,
     const char* application_name,
     i32 x,
@@ -54,8 +235,17 @@ b8 platform_startup(
     plat_state->internal_state = malloc(sizeof(internal_state));
     internal_state* state = (internal_state*)plat_state->internal_state;
 
+    state->width = (u16)width;
+    state->height = (u16)height;
+
     // Connect to X
     state->display = XOpenDisplay(NULL);
+    if (!state->display) {
+        KFATAL("Failed to open X display.");
+        free(plat_state->internal_state);
+        plat_state->internal_state = 0;
+        return FALSE;
+    }
 
     // Turn off key repeats.
     XAutoRepeatOff(state->display);
@@ -171,7 +361,7 @@ b8 platform_startup(
     return TRUE;
 }
 
-void platform_shutdown(platform_state* plat_state) {
+static void platform_xcb_shutdown(platform_state* plat_state) {
     // Simply cold-cast to the known type.
     internal_state* state = (internal_state*)plat_state->internal_state;
 
@@ -181,7 +371,7 @@ void platform_shutdown(platform_state* plat_state) {
     xcb_destroy_window(state->connection, state->window);
 }
 
-b8 platform_pump_messages(platform_state* plat_state) {
+static b8 platform_xcb_pump_messages(platform_state* plat_state) {
     // Simply cold-cast to the known type.
     internal_state* state = (internal_state*)plat_state->internal_state;
 
@@ -190,6 +380,12 @@ b8 platform_pump_messages(platform_state* plat_state) {
 
     b8 quit_flagged = FALSE;
 
+    // A drag-resize produces a burst of configure notifications. Only the
+    // last size seen during this pump is reported.
+    b8 resize_pending = FALSE;
+    u16 pending_width = state->width;
+    u16 pending_height = state->height;
+
     // Poll for events until null is returned.
     while (event != 0) {
         event = xcb_poll_for_event(state->connection);
@@ -249,8 +445,14 @@ b8 platform_pump_messages(platform_state* plat_state) {
                 break;
 
             case XCB_CONFIGURE_NOTIFY: {
-                // TODO: Resizing
-            }
+                // Resizing - note that this is also triggered by moving the window, but should be
+                // passed anyway since a change in the x/y could mean an upper-left resize.
+                // The application layer can decide what to do with this.
+                xcb_configure_notify_event_t* configure_event = (xcb_configure_notify_event_t*)event;
+                pending_width = configure_event->width;
+                pending_height = configure_event->height;
+                resize_pending = TRUE;
+            } break;
 
             case XCB_CLIENT_MESSAGE: {
                 cm = (xcb_client_message_event_t*)event;
@@ -267,6 +469,18 @@ b8 platform_pump_messages(platform_state* plat_state) {
 
         free(event);
     }
+
+    // Fire the event for the final size only, and only if it actually changed.
+    if (resize_pending && (pending_width != state->width || pending_height != state->height)) {
+        state->width = pending_width;
+        state->height = pending_height;
+
+        event_context context;
+        context.data.u16[0] = pending_width;
+        context.data.u16[1] = pending_height;
+        event_fire(EVENT_CODE_RESIZED, 0, context);
+    }
+
     return !quit_flagged;
 }
 
@@ -318,7 +532,7 @@ void platform_sleep(u64 ms) {
 }
 
 // surface creation for vulkan
-b8 platform_create_vulkan_surface(platform_state* plat_state, vulkan_context* context) {
+static b8 platform_xcb_create_vulkan_surface(platform_state* plat_state, vulkan_context* context) {
     internal_state* state = (internal_state*)plat_state->internal_state;
 
     VkXcbSurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR};
@@ -334,11 +548,469 @@ b8 platform_create_vulkan_surface(platform_state* plat_state, vulkan_context* co
     return TRUE;
 }
 
-void platform_get_required_extension_names(const char*** names__darray) {
+static void platform_xcb_get_required_extension_names(const char*** names__darray) {
     // For Linux platform, we need to add the VK_KHR_xcb_surface extension.
     darray_push(*names__darray, &VK_KHR_XCB_SURFACE_EXTENSION_NAME);
 }
 
+i32 platform_get_processor_count() {
+    // Counts only the cores which are currently online.
+    i32 count = (i32)sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+}
+
+b8 platform_map_file(const char* path, u32 hints, mapped_file* out_file) {
+    out_file->data = 0;
+    out_file->size = 0;
+    out_file->internal = 0;
+
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        KERROR("platform_map_file unable to open '%s': %s", path, strerror(errno));
+        return FALSE;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        KERROR("platform_map_file unable to stat '%s': %s", path, strerror(errno));
+        close(fd);
+        return FALSE;
+    }
+
+    // Nothing to map for an empty file, but it is still a valid file.
+    if (file_stat.st_size == 0) {
+        close(fd);
+        return TRUE;
+    }
+
+    void* data = mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file.
+    close(fd);
+    if (data == MAP_FAILED) {
+        KERROR("platform_map_file unable to map '%s': %s", path, strerror(errno));
+        return FALSE;
+    }
+
+    if (hints & FILE_MAP_HINT_SEQUENTIAL) {
+        madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+    } else if (hints & FILE_MAP_HINT_RANDOM) {
+        madvise(data, file_stat.st_size, MADV_RANDOM);
+    }
+    if (hints & FILE_MAP_HINT_WILLNEED) {
+        madvise(data, file_stat.st_size, MADV_WILLNEED);
+    }
+
+    out_file->data = data;
+    out_file->size = file_stat.st_size;
+    return TRUE;
+}
+
+void platform_unmap_file(mapped_file* file) {
+    if (file->data) {
+        munmap((void*)file->data, file->size);
+    }
+    file->data = 0;
+    file->size = 0;
+    file->internal = 0;
+}
+
+void platform_mapped_file_prefetch(mapped_file* file, u64 offset, u64 size) {
+    if (!file->data || offset >= file->size) {
+        return;
+    }
+    if (size > file->size - offset) {
+        size = file->size - offset;
+    }
+
+    // madvise requires a page-aligned start.
+    u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+    u64 aligned_offset = offset & ~(page_size - 1);
+    madvise((u8*)file->data + aligned_offset, size + (offset - aligned_offset), MADV_WILLNEED);
+}
+
+typedef struct posix_thread_start {
+    pfn_thread_start function;
+    void* params;
+} posix_thread_start;
+
+static void* posix_thread_entry(void* params) {
+    posix_thread_start start = *(posix_thread_start*)params;
+    platform_free(params, FALSE);
+    return (void*)(u64)start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread) {
+    if (!start_function_ptr) {
+        return FALSE;
+    }
+
+    // Handed to the new thread, which frees it.
+    posix_thread_start* start = platform_allocate(sizeof(posix_thread_start), FALSE);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    pthread_t* thread = platform_allocate(sizeof(pthread_t), FALSE);
+    i32 result = pthread_create(thread, 0, posix_thread_entry, start);
+    if (result != 0) {
+        KERROR("kthread_create failed: %s", strerror(result));
+        platform_free(start, FALSE);
+        platform_free(thread, FALSE);
+        return FALSE;
+    }
+
+    out_thread->internal_data = thread;
+    out_thread->thread_id = (u64)*thread;
+    return TRUE;
+}
+
+void kthread_wait(kthread* thread) {
+    if (thread->internal_data) {
+        pthread_join(*(pthread_t*)thread->internal_data, 0);
+        platform_free(thread->internal_data, FALSE);
+        thread->internal_data = 0;
+        thread->thread_id = 0;
+    }
+}
+
+u64 kthread_get_current_id() {
+    return (u64)pthread_self();
+}
+
+b8 kmutex_create(kmutex* out_mutex) {
+    pthread_mutex_t* mutex = platform_allocate(sizeof(pthread_mutex_t), FALSE);
+    if (pthread_mutex_init(mutex, 0) != 0) {
+        KERROR("kmutex_create failed.");
+        platform_free(mutex, FALSE);
+        return FALSE;
+    }
+    out_mutex->internal_data = mutex;
+    return TRUE;
+}
+
+void kmutex_destroy(kmutex* mutex) {
+    if (mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        platform_free(mutex->internal_data, FALSE);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex* mutex) {
+    return mutex->internal_data && pthread_mutex_lock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_unlock(kmutex* mutex) {
+    return mutex->internal_data && pthread_mutex_unlock(mutex->internal_data) == 0;
+}
+
+// NOTE: Built on a mutex and condition variable rather than sem_t, since
+// unnamed POSIX semaphores are not supported on every platform.
+typedef struct posix_semaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    u32 count;
+} posix_semaphore;
+
+b8 ksemaphore_create(ksemaphore* out_semaphore, u32 start_count) {
+    posix_semaphore* semaphore = platform_allocate(sizeof(posix_semaphore), FALSE);
+    if (pthread_mutex_init(&semaphore->mutex, 0) != 0) {
+        platform_free(semaphore, FALSE);
+        return FALSE;
+    }
+    if (pthread_cond_init(&semaphore->condition, 0) != 0) {
+        pthread_mutex_destroy(&semaphore->mutex);
+        platform_free(semaphore, FALSE);
+        return FALSE;
+    }
+    semaphore->count = start_count;
+    out_semaphore->internal_data = semaphore;
+    return TRUE;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    posix_semaphore* internal = semaphore->internal_data;
+    if (internal) {
+        pthread_cond_destroy(&internal->condition);
+        pthread_mutex_destroy(&internal->mutex);
+        platform_free(internal, FALSE);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    posix_semaphore* internal = semaphore->internal_data;
+    if (!internal) {
+        return FALSE;
+    }
+    pthread_mutex_lock(&internal->mutex);
+    internal->count++;
+    pthread_cond_signal(&internal->condition);
+    pthread_mutex_unlock(&internal->mutex);
+    return TRUE;
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms) {
+    posix_semaphore* internal = semaphore->internal_data;
+    if (!internal) {
+        return FALSE;
+    }
+
+    struct timespec deadline;
+    if (timeout_ms) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    b8 acquired = TRUE;
+    pthread_mutex_lock(&internal->mutex);
+    while (internal->count == 0) {
+        if (timeout_ms) {
+            if (pthread_cond_timedwait(&internal->condition, &internal->mutex, &deadline) == ETIMEDOUT) {
+                acquired = internal->count > 0;
+                break;
+            }
+        } else {
+            pthread_cond_wait(&internal->condition, &internal->mutex);
+        }
+    }
+    if (acquired) {
+        internal->count--;
+    }
+    pthread_mutex_unlock(&internal->mutex);
+    return acquired;
+}
+
+b8 platform_dynamic_library_load(const char* path, dynamic_library* out_library) {
+    if (!path || !out_library) {
+        return FALSE;
+    }
+
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        KERROR("Failed to load dynamic library '%s': %s", path, dlerror());
+        return FALSE;
+    }
+
+    out_library->handle = handle;
+    strncpy(out_library->path, path, sizeof(out_library->path) - 1);
+    out_library->path[sizeof(out_library->path) - 1] = 0;
+    return TRUE;
+}
+
+b8 platform_dynamic_library_unload(dynamic_library* library) {
+    if (!library || !library->handle) {
+        return FALSE;
+    }
+
+    if (dlclose(library->handle) != 0) {
+        KERROR("Failed to unload dynamic library '%s': %s", library->path, dlerror());
+        return FALSE;
+    }
+    library->handle = 0;
+    return TRUE;
+}
+
+void* platform_dynamic_library_load_function(dynamic_library* library, const char* name) {
+    if (!library || !library->handle || !name) {
+        return 0;
+    }
+
+    return dlsym(library->handle, name);
+}
+
+const char* platform_dynamic_library_extension() {
+    return ".so";
+}
+
+const char* platform_dynamic_library_prefix() {
+    return "lib";
+}
+
+b8 platform_copy_file(const char* source, const char* dest, b8 overwrite_if_exists) {
+    i32 source_fd = open(source, O_RDONLY | O_CLOEXEC);
+    if (source_fd < 0) {
+        KERROR("platform_copy_file unable to open source '%s': %s", source, strerror(errno));
+        return FALSE;
+    }
+
+    i32 flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (!overwrite_if_exists) {
+        flags |= O_EXCL;
+    }
+    i32 dest_fd = open(dest, flags, 0755);
+    if (dest_fd < 0) {
+        KERROR("platform_copy_file unable to open destination '%s': %s", dest, strerror(errno));
+        close(source_fd);
+        return FALSE;
+    }
+
+    b8 success = TRUE;
+    char buffer[65536];
+    for (;;) {
+        ssize_t read_count = read(source_fd, buffer, sizeof(buffer));
+        if (read_count == 0) {
+            break;
+        }
+        if (read_count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            success = FALSE;
+            break;
+        }
+
+        ssize_t written = 0;
+        while (written < read_count) {
+            ssize_t result = write(dest_fd, buffer + written, read_count - written);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                success = FALSE;
+                break;
+            }
+            written += result;
+        }
+        if (!success) {
+            break;
+        }
+    }
+
+    if (!success) {
+        KERROR("platform_copy_file failed copying '%s' to '%s': %s", source, dest, strerror(errno));
+    }
+
+    close(source_fd);
+    close(dest_fd);
+    return success;
+}
+
+b8 platform_watch_file(const char* file_path, u32* out_watch_id) {
+    if (!file_path || !out_watch_id) {
+        return FALSE;
+    }
+
+    if (inotify_fd < 0) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0) {
+            KERROR("Failed to initialize inotify: %s", strerror(errno));
+            return FALSE;
+        }
+    }
+
+    // Split the path into its directory and file name.
+    char directory[256] = ".";
+    const char* file_name = file_path;
+    const char* last_slash = strrchr(file_path, '/');
+    if (last_slash) {
+        u64 directory_length = last_slash - file_path;
+        if (directory_length == 0) {
+            directory_length = 1;  // Root directory.
+        }
+        if (directory_length >= sizeof(directory)) {
+            KERROR("platform_watch_file path is too long: '%s'", file_path);
+            return FALSE;
+        }
+        memcpy(directory, file_path, directory_length);
+        directory[directory_length] = 0;
+        file_name = last_slash + 1;
+    }
+
+    if (strlen(file_name) >= sizeof(file_watches[0].file_name)) {
+        KERROR("platform_watch_file file name is too long: '%s'", file_path);
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < LINUX_MAX_FILE_WATCHES; ++i) {
+        linux_file_watch* watch = &file_watches[i];
+        if (watch->in_use) {
+            continue;
+        }
+
+        // Watching the same directory again returns the same descriptor.
+        i32 wd = inotify_add_watch(inotify_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0) {
+            KERROR("Failed to watch '%s': %s", file_path, strerror(errno));
+            return FALSE;
+        }
+
+        watch->in_use = TRUE;
+        watch->written = FALSE;
+        watch->wd = wd;
+        strcpy(watch->file_name, file_name);
+        *out_watch_id = i;
+        return TRUE;
+    }
+
+    KERROR("platform_watch_file: no free watch slots (max %i).", LINUX_MAX_FILE_WATCHES);
+    return FALSE;
+}
+
+b8 platform_unwatch_file(u32 watch_id) {
+    if (watch_id >= LINUX_MAX_FILE_WATCHES || !file_watches[watch_id].in_use) {
+        return FALSE;
+    }
+
+    linux_file_watch* watch = &file_watches[watch_id];
+    watch->in_use = FALSE;
+
+    // Only drop the directory watch once nothing else in it is being watched.
+    for (u32 i = 0; i < LINUX_MAX_FILE_WATCHES; ++i) {
+        if (file_watches[i].in_use && file_watches[i].wd == watch->wd) {
+            return TRUE;
+        }
+    }
+    inotify_rm_watch(inotify_fd, watch->wd);
+    return TRUE;
+}
+
+/**
+ * Drains pending inotify events and fires EVENT_CODE_WATCHED_FILE_WRITTEN
+ * once per written file, however many writes happened since the last pump.
+ */
+static void platform_process_file_watches() {
+    if (inotify_fd < 0) {
+        return;
+    }
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN means there is nothing more to read.
+            break;
+        }
+
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            if (event->len > 0) {
+                for (u32 i = 0; i < LINUX_MAX_FILE_WATCHES; ++i) {
+                    linux_file_watch* watch = &file_watches[i];
+                    if (watch->in_use && watch->wd == event->wd && strcmp(watch->file_name, event->name) == 0) {
+                        watch->written = TRUE;
+                    }
+                }
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    for (u32 i = 0; i < LINUX_MAX_FILE_WATCHES; ++i) {
+        linux_file_watch* watch = &file_watches[i];
+        if (watch->in_use && watch->written) {
+            watch->written = FALSE;
+            event_context context = {};
+            context.data.u32[0] = i;
+            event_fire(EVENT_CODE_WATCHED_FILE_WRITTEN, 0, context);
+        }
+    }
+}
+
 keys translate_keycode(u32 x_keycode) {
     switch (x_keycode) {
         case XK_BackSpace:
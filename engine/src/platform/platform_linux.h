@@ -0,0 +1,41 @@
+#pragma once
+
+// Internal interface shared by the Linux platform backends. Not for use
+// outside of the platform layer.
+
+#include "platform.h"
+
+#if KPLATFORM_LINUX
+
+#include "core/input.h"
+
+typedef enum linux_window_system {
+    LINUX_WINDOW_SYSTEM_XCB,
+    LINUX_WINDOW_SYSTEM_WAYLAND,
+    // No window at all, see platform_null.h.
+    LINUX_WINDOW_SYSTEM_NULL,
+} linux_window_system;
+
+// Translates an X11/xkb keysym into an engine key code. Wayland delivers
+// xkb keysyms, which share their values with X11's, so both backends use this.
+keys translate_keycode(u32 x_keycode);
+
+#if KOHI_WAYLAND
+b8 platform_wayland_startup(
+    platform_state* plat_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height);
+
+void platform_wayland_shutdown(platform_state* plat_state);
+
+b8 platform_wayland_pump_messages(platform_state* plat_state);
+
+b8 platform_wayland_create_vulkan_surface(platform_state* plat_state, vulkan_context* context);
+
+void platform_wayland_get_required_extension_names(const char*** names__darray);
+#endif
+
+#endif
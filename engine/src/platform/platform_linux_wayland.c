@@ -0,0 +1,522 @@
+#include "platform_linux.h"
+
+// Linux Wayland platform backend. Selected at runtime by platform_linux.c.
+#if KPLATFORM_LINUX && KOHI_WAYLAND
+
+#include "core/event.h"
+#include "core/input.h"
+#include "core/logger.h"
+
+#include <wayland-client.h>
+#include <xkbcommon/xkbcommon.h>  // sudo apt-get install libxkbcommon-dev
+#include <linux/input-event-codes.h>
+
+// Generated by wayland-scanner in build.sh from the wayland-protocols package.
+#include "platform/generated/xdg-shell-client-protocol.h"
+
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// for surface creation
+#include <vulkan/vulkan.h>
+#include "renderer/vulkan/vulkan_types.inl"
+
+#include "containers/darray.h"
+
+// The longest a pump will wait for the compositor to ask for the next frame.
+// Hidden windows never get a frame callback, so this keeps the loop ticking
+// at a low rate instead of stalling or spinning.
+#define WAYLAND_FRAME_WAIT_MS 50
+
+typedef struct wayland_state {
+    struct wl_display* display;
+    struct wl_registry* registry;
+    struct wl_compositor* compositor;
+    struct xdg_wm_base* wm_base;
+    struct wl_seat* seat;
+    struct wl_keyboard* keyboard;
+    struct wl_pointer* pointer;
+
+    struct wl_surface* surface;
+    struct xdg_surface* xdg_surface;
+    struct xdg_toplevel* toplevel;
+    struct wl_callback* frame_callback;
+
+    struct xkb_context* xkb_context;
+    struct xkb_keymap* keymap;
+    struct xkb_state* xkb_state;
+
+    VkSurfaceKHR vk_surface;
+
+    // The last window size reported to the event system.
+    u16 width;
+    u16 height;
+    // The latest size the compositor configured.
+    u16 pending_width;
+    u16 pending_height;
+
+    // Set once the first xdg_surface.configure has been acknowledged.
+    b8 configured;
+    // Set when the compositor has signalled that it wants a new frame.
+    b8 frame_ready;
+    b8 quit_flagged;
+} wayland_state;
+
+static void wayland_destroy(wayland_state* state);
+static void wayland_read_events(wayland_state* state, i32 timeout_ms);
+
+// Registry
+
+static void registry_global(void* data, struct wl_registry* registry, u32 name, const char* interface, u32 version);
+static void registry_global_remove(void* data, struct wl_registry* registry, u32 name);
+
+static const struct wl_registry_listener registry_listener = {
+    .global = registry_global,
+    .global_remove = registry_global_remove,
+};
+
+// Shell
+
+static void wm_base_ping(void* data, struct xdg_wm_base* wm_base, u32 serial) {
+    xdg_wm_base_pong(wm_base, serial);
+}
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+    .ping = wm_base_ping,
+};
+
+static void xdg_surface_configure(void* data, struct xdg_surface* xdg_surface, u32 serial) {
+    wayland_state* state = (wayland_state*)data;
+    xdg_surface_ack_configure(xdg_surface, serial);
+    state->configured = TRUE;
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+    .configure = xdg_surface_configure,
+};
+
+static void toplevel_configure(void* data, struct xdg_toplevel* toplevel, i32 width, i32 height, struct wl_array* states) {
+    wayland_state* state = (wayland_state*)data;
+    // A zero size means the client is free to pick, so keep the current one.
+    if (width > 0 && height > 0) {
+        state->pending_width = (u16)width;
+        state->pending_height = (u16)height;
+    }
+}
+
+static void toplevel_close(void* data, struct xdg_toplevel* toplevel) {
+    wayland_state* state = (wayland_state*)data;
+    state->quit_flagged = TRUE;
+}
+
+static const struct xdg_toplevel_listener toplevel_listener = {
+    .configure = toplevel_configure,
+    .close = toplevel_close,
+};
+
+// Frame pacing
+
+static void frame_done(void* data, struct wl_callback* callback, u32 time) {
+    wayland_state* state = (wayland_state*)data;
+    wl_callback_destroy(callback);
+    state->frame_callback = 0;
+    state->frame_ready = TRUE;
+}
+
+static const struct wl_callback_listener frame_listener = {
+    .done = frame_done,
+};
+
+// Keyboard
+
+static void keyboard_keymap(void* data, struct wl_keyboard* keyboard, u32 format, i32 fd, u32 size) {
+    wayland_state* state = (wayland_state*)data;
+    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
+        close(fd);
+        return;
+    }
+
+    char* map_string = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map_string == MAP_FAILED) {
+        KERROR("Failed to map Wayland keymap.");
+        return;
+    }
+
+    struct xkb_keymap* keymap = xkb_keymap_new_from_string(
+        state->xkb_context,
+        map_string,
+        XKB_KEYMAP_FORMAT_TEXT_V1,
+        XKB_KEYMAP_COMPILE_NO_FLAGS);
+    munmap(map_string, size);
+    if (!keymap) {
+        KERROR("Failed to compile Wayland keymap.");
+        return;
+    }
+
+    if (state->xkb_state) {
+        xkb_state_unref(state->xkb_state);
+    }
+    if (state->keymap) {
+        xkb_keymap_unref(state->keymap);
+    }
+    state->keymap = keymap;
+    state->xkb_state = xkb_state_new(keymap);
+}
+
+static void keyboard_enter(void* data, struct wl_keyboard* keyboard, u32 serial, struct wl_surface* surface, struct wl_array* keys) {
+}
+
+static void keyboard_leave(void* data, struct wl_keyboard* keyboard, u32 serial, struct wl_surface* surface) {
+}
+
+static void keyboard_key(void* data, struct wl_keyboard* keyboard, u32 serial, u32 time, u32 key, u32 key_state) {
+    wayland_state* state = (wayland_state*)data;
+    if (!state->xkb_state) {
+        return;
+    }
+
+    // Wayland key codes are evdev codes, xkb's are offset by 8.
+    xkb_keysym_t key_sym = xkb_state_key_get_one_sym(state->xkb_state, key + 8);
+    keys translated = translate_keycode(key_sym);
+
+    // Pass to the input subsystem for processing.
+    input_process_key(translated, key_state == WL_KEYBOARD_KEY_STATE_PRESSED);
+}
+
+static void keyboard_modifiers(void* data, struct wl_keyboard* keyboard, u32 serial, u32 depressed, u32 latched, u32 locked, u32 group) {
+    wayland_state* state = (wayland_state*)data;
+    if (state->xkb_state) {
+        xkb_state_update_mask(state->xkb_state, depressed, latched, locked, 0, 0, group);
+    }
+}
+
+static void keyboard_repeat_info(void* data, struct wl_keyboard* keyboard, i32 rate, i32 delay) {
+    // Key repeat is left off, matching the X11 backend.
+}
+
+static const struct wl_keyboard_listener keyboard_listener = {
+    .keymap = keyboard_keymap,
+    .enter = keyboard_enter,
+    .leave = keyboard_leave,
+    .key = keyboard_key,
+    .modifiers = keyboard_modifiers,
+    .repeat_info = keyboard_repeat_info,
+};
+
+// Pointer
+
+static void pointer_enter(void* data, struct wl_pointer* pointer, u32 serial, struct wl_surface* surface, wl_fixed_t x, wl_fixed_t y) {
+    input_process_mouse_move(wl_fixed_to_int(x), wl_fixed_to_int(y));
+}
+
+static void pointer_leave(void* data, struct wl_pointer* pointer, u32 serial, struct wl_surface* surface) {
+}
+
+static void pointer_motion(void* data, struct wl_pointer* pointer, u32 time, wl_fixed_t x, wl_fixed_t y) {
+    // Pass over to the input subsystem.
+    input_process_mouse_move(wl_fixed_to_int(x), wl_fixed_to_int(y));
+}
+
+static void pointer_button(void* data, struct wl_pointer* pointer, u32 serial, u32 time, u32 button, u32 button_state) {
+    buttons mouse_button = BUTTON_MAX_BUTTONS;
+    switch (button) {
+        case BTN_LEFT:
+            mouse_button = BUTTON_LEFT;
+            break;
+        case BTN_MIDDLE:
+            mouse_button = BUTTON_MIDDLE;
+            break;
+        case BTN_RIGHT:
+            mouse_button = BUTTON_RIGHT;
+            break;
+    }
+
+    // Pass over to the input subsystem.
+    if (mouse_button != BUTTON_MAX_BUTTONS) {
+        input_process_button(mouse_button, button_state == WL_POINTER_BUTTON_STATE_PRESSED);
+    }
+}
+
+static void pointer_axis(void* data, struct wl_pointer* pointer, u32 time, u32 axis, wl_fixed_t value) {
+    if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL && value != 0) {
+        // Flatten into an OS-independent (-1, 1), positive being away from the user.
+        input_process_mouse_wheel(value < 0 ? 1 : -1);
+    }
+}
+
+static const struct wl_pointer_listener pointer_listener = {
+    .enter = pointer_enter,
+    .leave = pointer_leave,
+    .motion = pointer_motion,
+    .button = pointer_button,
+    .axis = pointer_axis,
+};
+
+// Seat
+
+static void seat_capabilities(void* data, struct wl_seat* seat, u32 capabilities) {
+    wayland_state* state = (wayland_state*)data;
+
+    b8 has_keyboard = (capabilities & WL_SEAT_CAPABILITY_KEYBOARD) != 0;
+    if (has_keyboard && !state->keyboard) {
+        state->keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(state->keyboard, &keyboard_listener, state);
+    } else if (!has_keyboard && state->keyboard) {
+        wl_keyboard_destroy(state->keyboard);
+        state->keyboard = 0;
+    }
+
+    b8 has_pointer = (capabilities & WL_SEAT_CAPABILITY_POINTER) != 0;
+    if (has_pointer && !state->pointer) {
+        state->pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(state->pointer, &pointer_listener, state);
+    } else if (!has_pointer && state->pointer) {
+        wl_pointer_destroy(state->pointer);
+        state->pointer = 0;
+    }
+}
+
+static void seat_name(void* data, struct wl_seat* seat, const char* name) {
+}
+
+static const struct wl_seat_listener seat_listener = {
+    .capabilities = seat_capabilities,
+    .name = seat_name,
+};
+
+static void registry_global(void* data, struct wl_registry* registry, u32 name, const char* interface, u32 version) {
+    wayland_state* state = (wayland_state*)data;
+
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        state->compositor = wl_registry_bind(registry, name, &wl_compositor_interface, KMIN(version, 4));
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        state->wm_base = wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener(state->wm_base, &wm_base_listener, state);
+    } else if (strcmp(interface, wl_seat_interface.name) == 0 && !state->seat) {
+        // Version 4 is the newest whose events are all handled above.
+        state->seat = wl_registry_bind(registry, name, &wl_seat_interface, KMIN(version, 4));
+        wl_seat_add_listener(state->seat, &seat_listener, state);
+    }
+}
+
+static void registry_global_remove(void* data, struct wl_registry* registry, u32 name) {
+}
+
+b8 platform_wayland_startup(
+    platform_state* plat_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height) {
+    // Create the internal state.
+    wayland_state* state = malloc(sizeof(wayland_state));
+    memset(state, 0, sizeof(wayland_state));
+    plat_state->internal_state = state;
+
+    // NOTE: Wayland clients cannot position their own windows, so x/y are ignored.
+    state->width = state->pending_width = (u16)width;
+    state->height = state->pending_height = (u16)height;
+    state->frame_ready = TRUE;
+
+    state->display = wl_display_connect(0);
+    if (!state->display) {
+        KERROR("Failed to connect to a Wayland compositor.");
+        wayland_destroy(state);
+        plat_state->internal_state = 0;
+        return FALSE;
+    }
+
+    state->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+
+    // Gather the globals.
+    state->registry = wl_display_get_registry(state->display);
+    wl_registry_add_listener(state->registry, &registry_listener, state);
+    wl_display_roundtrip(state->display);
+
+    if (!state->compositor || !state->wm_base) {
+        KERROR("Wayland compositor does not support wl_compositor and xdg_wm_base.");
+        wayland_destroy(state);
+        plat_state->internal_state = 0;
+        return FALSE;
+    }
+
+    // Create the window
+    state->surface = wl_compositor_create_surface(state->compositor);
+    state->xdg_surface = xdg_wm_base_get_xdg_surface(state->wm_base, state->surface);
+    xdg_surface_add_listener(state->xdg_surface, &xdg_surface_listener, state);
+    state->toplevel = xdg_surface_get_toplevel(state->xdg_surface);
+    xdg_toplevel_add_listener(state->toplevel, &toplevel_listener, state);
+
+    // Change the title
+    xdg_toplevel_set_title(state->toplevel, application_name);
+    xdg_toplevel_set_app_id(state->toplevel, application_name);
+
+    // The surface may not have a buffer attached until it has been configured.
+    wl_surface_commit(state->surface);
+    while (!state->configured) {
+        if (wl_display_dispatch(state->display) < 0) {
+            KERROR("Lost the Wayland connection while waiting for the window to be configured.");
+            wayland_destroy(state);
+            plat_state->internal_state = 0;
+            return FALSE;
+        }
+    }
+
+    // The first configure may already hold the real size. Take it as the starting size.
+    state->width = state->pending_width;
+    state->height = state->pending_height;
+
+    return TRUE;
+}
+
+void platform_wayland_shutdown(platform_state* plat_state) {
+    wayland_state* state = (wayland_state*)plat_state->internal_state;
+    if (state) {
+        wayland_destroy(state);
+        plat_state->internal_state = 0;
+    }
+}
+
+b8 platform_wayland_pump_messages(platform_state* plat_state) {
+    wayland_state* state = (wayland_state*)plat_state->internal_state;
+
+    // Pace the loop to the compositor. If the last frame has not been asked
+    // for yet, wait (up to a limit) for the frame callback, handling any
+    // input that arrives in the meantime.
+    if (state->frame_ready) {
+        wayland_read_events(state, 0);
+    } else {
+        f64 deadline = platform_get_absolute_time(plat_state) + (WAYLAND_FRAME_WAIT_MS / 1000.0);
+        while (!state->frame_ready && !state->quit_flagged) {
+            i32 remaining_ms = (i32)((deadline - platform_get_absolute_time(plat_state)) * 1000.0);
+            if (remaining_ms <= 0) {
+                break;
+            }
+            wayland_read_events(state, remaining_ms);
+            if (wl_display_get_error(state->display)) {
+                break;
+            }
+        }
+    }
+
+    if (wl_display_get_error(state->display)) {
+        KERROR("The Wayland connection was lost.");
+        return FALSE;
+    }
+
+    // Ask to be told when to draw the next frame. This is attached to the
+    // surface commit done by the upcoming present.
+    if (state->frame_ready) {
+        state->frame_callback = wl_surface_frame(state->surface);
+        wl_callback_add_listener(state->frame_callback, &frame_listener, state);
+        state->frame_ready = FALSE;
+    }
+
+    // Fire the event for the final size only, and only if it actually changed.
+    if (state->pending_width != state->width || state->pending_height != state->height) {
+        state->width = state->pending_width;
+        state->height = state->pending_height;
+
+        event_context context;
+        context.data.u16[0] = state->width;
+        context.data.u16[1] = state->height;
+        event_fire(EVENT_CODE_RESIZED, 0, context);
+    }
+
+    return !state->quit_flagged;
+}
+
+b8 platform_wayland_create_vulkan_surface(platform_state* plat_state, vulkan_context* context) {
+    wayland_state* state = (wayland_state*)plat_state->internal_state;
+
+    VkWaylandSurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_WAYLAND_SURFACE_CREATE_INFO_KHR};
+    create_info.display = state->display;
+    create_info.surface = state->surface;
+
+    VkResult result = vkCreateWaylandSurfaceKHR(context->instance, &create_info, context->allocator, &state->vk_surface);
+    if (result != VK_SUCCESS) {
+        KERROR("Failed to create Wayland Vulkan surface. Error code: %d", result);
+        return FALSE;
+    }
+    context->surface = state->vk_surface;
+    return TRUE;
+}
+
+void platform_wayland_get_required_extension_names(const char*** names__darray) {
+    darray_push(*names__darray, &VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
+}
+
+/**
+ * Dispatches queued events, then waits up to timeout_ms for more to arrive
+ * from the compositor and dispatches those as well. Never blocks when
+ * timeout_ms is 0.
+ */
+static void wayland_read_events(wayland_state* state, i32 timeout_ms) {
+    while (wl_display_prepare_read(state->display) != 0) {
+        wl_display_dispatch_pending(state->display);
+    }
+    wl_display_flush(state->display);
+
+    struct pollfd fd = {wl_display_get_fd(state->display), POLLIN, 0};
+    if (poll(&fd, 1, timeout_ms) > 0 && (fd.revents & POLLIN)) {
+        wl_display_read_events(state->display);
+    } else {
+        wl_display_cancel_read(state->display);
+    }
+
+    wl_display_dispatch_pending(state->display);
+}
+
+static void wayland_destroy(wayland_state* state) {
+    // The Vulkan surface is owned and destroyed by the renderer.
+    if (state->frame_callback) {
+        wl_callback_destroy(state->frame_callback);
+    }
+    if (state->toplevel) {
+        xdg_toplevel_destroy(state->toplevel);
+    }
+    if (state->xdg_surface) {
+        xdg_surface_destroy(state->xdg_surface);
+    }
+    if (state->surface) {
+        wl_surface_destroy(state->surface);
+    }
+    if (state->keyboard) {
+        wl_keyboard_destroy(state->keyboard);
+    }
+    if (state->pointer) {
+        wl_pointer_destroy(state->pointer);
+    }
+    if (state->seat) {
+        wl_seat_destroy(state->seat);
+    }
+    if (state->wm_base) {
+        xdg_wm_base_destroy(state->wm_base);
+    }
+    if (state->compositor) {
+        wl_compositor_destroy(state->compositor);
+    }
+    if (state->registry) {
+        wl_registry_destroy(state->registry);
+    }
+    if (state->xkb_state) {
+        xkb_state_unref(state->xkb_state);
+    }
+    if (state->keymap) {
+        xkb_keymap_unref(state->keymap);
+    }
+    if (state->xkb_context) {
+        xkb_context_unref(state->xkb_context);
+    }
+    if (state->display) {
+        wl_display_disconnect(state->display);
+    }
+    free(state);
+}
+
+#endif
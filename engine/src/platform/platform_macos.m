@@ -1,4 +1,5 @@
 #include "platform.h"
+#include "platform_null.h"
 #include <vulkan/vulkan.h>
 // macOS platform layer using native Cocoa/AppKit
 #if KPLATFORM_APPLE
@@ -12,8 +13,20 @@
 #include <mach/mach_time.h>
 #include <stdlib.h>
 #include <string.h>
+#include <dlfcn.h>
+#include <copyfile.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "containers/darray.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
 // // For surface creation - MoltenVK on macOS
 // #define VK_USE_PLATFORM_METAL_EXT  // Define BEFORE including Vulkan headers
 #include <vulkan/vulkan.h> 
@@ -261,14 +274,37 @@ typedef struct internal_state {
     CAMetalLayer* metal_layer;
     
     b8 quit_flagged; 
-    // Timing
-    mach_timebase_info_data_t timebase_info;
-    u64 start_time;
     
     // Vulkan surface
     VkSurfaceKHR surface; 
 } internal_state;
 
+// Timing. Kept out of internal_state, as the null platform times itself too.
+static mach_timebase_info_data_t timebase_info;
+static u64 start_time;
+
+// Set when started without a window, in which case the null platform handles everything the window would.
+static b8 headless = FALSE;
+
+// The maximum number of files which can be watched at once.
+#define MACOS_MAX_FILE_WATCHES 64
+
+typedef struct macos_file_watch {
+    b8 in_use;
+    // What the file looked like when last checked. A replaced file has a new inode.
+    ino_t inode;
+    struct timespec modified;
+    off_t size;
+    char* file_path;
+} macos_file_watch;
+
+// Watched files are polled from platform_pump_messages. A kqueue vnode watch
+// would follow the open file, and so miss tools which replace a file (write
+// to a temp file and rename) rather than writing it in place.
+static macos_file_watch file_watches[MACOS_MAX_FILE_WATCHES];
+
+static void platform_process_file_watches();
+
 // In platform_startup:
 b8 platform_startup(
     platform_state* plat_state,
@@ -277,6 +313,13 @@ b8 platform_startup(
     i32 y,
     i32 width,
     i32 height) {
+    mach_timebase_info(&timebase_info);
+    start_time = mach_absolute_time();
+
+    headless = platform_null_requested();
+    if (headless) {
+        return platform_null_startup(plat_state, application_name, x, y, width, height);
+    }
     
     @autoreleasepool {
         plat_state->internal_state = malloc(sizeof(internal_state));
@@ -364,9 +407,6 @@ b8 platform_startup(
             return FALSE;
         }
         
-        mach_timebase_info(&state->timebase_info);
-        state->start_time = mach_absolute_time();
-        
         KINFO("macOS platform initialized: %dx%d at (%d, %d)", width, height, x, y);
         KINFO("CAMetalLayer ready for Vulkan surface creation");
         
@@ -374,6 +414,10 @@ b8 platform_startup(
     }
 }
 void platform_shutdown(platform_state* plat_state) {
+    if (headless) {
+        platform_null_shutdown(plat_state);
+        return;
+    }
     @autoreleasepool {
         internal_state* state = (internal_state*)plat_state->internal_state;
         
@@ -393,7 +437,16 @@ void platform_shutdown(platform_state* plat_state) {
     }
 }
 
+b8 platform_is_headless(platform_state* plat_state) {
+    return headless;
+}
+
 b8 platform_pump_messages(platform_state* plat_state) {
+    platform_process_file_watches();
+
+    if (headless) {
+        return platform_null_pump_messages(plat_state);
+    }
     @autoreleasepool {
         internal_state* state = (internal_state*)plat_state->internal_state;
         
@@ -453,13 +506,11 @@ void platform_console_write_error(const char* message, u8 colour) {
 }
 
 f64 platform_get_absolute_time(platform_state* plat_state) {
-    internal_state* state = (internal_state*)plat_state->internal_state;
-    
     u64 now = mach_absolute_time();
-    u64 elapsed = now - state->start_time;
+    u64 elapsed = now - start_time;
     
-    return (f64)elapsed * state->timebase_info.numer / 
-           (state->timebase_info.denom * 1000000000.0);
+    return (f64)elapsed * timebase_info.numer / 
+           (timebase_info.denom * 1000000000.0);
 }
 
 void platform_sleep(u64 ms) {
@@ -471,7 +522,382 @@ void platform_sleep(u64 ms) {
     nanosleep(&req, NULL);
 }
 
+i32 platform_get_processor_count() {
+    i32 count = (i32)sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+}
+
+b8 platform_map_file(const char* path, u32 hints, mapped_file* out_file) {
+    out_file->data = 0;
+    out_file->size = 0;
+    out_file->internal = 0;
+
+    i32 fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        KERROR("platform_map_file unable to open '%s': %s", path, strerror(errno));
+        return FALSE;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        KERROR("platform_map_file unable to stat '%s': %s", path, strerror(errno));
+        close(fd);
+        return FALSE;
+    }
+
+    // Nothing to map for an empty file, but it is still a valid file.
+    if (file_stat.st_size == 0) {
+        close(fd);
+        return TRUE;
+    }
+
+    void* data = mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file.
+    close(fd);
+    if (data == MAP_FAILED) {
+        KERROR("platform_map_file unable to map '%s': %s", path, strerror(errno));
+        return FALSE;
+    }
+
+    if (hints & FILE_MAP_HINT_SEQUENTIAL) {
+        madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+    } else if (hints & FILE_MAP_HINT_RANDOM) {
+        madvise(data, file_stat.st_size, MADV_RANDOM);
+    }
+    if (hints & FILE_MAP_HINT_WILLNEED) {
+        madvise(data, file_stat.st_size, MADV_WILLNEED);
+    }
+
+    out_file->data = data;
+    out_file->size = file_stat.st_size;
+    return TRUE;
+}
+
+void platform_unmap_file(mapped_file* file) {
+    if (file->data) {
+        munmap((void*)file->data, file->size);
+    }
+    file->data = 0;
+    file->size = 0;
+    file->internal = 0;
+}
+
+void platform_mapped_file_prefetch(mapped_file* file, u64 offset, u64 size) {
+    if (!file->data || offset >= file->size) {
+        return;
+    }
+    if (size > file->size - offset) {
+        size = file->size - offset;
+    }
+
+    // madvise requires a page-aligned start.
+    u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+    u64 aligned_offset = offset & ~(page_size - 1);
+    madvise((u8*)file->data + aligned_offset, size + (offset - aligned_offset), MADV_WILLNEED);
+}
+
+typedef struct posix_thread_start {
+    pfn_thread_start function;
+    void* params;
+} posix_thread_start;
+
+static void* posix_thread_entry(void* params) {
+    posix_thread_start start = *(posix_thread_start*)params;
+    platform_free(params, FALSE);
+    return (void*)(u64)start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread) {
+    if (!start_function_ptr) {
+        return FALSE;
+    }
+
+    // Handed to the new thread, which frees it.
+    posix_thread_start* start = platform_allocate(sizeof(posix_thread_start), FALSE);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    pthread_t* thread = platform_allocate(sizeof(pthread_t), FALSE);
+    i32 result = pthread_create(thread, 0, posix_thread_entry, start);
+    if (result != 0) {
+        KERROR("kthread_create failed: %s", strerror(result));
+        platform_free(start, FALSE);
+        platform_free(thread, FALSE);
+        return FALSE;
+    }
+
+    out_thread->internal_data = thread;
+    out_thread->thread_id = (u64)*thread;
+    return TRUE;
+}
+
+void kthread_wait(kthread* thread) {
+    if (thread->internal_data) {
+        pthread_join(*(pthread_t*)thread->internal_data, 0);
+        platform_free(thread->internal_data, FALSE);
+        thread->internal_data = 0;
+        thread->thread_id = 0;
+    }
+}
+
+u64 kthread_get_current_id() {
+    return (u64)pthread_self();
+}
+
+b8 kmutex_create(kmutex* out_mutex) {
+    pthread_mutex_t* mutex = platform_allocate(sizeof(pthread_mutex_t), FALSE);
+    if (pthread_mutex_init(mutex, 0) != 0) {
+        KERROR("kmutex_create failed.");
+        platform_free(mutex, FALSE);
+        return FALSE;
+    }
+    out_mutex->internal_data = mutex;
+    return TRUE;
+}
+
+void kmutex_destroy(kmutex* mutex) {
+    if (mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        platform_free(mutex->internal_data, FALSE);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex* mutex) {
+    return mutex->internal_data && pthread_mutex_lock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_unlock(kmutex* mutex) {
+    return mutex->internal_data && pthread_mutex_unlock(mutex->internal_data) == 0;
+}
+
+// NOTE: Built on a mutex and condition variable rather than sem_t, since
+// unnamed POSIX semaphores are not supported on every platform.
+typedef struct posix_semaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    u32 count;
+} posix_semaphore;
+
+b8 ksemaphore_create(ksemaphore* out_semaphore, u32 start_count) {
+    posix_semaphore* semaphore = platform_allocate(sizeof(posix_semaphore), FALSE);
+    if (pthread_mutex_init(&semaphore->mutex, 0) != 0) {
+        platform_free(semaphore, FALSE);
+        return FALSE;
+    }
+    if (pthread_cond_init(&semaphore->condition, 0) != 0) {
+        pthread_mutex_destroy(&semaphore->mutex);
+        platform_free(semaphore, FALSE);
+        return FALSE;
+    }
+    semaphore->count = start_count;
+    out_semaphore->internal_data = semaphore;
+    return TRUE;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    posix_semaphore* internal = semaphore->internal_data;
+    if (internal) {
+        pthread_cond_destroy(&internal->condition);
+        pthread_mutex_destroy(&internal->mutex);
+        platform_free(internal, FALSE);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    posix_semaphore* internal = semaphore->internal_data;
+    if (!internal) {
+        return FALSE;
+    }
+    pthread_mutex_lock(&internal->mutex);
+    internal->count++;
+    pthread_cond_signal(&internal->condition);
+    pthread_mutex_unlock(&internal->mutex);
+    return TRUE;
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms) {
+    posix_semaphore* internal = semaphore->internal_data;
+    if (!internal) {
+        return FALSE;
+    }
+
+    struct timespec deadline;
+    if (timeout_ms) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    b8 acquired = TRUE;
+    pthread_mutex_lock(&internal->mutex);
+    while (internal->count == 0) {
+        if (timeout_ms) {
+            if (pthread_cond_timedwait(&internal->condition, &internal->mutex, &deadline) == ETIMEDOUT) {
+                acquired = internal->count > 0;
+                break;
+            }
+        } else {
+            pthread_cond_wait(&internal->condition, &internal->mutex);
+        }
+    }
+    if (acquired) {
+        internal->count--;
+    }
+    pthread_mutex_unlock(&internal->mutex);
+    return acquired;
+}
+
+b8 platform_dynamic_library_load(const char* path, dynamic_library* out_library) {
+    if (!path || !out_library) {
+        return FALSE;
+    }
+
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        KERROR("Failed to load dynamic library '%s': %s", path, dlerror());
+        return FALSE;
+    }
+
+    out_library->handle = handle;
+    strncpy(out_library->path, path, sizeof(out_library->path) - 1);
+    out_library->path[sizeof(out_library->path) - 1] = 0;
+    return TRUE;
+}
+
+b8 platform_dynamic_library_unload(dynamic_library* library) {
+    if (!library || !library->handle) {
+        return FALSE;
+    }
+
+    if (dlclose(library->handle) != 0) {
+        KERROR("Failed to unload dynamic library '%s': %s", library->path, dlerror());
+        return FALSE;
+    }
+    library->handle = 0;
+    return TRUE;
+}
+
+void* platform_dynamic_library_load_function(dynamic_library* library, const char* name) {
+    if (!library || !library->handle || !name) {
+        return 0;
+    }
+
+    return dlsym(library->handle, name);
+}
+
+const char* platform_dynamic_library_extension() {
+    return ".dylib";
+}
+
+const char* platform_dynamic_library_prefix() {
+    return "lib";
+}
+
+b8 platform_copy_file(const char* source, const char* dest, b8 overwrite_if_exists) {
+    copyfile_flags_t flags = COPYFILE_ALL;
+    if (!overwrite_if_exists) {
+        flags |= COPYFILE_EXCL;
+    }
+    if (copyfile(source, dest, 0, flags) != 0) {
+        KERROR("platform_copy_file failed copying '%s' to '%s'.", source, dest);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Records the file's current state. A missing file is recorded as all zeroes, so it is seen when it appears.
+static void file_watch_snapshot(macos_file_watch* watch) {
+    struct stat info;
+    if (stat(watch->file_path, &info) != 0) {
+        memset(&info, 0, sizeof(info));
+    }
+    watch->inode = info.st_ino;
+    watch->modified = info.st_mtimespec;
+    watch->size = info.st_size;
+}
+
+b8 platform_watch_file(const char* file_path, u32* out_watch_id) {
+    if (!file_path || !out_watch_id) {
+        return FALSE;
+    }
+
+    struct stat info;
+    if (stat(file_path, &info) != 0) {
+        KERROR("Failed to watch '%s': %s", file_path, strerror(errno));
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < MACOS_MAX_FILE_WATCHES; ++i) {
+        macos_file_watch* watch = &file_watches[i];
+        if (watch->in_use) {
+            continue;
+        }
+
+        watch->file_path = strdup(file_path);
+        if (!watch->file_path) {
+            return FALSE;
+        }
+        file_watch_snapshot(watch);
+        watch->in_use = TRUE;
+        *out_watch_id = i;
+        return TRUE;
+    }
+
+    KERROR("platform_watch_file: no free watch slots (max %i).", MACOS_MAX_FILE_WATCHES);
+    return FALSE;
+}
+
+b8 platform_unwatch_file(u32 watch_id) {
+    if (watch_id >= MACOS_MAX_FILE_WATCHES || !file_watches[watch_id].in_use) {
+        return FALSE;
+    }
+
+    macos_file_watch* watch = &file_watches[watch_id];
+    watch->in_use = FALSE;
+    free(watch->file_path);
+    watch->file_path = 0;
+    return TRUE;
+}
+
+/**
+ * Checks each watched file and fires EVENT_CODE_WATCHED_FILE_WRITTEN once per
+ * file that changed, however many writes happened since the last pump.
+ */
+static void platform_process_file_watches() {
+    for (u32 i = 0; i < MACOS_MAX_FILE_WATCHES; ++i) {
+        macos_file_watch* watch = &file_watches[i];
+        if (!watch->in_use) {
+            continue;
+        }
+
+        ino_t inode = watch->inode;
+        struct timespec modified = watch->modified;
+        off_t size = watch->size;
+        file_watch_snapshot(watch);
+        if (watch->inode == 0) {
+            // Removed, or midway through being replaced. Fire once it is back.
+            continue;
+        }
+        if (watch->inode != inode || watch->size != size ||
+            watch->modified.tv_sec != modified.tv_sec || watch->modified.tv_nsec != modified.tv_nsec) {
+            event_context context = {};
+            context.data.u32[0] = i;
+            event_fire(EVENT_CODE_WATCHED_FILE_WRITTEN, 0, context);
+        }
+    }
+}
+
 void platform_get_required_extension_names(const char ***names__darray) {
+    if (headless) {
+        platform_null_get_required_extension_names(names__darray);
+        return;
+    }
     // VK_KHR_portability_enumeration is required on macOS/MoltenVK since Vulkan SDK 1.3.216.
     //
     // WHY IT CRASHED:
@@ -499,6 +925,9 @@ void platform_get_required_extension_names(const char ***names__darray) {
 b8 platform_create_vulkan_surface(
     platform_state* plat_state,
     vulkan_context* context) {
+    if (headless) {
+        return platform_null_create_vulkan_surface(plat_state, context);
+    }
     @autoreleasepool {
         internal_state* state = (internal_state*)plat_state->internal_state;
         // Extensive validation
@@ -0,0 +1,210 @@
+#include "platform_null.h"
+
+#include "core/event.h"
+#include "core/logger.h"
+
+#include <stdlib.h>
+
+// How many synthetic events can be queued between two pumps.
+#define NULL_PLATFORM_MAX_QUEUED_EVENTS 256
+
+typedef enum null_event_type {
+    NULL_EVENT_KEY,
+    NULL_EVENT_BUTTON,
+    NULL_EVENT_MOUSE_MOVE,
+    NULL_EVENT_MOUSE_WHEEL,
+    NULL_EVENT_RESIZE,
+    NULL_EVENT_QUIT
+} null_event_type;
+
+typedef struct null_event {
+    null_event_type type;
+    union {
+        struct {
+            u16 code;
+            b8 pressed;
+        } key;
+        struct {
+            i16 x;
+            i16 y;
+        } mouse;
+        struct {
+            u16 width;
+            u16 height;
+        } size;
+        i8 z_delta;
+    };
+} null_event;
+
+typedef struct null_platform_state {
+    // Frames pumped so far.
+    u64 frame_count;
+    // Quit after this many frames. 0 means no limit.
+    u64 frame_limit;
+    f64 start_time;
+} null_platform_state;
+
+// The queue is kept outside of the platform state so input can be queued
+// before startup, e.g. by a test harness preparing a scripted run.
+static null_event queued_events[NULL_PLATFORM_MAX_QUEUED_EVENTS];
+static u32 queued_event_count = 0;
+
+static void queue_event(null_event event) {
+    if (queued_event_count >= NULL_PLATFORM_MAX_QUEUED_EVENTS) {
+        KWARN("Null platform event queue is full, dropping synthetic event.");
+        return;
+    }
+    queued_events[queued_event_count++] = event;
+}
+
+void platform_null_queue_key(keys key, b8 pressed) {
+    null_event event = {NULL_EVENT_KEY};
+    event.key.code = key;
+    event.key.pressed = pressed;
+    queue_event(event);
+}
+
+void platform_null_queue_button(buttons button, b8 pressed) {
+    null_event event = {NULL_EVENT_BUTTON};
+    event.key.code = button;
+    event.key.pressed = pressed;
+    queue_event(event);
+}
+
+void platform_null_queue_mouse_move(i16 x, i16 y) {
+    null_event event = {NULL_EVENT_MOUSE_MOVE};
+    event.mouse.x = x;
+    event.mouse.y = y;
+    queue_event(event);
+}
+
+void platform_null_queue_mouse_wheel(i8 z_delta) {
+    null_event event = {NULL_EVENT_MOUSE_WHEEL};
+    event.z_delta = z_delta;
+    queue_event(event);
+}
+
+void platform_null_queue_resize(u16 width, u16 height) {
+    null_event event = {NULL_EVENT_RESIZE};
+    event.size.width = width;
+    event.size.height = height;
+    queue_event(event);
+}
+
+void platform_null_queue_quit() {
+    null_event event = {NULL_EVENT_QUIT};
+    queue_event(event);
+}
+
+// Compares ASCII strings ignoring case, as the platforms' own functions for it differ.
+static b8 equals_ignoring_case(const char* a, const char* b) {
+    for (; *a && *b; ++a, ++b) {
+        char ca = (*a >= 'A' && *a <= 'Z') ? (char)(*a + 32) : *a;
+        char cb = (*b >= 'A' && *b <= 'Z') ? (char)(*b + 32) : *b;
+        if (ca != cb) {
+            return FALSE;
+        }
+    }
+    return *a == *b;
+}
+
+b8 platform_null_requested() {
+    const char* requested = getenv("KOHI_PLATFORM");
+    return requested && (equals_ignoring_case(requested, "null") || equals_ignoring_case(requested, "headless"));
+}
+
+b8 platform_null_startup(
+    platform_state* plat_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height) {
+    plat_state->internal_state = platform_allocate(sizeof(null_platform_state), FALSE);
+    null_platform_state* state = (null_platform_state*)plat_state->internal_state;
+    platform_zero_memory(state, sizeof(null_platform_state));
+
+    const char* frame_limit = getenv("KOHI_NULL_FRAME_LIMIT");
+    if (frame_limit && frame_limit[0]) {
+        state->frame_limit = strtoull(frame_limit, 0, 10);
+    }
+
+    state->start_time = platform_get_absolute_time(plat_state);
+
+    if (state->frame_limit) {
+        KINFO("Null platform started for '%s' (%ix%i), quitting after %llu frames.", application_name, width, height, state->frame_limit);
+    } else {
+        KINFO("Null platform started for '%s' (%ix%i).", application_name, width, height);
+    }
+    return TRUE;
+}
+
+void platform_null_shutdown(platform_state* plat_state) {
+    null_platform_state* state = (null_platform_state*)plat_state->internal_state;
+    if (!state) {
+        return;
+    }
+
+    f64 elapsed = platform_get_absolute_time(plat_state) - state->start_time;
+    if (state->frame_count > 0 && elapsed > 0) {
+        KINFO("Null platform ran %llu frames in %.3fs (%.4fms/frame, %.1f fps).",
+              state->frame_count,
+              elapsed,
+              (elapsed * 1000.0) / (f64)state->frame_count,
+              (f64)state->frame_count / elapsed);
+    }
+
+    platform_free(state, FALSE);
+    plat_state->internal_state = 0;
+}
+
+b8 platform_null_pump_messages(platform_state* plat_state) {
+    null_platform_state* state = (null_platform_state*)plat_state->internal_state;
+
+    b8 quit_flagged = FALSE;
+
+    // Deliver everything queued since the last pump, in order.
+    for (u32 i = 0; i < queued_event_count; ++i) {
+        null_event* event = &queued_events[i];
+        switch (event->type) {
+            case NULL_EVENT_KEY:
+                input_process_key((keys)event->key.code, event->key.pressed);
+                break;
+            case NULL_EVENT_BUTTON:
+                input_process_button((buttons)event->key.code, event->key.pressed);
+                break;
+            case NULL_EVENT_MOUSE_MOVE:
+                input_process_mouse_move(event->mouse.x, event->mouse.y);
+                break;
+            case NULL_EVENT_MOUSE_WHEEL:
+                input_process_mouse_wheel(event->z_delta);
+                break;
+            case NULL_EVENT_RESIZE: {
+                event_context context;
+                context.data.u16[0] = event->size.width;
+                context.data.u16[1] = event->size.height;
+                event_fire(EVENT_CODE_RESIZED, 0, context);
+            } break;
+            case NULL_EVENT_QUIT:
+                quit_flagged = TRUE;
+                break;
+        }
+    }
+    queued_event_count = 0;
+
+    state->frame_count++;
+    if (state->frame_limit && state->frame_count >= state->frame_limit) {
+        quit_flagged = TRUE;
+    }
+
+    return !quit_flagged;
+}
+
+b8 platform_null_create_vulkan_surface(platform_state* plat_state, vulkan_context* context) {
+    KERROR("The null platform has no window to create a Vulkan surface for. Use the null renderer backend.");
+    return FALSE;
+}
+
+void platform_null_get_required_extension_names(const char*** names__darray) {
+    // No surface, so no surface extensions.
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "platform.h"
+#include "core/input.h"
+
+/*
+ * Headless platform backend. There is no window and no surface; the clock,
+ * memory and console functions of the host platform keep working, and the
+ * only input is what gets queued through the functions below. Queued input
+ * is delivered on the next pump, exactly as OS input would be.
+ *
+ * Selected with KOHI_PLATFORM=null (or headless) on every platform. Setting
+ * KOHI_NULL_FRAME_LIMIT=<n> quits after n frames, which is handy for
+ * benchmark and CI runs.
+ */
+
+// Queues a synthetic key press or release.
+KAPI void platform_null_queue_key(keys key, b8 pressed);
+
+// Queues a synthetic mouse button press or release.
+KAPI void platform_null_queue_button(buttons button, b8 pressed);
+
+// Queues a synthetic mouse move to the given window coordinates.
+KAPI void platform_null_queue_mouse_move(i16 x, i16 y);
+
+// Queues a synthetic mouse wheel movement.
+KAPI void platform_null_queue_mouse_wheel(i8 z_delta);
+
+// Queues a change to the size of the (virtual) window.
+KAPI void platform_null_queue_resize(u16 width, u16 height);
+
+// Queues a request to close the (virtual) window.
+KAPI void platform_null_queue_quit();
+
+// Whether KOHI_PLATFORM asks for the null platform. Checked by each platform's startup.
+b8 platform_null_requested();
+
+b8 platform_null_startup(
+    platform_state* plat_state,
+    const char* application_name,
+    i32 x,
+    i32 y,
+    i32 width,
+    i32 height);
+
+void platform_null_shutdown(platform_state* plat_state);
+
+b8 platform_null_pump_messages(platform_state* plat_state);
+
+b8 platform_null_create_vulkan_surface(platform_state* plat_state, vulkan_context* context);
+
+void platform_null_get_required_extension_names(const char*** names__darray);
@@ -1,14 +1,20 @@
 #include "platform/platform.h"
+#include "platform/platform_null.h"
 
 // Windows platform layer.
 #if KPLATFORM_WINDOWS
 
+#include "core/event.h"
 #include "core/logger.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
 
 #include <windows.h>
 #include <windowsx.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 // for surface creation
 #include "VK_USE_PLATFORM_WIN32_KHR.h"
@@ -26,6 +32,30 @@ typedef struct internal_state {
 static f64 clock_frequency;
 static LARGE_INTEGER start_time;
 
+// Set when started without a window, in which case the null platform handles everything the window would.
+static b8 headless = FALSE;
+
+// The maximum number of files which can be watched at once.
+#define WIN32_MAX_FILE_WATCHES 64
+
+typedef struct win32_file_watch {
+    b8 in_use;
+    // Set when a write was seen during the current pump.
+    b8 written;
+    // The containing directory, opened for overlapped change notifications.
+    HANDLE directory;
+    OVERLAPPED overlapped;
+    // Filled by ReadDirectoryChangesW with FILE_NOTIFY_INFORMATION records.
+    DWORD buffer[1024];
+    WCHAR file_name[256];
+} win32_file_watch;
+
+// Files are watched through their directory, since tools commonly replace a
+// file (write to a temp file and rename) rather than writing it in place.
+static win32_file_watch file_watches[WIN32_MAX_FILE_WATCHES];
+
+static void platform_process_file_watches();
+
 LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARAM l_param);
 
 b8 platform_startup(
@@ -35,6 +65,17 @@ b8 platform_startup(
     i32 y,
     i32 width,
     i32 height) {
+    // Clock setup, first, as the null platform times itself too.
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    clock_frequency = 1.0 / (f64)frequency.QuadPart;
+    QueryPerformanceCounter(&start_time);
+
+    headless = platform_null_requested();
+    if (headless) {
+        return platform_null_startup(plat_state, application_name, x, y, width, height);
+    }
+
     plat_state->internal_state = malloc(sizeof(internal_state));
     internal_state* state = (internal_state*)plat_state->internal_state;
 
@@ -110,16 +151,15 @@ b8 platform_startup(
     // If initially maximized, use SW_SHOWMAXIMIZED : SW_MAXIMIZE
     ShowWindow(state->hwnd, show_window_command_flags);
 
-    // Clock setup
-    LARGE_INTEGER frequency;
-    QueryPerformanceFrequency(&frequency);
-    clock_frequency = 1.0 / (f64)frequency.QuadPart;
-    QueryPerformanceCounter(&start_time);
-
     return TRUE;
 }
 
 void platform_shutdown(platform_state* plat_state) {
+    if (headless) {
+        platform_null_shutdown(plat_state);
+        return;
+    }
+
     // Simply cold-cast to the known type.
     internal_state* state = (internal_state*)plat_state->internal_state;
 
@@ -129,7 +169,17 @@ void platform_shutdown(platform_state* plat_state) {
     }
 }
 
+b8 platform_is_headless(platform_state* plat_state) {
+    return headless;
+}
+
 b8 platform_pump_messages(platform_state* plat_state) {
+    platform_process_file_watches();
+
+    if (headless) {
+        return platform_null_pump_messages(plat_state);
+    }
+
     MSG message;
     while (PeekMessageA(&message, NULL, 0, 0, PM_REMOVE)) {
         TranslateMessage(&message);
@@ -191,7 +241,422 @@ void platform_sleep(u64 ms) {
     Sleep(ms);
 }
 
+i32 platform_get_processor_count() {
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return (i32)sysinfo.dwNumberOfProcessors;
+}
+
+b8 platform_map_file(const char* path, u32 hints, mapped_file* out_file) {
+    out_file->data = 0;
+    out_file->size = 0;
+    out_file->internal = 0;
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (hints & FILE_MAP_HINT_SEQUENTIAL) {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    } else if (hints & FILE_MAP_HINT_RANDOM) {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        KERROR("platform_map_file unable to open '%s'. Error: %lu", path, GetLastError());
+        return FALSE;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        KERROR("platform_map_file unable to get the size of '%s'. Error: %lu", path, GetLastError());
+        CloseHandle(file);
+        return FALSE;
+    }
+
+    // Nothing to map for an empty file, but it is still a valid file.
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        return TRUE;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    // The mapping holds its own reference to the file.
+    CloseHandle(file);
+    if (!mapping) {
+        KERROR("platform_map_file unable to create a mapping for '%s'. Error: %lu", path, GetLastError());
+        return FALSE;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        KERROR("platform_map_file unable to map '%s'. Error: %lu", path, GetLastError());
+        CloseHandle(mapping);
+        return FALSE;
+    }
+
+    out_file->data = data;
+    out_file->size = (u64)size.QuadPart;
+    out_file->internal = mapping;
+    return TRUE;
+}
+
+void platform_unmap_file(mapped_file* file) {
+    if (file->data) {
+        UnmapViewOfFile(file->data);
+    }
+    if (file->internal) {
+        CloseHandle((HANDLE)file->internal);
+    }
+    file->data = 0;
+    file->size = 0;
+    file->internal = 0;
+}
+
+// Matches WIN32_MEMORY_RANGE_ENTRY, which the headers only declare when targeting Windows 8 or later.
+typedef struct win32_memory_range {
+    void* address;
+    SIZE_T size;
+} win32_memory_range;
+
+typedef BOOL(WINAPI* pfn_prefetch_virtual_memory)(HANDLE process, ULONG_PTR count, win32_memory_range* ranges, ULONG flags);
+
+void platform_mapped_file_prefetch(mapped_file* file, u64 offset, u64 size) {
+    if (!file->data || offset >= file->size) {
+        return;
+    }
+    if (size > file->size - offset) {
+        size = file->size - offset;
+    }
+
+    // PrefetchVirtualMemory is looked up rather than linked so Windows 7 still runs, just without the hint.
+    static pfn_prefetch_virtual_memory prefetch = 0;
+    static b8 looked_up = FALSE;
+    if (!looked_up) {
+        prefetch = (pfn_prefetch_virtual_memory)GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory");
+        looked_up = TRUE;
+    }
+    if (!prefetch) {
+        return;
+    }
+
+    win32_memory_range range;
+    range.address = (u8*)file->data + offset;
+    range.size = (SIZE_T)size;
+    prefetch(GetCurrentProcess(), 1, &range, 0);
+}
+
+typedef struct win32_thread_start {
+    pfn_thread_start function;
+    void* params;
+} win32_thread_start;
+
+static DWORD WINAPI win32_thread_entry(LPVOID params) {
+    win32_thread_start start = *(win32_thread_start*)params;
+    platform_free(params, FALSE);
+    return start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread) {
+    if (!start_function_ptr) {
+        return FALSE;
+    }
+
+    // Handed to the new thread, which frees it.
+    win32_thread_start* start = platform_allocate(sizeof(win32_thread_start), FALSE);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    DWORD thread_id = 0;
+    HANDLE thread = CreateThread(0, 0, win32_thread_entry, start, 0, &thread_id);
+    if (!thread) {
+        KERROR("kthread_create failed. Error: %lu", GetLastError());
+        platform_free(start, FALSE);
+        return FALSE;
+    }
+
+    out_thread->internal_data = thread;
+    out_thread->thread_id = thread_id;
+    return TRUE;
+}
+
+void kthread_wait(kthread* thread) {
+    if (thread->internal_data) {
+        WaitForSingleObject((HANDLE)thread->internal_data, INFINITE);
+        CloseHandle((HANDLE)thread->internal_data);
+        thread->internal_data = 0;
+        thread->thread_id = 0;
+    }
+}
+
+u64 kthread_get_current_id() {
+    return (u64)GetCurrentThreadId();
+}
+
+b8 kmutex_create(kmutex* out_mutex) {
+    CRITICAL_SECTION* section = platform_allocate(sizeof(CRITICAL_SECTION), FALSE);
+    InitializeCriticalSection(section);
+    out_mutex->internal_data = section;
+    return TRUE;
+}
+
+void kmutex_destroy(kmutex* mutex) {
+    if (mutex->internal_data) {
+        DeleteCriticalSection((CRITICAL_SECTION*)mutex->internal_data);
+        platform_free(mutex->internal_data, FALSE);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex* mutex) {
+    if (!mutex->internal_data) {
+        return FALSE;
+    }
+    EnterCriticalSection((CRITICAL_SECTION*)mutex->internal_data);
+    return TRUE;
+}
+
+b8 kmutex_unlock(kmutex* mutex) {
+    if (!mutex->internal_data) {
+        return FALSE;
+    }
+    LeaveCriticalSection((CRITICAL_SECTION*)mutex->internal_data);
+    return TRUE;
+}
+
+b8 ksemaphore_create(ksemaphore* out_semaphore, u32 start_count) {
+    HANDLE semaphore = CreateSemaphoreA(0, start_count, 0x7FFFFFFF, 0);
+    if (!semaphore) {
+        KERROR("ksemaphore_create failed. Error: %lu", GetLastError());
+        return FALSE;
+    }
+    out_semaphore->internal_data = semaphore;
+    return TRUE;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore->internal_data) {
+        CloseHandle((HANDLE)semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    return semaphore->internal_data && ReleaseSemaphore((HANDLE)semaphore->internal_data, 1, 0);
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms) {
+    if (!semaphore->internal_data) {
+        return FALSE;
+    }
+    DWORD result = WaitForSingleObject((HANDLE)semaphore->internal_data, timeout_ms ? (DWORD)timeout_ms : INFINITE);
+    return result == WAIT_OBJECT_0;
+}
+
+b8 platform_dynamic_library_load(const char* path, dynamic_library* out_library) {
+    if (!path || !out_library) {
+        return FALSE;
+    }
+
+    HMODULE library = LoadLibraryA(path);
+    if (!library) {
+        KERROR("Failed to load dynamic library '%s'. Error: %lu", path, GetLastError());
+        return FALSE;
+    }
+
+    out_library->handle = library;
+    strncpy(out_library->path, path, sizeof(out_library->path) - 1);
+    out_library->path[sizeof(out_library->path) - 1] = 0;
+    return TRUE;
+}
+
+b8 platform_dynamic_library_unload(dynamic_library* library) {
+    if (!library || !library->handle) {
+        return FALSE;
+    }
+
+    if (!FreeLibrary((HMODULE)library->handle)) {
+        return FALSE;
+    }
+    library->handle = 0;
+    return TRUE;
+}
+
+void* platform_dynamic_library_load_function(dynamic_library* library, const char* name) {
+    if (!library || !library->handle || !name) {
+        return 0;
+    }
+
+    return (void*)GetProcAddress((HMODULE)library->handle, name);
+}
+
+const char* platform_dynamic_library_extension() {
+    return ".dll";
+}
+
+const char* platform_dynamic_library_prefix() {
+    return "";
+}
+
+b8 platform_copy_file(const char* source, const char* dest, b8 overwrite_if_exists) {
+    if (!CopyFileA(source, dest, !overwrite_if_exists)) {
+        KERROR("platform_copy_file failed copying '%s' to '%s'. Error: %lu", source, dest, GetLastError());
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Queues the next change notification read for the watch's directory.
+static b8 file_watch_read(win32_file_watch* watch) {
+    return ReadDirectoryChangesW(
+        watch->directory,
+        watch->buffer,
+        sizeof(watch->buffer),
+        FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+        0,
+        &watch->overlapped,
+        0);
+}
+
+b8 platform_watch_file(const char* file_path, u32* out_watch_id) {
+    if (!file_path || !out_watch_id) {
+        return FALSE;
+    }
+
+    // Split the path into its directory and file name. Either slash may be used.
+    char directory[MAX_PATH] = ".";
+    const char* file_name = file_path;
+    const char* last_slash = strrchr(file_path, '\\');
+    const char* last_forward_slash = strrchr(file_path, '/');
+    if (!last_slash || (last_forward_slash && last_forward_slash > last_slash)) {
+        last_slash = last_forward_slash;
+    }
+    if (last_slash) {
+        u64 directory_length = last_slash - file_path + 1;  // Keep the slash, so a drive root stays a root.
+        if (directory_length >= sizeof(directory)) {
+            KERROR("platform_watch_file path is too long: '%s'", file_path);
+            return FALSE;
+        }
+        memcpy(directory, file_path, directory_length);
+        directory[directory_length] = 0;
+        file_name = last_slash + 1;
+    }
+
+    for (u32 i = 0; i < WIN32_MAX_FILE_WATCHES; ++i) {
+        win32_file_watch* watch = &file_watches[i];
+        if (watch->in_use) {
+            continue;
+        }
+
+        memset(watch, 0, sizeof(win32_file_watch));
+        if (!MultiByteToWideChar(CP_UTF8, 0, file_name, -1, watch->file_name, 256)) {
+            KERROR("platform_watch_file file name is too long: '%s'", file_path);
+            return FALSE;
+        }
+
+        watch->directory = CreateFileA(
+            directory,
+            FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            0,
+            OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            0);
+        if (watch->directory == INVALID_HANDLE_VALUE) {
+            KERROR("Failed to watch '%s'. Error: %lu", file_path, GetLastError());
+            return FALSE;
+        }
+        watch->overlapped.hEvent = CreateEventA(0, TRUE, FALSE, 0);
+        if (!watch->overlapped.hEvent || !file_watch_read(watch)) {
+            KERROR("Failed to watch '%s'. Error: %lu", file_path, GetLastError());
+            if (watch->overlapped.hEvent) {
+                CloseHandle(watch->overlapped.hEvent);
+            }
+            CloseHandle(watch->directory);
+            return FALSE;
+        }
+
+        watch->in_use = TRUE;
+        *out_watch_id = i;
+        return TRUE;
+    }
+
+    KERROR("platform_watch_file: no free watch slots (max %i).", WIN32_MAX_FILE_WATCHES);
+    return FALSE;
+}
+
+b8 platform_unwatch_file(u32 watch_id) {
+    if (watch_id >= WIN32_MAX_FILE_WATCHES || !file_watches[watch_id].in_use) {
+        return FALSE;
+    }
+
+    win32_file_watch* watch = &file_watches[watch_id];
+    watch->in_use = FALSE;
+
+    // The read must be finished before its buffer can be reused.
+    CancelIoEx(watch->directory, &watch->overlapped);
+    DWORD bytes = 0;
+    GetOverlappedResult(watch->directory, &watch->overlapped, &bytes, TRUE);
+    CloseHandle(watch->overlapped.hEvent);
+    CloseHandle(watch->directory);
+    return TRUE;
+}
+
+/**
+ * Collects finished directory change reads and fires
+ * EVENT_CODE_WATCHED_FILE_WRITTEN once per written file, however many writes
+ * happened since the last pump.
+ */
+static void platform_process_file_watches() {
+    for (u32 i = 0; i < WIN32_MAX_FILE_WATCHES; ++i) {
+        win32_file_watch* watch = &file_watches[i];
+        if (!watch->in_use) {
+            continue;
+        }
+
+        DWORD bytes = 0;
+        while (GetOverlappedResult(watch->directory, &watch->overlapped, &bytes, FALSE)) {
+            if (bytes == 0) {
+                // The buffer overflowed and the changes were lost, so assume the file was among them.
+                watch->written = TRUE;
+            }
+            for (u8* ptr = (u8*)watch->buffer; bytes > 0;) {
+                const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)ptr;
+                u32 name_length = info->FileNameLength / sizeof(WCHAR);
+                if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME &&
+                    name_length == wcslen(watch->file_name) &&
+                    _wcsnicmp(info->FileName, watch->file_name, name_length) == 0) {
+                    watch->written = TRUE;
+                }
+                if (info->NextEntryOffset == 0) {
+                    break;
+                }
+                ptr += info->NextEntryOffset;
+            }
+
+            if (!file_watch_read(watch)) {
+                // Nothing is pending any more, so the handles can simply be closed.
+                KERROR("Lost the watch on file %u. Error: %lu", i, GetLastError());
+                CloseHandle(watch->overlapped.hEvent);
+                CloseHandle(watch->directory);
+                watch->in_use = FALSE;
+                break;
+            }
+        }
+
+        if (watch->written) {
+            watch->written = FALSE;
+            event_context context = {};
+            context.data.u32[0] = i;
+            event_fire(EVENT_CODE_WATCHED_FILE_WRITTEN, 0, context);
+        }
+    }
+}
+
 void platform_get_required_extension_names(const char*** names__darray) {
+    if (headless) {
+        platform_null_get_required_extension_names(names__darray);
+        return;
+    }
     // For Win32 platform, we need to add the VK_KHR_win32_surface extension.
     darray_push(*names__darray, &VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 }
@@ -201,6 +666,10 @@ b8 platform_create_vulkan_surface(
     platform_state* plat_state,
     VkInstance instance,
     VkSurfaceKHR* out_surface) {
+    if (headless) {
+        KERROR("The null platform has no window to create a Vulkan surface for. Use the null renderer backend.");
+        return FALSE;
+    }
     internal_state* state = (internal_state*)plat_state->internal_state;
 
     VkWin32SurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR};
@@ -0,0 +1,291 @@
+#include "debug_draw.h"
+
+#include "debug_font.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+
+#if KDEBUG_DRAW_ENABLED
+
+#define DEBUG_DRAW_REGION_VERTICES (DEBUG_DRAW_MAX_LINE_VERTICES + DEBUG_DRAW_MAX_TRIANGLE_VERTICES + DEBUG_DRAW_MAX_OVERLAY_VERTICES)
+// Segments in each of a sphere's circles.
+#define DEBUG_DRAW_SPHERE_SEGMENTS 24
+
+static const u32 type_capacity[DEBUG_DRAW_TYPE_COUNT] = {
+    DEBUG_DRAW_MAX_LINE_VERTICES,
+    DEBUG_DRAW_MAX_TRIANGLE_VERTICES,
+    DEBUG_DRAW_MAX_OVERLAY_VERTICES};
+
+static const u32 type_offset[DEBUG_DRAW_TYPE_COUNT] = {
+    0,
+    DEBUG_DRAW_MAX_LINE_VERTICES,
+    DEBUG_DRAW_MAX_LINE_VERTICES + DEBUG_DRAW_MAX_TRIANGLE_VERTICES};
+
+typedef struct debug_draw_state {
+    renderer_backend* backend;
+    // region_count regions of DEBUG_DRAW_REGION_VERTICES, each split by type.
+    debug_vertex* vertices;
+    // Set when the backend could not map any, so they were allocated here and are never drawn.
+    b8 owns_vertices;
+    u32 region_count;
+    // The region being written this frame.
+    debug_vertex* region;
+    u32 counts[DEBUG_DRAW_TYPE_COUNT];
+    b8 overflow_reported;
+    // A unit circle, so spheres need no trigonometry.
+    f32 circle[DEBUG_DRAW_SPHERE_SEGMENTS + 1][2];
+} debug_draw_state;
+
+static b8 is_initialized = FALSE;
+static debug_draw_state state;
+
+static void select_region() {
+    u32 region = (u32)(state.backend->frame_number % state.region_count);
+    state.region = state.vertices + (u64)region * DEBUG_DRAW_REGION_VERTICES;
+}
+
+b8 debug_draw_initialize(renderer_backend* backend) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(debug_draw_state));
+    state.backend = backend;
+    // The GPU may still be reading a region for each frame in flight.
+    state.region_count = backend->config.max_frames_in_flight + 1;
+
+    u64 size = sizeof(debug_vertex) * DEBUG_DRAW_REGION_VERTICES * state.region_count;
+    if (backend->debug_draw_map) {
+        state.vertices = backend->debug_draw_map(backend, size);
+    }
+    if (!state.vertices) {
+        KWARN("The renderer backend cannot draw debug geometry. Debug draws will not be shown.");
+        state.vertices = kallocate(size, MEMORY_TAG_RENDERER);
+        state.owns_vertices = TRUE;
+    }
+
+    for (u32 i = 0; i <= DEBUG_DRAW_SPHERE_SEGMENTS; ++i) {
+        f32 angle = K_2PI * i / DEBUG_DRAW_SPHERE_SEGMENTS;
+        state.circle[i][0] = kcos(angle);
+        state.circle[i][1] = ksin(angle);
+    }
+
+    select_region();
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void debug_draw_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    if (state.owns_vertices) {
+        kfree(state.vertices, sizeof(debug_vertex) * DEBUG_DRAW_REGION_VERTICES * state.region_count, MEMORY_TAG_RENDERER);
+    }
+    kzero_memory(&state, sizeof(debug_draw_state));
+    is_initialized = FALSE;
+}
+
+void debug_draw_build(const mat4* view_projection, debug_draw_packet* out_packet) {
+    kzero_memory(out_packet, sizeof(debug_draw_packet));
+    if (!is_initialized || state.owns_vertices) {
+        return;
+    }
+    out_packet->view_projection = *view_projection;
+    u32 region_first = (u32)(state.region - state.vertices);
+    for (u32 type = 0; type < DEBUG_DRAW_TYPE_COUNT; ++type) {
+        out_packet->first_vertex[type] = region_first + type_offset[type];
+        out_packet->vertex_count[type] = state.counts[type];
+    }
+}
+
+void debug_draw_frame_end() {
+    if (!is_initialized) {
+        return;
+    }
+    kzero_memory(state.counts, sizeof(state.counts));
+    state.overflow_reported = FALSE;
+    select_region();
+}
+
+// Room for count more vertices of a type, or 0 if the frame has run out.
+static debug_vertex* reserve(debug_draw_type type, u32 count) {
+    if (!is_initialized) {
+        return 0;
+    }
+    if (state.counts[type] + count > type_capacity[type]) {
+        if (!state.overflow_reported) {
+            KWARN("Too much debug geometry this frame. Some will not be drawn.");
+            state.overflow_reported = TRUE;
+        }
+        return 0;
+    }
+    debug_vertex* vertices = state.region + type_offset[type] + state.counts[type];
+    state.counts[type] += count;
+    return vertices;
+}
+
+static u32 pack_color(vec4 color) {
+    u32 packed = 0;
+    for (u32 i = 0; i < 4; ++i) {
+        f32 channel = KCLAMP(color.elements[i], 0.0f, 1.0f);
+        packed |= (u32)(channel * 255.0f + 0.5f) << (i * 8);
+    }
+    return packed;
+}
+
+// The vertices are write-combined on most devices, so each is written whole and never read back.
+static void write_vertex(debug_vertex* out, f32 x, f32 y, f32 z, u32 color) {
+    debug_vertex v;
+    v.position[0] = x;
+    v.position[1] = y;
+    v.position[2] = z;
+    v.color = color;
+    *out = v;
+}
+
+void debug_draw_line(vec3 start, vec3 end, vec4 color) {
+    debug_vertex* v = reserve(DEBUG_DRAW_TYPE_LINES, 2);
+    if (!v) {
+        return;
+    }
+    u32 packed = pack_color(color);
+    write_vertex(&v[0], start.x, start.y, start.z, packed);
+    write_vertex(&v[1], end.x, end.y, end.z, packed);
+}
+
+// Corner i takes max on axis n when bit n of i is set.
+static vec3 box_corner(aabb box, u32 i) {
+    return vec3_create(
+        (i & 1) ? box.max.x : box.min.x,
+        (i & 2) ? box.max.y : box.min.y,
+        (i & 4) ? box.max.z : box.min.z);
+}
+
+void debug_draw_box(aabb box, vec4 color) {
+    static const u8 edges[12][2] = {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+    debug_vertex* v = reserve(DEBUG_DRAW_TYPE_LINES, 24);
+    if (!v) {
+        return;
+    }
+    u32 packed = pack_color(color);
+    for (u32 e = 0; e < 12; ++e) {
+        for (u32 end = 0; end < 2; ++end) {
+            vec3 corner = box_corner(box, edges[e][end]);
+            write_vertex(v++, corner.x, corner.y, corner.z, packed);
+        }
+    }
+}
+
+void debug_draw_box_solid(aabb box, vec4 color) {
+    // Two triangles per face, wound counter-clockwise from outside.
+    static const u8 faces[6][4] = {
+        {0, 4, 6, 2}, {1, 3, 7, 5},
+        {0, 1, 5, 4}, {2, 6, 7, 3},
+        {0, 2, 3, 1}, {4, 5, 7, 6}};
+    static const u8 quad[6] = {0, 1, 2, 0, 2, 3};
+    debug_vertex* v = reserve(DEBUG_DRAW_TYPE_TRIANGLES, 36);
+    if (!v) {
+        return;
+    }
+    u32 packed = pack_color(color);
+    for (u32 f = 0; f < 6; ++f) {
+        for (u32 i = 0; i < 6; ++i) {
+            vec3 corner = box_corner(box, faces[f][quad[i]]);
+            write_vertex(v++, corner.x, corner.y, corner.z, packed);
+        }
+    }
+}
+
+void debug_draw_sphere(vec3 center, f32 radius, vec4 color) {
+    debug_vertex* v = reserve(DEBUG_DRAW_TYPE_LINES, DEBUG_DRAW_SPHERE_SEGMENTS * 2 * 3);
+    if (!v) {
+        return;
+    }
+    u32 packed = pack_color(color);
+    for (u32 axis = 0; axis < 3; ++axis) {
+        // The circle lies in the plane of the other two axes.
+        u32 a = (axis + 1) % 3;
+        u32 b = (axis + 2) % 3;
+        for (u32 i = 0; i < DEBUG_DRAW_SPHERE_SEGMENTS; ++i) {
+            for (u32 end = 0; end < 2; ++end) {
+                vec3 p = center;
+                p.elements[a] += state.circle[i + end][0] * radius;
+                p.elements[b] += state.circle[i + end][1] * radius;
+                write_vertex(v++, p.x, p.y, p.z, packed);
+            }
+        }
+    }
+}
+
+// A rectangle of the overlay, as two triangles.
+static void overlay_rect(debug_vertex* v, f32 left, f32 top, f32 right, f32 bottom, u32 color) {
+    write_vertex(&v[0], left, top, 0, color);
+    write_vertex(&v[1], left, bottom, 0, color);
+    write_vertex(&v[2], right, bottom, 0, color);
+    write_vertex(&v[3], left, top, 0, color);
+    write_vertex(&v[4], right, bottom, 0, color);
+    write_vertex(&v[5], right, top, 0, color);
+}
+
+void debug_draw_text(f32 x, f32 y, f32 size, vec4 color, const char* text) {
+    if (!is_initialized || !text) {
+        return;
+    }
+    u32 packed = pack_color(color);
+    f32 scale = size / DEBUG_FONT_CELL_HEIGHT;
+    f32 pen_x = x;
+    f32 pen_y = y;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '\n') {
+            pen_x = x;
+            pen_y += size;
+            continue;
+        }
+        const u8* glyph = debug_font_glyph(*c);
+        // Each horizontal run of set pixels in a row is one rectangle.
+        for (u32 row = 0; row < DEBUG_FONT_GLYPH_HEIGHT; ++row) {
+            u32 column = 0;
+            while (column < DEBUG_FONT_GLYPH_WIDTH) {
+                if (!(glyph[column] & (1 << row))) {
+                    column++;
+                    continue;
+                }
+                u32 run_start = column;
+                while (column < DEBUG_FONT_GLYPH_WIDTH && (glyph[column] & (1 << row))) {
+                    column++;
+                }
+                debug_vertex* v = reserve(DEBUG_DRAW_TYPE_OVERLAY, 6);
+                if (!v) {
+                    return;
+                }
+                overlay_rect(v,
+                             pen_x + run_start * scale, pen_y + row * scale,
+                             pen_x + column * scale, pen_y + (row + 1) * scale,
+                             packed);
+            }
+        }
+        pen_x += DEBUG_FONT_CELL_WIDTH * scale;
+    }
+}
+
+#else
+
+b8 debug_draw_initialize(renderer_backend* backend) {
+    return TRUE;
+}
+
+void debug_draw_shutdown() {
+}
+
+void debug_draw_build(const mat4* view_projection, debug_draw_packet* out_packet) {
+    kzero_memory(out_packet, sizeof(debug_draw_packet));
+}
+
+void debug_draw_frame_end() {
+}
+
+#endif
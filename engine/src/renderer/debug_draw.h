@@ -0,0 +1,66 @@
+#pragma once
+
+#include "renderer_types.inl"
+
+/*
+Immediate mode drawing of lines, boxes, spheres and text for diagnostics.
+Whatever is drawn during a frame is shown at the end of it, over the scene,
+then forgotten. Vertices are written straight into memory the backend keeps
+mapped, with a region for each frame the GPU may still be reading and one
+more for the frame being written, so drawing neither allocates nor copies.
+Drawing is main thread only.
+
+Only debug builds have it; elsewhere every call compiles to nothing, so
+calls can be left in game code.
+*/
+
+#if defined(_DEBUG)
+#define KDEBUG_DRAW_ENABLED 1
+#else
+#define KDEBUG_DRAW_ENABLED 0
+#endif
+
+// Vertices per frame for each type. Anything past these is dropped.
+#define DEBUG_DRAW_MAX_LINE_VERTICES 65536
+#define DEBUG_DRAW_MAX_TRIANGLE_VERTICES 32768
+#define DEBUG_DRAW_MAX_OVERLAY_VERTICES 65536
+
+// Called by the renderer frontend.
+b8 debug_draw_initialize(renderer_backend* backend);
+void debug_draw_shutdown();
+// Describes the frame's geometry, to be drawn from view_projection.
+void debug_draw_build(const mat4* view_projection, debug_draw_packet* out_packet);
+// Forgets the frame's geometry, once it has been drawn.
+void debug_draw_frame_end();
+
+#if KDEBUG_DRAW_ENABLED
+
+KAPI void debug_draw_line(vec3 start, vec3 end, vec4 color);
+
+// The box's edges.
+KAPI void debug_draw_box(aabb box, vec4 color);
+
+// The box's faces. Blended, so a translucent color shows what is inside.
+KAPI void debug_draw_box_solid(aabb box, vec4 color);
+
+// Circles around the sphere in each axis plane.
+KAPI void debug_draw_sphere(vec3 center, f32 radius, vec4 color);
+
+/**
+ * Draws text over everything else, in the built in 5x7 font. Newlines start
+ * a new line below.
+ * @param x The left of the text, in pixels from the left of the screen.
+ * @param y The top of the text, in pixels from the top of the screen.
+ * @param size The height of a line in pixels. Multiples of 8 keep pixels square.
+ */
+KAPI void debug_draw_text(f32 x, f32 y, f32 size, vec4 color, const char* text);
+
+#else
+
+#define debug_draw_line(start, end, color) ((void)0)
+#define debug_draw_box(box, color) ((void)0)
+#define debug_draw_box_solid(box, color) ((void)0)
+#define debug_draw_sphere(center, radius, color) ((void)0)
+#define debug_draw_text(x, y, size, color, text) ((void)0)
+
+#endif
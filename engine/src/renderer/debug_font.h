@@ -0,0 +1,36 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+A 5x7 pixel font for diagnostic text, built in so it works before any asset
+has loaded. Each glyph is 5 columns of 7 bits, the lowest bit at the top, in
+a cell 6 pixels wide and 8 high to leave a gap.
+*/
+
+#define DEBUG_FONT_FIRST_CHAR 32
+#define DEBUG_FONT_LAST_CHAR 126
+#define DEBUG_FONT_GLYPH_WIDTH 5
+#define DEBUG_FONT_GLYPH_HEIGHT 7
+#define DEBUG_FONT_CELL_WIDTH 6
+#define DEBUG_FONT_CELL_HEIGHT 8
+
+/*
+The glyphs laid out in a single channel atlas, DEBUG_FONT_ATLAS_COLUMNS cells
+across, for drawing text as textured quads. After the last glyph is a fully
+set cell, so solid shapes can share the atlas and be batched with text.
+*/
+#define DEBUG_FONT_ATLAS_COLUMNS 16
+#define DEBUG_FONT_ATLAS_ROWS 6
+#define DEBUG_FONT_ATLAS_WIDTH (DEBUG_FONT_ATLAS_COLUMNS * DEBUG_FONT_CELL_WIDTH)
+#define DEBUG_FONT_ATLAS_HEIGHT (DEBUG_FONT_ATLAS_ROWS * DEBUG_FONT_CELL_HEIGHT)
+#define DEBUG_FONT_ATLAS_SOLID_CELL (DEBUG_FONT_LAST_CHAR - DEBUG_FONT_FIRST_CHAR + 1)
+
+// The columns of a character's glyph. Characters outside the font get '?'.
+const u8* debug_font_glyph(char c);
+
+// Fills DEBUG_FONT_ATLAS_WIDTH * DEBUG_FONT_ATLAS_HEIGHT bytes, a row at a time, with 255 where glyphs are set.
+void debug_font_atlas_build(u8* out_pixels);
+
+// The atlas cell of a character, or of the solid cell when c is 0.
+u32 debug_font_atlas_cell(char c);
@@ -0,0 +1,23 @@
+#include "null_backend.h"
+
+#include "core/logger.h"
+
+b8 null_renderer_backend_initialize(renderer_backend* backend, const char* application_name, struct platform_state* plat_state) {
+    KINFO("Null renderer initialized. Nothing will be drawn.");
+    return TRUE;
+}
+
+void null_renderer_backend_shutdown(renderer_backend* backend) {
+}
+
+void null_renderer_backend_on_resized(renderer_backend* backend, u16 width, u16 height) {
+    KDEBUG("Null renderer backend->resized: w/h: %i/%i", width, height);
+}
+
+b8 null_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time) {
+    return TRUE;
+}
+
+b8 null_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time) {
+    return TRUE;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "renderer/renderer_backend.h"
+
+/*
+ * Renderer backend which does no rendering at all. Used with the headless
+ * platform so that the full engine loop can run without a GPU or display.
+ */
+
+b8 null_renderer_backend_initialize(renderer_backend* backend, const char* application_name, struct platform_state* plat_state);
+void null_renderer_backend_shutdown(renderer_backend* backend);
+
+void null_renderer_backend_on_resized(renderer_backend* backend, u16 width, u16 height);
+
+b8 null_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time);
+b8 null_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time);
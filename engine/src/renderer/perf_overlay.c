@@ -0,0 +1,271 @@
+#include "perf_overlay.h"
+
+#include "debug_font.h"
+
+#include "core/clock.h"
+#include "core/event.h"
+#include "core/input.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+
+// Pixels per font pixel.
+#define PERF_OVERLAY_SCALE 2.0f
+#define PERF_OVERLAY_LINE (DEBUG_FONT_CELL_HEIGHT * PERF_OVERLAY_SCALE)
+#define PERF_OVERLAY_MARGIN 8.0f
+#define PERF_OVERLAY_PADDING 6.0f
+#define PERF_OVERLAY_WIDTH (PERF_OVERLAY_PADDING * 2 + 40 * DEBUG_FONT_CELL_WIDTH * PERF_OVERLAY_SCALE)
+// The graph shows a bar per frame of history, from 0 at the bottom to this at the top.
+#define PERF_OVERLAY_GRAPH_HEIGHT 64.0f
+#define PERF_OVERLAY_GRAPH_MAX_MS 33.3f
+#define PERF_OVERLAY_GRAPH_TARGET_MS 16.7f
+
+#define PERF_OVERLAY_WHITE 0xFFFFFFFF
+#define PERF_OVERLAY_GREY 0xFFB0B0B0
+#define PERF_OVERLAY_PANEL 0xB0101010
+#define PERF_OVERLAY_GREEN 0xFF40D040
+#define PERF_OVERLAY_YELLOW 0xFF30D0E0
+#define PERF_OVERLAY_RED 0xFF3030E0
+
+typedef struct perf_overlay_state {
+    renderer_backend* backend;
+    // region_count regions of PERF_OVERLAY_MAX_VERTICES.
+    overlay_vertex* vertices;
+    // Set when the backend could not map any, so they were allocated here and are never drawn.
+    b8 owns_vertices;
+    u32 region_count;
+    b8 visible;
+
+    // Being written by the current build.
+    overlay_vertex* region;
+    u32 count;
+
+    u32 wait_scope;
+    u32 build_scope;
+} perf_overlay_state;
+
+static b8 is_initialized = FALSE;
+static perf_overlay_state state;
+
+static b8 perf_overlay_on_key(u16 code, void* sender, void* listener_inst, event_context context) {
+    if (context.data.u16[0] == PERF_OVERLAY_TOGGLE_KEY) {
+        state.visible = !state.visible;
+    }
+    // Others may want the key too.
+    return FALSE;
+}
+
+b8 perf_overlay_initialize(renderer_backend* backend) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(perf_overlay_state));
+    state.backend = backend;
+    // The GPU may still be reading a region for each frame in flight.
+    state.region_count = backend->config.max_frames_in_flight + 1;
+
+    u64 size = sizeof(overlay_vertex) * PERF_OVERLAY_MAX_VERTICES * state.region_count;
+    if (backend->overlay_map) {
+        state.vertices = backend->overlay_map(backend, size);
+    }
+    if (!state.vertices) {
+        KWARN("The renderer backend cannot draw the performance overlay. It will not be shown.");
+        state.vertices = kallocate(size, MEMORY_TAG_RENDERER);
+        state.owns_vertices = TRUE;
+    }
+
+    // The frontend records the wait under this name.
+    state.wait_scope = profiler_scope_register("renderer_wait");
+    state.build_scope = profiler_scope_register("perf_overlay");
+    event_register(EVENT_CODE_KEY_PRESSED, &state, perf_overlay_on_key);
+
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void perf_overlay_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    event_unregister(EVENT_CODE_KEY_PRESSED, &state, perf_overlay_on_key);
+    if (state.owns_vertices) {
+        kfree(state.vertices, sizeof(overlay_vertex) * PERF_OVERLAY_MAX_VERTICES * state.region_count, MEMORY_TAG_RENDERER);
+    }
+    kzero_memory(&state, sizeof(perf_overlay_state));
+    is_initialized = FALSE;
+}
+
+void perf_overlay_set_visible(b8 visible) {
+    state.visible = visible;
+}
+
+b8 perf_overlay_is_visible() {
+    return state.visible;
+}
+
+// The vertices are write-combined on most devices, so each is written whole and never read back.
+static void write_vertex(overlay_vertex* out, f32 x, f32 y, f32 u, f32 v, u32 color) {
+    overlay_vertex vertex;
+    vertex.position[0] = x;
+    vertex.position[1] = y;
+    vertex.texcoord[0] = u;
+    vertex.texcoord[1] = v;
+    vertex.color = color;
+    *out = vertex;
+}
+
+// A rectangle covering the atlas from (u0, v0) to (u1, v1), as two triangles.
+static void quad(f32 left, f32 top, f32 right, f32 bottom, f32 u0, f32 v0, f32 u1, f32 v1, u32 color) {
+    if (state.count + 6 > PERF_OVERLAY_MAX_VERTICES) {
+        return;
+    }
+    overlay_vertex* v = state.region + state.count;
+    write_vertex(&v[0], left, top, u0, v0, color);
+    write_vertex(&v[1], left, bottom, u0, v1, color);
+    write_vertex(&v[2], right, bottom, u1, v1, color);
+    write_vertex(&v[3], left, top, u0, v0, color);
+    write_vertex(&v[4], right, bottom, u1, v1, color);
+    write_vertex(&v[5], right, top, u1, v0, color);
+    state.count += 6;
+}
+
+// A solid rectangle, sampling the middle of the atlas' solid cell.
+static void rect(f32 left, f32 top, f32 right, f32 bottom, u32 color) {
+    u32 cell = DEBUG_FONT_ATLAS_SOLID_CELL;
+    f32 u = ((cell % DEBUG_FONT_ATLAS_COLUMNS) * DEBUG_FONT_CELL_WIDTH + DEBUG_FONT_CELL_WIDTH * 0.5f) / DEBUG_FONT_ATLAS_WIDTH;
+    f32 v = ((cell / DEBUG_FONT_ATLAS_COLUMNS) * DEBUG_FONT_CELL_HEIGHT + DEBUG_FONT_CELL_HEIGHT * 0.5f) / DEBUG_FONT_ATLAS_HEIGHT;
+    quad(left, top, right, bottom, u, v, u, v, color);
+}
+
+// A line of text, a quad per glyph.
+static void text(f32 x, f32 y, u32 color, const char* line) {
+    f32 width = DEBUG_FONT_CELL_WIDTH * PERF_OVERLAY_SCALE;
+    for (const char* c = line; *c; ++c, x += width) {
+        if (*c == ' ') {
+            continue;
+        }
+        u32 cell = debug_font_atlas_cell(*c);
+        f32 u0 = (f32)((cell % DEBUG_FONT_ATLAS_COLUMNS) * DEBUG_FONT_CELL_WIDTH) / DEBUG_FONT_ATLAS_WIDTH;
+        f32 v0 = (f32)((cell / DEBUG_FONT_ATLAS_COLUMNS) * DEBUG_FONT_CELL_HEIGHT) / DEBUG_FONT_ATLAS_HEIGHT;
+        f32 u1 = u0 + (f32)DEBUG_FONT_CELL_WIDTH / DEBUG_FONT_ATLAS_WIDTH;
+        f32 v1 = v0 + (f32)DEBUG_FONT_CELL_HEIGHT / DEBUG_FONT_ATLAS_HEIGHT;
+        quad(x, y, x + width, y + PERF_OVERLAY_LINE, u0, v0, u1, v1, color);
+    }
+}
+
+// Bytes as the largest unit that leaves at least 1.
+static void format_bytes(char* out, u64 size, u64 bytes) {
+    if (bytes >= 1024 * 1024 * 1024) {
+        string_format(out, size, "%7.2f GiB", bytes / (1024.0 * 1024.0 * 1024.0));
+    } else if (bytes >= 1024 * 1024) {
+        string_format(out, size, "%7.2f MiB", bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024) {
+        string_format(out, size, "%7.2f KiB", bytes / 1024.0);
+    } else {
+        string_format(out, size, "%7llu B", bytes);
+    }
+}
+
+// Vertical bars of recent frame times, colored against the target.
+static void frame_graph(f32 left, f32 top) {
+    f32 history[PROFILER_FRAME_HISTORY];
+    u32 count = profiler_frame_history(history, PROFILER_FRAME_HISTORY);
+    f32 bar_width = (PERF_OVERLAY_WIDTH - PERF_OVERLAY_PADDING * 2) / PROFILER_FRAME_HISTORY;
+    f32 bottom = top + PERF_OVERLAY_GRAPH_HEIGHT;
+    // Newest at the right.
+    f32 x = left + (PROFILER_FRAME_HISTORY - count) * bar_width;
+    for (u32 i = 0; i < count; ++i, x += bar_width) {
+        f32 ms = history[i] < PERF_OVERLAY_GRAPH_MAX_MS ? history[i] : PERF_OVERLAY_GRAPH_MAX_MS;
+        f32 height = ms / PERF_OVERLAY_GRAPH_MAX_MS * PERF_OVERLAY_GRAPH_HEIGHT;
+        u32 color = history[i] <= PERF_OVERLAY_GRAPH_TARGET_MS ? PERF_OVERLAY_GREEN : history[i] <= PERF_OVERLAY_GRAPH_MAX_MS ? PERF_OVERLAY_YELLOW
+                                                                                                                           : PERF_OVERLAY_RED;
+        rect(x, bottom - height, x + bar_width, bottom, color);
+    }
+    f32 target = bottom - PERF_OVERLAY_GRAPH_TARGET_MS / PERF_OVERLAY_GRAPH_MAX_MS * PERF_OVERLAY_GRAPH_HEIGHT;
+    rect(left, target, left + PROFILER_FRAME_HISTORY * bar_width, target + 1.0f, PERF_OVERLAY_GREY);
+}
+
+void perf_overlay_build(render_packet* packet) {
+    packet->overlay_first_vertex = 0;
+    packet->overlay_vertex_count = 0;
+    if (!is_initialized || !state.visible || state.owns_vertices) {
+        return;
+    }
+    f64 start = clock_get_current_time();
+
+    state.region = state.vertices + (state.backend->frame_number % state.region_count) * PERF_OVERLAY_MAX_VERTICES;
+    state.count = 0;
+
+    // The panel goes first, so everything else is drawn over it. Its height is known once the rest is laid out.
+    rect(0, 0, 0, 0, PERF_OVERLAY_PANEL);
+
+    f32 left = PERF_OVERLAY_MARGIN + PERF_OVERLAY_PADDING;
+    f32 y = PERF_OVERLAY_MARGIN + PERF_OVERLAY_PADDING;
+    char line[128];
+
+    // The last finished frame.
+    f32 frame_ms = 0;
+    profiler_frame_history(&frame_ms, 1);
+    profiler_scope_stats wait = {0};
+    profiler_scope_get(state.wait_scope, &wait);
+    profiler_scope_stats build = {0};
+    profiler_scope_get(state.build_scope, &build);
+
+    string_format(line, sizeof(line), "FPS %5.0f  frame %6.2f ms", frame_ms > 0 ? 1000.0f / frame_ms : 0.0f, frame_ms);
+    text(left, y, PERF_OVERLAY_WHITE, line);
+    y += PERF_OVERLAY_LINE;
+
+    // The CPU's share is the frame less the time spent waiting on the GPU.
+    f64 cpu_ms = frame_ms - wait.last_ms;
+    f64 gpu_ms = 0;
+    if (state.backend->gpu_frame_time && state.backend->gpu_frame_time(state.backend, &gpu_ms)) {
+        string_format(line, sizeof(line), "CPU %6.2f ms  GPU %6.2f ms", cpu_ms > 0 ? cpu_ms : 0.0, gpu_ms);
+    } else {
+        string_format(line, sizeof(line), "CPU %6.2f ms  GPU    n/a", cpu_ms > 0 ? cpu_ms : 0.0);
+    }
+    text(left, y, PERF_OVERLAY_WHITE, line);
+    y += PERF_OVERLAY_LINE + PERF_OVERLAY_PADDING;
+
+    frame_graph(left, y);
+    y += PERF_OVERLAY_GRAPH_HEIGHT + PERF_OVERLAY_PADDING;
+
+    string_format(line, sizeof(line), "draws %u  batches %u  pipelines %u", packet->mesh_count, packet->batch_count, packet->pipeline_change_count);
+    text(left, y, PERF_OVERLAY_WHITE, line);
+    y += PERF_OVERLAY_LINE;
+    string_format(line, sizeof(line), "tris %llu of %llu  culled %u", packet->triangle_count, packet->full_triangle_count, packet->culled_count);
+    text(left, y, PERF_OVERLAY_WHITE, line);
+    y += PERF_OVERLAY_LINE + PERF_OVERLAY_PADDING;
+
+    char amount[32];
+    format_bytes(amount, sizeof(amount), memory_usage_get(MEMORY_TAG_MAX_TAGS));
+    string_format(line, sizeof(line), "memory      %s", amount);
+    text(left, y, PERF_OVERLAY_WHITE, line);
+    y += PERF_OVERLAY_LINE;
+    for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; ++tag) {
+        u64 bytes = memory_usage_get(tag);
+        if (bytes == 0) {
+            continue;
+        }
+        format_bytes(amount, sizeof(amount), bytes);
+        string_format(line, sizeof(line), "%s %s", memory_tag_name(tag), amount);
+        text(left, y, PERF_OVERLAY_GREY, line);
+        y += PERF_OVERLAY_LINE;
+    }
+    y += PERF_OVERLAY_PADDING;
+
+    string_format(line, sizeof(line), "overlay %6.3f ms", build.last_ms);
+    text(left, y, PERF_OVERLAY_GREY, line);
+    y += PERF_OVERLAY_LINE;
+
+    // Back over the panel's placeholder.
+    u32 count = state.count;
+    state.count = 0;
+    rect(PERF_OVERLAY_MARGIN, PERF_OVERLAY_MARGIN, PERF_OVERLAY_MARGIN + PERF_OVERLAY_WIDTH, y + PERF_OVERLAY_PADDING, PERF_OVERLAY_PANEL);
+    state.count = count;
+
+    packet->overlay_first_vertex = (u32)(state.region - state.vertices);
+    packet->overlay_vertex_count = state.count;
+
+    profiler_record(state.build_scope, clock_get_current_time() - start);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "renderer_types.inl"
+
+/*
+An on-screen panel of performance figures: a frame time graph, how the frame
+splits between CPU and GPU, memory use per tag, and what the renderer drew.
+Every glyph and bar is a quad sampling the debug font atlas, written straight
+into memory the backend keeps mapped, so the whole panel is one draw call.
+Toggled with PERF_OVERLAY_TOGGLE_KEY. Costs nothing while hidden.
+*/
+
+#define PERF_OVERLAY_TOGGLE_KEY KEY_F3
+// Vertices per frame. Anything past this is dropped.
+#define PERF_OVERLAY_MAX_VERTICES 16384
+
+// Called by the renderer frontend.
+b8 perf_overlay_initialize(renderer_backend* backend);
+void perf_overlay_shutdown();
+// Lays out the panel for a packet whose draws have been gathered.
+void perf_overlay_build(render_packet* packet);
+
+KAPI void perf_overlay_set_visible(b8 visible);
+KAPI b8 perf_overlay_is_visible();
@@ -0,0 +1,210 @@
+#include "render_commands.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// A new recording's first buffer, enough for a hundred or so draws.
+#define RENDER_COMMANDS_INITIAL_CAPACITY 4096
+
+#define RECORDER_FREE 0
+#define RECORDER_RECORDING 1
+#define RECORDER_ENDED 2
+
+typedef struct render_commands_state {
+    render_command_recorder recorders[RENDER_COMMANDS_MAX_RECORDERS];
+    // Where the next search for a free recorder starts, so threads rarely contend for the same one.
+    u32 next_recorder;
+    u32 end_sequence;
+    b8 full_reported;
+
+    // The frame's commands, all recordings one after another.
+    u8* frame_data;
+    u64 frame_capacity;
+    // The ended recordings, in the order they go in the frame.
+    u32 ended[RENDER_COMMANDS_MAX_RECORDERS];
+} render_commands_state;
+
+static b8 is_initialized = FALSE;
+static render_commands_state state;
+
+b8 render_commands_initialize() {
+    if (is_initialized) {
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(render_commands_state));
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void render_commands_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    for (u32 i = 0; i < RENDER_COMMANDS_MAX_RECORDERS; ++i) {
+        render_command_recorder* recorder = &state.recorders[i];
+        if (recorder->status == RECORDER_RECORDING) {
+            KWARN("A render command recording was never ended.");
+        }
+        if (recorder->data) {
+            kfree(recorder->data, recorder->capacity, MEMORY_TAG_RENDERER);
+        }
+    }
+    if (state.frame_data) {
+        kfree(state.frame_data, state.frame_capacity, MEMORY_TAG_RENDERER);
+    }
+    is_initialized = FALSE;
+}
+
+// Orders ended recordings by order, then by when they ended.
+static b8 recorder_before(const render_command_recorder* a, const render_command_recorder* b) {
+    return a->order != b->order ? a->order < b->order : a->end_sequence < b->end_sequence;
+}
+
+void render_commands_build(render_command_list* out_list) {
+    out_list->data = 0;
+    out_list->size = 0;
+    out_list->command_count = 0;
+    if (!is_initialized) {
+        return;
+    }
+
+    // Few recordings end each frame, so an insertion sort is plenty.
+    u32 ended_count = 0;
+    u64 size = 0;
+    for (u32 i = 0; i < RENDER_COMMANDS_MAX_RECORDERS; ++i) {
+        render_command_recorder* recorder = &state.recorders[i];
+        if (__atomic_load_n(&recorder->status, __ATOMIC_ACQUIRE) != RECORDER_ENDED) {
+            continue;
+        }
+        size += recorder->size;
+        u32 slot = ended_count++;
+        while (slot > 0 && recorder_before(recorder, &state.recorders[state.ended[slot - 1]])) {
+            state.ended[slot] = state.ended[slot - 1];
+            slot--;
+        }
+        state.ended[slot] = i;
+    }
+
+    if (size > state.frame_capacity) {
+        if (state.frame_data) {
+            kfree(state.frame_data, state.frame_capacity, MEMORY_TAG_RENDERER);
+        }
+        state.frame_capacity = size * 2;
+        state.frame_data = kallocate(state.frame_capacity, MEMORY_TAG_RENDERER);
+    }
+
+    u64 offset = 0;
+    u32 command_count = 0;
+    for (u32 i = 0; i < ended_count; ++i) {
+        render_command_recorder* recorder = &state.recorders[state.ended[i]];
+        kcopy_memory(state.frame_data + offset, recorder->data, recorder->size);
+        offset += recorder->size;
+        command_count += recorder->command_count;
+        // Its buffer is kept for the next recording.
+        __atomic_store_n(&recorder->status, RECORDER_FREE, __ATOMIC_RELEASE);
+    }
+
+    out_list->data = state.frame_data;
+    out_list->size = size;
+    out_list->command_count = command_count;
+}
+
+render_command_recorder* render_commands_begin(u32 order) {
+    if (!is_initialized) {
+        return 0;
+    }
+    u32 start = __atomic_fetch_add(&state.next_recorder, 1, __ATOMIC_RELAXED);
+    for (u32 n = 0; n < RENDER_COMMANDS_MAX_RECORDERS; ++n) {
+        render_command_recorder* recorder = &state.recorders[(start + n) % RENDER_COMMANDS_MAX_RECORDERS];
+        u32 expected = RECORDER_FREE;
+        if (__atomic_compare_exchange_n(&recorder->status, &expected, RECORDER_RECORDING, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            recorder->order = order;
+            recorder->size = 0;
+            recorder->command_count = 0;
+            return recorder;
+        }
+    }
+    if (!state.full_reported) {
+        state.full_reported = TRUE;
+        KWARN("All %u render command recorders are in use. Recordings are being dropped.", RENDER_COMMANDS_MAX_RECORDERS);
+    }
+    return 0;
+}
+
+void render_commands_end(render_command_recorder* recorder) {
+    if (!recorder) {
+        return;
+    }
+    recorder->end_sequence = __atomic_fetch_add(&state.end_sequence, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->status, RECORDER_ENDED, __ATOMIC_RELEASE);
+}
+
+// Reserves a command at the end of the recording and fills in its header.
+static void* command_push(render_command_recorder* recorder, render_command_type type, u32 size) {
+    if (recorder->size + size > recorder->capacity) {
+        u64 capacity = recorder->capacity ? recorder->capacity * 2 : RENDER_COMMANDS_INITIAL_CAPACITY;
+        u8* data = kallocate(capacity, MEMORY_TAG_RENDERER);
+        if (recorder->data) {
+            kcopy_memory(data, recorder->data, recorder->size);
+            kfree(recorder->data, recorder->capacity, MEMORY_TAG_RENDERER);
+        }
+        recorder->data = data;
+        recorder->capacity = capacity;
+    }
+    render_command_header* header = (render_command_header*)(recorder->data + recorder->size);
+    header->type = (u16)type;
+    header->size = (u16)size;
+    recorder->size += size;
+    recorder->command_count++;
+    return header;
+}
+
+void render_commands_bind_pipeline(render_command_recorder* recorder, u32 pipeline) {
+    render_command_bind_pipeline* command = command_push(recorder, RENDER_COMMAND_BIND_PIPELINE, sizeof(render_command_bind_pipeline));
+    command->pipeline = pipeline;
+}
+
+void render_commands_bind_resources(render_command_recorder* recorder, render_vertex_source vertices, render_space space, const mat4* transform, u32 material) {
+    render_command_bind_resources* command = command_push(recorder, RENDER_COMMAND_BIND_RESOURCES, sizeof(render_command_bind_resources));
+    command->vertices = vertices;
+    command->space = space;
+    command->material = material;
+    if (transform) {
+        kcopy_memory(command->transform, transform->data, sizeof(command->transform));
+    } else {
+        kzero_memory(command->transform, sizeof(command->transform));
+    }
+}
+
+void render_commands_draw(render_command_recorder* recorder, u32 first_vertex, u32 vertex_count) {
+    render_command_draw* command = command_push(recorder, RENDER_COMMAND_DRAW, sizeof(render_command_draw));
+    command->first_vertex = first_vertex;
+    command->vertex_count = vertex_count;
+    command->padding = 0;
+}
+
+void render_commands_draw_mesh(render_command_recorder* recorder, const render_mesh* mesh) {
+    render_command_draw_mesh* command = command_push(recorder, RENDER_COMMAND_DRAW_MESH, sizeof(render_command_draw_mesh));
+    command->lod = mesh->lod;
+    command->mesh = mesh->mesh;
+    command->position[0] = mesh->position[0];
+    command->position[1] = mesh->position[1];
+    command->position[2] = mesh->position[2];
+    command->scale = mesh->scale;
+    command->material_row = mesh->material_row;
+    command->padding = 0;
+}
+
+void render_commands_dispatch(render_command_recorder* recorder, u32 x, u32 y, u32 z) {
+    render_command_dispatch* command = command_push(recorder, RENDER_COMMAND_DISPATCH, sizeof(render_command_dispatch));
+    command->group_count[0] = x;
+    command->group_count[1] = y;
+    command->group_count[2] = z;
+}
+
+void render_commands_barrier(render_command_recorder* recorder, u32 before, u32 after) {
+    render_command_barrier* command = command_push(recorder, RENDER_COMMAND_BARRIER, sizeof(render_command_barrier));
+    command->before = before;
+    command->after = after;
+    command->padding = 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "renderer_types.inl"
+
+/*
+Records the commands a frame is drawn with. Any thread may record: each
+recording has a buffer of its own, so recording never locks or waits on
+another thread. When the packet is built, the finished recordings are
+copied one after another, by order, into the frame's single buffer, which
+the backend translates in one pass.
+
+Recordings must be ended before the packet is built to be in its frame.
+*/
+
+// The most recordings which may be open or waiting for their frame at once.
+#define RENDER_COMMANDS_MAX_RECORDERS 256
+
+// Recordings are put in the frame by order, lowest first, then by when they ended.
+// Dispatches and barriers, which must come before anything is drawn.
+#define RENDER_COMMAND_ORDER_COMPUTE 0x00000000
+// The packet's meshes, recorded by the renderer. Games may record their own draws after them.
+#define RENDER_COMMAND_ORDER_SCENE 0x10000000
+// Debug geometry, then the performance overlay, over everything else.
+#define RENDER_COMMAND_ORDER_DEBUG 0x20000000
+#define RENDER_COMMAND_ORDER_OVERLAY 0x30000000
+
+typedef struct render_command_recorder {
+    u8* data;
+    u64 size;
+    u64 capacity;
+    u32 command_count;
+    u32 order;
+    u32 end_sequence;
+    // 0 while free, 1 while recording, 2 once ended.
+    u32 status;
+} render_command_recorder;
+
+// Called by the renderer frontend.
+b8 render_commands_initialize();
+void render_commands_shutdown();
+// Gathers the ended recordings into the frame's buffer, and frees their recorders.
+void render_commands_build(render_command_list* out_list);
+
+/**
+ * Starts a recording. Thread safe.
+ * @param order Where the recording goes in the frame, e.g. RENDER_COMMAND_ORDER_SCENE.
+ * @returns The recorder, or 0 if every recorder is in use.
+ */
+KAPI render_command_recorder* render_commands_begin(u32 order);
+
+// Ends a recording, to be put in the next packet built.
+KAPI void render_commands_end(render_command_recorder* recorder);
+
+KAPI void render_commands_bind_pipeline(render_command_recorder* recorder, u32 pipeline);
+
+/**
+ * Binds vertices and a transform for the draws after it, with the pipeline
+ * bound last.
+ * @param transform Transforms world space vertices to clip space. Ignored in screen space.
+ * @param material The material whose parameters mesh draws index, or INVALID_ID.
+ */
+KAPI void render_commands_bind_resources(render_command_recorder* recorder, render_vertex_source vertices, render_space space, const mat4* transform, u32 material);
+
+KAPI void render_commands_draw(render_command_recorder* recorder, u32 first_vertex, u32 vertex_count);
+
+// Draws a mesh at the level of detail picked for it. The mesh must stay loaded until the frame has been drawn.
+KAPI void render_commands_draw_mesh(render_command_recorder* recorder, const render_mesh* mesh);
+
+KAPI void render_commands_dispatch(render_command_recorder* recorder, u32 x, u32 y, u32 z);
+
+// Makes the work of the before stages, render_stage_bits, visible to the after stages.
+KAPI void render_commands_barrier(render_command_recorder* recorder, u32 before, u32 after);
@@ -1,6 +1,7 @@
 #include "renderer_backend.h"
 
 #include "vulkan/vulkan_backend.h"
+#include "null/null_backend.h"
 
 b8 renderer_backend_create(renderer_backend_type type, struct platform_state* plat_state, renderer_backend* out_renderer_backend) {
     out_renderer_backend->plat_state = plat_state;
@@ -11,6 +12,23 @@ b8 renderer_backend_create(renderer_backend_type type, struct platform_state* pl
         out_renderer_backend->begin_frame = vulkan_renderer_backend_begin_frame;
         out_renderer_backend->end_frame = vulkan_renderer_backend_end_frame;
         out_renderer_backend->resized = vulkan_renderer_backend_on_resized;
+        out_renderer_backend->config_changed = vulkan_renderer_backend_config_changed;
+        out_renderer_backend->debug_draw_map = vulkan_renderer_backend_debug_draw_map;
+        out_renderer_backend->overlay_map = vulkan_renderer_backend_overlay_map;
+        out_renderer_backend->execute = vulkan_renderer_backend_execute;
+        out_renderer_backend->gpu_frame_time = vulkan_renderer_backend_gpu_frame_time;
+        return TRUE;
+    } else if (type == RENDERER_BACKEND_TYPE_NULL) {
+        out_renderer_backend->initialize = null_renderer_backend_initialize;
+        out_renderer_backend->shutdown = null_renderer_backend_shutdown;
+        out_renderer_backend->begin_frame = null_renderer_backend_begin_frame;
+        out_renderer_backend->end_frame = null_renderer_backend_end_frame;
+        out_renderer_backend->resized = null_renderer_backend_on_resized;
+        out_renderer_backend->config_changed = 0;
+        out_renderer_backend->debug_draw_map = 0;
+        out_renderer_backend->overlay_map = 0;
+        out_renderer_backend->execute = 0;
+        out_renderer_backend->gpu_frame_time = 0;
         return TRUE;
     }
 
@@ -23,4 +41,9 @@ void renderer_backend_destroy(renderer_backend* renderer_backend) {
     renderer_backend->begin_frame = 0;
     renderer_backend->end_frame = 0;
     renderer_backend->resized = 0;
+    renderer_backend->config_changed = 0;
+    renderer_backend->debug_draw_map = 0;
+    renderer_backend->overlay_map = 0;
+    renderer_backend->execute = 0;
+    renderer_backend->gpu_frame_time = 0;
 }
\ No newline at end of file
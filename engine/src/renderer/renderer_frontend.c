@@ -1,34 +1,503 @@
 #include "renderer_frontend.h"
 
 #include "renderer_backend.h"
+#include "debug_draw.h"
+#include "render_commands.h"
+#include "perf_overlay.h"
 
+#include "containers/darray.h"
+#include "core/clock.h"
 #include "core/logger.h"
 #include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/profiler.h"
+#include "math/kmath.h"
+#include "resources/resource_types.h"
+#include "systems/job_system.h"
+#include "systems/material_system.h"
+
+#include <math.h>
 
 struct platform_state;
 
 // Backend render context.
 static renderer_backend* backend = 0;
 
-b8 renderer_initialize(const char* application_name, struct platform_state* plat_state) {
+// Each culling batch is tested on one thread. A multiple of 8, the widest SIMD batch.
+#define RENDERER_CULL_BATCH_SIZE 4096
+
+// The fewest meshes one thread records commands for. Big scenes are split into at most RENDERER_RECORD_MAX_RANGES.
+#define RENDERER_RECORD_BATCH_SIZE 2048
+#define RENDERER_RECORD_MAX_RANGES 128
+
+// Meshes submitted for the next frame. A darray.
+static render_mesh* submitted_meshes = 0;
+static render_view current_view;
+
+/*
+The bounding sphere of each submitted mesh, structure-of-arrays so the
+culling kernel loads 8 of each at once. darrays, parallel to submitted_meshes.
+*/
+static f32* cull_xs = 0;
+static f32* cull_ys = 0;
+static f32* cull_zs = 0;
+static f32* cull_radii = 0;
+
+// Indices of the meshes left by each batch, at the batch's offset, and how many.
+static u32* cull_indices = 0;
+static u32* cull_batch_counts = 0;
+static u32 cull_capacity = 0;
+
+// Each visible mesh's sort key, and room for the radix sort's other half. Sized as cull_indices.
+static u32* sort_keys = 0;
+static u32* sort_scratch_keys = 0;
+static u32* sort_scratch_indices = 0;
+
+// The meshes left after culling, grouped by material. A darray.
+static render_mesh* visible_meshes = 0;
+// The runs of visible_meshes sharing a material. A darray.
+static render_batch* batches = 0;
+
+// Time spent in the backend's begin_frame, mostly waiting on the GPU.
+static u32 wait_scope = INVALID_ID;
+
+// The key of meshes without a material, which sorts them last.
+#define RENDERER_NO_MATERIAL_KEY 0xFFFFFFFF
+
+b8 renderer_initialize(renderer_backend_type type, const char* application_name, struct platform_state* plat_state, const renderer_config* config) {
     backend = kallocate(sizeof(renderer_backend), MEMORY_TAG_RENDERER);
-    // TODO: make this configurable.
-    renderer_backend_create(RENDERER_BACKEND_TYPE_VULKAN, plat_state, backend);
+    if (!renderer_backend_create(type, plat_state, backend)) {
+        KFATAL("Unsupported renderer backend type: %i", type);
+        return FALSE;
+    }
     backend->frame_number = 0;
+    backend->config = *config;
+    if (backend->config.present_mode >= RENDERER_PRESENT_MODE_COUNT) {
+        backend->config.present_mode = RENDERER_PRESENT_MODE_FIFO;
+    }
+    if (backend->config.max_frames_in_flight < 1 || backend->config.max_frames_in_flight > 3) {
+        KWARN("max_frames_in_flight must be 1 to 3, not %u. Using 2.", backend->config.max_frames_in_flight);
+        backend->config.max_frames_in_flight = 2;
+    }
     if (!backend->initialize(backend, application_name, plat_state)) {
         KFATAL("Renderer backend failed to initialize. Shutting down.");
         return FALSE;
     }
+    submitted_meshes = darray_create(render_mesh);
+    cull_xs = darray_create(f32);
+    cull_ys = darray_create(f32);
+    cull_zs = darray_create(f32);
+    cull_radii = darray_create(f32);
+    visible_meshes = darray_create(render_mesh);
+    batches = darray_create(render_batch);
+    kzero_memory(&current_view, sizeof(render_view));
+    current_view.view_projection = mat4_identity();
+    render_commands_initialize();
+    debug_draw_initialize(backend);
+    wait_scope = profiler_scope_register("renderer_wait");
+    perf_overlay_initialize(backend);
     return TRUE;
 }
 
 void renderer_shutdown() {
+    // Before the backend, which owns the debug and overlay vertices' memory.
+    perf_overlay_shutdown();
+    debug_draw_shutdown();
+    if (submitted_meshes) {
+        darray_destroy(submitted_meshes);
+        darray_destroy(cull_xs);
+        darray_destroy(cull_ys);
+        darray_destroy(cull_zs);
+        darray_destroy(cull_radii);
+        darray_destroy(visible_meshes);
+        darray_destroy(batches);
+        submitted_meshes = 0;
+    }
+    if (cull_capacity) {
+        kfree(cull_indices, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+        kfree(cull_batch_counts, sizeof(u32) * (cull_capacity / RENDERER_CULL_BATCH_SIZE + 1), MEMORY_TAG_RENDERER);
+        kfree(sort_keys, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+        kfree(sort_scratch_keys, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+        kfree(sort_scratch_indices, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+        cull_capacity = 0;
+    }
+    render_commands_shutdown();
     backend->shutdown(backend);
     kfree(backend, sizeof(renderer_backend), MEMORY_TAG_RENDERER);
 }
 
+void renderer_on_resized(u16 width, u16 height) {
+    if (backend) {
+        backend->resized(backend, width, height);
+    } else {
+        KWARN("renderer backend does not exist to accept resize: %i %i", width, height);
+    }
+}
+
+void renderer_set_view(const render_view* view) {
+    current_view = *view;
+}
+
+void renderer_submit_mesh(const struct mesh_resource_data* mesh, const f32 position[3], f32 scale) {
+    material_instance none = {0};
+    renderer_submit_mesh_material(mesh, position, scale, none);
+}
+
+void renderer_submit_mesh_material(const struct mesh_resource_data* mesh, const f32 position[3], f32 scale, material_instance material) {
+    render_mesh draw;
+    draw.mesh = mesh;
+    draw.position[0] = position[0];
+    draw.position[1] = position[1];
+    draw.position[2] = position[2];
+    draw.scale = scale;
+    draw.lod = 0;
+    draw.material = material;
+    draw.material_row = 0;
+    darray_push(submitted_meshes, draw);
+
+    f32 radius_sq = 0;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 half_extent = (mesh->bounds_max[axis] - mesh->bounds_min[axis]) * 0.5f;
+        radius_sq += half_extent * half_extent;
+    }
+    darray_push(cull_xs, position[0] + (mesh->bounds_min[0] + mesh->bounds_max[0]) * 0.5f * scale);
+    darray_push(cull_ys, position[1] + (mesh->bounds_min[1] + mesh->bounds_max[1]) * 0.5f * scale);
+    darray_push(cull_zs, position[2] + (mesh->bounds_min[2] + mesh->bounds_max[2]) * 0.5f * scale);
+    darray_push(cull_radii, sqrtf(radius_sq) * fabsf(scale));
+}
+
+static void cull_batch(void* context, u32 begin, u32 end) {
+    const frustum* f = context;
+    cull_batch_counts[begin / RENDERER_CULL_BATCH_SIZE] =
+        frustum_cull_spheres(f, cull_xs + begin, cull_ys + begin, cull_zs + begin, cull_radii + begin, end - begin, begin, cull_indices + begin);
+}
+
+// Grows the per-mesh scratch arrays to hold at least count meshes.
+static void ensure_draw_capacity(u32 count) {
+    if (count <= cull_capacity) {
+        return;
+    }
+    if (cull_capacity) {
+        kfree(cull_indices, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+        kfree(cull_batch_counts, sizeof(u32) * (cull_capacity / RENDERER_CULL_BATCH_SIZE + 1), MEMORY_TAG_RENDERER);
+        kfree(sort_keys, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+        kfree(sort_scratch_keys, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+        kfree(sort_scratch_indices, sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+    }
+    cull_capacity = count * 2;
+    cull_indices = kallocate(sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+    cull_batch_counts = kallocate(sizeof(u32) * (cull_capacity / RENDERER_CULL_BATCH_SIZE + 1), MEMORY_TAG_RENDERER);
+    sort_keys = kallocate(sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+    sort_scratch_keys = kallocate(sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+    sort_scratch_indices = kallocate(sizeof(u32) * cull_capacity, MEMORY_TAG_RENDERER);
+}
+
+/**
+ * Culls the submitted meshes against the view's frustum across the job
+ * system, then packs the survivors' indices to the front of cull_indices in
+ * submission order.
+ * @returns The number of survivors.
+ */
+static u32 cull_submitted(const frustum* f) {
+    u32 count = (u32)darray_length(submitted_meshes);
+    job_system_parallel_for(cull_batch, (void*)f, count, RENDERER_CULL_BATCH_SIZE);
+
+    // Each batch's survivors move down to the end of the previous ones, never past their own start.
+    u32 visible_count = 0;
+    u32 batch_count = (count + RENDERER_CULL_BATCH_SIZE - 1) / RENDERER_CULL_BATCH_SIZE;
+    for (u32 b = 0; b < batch_count; ++b) {
+        const u32* indices = cull_indices + b * RENDERER_CULL_BATCH_SIZE;
+        for (u32 i = 0; i < cull_batch_counts[b]; ++i) {
+            cull_indices[visible_count++] = indices[i];
+        }
+    }
+    return visible_count;
+}
+
+/**
+ * Sorts the first count of cull_indices by their sort_keys, least significant
+ * byte first. Stable, so meshes sharing a material keep their submission
+ * order. Bytes every key shares are skipped, so the usual handful of
+ * materials and pipelines costs one or two passes.
+ */
+static void sort_by_key(u32 count) {
+    u32 all_or = 0;
+    u32 all_and = 0xFFFFFFFF;
+    for (u32 i = 0; i < count; ++i) {
+        all_or |= sort_keys[i];
+        all_and &= sort_keys[i];
+    }
+    u32 varying = all_or ^ all_and;
+
+    u32* keys = sort_keys;
+    u32* indices = cull_indices;
+    u32* scratch_keys = sort_scratch_keys;
+    u32* scratch_indices = sort_scratch_indices;
+    for (u32 shift = 0; shift < 32; shift += 8) {
+        if (((varying >> shift) & 0xFF) == 0) {
+            continue;
+        }
+        u32 offsets[256] = {0};
+        for (u32 i = 0; i < count; ++i) {
+            offsets[(keys[i] >> shift) & 0xFF]++;
+        }
+        u32 total = 0;
+        for (u32 d = 0; d < 256; ++d) {
+            u32 digit_count = offsets[d];
+            offsets[d] = total;
+            total += digit_count;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            u32 target = offsets[(keys[i] >> shift) & 0xFF]++;
+            scratch_keys[target] = keys[i];
+            scratch_indices[target] = indices[i];
+        }
+        u32* swap = keys;
+        keys = scratch_keys;
+        scratch_keys = swap;
+        swap = indices;
+        indices = scratch_indices;
+        scratch_indices = swap;
+    }
+    if (indices != cull_indices) {
+        kcopy_memory(cull_indices, indices, sizeof(u32) * count);
+        kcopy_memory(sort_keys, keys, sizeof(u32) * count);
+    }
+}
+
+/**
+ * Gathers the visible meshes into visible_meshes, ordered by pipeline then
+ * material, and describes each material's run as a batch.
+ */
+static void group_by_material(u32 visible_count, render_packet* out_packet) {
+    for (u32 i = 0; i < visible_count; ++i) {
+        render_mesh* draw = &submitted_meshes[cull_indices[i]];
+        u32 material;
+        u32 pipeline;
+        if (material_instance_resolve(draw->material, &material, &pipeline, &draw->material_row)) {
+            sort_keys[i] = (pipeline << 16) | material;
+        } else {
+            // Stale instances draw without one, rather than with whatever reuses their slot.
+            kzero_memory(&draw->material, sizeof(material_instance));
+            draw->material_row = 0;
+            sort_keys[i] = RENDERER_NO_MATERIAL_KEY;
+        }
+    }
+    sort_by_key(visible_count);
+
+    darray_clear(visible_meshes);
+    darray_clear(batches);
+    out_packet->pipeline_change_count = 0;
+    u32 previous_pipeline = INVALID_ID;
+    for (u32 i = 0; i < visible_count; ++i) {
+        darray_push(visible_meshes, submitted_meshes[cull_indices[i]]);
+        if (i > 0 && sort_keys[i] == sort_keys[i - 1]) {
+            batches[darray_length(batches) - 1].mesh_count++;
+            continue;
+        }
+
+        render_batch batch;
+        kzero_memory(&batch, sizeof(render_batch));
+        if (sort_keys[i] == RENDERER_NO_MATERIAL_KEY || !material_batch_describe(sort_keys[i] & 0xFFFF, &batch)) {
+            batch.pipeline = INVALID_ID;
+            batch.material = INVALID_ID;
+        }
+        batch.first_mesh = i;
+        batch.mesh_count = 1;
+        darray_push(batches, batch);
+        if (batch.pipeline != previous_pipeline || batch.pipeline == INVALID_ID) {
+            out_packet->pipeline_change_count++;
+            previous_pipeline = batch.pipeline;
+        }
+    }
+}
+
+/**
+ * Picks the coarsest level of detail whose error, projected onto the screen
+ * at the distance of the mesh's nearest bound, stays under the view's pixel
+ * threshold. The mesh's bounding sphere is used rather than its box, which
+ * errs on the side of detail.
+ */
+static u32 select_lod(const render_mesh* draw, const render_view* view) {
+    const mesh_resource_data* mesh = draw->mesh;
+    if (mesh->lod_count <= 1 || view->viewport_height <= 0 || view->fov_y <= 0) {
+        return 0;
+    }
+
+    f32 distance_sq = 0;
+    f32 radius_sq = 0;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 half_extent = (mesh->bounds_max[axis] - mesh->bounds_min[axis]) * 0.5f;
+        f32 center = draw->position[axis] + (mesh->bounds_min[axis] + half_extent) * draw->scale;
+        f32 offset = center - view->position[axis];
+        distance_sq += offset * offset;
+        radius_sq += half_extent * half_extent;
+    }
+    f32 distance = sqrtf(distance_sq) - sqrtf(radius_sq) * draw->scale;
+    if (distance <= 0) {
+        // Inside the bounds.
+        return 0;
+    }
+
+    // Pixels covered by one world unit at that distance.
+    f32 pixels_per_unit = view->viewport_height / (2.0f * tanf(view->fov_y * 0.5f) * distance);
+    for (u32 lod = mesh->lod_count - 1; lod > 0; --lod) {
+        if (mesh->lods[lod].error * draw->scale * pixels_per_unit <= view->lod_error_pixels) {
+            return lod;
+        }
+    }
+    return 0;
+}
+
+typedef struct scene_recording {
+    const render_packet* packet;
+    u32 range_size;
+} scene_recording;
+
+// The index of the batch holding the packet's mesh at index.
+static u32 batch_containing(const render_packet* packet, u32 index) {
+    u32 low = 0;
+    u32 high = packet->batch_count - 1;
+    while (low < high) {
+        u32 mid = (low + high + 1) / 2;
+        if (packet->batches[mid].first_mesh <= index) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+/**
+ * Records the draws of one range of the packet's meshes, binding each batch's
+ * pipeline and material as the range reaches it. Ranges are ordered by where
+ * they start, so the frame draws the meshes in packet order.
+ */
+static void record_scene_range(void* context, u32 begin, u32 end) {
+    const scene_recording* recording = context;
+    const render_packet* packet = recording->packet;
+    render_command_recorder* recorder = render_commands_begin(RENDER_COMMAND_ORDER_SCENE + begin / recording->range_size);
+    if (!recorder) {
+        return;
+    }
+
+    u32 pipeline = INVALID_ID;
+    u32 i = begin;
+    for (u32 b = batch_containing(packet, begin); i < end; ++b) {
+        const render_batch* batch = &packet->batches[b];
+        u32 batch_pipeline = batch->pipeline == INVALID_ID ? RENDER_PIPELINE_MESH_DEFAULT : RENDER_PIPELINE_MATERIAL_BASE + batch->pipeline;
+        if (batch_pipeline != pipeline) {
+            render_commands_bind_pipeline(recorder, batch_pipeline);
+            pipeline = batch_pipeline;
+        }
+        render_commands_bind_resources(recorder, RENDER_VERTICES_NONE, RENDER_SPACE_WORLD, &packet->view.view_projection, batch->material);
+        u32 batch_end = KMIN(batch->first_mesh + batch->mesh_count, end);
+        for (; i < batch_end; ++i) {
+            render_commands_draw_mesh(recorder, &packet->meshes[i]);
+        }
+    }
+    render_commands_end(recorder);
+}
+
+// Records the packet's debug geometry, each kind with its own pipeline.
+static void record_debug(const debug_draw_packet* debug) {
+    render_command_recorder* recorder = 0;
+    for (u32 type = 0; type < DEBUG_DRAW_TYPE_COUNT; ++type) {
+        if (!debug->vertex_count[type]) {
+            continue;
+        }
+        if (!recorder && !(recorder = render_commands_begin(RENDER_COMMAND_ORDER_DEBUG))) {
+            return;
+        }
+        render_space space = type == DEBUG_DRAW_TYPE_OVERLAY ? RENDER_SPACE_SCREEN : RENDER_SPACE_WORLD;
+        render_commands_bind_pipeline(recorder, RENDER_PIPELINE_DEBUG_LINES + type);
+        render_commands_bind_resources(recorder, RENDER_VERTICES_DEBUG, space, &debug->view_projection, INVALID_ID);
+        render_commands_draw(recorder, debug->first_vertex[type], debug->vertex_count[type]);
+    }
+    render_commands_end(recorder);
+}
+
+void renderer_build_packet(f32 delta_time, render_packet* out_packet) {
+    out_packet->delta_time = delta_time;
+    out_packet->view = current_view;
+    u32 submitted_count = (u32)darray_length(submitted_meshes);
+    ensure_draw_capacity(submitted_count);
+    u32 visible_count = submitted_count;
+    if (current_view.cull && submitted_count) {
+        visible_count = cull_submitted(&current_view.view_frustum);
+    } else {
+        for (u32 i = 0; i < submitted_count; ++i) {
+            cull_indices[i] = i;
+        }
+    }
+    group_by_material(visible_count, out_packet);
+
+    out_packet->meshes = visible_meshes;
+    out_packet->mesh_count = visible_count;
+    out_packet->culled_count = submitted_count - visible_count;
+    out_packet->batches = batches;
+    out_packet->batch_count = (u32)darray_length(batches);
+    out_packet->triangle_count = 0;
+    out_packet->full_triangle_count = 0;
+
+    for (u32 i = 0; i < out_packet->mesh_count; ++i) {
+        render_mesh* draw = &out_packet->meshes[i];
+        draw->lod = select_lod(draw, &current_view);
+        out_packet->triangle_count += draw->mesh->lods[draw->lod].index_count / 3;
+        out_packet->full_triangle_count += draw->mesh->lods[0].index_count / 3;
+    }
+
+    if (out_packet->mesh_count) {
+        scene_recording recording;
+        recording.packet = out_packet;
+        recording.range_size = KMAX(RENDERER_RECORD_BATCH_SIZE, (out_packet->mesh_count + RENDERER_RECORD_MAX_RANGES - 1) / RENDERER_RECORD_MAX_RANGES);
+        job_system_parallel_for(record_scene_range, &recording, out_packet->mesh_count, recording.range_size);
+    }
+
+    debug_draw_build(&current_view.view_projection, &out_packet->debug);
+    record_debug(&out_packet->debug);
+    // Last, once the packet's figures are known.
+    perf_overlay_build(out_packet);
+    if (out_packet->overlay_vertex_count) {
+        render_command_recorder* recorder = render_commands_begin(RENDER_COMMAND_ORDER_OVERLAY);
+        if (recorder) {
+            render_commands_bind_pipeline(recorder, RENDER_PIPELINE_PERF_OVERLAY);
+            render_commands_bind_resources(recorder, RENDER_VERTICES_OVERLAY, RENDER_SPACE_SCREEN, 0, INVALID_ID);
+            render_commands_draw(recorder, out_packet->overlay_first_vertex, out_packet->overlay_vertex_count);
+            render_commands_end(recorder);
+        }
+    }
+
+    // Along with anything the game recorded since the last packet.
+    render_commands_build(&out_packet->commands);
+}
+
+void renderer_apply_config(const renderer_config* config) {
+    if (!backend) {
+        return;
+    }
+
+    renderer_config* current = &backend->config;
+    if (config->max_frames_in_flight != current->max_frames_in_flight ||
+        config->require_discrete_gpu != current->require_discrete_gpu ||
+        !strings_equal(config->device_name, current->device_name)) {
+        KINFO("Frames in flight and device selection changes take effect on the next start.");
+    }
+
+    if (config->present_mode != current->present_mode && config->present_mode < RENDERER_PRESENT_MODE_COUNT) {
+        current->present_mode = config->present_mode;
+        if (backend->config_changed) {
+            backend->config_changed(backend);
+        }
+    }
+}
+
 b8 renderer_begin_frame(f32 delta_time) {
-    return backend->begin_frame(backend, delta_time);
+    f64 start = clock_get_current_time();
+    b8 result = backend->begin_frame(backend, delta_time);
+    profiler_record(wait_scope, clock_get_current_time() - start);
+    return result;
 }
 
 b8 renderer_end_frame(f32 delta_time) {
@@ -40,6 +509,10 @@ b8 renderer_end_frame(f32 delta_time) {
 b8 renderer_draw_frame(render_packet* packet) {
     // If the begin frame returned successfully, mid-frame operations may continue.
     if (renderer_begin_frame(packet->delta_time)) {
+        if (backend->execute) {
+            backend->execute(backend, &packet->commands);
+        }
+
         // End the frame. If this fails, it is likely unrecoverable.
         b8 result = renderer_end_frame(packet->delta_time);
         if (!result) {
@@ -48,5 +521,14 @@ b8 renderer_draw_frame(render_packet* packet) {
         }
     }
 
+    debug_draw_frame_end();
+
+    // Submissions only last one frame.
+    darray_clear(submitted_meshes);
+    darray_clear(cull_xs);
+    darray_clear(cull_ys);
+    darray_clear(cull_zs);
+    darray_clear(cull_radii);
+
     return TRUE;
 }
\ No newline at end of file
@@ -5,9 +5,43 @@
 struct static_mesh_data;
 struct platform_state;
 
-b8 renderer_initialize(const char* application_name, struct platform_state* plat_state);
+b8 renderer_initialize(renderer_backend_type type, const char* application_name, struct platform_state* plat_state, const renderer_config* config);
 void renderer_shutdown();
 
 void renderer_on_resized(u16 width, u16 height);
 
+// Applies changed renderer settings. Settings read at startup only keep their old values.
+void renderer_apply_config(const renderer_config* config);
+
+/**
+ * Sets the view the next frame is drawn from. Until a view is set, every
+ * mesh is drawn at full detail.
+ */
+KAPI void renderer_set_view(const render_view* view);
+
+/**
+ * Submits a mesh to be drawn in the next frame. The mesh must stay loaded
+ * until the frame has been drawn.
+ */
+KAPI void renderer_submit_mesh(const struct mesh_resource_data* mesh, const f32 position[3], f32 scale);
+
+/**
+ * Submits a mesh to be drawn with a material instance in the next frame.
+ * Meshes are grouped by material when the packet is built, so the order of
+ * submission does not matter.
+ */
+KAPI void renderer_submit_mesh_material(const struct mesh_resource_data* mesh, const f32 position[3], f32 scale, material_instance material);
+
+/**
+ * Builds the packet for the next frame from everything submitted since the
+ * last one. If the view culls, meshes whose bounding spheres are outside its
+ * frustum are left out; each remaining mesh's level of detail is picked by
+ * its projected error. The rest are sorted by pipeline and material, and
+ * split into batches which each bind one material. Their draws are recorded
+ * as commands across the job system, and gathered with the debug geometry,
+ * the overlay and any recordings the game ended into the packet's command
+ * list.
+ */
+void renderer_build_packet(f32 delta_time, render_packet* out_packet);
+
 b8 renderer_draw_frame(render_packet* packet);
\ No newline at end of file
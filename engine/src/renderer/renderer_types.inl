@@ -1,25 +1,306 @@
 #pragma once
 
 #include "defines.h"
+#include "math/math_types.h"
+#include "resources/resource_types.h"
 
 typedef enum renderer_backend_type {
     RENDERER_BACKEND_TYPE_VULKAN,
     RENDERER_BACKEND_TYPE_OPENGL,
     RENDERER_BACKEND_TYPE_DIRECTX,
     RENDERER_BACKEND_TYPE_METAL,
+    // Draws nothing. Used when running headless.
+    RENDERER_BACKEND_TYPE_NULL,
 } renderer_backend_type;
 
+typedef enum renderer_present_mode {
+    // Waits for vertical blank. Always supported.
+    RENDERER_PRESENT_MODE_FIFO,
+    // Waits for vertical blank, replacing queued frames with newer ones.
+    RENDERER_PRESENT_MODE_MAILBOX,
+    // Presents immediately, and may tear.
+    RENDERER_PRESENT_MODE_IMMEDIATE,
+    RENDERER_PRESENT_MODE_COUNT
+} renderer_present_mode;
+
+// Renderer settings, usually bound to the application's config file.
+typedef struct renderer_config {
+    // Falls back to FIFO when the device does not support it.
+    renderer_present_mode present_mode;
+    // How many frames may be recorded ahead of the GPU, 1 to 3. Read at startup only.
+    u32 max_frames_in_flight;
+    // Only use a discrete GPU. Read at startup only.
+    b8 require_discrete_gpu;
+    // Only use a device whose name contains this, if not empty. Read at startup only.
+    char device_name[64];
+} renderer_config;
+
+// The kinds of debug geometry. Each is drawn with a single draw call.
+typedef enum debug_draw_type {
+    // World space lines, depth tested.
+    DEBUG_DRAW_TYPE_LINES,
+    // World space triangles, depth tested and blended.
+    DEBUG_DRAW_TYPE_TRIANGLES,
+    // Triangles in pixels from the top left of the screen, drawn over everything. Used for text.
+    DEBUG_DRAW_TYPE_OVERLAY,
+    DEBUG_DRAW_TYPE_COUNT
+} debug_draw_type;
+
+typedef struct debug_vertex {
+    f32 position[3];
+    // 8 bits per channel, red in the lowest byte.
+    u32 color;
+} debug_vertex;
+
+// Where a frame's debug geometry is in the memory mapped by the backend's debug_draw_map.
+typedef struct debug_draw_packet {
+    mat4 view_projection;
+    u32 first_vertex[DEBUG_DRAW_TYPE_COUNT];
+    u32 vertex_count[DEBUG_DRAW_TYPE_COUNT];
+} debug_draw_packet;
+
+// A vertex of the performance overlay, textured with the debug font atlas.
+typedef struct overlay_vertex {
+    // Pixels from the top left of the screen.
+    f32 position[2];
+    // Normalized atlas coordinates.
+    f32 texcoord[2];
+    // 8 bits per channel, red in the lowest byte.
+    u32 color;
+} overlay_vertex;
+
+/*
+A frame's drawing, as a stream of commands the backend translates in order.
+Commands sit one after another in a single buffer, each starting with a
+header giving its type and size, a multiple of 8 so pointers stay aligned.
+*/
+
+typedef enum render_command_type {
+    RENDER_COMMAND_BIND_PIPELINE,
+    // Binds vertices and a transform for the draws after it. Must follow the pipeline it is for.
+    RENDER_COMMAND_BIND_RESOURCES,
+    RENDER_COMMAND_DRAW,
+    RENDER_COMMAND_DRAW_MESH,
+    // Dispatches and barriers must come before the frame's first draw, outside of its renderpass.
+    RENDER_COMMAND_DISPATCH,
+    RENDER_COMMAND_BARRIER,
+    RENDER_COMMAND_TYPE_COUNT
+} render_command_type;
+
+// The pipelines every backend knows. Material pipelines follow, RENDER_PIPELINE_MATERIAL_BASE + their index.
+typedef enum render_pipeline {
+    RENDER_PIPELINE_DEBUG_LINES,
+    RENDER_PIPELINE_DEBUG_TRIANGLES,
+    RENDER_PIPELINE_DEBUG_OVERLAY,
+    RENDER_PIPELINE_PERF_OVERLAY,
+    // Meshes without a material.
+    RENDER_PIPELINE_MESH_DEFAULT,
+    RENDER_PIPELINE_MATERIAL_BASE
+} render_pipeline;
+
+typedef enum render_vertex_source {
+    RENDER_VERTICES_NONE,
+    // The memory mapped by debug_draw_map.
+    RENDER_VERTICES_DEBUG,
+    // The memory mapped by overlay_map.
+    RENDER_VERTICES_OVERLAY
+} render_vertex_source;
+
+typedef enum render_space {
+    // Vertices are transformed by the command's matrix.
+    RENDER_SPACE_WORLD,
+    // Vertices are pixels from the top left of the screen, whatever its size when drawn.
+    RENDER_SPACE_SCREEN
+} render_space;
+
+// What a barrier waits on, and what waits on it.
+typedef enum render_stage_bits {
+    RENDER_STAGE_TRANSFER = 0x01,
+    RENDER_STAGE_COMPUTE = 0x02,
+    RENDER_STAGE_VERTEX = 0x04,
+    RENDER_STAGE_FRAGMENT = 0x08,
+    RENDER_STAGE_HOST = 0x10
+} render_stage_bits;
+
+typedef struct render_command_header {
+    u16 type;
+    // In bytes, including the header.
+    u16 size;
+} render_command_header;
+
+typedef struct render_command_bind_pipeline {
+    render_command_header header;
+    u32 pipeline;
+} render_command_bind_pipeline;
+
+typedef struct render_command_bind_resources {
+    render_command_header header;
+    u32 vertices;
+    u32 space;
+    // The material whose parameter rows DRAW_MESH indexes, or INVALID_ID.
+    u32 material;
+    // Column major, as mat4. Used in world space only.
+    f32 transform[16];
+} render_command_bind_resources;
+
+typedef struct render_command_draw {
+    render_command_header header;
+    u32 first_vertex;
+    u32 vertex_count;
+    u32 padding;
+} render_command_draw;
+
+typedef struct render_command_draw_mesh {
+    render_command_header header;
+    u32 lod;
+    const struct mesh_resource_data* mesh;
+    f32 position[3];
+    f32 scale;
+    // The instance's row in the bound material's parameters.
+    u32 material_row;
+    u32 padding;
+} render_command_draw_mesh;
+
+typedef struct render_command_dispatch {
+    render_command_header header;
+    u32 group_count[3];
+} render_command_dispatch;
+
+typedef struct render_command_barrier {
+    render_command_header header;
+    // render_stage_bits.
+    u32 before;
+    u32 after;
+    u32 padding;
+} render_command_barrier;
+
+/**
+ * A frame's commands, in the order they are to be translated. Valid until the
+ * next packet is built. Apart from DRAW_MESH's mesh pointers the bytes hold no
+ * addresses, so copying them captures the frame, and executing the copy
+ * replays it.
+ */
+typedef struct render_command_list {
+    const u8* data;
+    u64 size;
+    u32 command_count;
+} render_command_list;
+
 typedef struct renderer_backend {
     struct platform_state* plat_state;
     u64 frame_number;
+    renderer_config config;
     b8 (*initialize)(struct renderer_backend* backend, const char* application_name, struct platform_state* plat_state);
     void (*shutdown)(struct renderer_backend* backend);
     void (*resized)(struct renderer_backend* backend, u16 width, u16 height);
     b8 (*begin_frame)(struct renderer_backend* backend, f32 delta_time);
     b8 (*end_frame)(struct renderer_backend* backend, f32 delta_time);
+    // Optional. Called after config has changed while running.
+    void (*config_changed)(struct renderer_backend* backend);
+    // Optional. Maps size bytes of memory for debug vertices, which stays mapped until shutdown. Returns 0 on failure.
+    void* (*debug_draw_map)(struct renderer_backend* backend, u64 size);
+    // Optional. Maps size bytes of memory for overlay vertices, which stays mapped until shutdown. Returns 0 on failure.
+    void* (*overlay_map)(struct renderer_backend* backend, u64 size);
+    // Optional. Translates the frame's commands, between begin_frame and end_frame.
+    void (*execute)(struct renderer_backend* backend, const render_command_list* commands);
+    // Optional. How long the GPU took over the most recently finished frame. Returns FALSE if not known.
+    b8 (*gpu_frame_time)(struct renderer_backend* backend, f64* out_ms);
 } renderer_backend;
 
+struct mesh_resource_data;
+
+// Where the frame is seen from. Used to pick each mesh's level of detail.
+typedef struct render_view {
+    f32 position[3];
+    // Vertical field of view in radians.
+    f32 fov_y;
+    // Viewport height in pixels.
+    f32 viewport_height;
+    // The most error, in pixels, a level of detail may show on screen.
+    f32 lod_error_pixels;
+    // When set, meshes whose bounds are wholly outside view_frustum are not drawn.
+    b8 cull;
+    frustum view_frustum;
+    // Used to draw debug geometry.
+    mat4 view_projection;
+} render_view;
+
+/**
+ * A material: the shaders to draw with, and the layout of the parameters
+ * each of its instances has. Handles go stale once destroyed, and a zeroed
+ * handle is invalid.
+ */
+typedef struct material_handle {
+    u32 index;
+    u32 generation;
+} material_handle;
+
+// One set of parameters for a material, e.g. a colour and textures.
+typedef struct material_instance {
+    u32 index;
+    u32 generation;
+} material_instance;
+
+typedef struct render_mesh {
+    const struct mesh_resource_data* mesh;
+    f32 position[3];
+    // Uniform scale from object to world space.
+    f32 scale;
+    // The level of detail to draw, picked when the packet is built.
+    u32 lod;
+    // Zeroed for none.
+    material_instance material;
+    // The instance's index in its batch's parameters, set when the packet is built.
+    u32 material_row;
+} render_mesh;
+
+/**
+ * A run of consecutive meshes in a packet drawn with one material, so its
+ * pipeline and parameters are bound once. Batches sharing a pipeline are
+ * adjacent, and meshes without a material come last, in a batch of their own
+ * with material INVALID_ID.
+ */
+typedef struct render_batch {
+    // Shared by every material with the same shaders.
+    u32 pipeline;
+    resource_handle vertex_shader;
+    resource_handle fragment_shader;
+    u32 material;
+    u32 first_mesh;
+    u32 mesh_count;
+    // Every instance's parameters, one after another, parameter_stride bytes apart.
+    const void* parameters;
+    u32 parameter_stride;
+    u32 parameter_count;
+    /**
+     * Changes whenever the parameters do, and never repeats, so a backend can
+     * keep the version each frame in flight last uploaded and upload only when
+     * it differs. No backend uploads parameters yet: the Vulkan backend makes
+     * no mesh pipelines to read them, as mesh geometry is not on the GPU.
+     */
+    u64 parameters_version;
+} render_batch;
+
 typedef struct render_packet {
     f32 delta_time;
+    render_view view;
+    // The meshes left after culling.
+    u32 mesh_count;
+    render_mesh* meshes;
+    u32 culled_count;
+    // The meshes grouped by material, in order.
+    u32 batch_count;
+    render_batch* batches;
+    // How many times the pipeline changes from one batch to the next, counting the first.
+    u32 pipeline_change_count;
+    // Triangles to draw at the picked levels of detail, and at full detail.
+    u64 triangle_count;
+    u64 full_triangle_count;
+    debug_draw_packet debug;
+    // Where the performance overlay is in the memory mapped by the backend's overlay_map. No vertices when hidden.
+    u32 overlay_first_vertex;
+    u32 overlay_vertex_count;
+    // Everything above to be drawn, along with whatever else was recorded for the frame.
+    render_command_list commands;
 } render_packet;
 
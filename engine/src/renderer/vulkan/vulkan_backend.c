@@ -9,6 +9,9 @@
 #include "vulkan_framebuffer.h"
 #include "vulkan_fence.h"
 #include "vulkan_utils.h"
+#include "vulkan_debug_draw.h"
+#include "vulkan_perf_overlay.h"
+#include "vulkan_commands.h"
 
 #include "core/logger.h"
 #include "core/kstring.h"
@@ -43,6 +46,8 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
     // TODO: custom allocator.
     context.allocator = 0;
 
+    context.config = backend->config;
+
     application_get_framebuffer_size(&cached_framebuffer_width, &cached_framebuffer_height);
     context.framebuffer_width = (cached_framebuffer_width != 0) ? cached_framebuffer_width : 800;
     context.framebuffer_height = (cached_framebuffer_height != 0) ? cached_framebuffer_height : 600;
@@ -203,6 +208,7 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
 
     // Create command buffers.
     create_command_buffers(backend);
+    vulkan_timestamps_create(&context);
 
     // Create sync objects.
     context.image_available_semaphores = darray_reserve(VkSemaphore, context.swapchain.max_frames_in_flight);
@@ -236,6 +242,9 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend) {
     vkDeviceWaitIdle(context.device.logical_device);
 
     // Destroy in the opposite order of creation.
+    vulkan_perf_overlay_destroy(&context);
+    vulkan_debug_draw_destroy(&context);
+    vulkan_timestamps_destroy(&context);
 
     // Sync objects
     for (u8 i = 0; i < context.swapchain.max_frames_in_flight; ++i) {
@@ -321,6 +330,20 @@ void vulkan_renderer_backend_on_resized(renderer_backend* backend, u16 width, u1
     KINFO("Vulkan renderer backend->resized: w/h/gen: %i/%i/%llu", width, height, context.framebuffer_size_generation);
 }
 
+void vulkan_renderer_backend_config_changed(renderer_backend* backend) {
+    // Only the present mode may change while running. Bumping the generation
+    // gets the swapchain recreated with it at the start of the next frame.
+    context.config.present_mode = backend->config.present_mode;
+    if (cached_framebuffer_width == 0 || cached_framebuffer_height == 0) {
+        // No resize pending, so recreate at the current size.
+        cached_framebuffer_width = context.framebuffer_width;
+        cached_framebuffer_height = context.framebuffer_height;
+    }
+    context.framebuffer_size_generation++;
+
+    KINFO("Vulkan renderer backend->config_changed: present mode %u", context.config.present_mode);
+}
+
 b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time) {
     vulkan_device* device = &context.device;
 
@@ -378,6 +401,7 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
     vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
     vulkan_command_buffer_reset(command_buffer);
     vulkan_command_buffer_begin(command_buffer, FALSE, FALSE, FALSE);
+    vulkan_timestamps_begin(&context, command_buffer, context.image_index);
 
     // Dynamic state
     VkViewport viewport;
@@ -400,20 +424,17 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
     context.main_renderpass.w = context.framebuffer_width;
     context.main_renderpass.h = context.framebuffer_height;
 
-    // Begin the render pass.
-    vulkan_renderpass_begin(
-        command_buffer,
-        &context.main_renderpass,
-        context.swapchain.framebuffers[context.image_index].handle);
-
+    // The render pass begins with the frame's first draw, so its dispatches and barriers can come before it.
     return TRUE;
 }
 
 b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time) {
     vulkan_command_buffer* command_buffer = &context.graphics_command_buffers[context.image_index];
 
-    // End renderpass
+    // End renderpass, beginning it first if nothing was drawn, so the frame is still cleared.
+    vulkan_commands_begin_renderpass(&context, command_buffer);
     vulkan_renderpass_end(command_buffer, &context.main_renderpass);
+    vulkan_timestamps_end(&context, command_buffer, context.image_index);
 
     vulkan_command_buffer_end(command_buffer);
 
@@ -478,6 +499,26 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
     return TRUE;
 }
 
+void* vulkan_renderer_backend_debug_draw_map(renderer_backend* backend, u64 size) {
+    return vulkan_debug_draw_create(&context, size);
+}
+
+void* vulkan_renderer_backend_overlay_map(renderer_backend* backend, u64 size) {
+    return vulkan_perf_overlay_create(&context, size);
+}
+
+void vulkan_renderer_backend_execute(renderer_backend* backend, const render_command_list* commands) {
+    vulkan_commands_execute(&context, &context.graphics_command_buffers[context.image_index], commands);
+}
+
+b8 vulkan_renderer_backend_gpu_frame_time(renderer_backend* backend, f64* out_ms) {
+    if (!context.gpu_frame_ms_valid) {
+        return FALSE;
+    }
+    *out_ms = context.gpu_frame_ms;
+    return TRUE;
+}
+
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
     VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
     VkDebugUtilsMessageTypeFlagsEXT message_types,
@@ -6,6 +6,13 @@ b8 vulkan_renderer_backend_initialize(renderer_backend* backend, const char* app
 void vulkan_renderer_backend_shutdown(renderer_backend* backend);
 
 void vulkan_renderer_backend_on_resized(renderer_backend* backend, u16 width, u16 height);
+void vulkan_renderer_backend_config_changed(renderer_backend* backend);
 
 b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time);
-b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time);
\ No newline at end of file
+b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time);
+
+void* vulkan_renderer_backend_debug_draw_map(renderer_backend* backend, u64 size);
+
+void* vulkan_renderer_backend_overlay_map(renderer_backend* backend, u64 size);
+void vulkan_renderer_backend_execute(renderer_backend* backend, const render_command_list* commands);
+b8 vulkan_renderer_backend_gpu_frame_time(renderer_backend* backend, f64* out_ms);
\ No newline at end of file
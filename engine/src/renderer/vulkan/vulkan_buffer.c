@@ -0,0 +1,74 @@
+#include "vulkan_buffer.h"
+
+#include "vulkan_utils.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+b8 vulkan_buffer_create(
+    vulkan_context* context,
+    u64 size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags memory_flags,
+    b8 map,
+    vulkan_buffer* out_buffer) {
+    kzero_memory(out_buffer, sizeof(vulkan_buffer));
+    out_buffer->size = size;
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;  // Only used in one queue.
+
+    VkResult result = vkCreateBuffer(context->device.logical_device, &buffer_info, context->allocator, &out_buffer->handle);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreateBuffer failed: '%s'", vulkan_result_string(result, TRUE));
+        return FALSE;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(context->device.logical_device, out_buffer->handle, &requirements);
+    i32 memory_type = context->find_memory_index(requirements.memoryTypeBits, memory_flags);
+    if (memory_type == -1) {
+        KERROR("Required memory type not found. Buffer not created.");
+        vulkan_buffer_destroy(context, out_buffer);
+        return FALSE;
+    }
+
+    VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocate_info.allocationSize = requirements.size;
+    allocate_info.memoryTypeIndex = (u32)memory_type;
+    result = vkAllocateMemory(context->device.logical_device, &allocate_info, context->allocator, &out_buffer->memory);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkAllocateMemory failed for a buffer of %llu bytes: '%s'", size, vulkan_result_string(result, TRUE));
+        vulkan_buffer_destroy(context, out_buffer);
+        return FALSE;
+    }
+    VK_CHECK(vkBindBufferMemory(context->device.logical_device, out_buffer->handle, out_buffer->memory, 0));
+
+    if (map) {
+        result = vkMapMemory(context->device.logical_device, out_buffer->memory, 0, size, 0, &out_buffer->mapped);
+        if (!vulkan_result_is_success(result)) {
+            KERROR("vkMapMemory failed: '%s'", vulkan_result_string(result, TRUE));
+            vulkan_buffer_destroy(context, out_buffer);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer) {
+    if (buffer->mapped) {
+        vkUnmapMemory(context->device.logical_device, buffer->memory);
+        buffer->mapped = 0;
+    }
+    if (buffer->memory) {
+        vkFreeMemory(context->device.logical_device, buffer->memory, context->allocator);
+        buffer->memory = 0;
+    }
+    if (buffer->handle) {
+        vkDestroyBuffer(context->device.logical_device, buffer->handle, context->allocator);
+        buffer->handle = 0;
+    }
+    buffer->size = 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+/**
+ * Creates a buffer with its own memory.
+ * @param map Whether to map the memory for the life of the buffer. Requires host visible memory.
+ * @returns FALSE on failure, leaving nothing to destroy.
+ */
+b8 vulkan_buffer_create(
+    vulkan_context* context,
+    u64 size,
+    VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags memory_flags,
+    b8 map,
+    vulkan_buffer* out_buffer);
+
+void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer);
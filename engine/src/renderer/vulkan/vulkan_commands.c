@@ -0,0 +1,141 @@
+#include "vulkan_commands.h"
+
+#include "vulkan_renderpass.h"
+
+#include "core/logger.h"
+#include "math/kmath.h"
+
+// The stages and memory each render_stage_bits stands for, lowest bit first.
+typedef struct stage_mapping {
+    VkPipelineStageFlags stages;
+    // Written by the stage, when it is waited on.
+    VkAccessFlags writes;
+    // Accessed by the stage, when it waits.
+    VkAccessFlags accesses;
+} stage_mapping;
+
+static const stage_mapping stage_mappings[] = {
+    {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT},
+    {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT},
+    {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT},
+    {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT},
+    {VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT, VK_ACCESS_HOST_READ_BIT},
+};
+
+#define STAGE_MAPPING_COUNT (sizeof(stage_mappings) / sizeof(stage_mapping))
+
+static b8 outside_renderpass_reported = FALSE;
+
+void vulkan_commands_begin_renderpass(vulkan_context* context, vulkan_command_buffer* command_buffer) {
+    if (command_buffer->state == COMMAND_BUFFER_STATE_IN_RENDER_PASS) {
+        return;
+    }
+    vulkan_renderpass_begin(
+        command_buffer,
+        &context->main_renderpass,
+        context->swapchain.framebuffers[context->image_index].handle);
+}
+
+static void record_barrier(vulkan_command_buffer* command_buffer, const render_command_barrier* barrier) {
+    VkPipelineStageFlags source_stages = 0;
+    VkPipelineStageFlags destination_stages = 0;
+    VkMemoryBarrier memory_barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    for (u32 i = 0; i < STAGE_MAPPING_COUNT; ++i) {
+        if (barrier->before & (1u << i)) {
+            source_stages |= stage_mappings[i].stages;
+            memory_barrier.srcAccessMask |= stage_mappings[i].writes;
+        }
+        if (barrier->after & (1u << i)) {
+            destination_stages |= stage_mappings[i].stages;
+            memory_barrier.dstAccessMask |= stage_mappings[i].accesses;
+        }
+    }
+    if (!source_stages || !destination_stages) {
+        return;
+    }
+    vkCmdPipelineBarrier(command_buffer->handle, source_stages, destination_stages, 0, 1, &memory_barrier, 0, 0, 0, 0);
+}
+
+void vulkan_commands_execute(vulkan_context* context, vulkan_command_buffer* command_buffer, const render_command_list* commands) {
+    VkCommandBuffer handle = command_buffer->handle;
+    // The pipeline draws go to. 0 for one this backend has not made, whose draws are skipped.
+    vulkan_pipeline* pipeline = 0;
+    b8 bound = FALSE;
+    // Screen space positions are pixels from the top left. The viewport is flipped, so +y is up in clip space.
+    mat4 screen = mat4_orthographic(0, (f32)context->framebuffer_width, (f32)context->framebuffer_height, 0, -1.0f, 1.0f);
+
+    const u8* at = commands->data;
+    const u8* end = at + commands->size;
+    while (at < end) {
+        const render_command_header* header = (const render_command_header*)at;
+        at += header->size;
+
+        switch (header->type) {
+            case RENDER_COMMAND_BIND_PIPELINE: {
+                u32 id = ((const render_command_bind_pipeline*)header)->pipeline;
+                bound = FALSE;
+                pipeline = 0;
+                if (id <= RENDER_PIPELINE_DEBUG_OVERLAY && context->debug_vertex_buffer.handle) {
+                    pipeline = &context->debug_pipelines[id - RENDER_PIPELINE_DEBUG_LINES];
+                } else if (id == RENDER_PIPELINE_PERF_OVERLAY && context->overlay_vertex_buffer.handle) {
+                    pipeline = &context->overlay_pipeline;
+                }
+                // There is no mesh geometry on the GPU yet, so mesh pipelines are not made.
+                if (!pipeline) {
+                    break;
+                }
+                vulkan_commands_begin_renderpass(context, command_buffer);
+                vkCmdBindPipeline(handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->handle);
+                if (pipeline == &context->overlay_pipeline) {
+                    vkCmdBindDescriptorSets(handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->layout, 0, 1, &context->overlay_descriptor_set, 0, 0);
+                }
+            } break;
+
+            case RENDER_COMMAND_BIND_RESOURCES: {
+                const render_command_bind_resources* resources = (const render_command_bind_resources*)header;
+                const vulkan_buffer* buffer = 0;
+                if (resources->vertices == RENDER_VERTICES_DEBUG) {
+                    buffer = &context->debug_vertex_buffer;
+                } else if (resources->vertices == RENDER_VERTICES_OVERLAY) {
+                    buffer = &context->overlay_vertex_buffer;
+                }
+                // resources->material is not bound. Material parameters are not uploaded,
+                // since there are no mesh pipelines to read them.
+                if (!pipeline || !buffer) {
+                    break;
+                }
+                VkDeviceSize offset = 0;
+                vkCmdBindVertexBuffers(handle, 0, 1, &buffer->handle, &offset);
+                const void* transform = resources->space == RENDER_SPACE_SCREEN ? (const void*)screen.data : (const void*)resources->transform;
+                vkCmdPushConstants(handle, pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mat4), transform);
+                bound = TRUE;
+            } break;
+
+            case RENDER_COMMAND_DRAW: {
+                const render_command_draw* draw = (const render_command_draw*)header;
+                if (bound && draw->vertex_count) {
+                    vkCmdDraw(handle, draw->vertex_count, 1, draw->first_vertex, 0);
+                }
+            } break;
+
+            case RENDER_COMMAND_BARRIER:
+                if (command_buffer->state != COMMAND_BUFFER_STATE_IN_RENDER_PASS) {
+                    record_barrier(command_buffer, (const render_command_barrier*)header);
+                    break;
+                }
+                // Fall through.
+            case RENDER_COMMAND_DISPATCH:
+                // Nothing is dispatched yet, as there are no compute pipelines. Either is dropped inside the renderpass.
+                if (command_buffer->state == COMMAND_BUFFER_STATE_IN_RENDER_PASS && !outside_renderpass_reported) {
+                    outside_renderpass_reported = TRUE;
+                    KWARN("A dispatch or barrier was recorded after the frame's first draw, and was dropped.");
+                }
+                break;
+
+            case RENDER_COMMAND_DRAW_MESH:
+            default:
+                // Mesh draws wait on mesh geometry on the GPU, which the backend does not have yet.
+                break;
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+/**
+ * Translates a frame's render commands into the command buffer, in a single
+ * pass. The main renderpass is begun before the first draw; dispatches and
+ * barriers after that are dropped.
+ */
+void vulkan_commands_execute(vulkan_context* context, vulkan_command_buffer* command_buffer, const render_command_list* commands);
+
+// Begins the main renderpass, unless it already has been this frame.
+void vulkan_commands_begin_renderpass(vulkan_context* context, vulkan_command_buffer* command_buffer);
@@ -0,0 +1,76 @@
+#include "vulkan_debug_draw.h"
+
+#include "vulkan_buffer.h"
+#include "vulkan_pipeline.h"
+
+#include "core/logger.h"
+#include "math/kmath.h"
+
+#include <stddef.h>
+
+void* vulkan_debug_draw_create(vulkan_context* context, u64 size) {
+    VkShaderModule vertex_shader = 0;
+    VkShaderModule fragment_shader = 0;
+    if (!vulkan_shader_module_create(context, "debug_draw.vert.spv", &vertex_shader) ||
+        !vulkan_shader_module_create(context, "debug_draw.frag.spv", &fragment_shader)) {
+        if (vertex_shader) {
+            vkDestroyShaderModule(context->device.logical_device, vertex_shader, context->allocator);
+        }
+        return 0;
+    }
+
+    VkVertexInputAttributeDescription attributes[2];
+    attributes[0].location = 0;
+    attributes[0].binding = 0;
+    attributes[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attributes[0].offset = offsetof(debug_vertex, position);
+    attributes[1].location = 1;
+    attributes[1].binding = 0;
+    attributes[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attributes[1].offset = offsetof(debug_vertex, color);
+
+    vulkan_pipeline_config config = {0};
+    config.vertex_shader = vertex_shader;
+    config.fragment_shader = fragment_shader;
+    config.vertex_stride = sizeof(debug_vertex);
+    config.attribute_count = 2;
+    config.attributes = attributes;
+    config.push_constant_size = sizeof(mat4);
+
+    // Lines and triangles sit in the scene without hiding it; the overlay covers everything.
+    b8 created = TRUE;
+    for (u32 type = 0; type < DEBUG_DRAW_TYPE_COUNT && created; ++type) {
+        config.topology = type == DEBUG_DRAW_TYPE_LINES ? VK_PRIMITIVE_TOPOLOGY_LINE_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        config.depth_test = type != DEBUG_DRAW_TYPE_OVERLAY;
+        config.depth_write = FALSE;
+        config.blend = TRUE;
+        created = vulkan_graphics_pipeline_create(context, &context->main_renderpass, &config, &context->debug_pipelines[type]);
+    }
+
+    // Pipelines keep what they need of the modules.
+    vkDestroyShaderModule(context->device.logical_device, vertex_shader, context->allocator);
+    vkDestroyShaderModule(context->device.logical_device, fragment_shader, context->allocator);
+
+    // Host coherent, so what the frontend writes needs no flushing.
+    if (!created ||
+        !vulkan_buffer_create(
+            context,
+            size,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            TRUE,
+            &context->debug_vertex_buffer)) {
+        vulkan_debug_draw_destroy(context);
+        return 0;
+    }
+
+    KDEBUG("Vulkan debug draw created.");
+    return context->debug_vertex_buffer.mapped;
+}
+
+void vulkan_debug_draw_destroy(vulkan_context* context) {
+    for (u32 type = 0; type < DEBUG_DRAW_TYPE_COUNT; ++type) {
+        vulkan_pipeline_destroy(context, &context->debug_pipelines[type]);
+    }
+    vulkan_buffer_destroy(context, &context->debug_vertex_buffer);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+/**
+ * Creates the persistently mapped vertex buffer debug geometry is written
+ * into, and a pipeline for each type of debug geometry.
+ * @returns The buffer's mapped memory, or 0 on failure.
+ */
+void* vulkan_debug_draw_create(vulkan_context* context, u64 size);
+
+void vulkan_debug_draw_destroy(vulkan_context* context);
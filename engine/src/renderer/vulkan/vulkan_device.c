@@ -406,7 +406,7 @@ b8 select_physical_device(vulkan_context* context) {
         requirements.compute = TRUE;
         requirements.transfer = TRUE;
         requirements.sampler_anisotropy = TRUE;
-        requirements.discrete_gpu = FALSE;
+        requirements.discrete_gpu = context->config.require_discrete_gpu;
 
         const char* required_device_extensions[] = {
             VK_KHR_SWAPCHAIN_EXTENSION_NAME,
@@ -416,6 +416,13 @@ b8 select_physical_device(vulkan_context* context) {
             darray_push(requirements.device_extension_names, required_device_extensions[j]);
         }
 
+        if (context->config.device_name[0] &&
+            string_view_find(string_view(properties.deviceName), string_view(context->config.device_name)) < 0) {
+            KINFO("Physical device '%s' rejected: name does not match '%s'.", properties.deviceName, context->config.device_name);
+            darray_destroy(requirements.device_extension_names);
+            continue;
+        }
+
         vulkan_physical_device_queue_family_info queue_info = {};
 
         b8 result = physical_device_meets_requirements(
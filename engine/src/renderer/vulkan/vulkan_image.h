@@ -23,4 +23,23 @@ void vulkan_image_view_create(
 
 void vulkan_image_destroy(
     vulkan_context* context,
-    vulkan_image* image);
\ No newline at end of file
+    vulkan_image* image);
+
+/**
+ * Records a barrier moving the image's first mip level from one layout to
+ * another. Handles undefined to transfer destination, and transfer
+ * destination to shader read only.
+ */
+void vulkan_image_transition_layout(
+    vulkan_context* context,
+    vulkan_command_buffer* command_buffer,
+    vulkan_image* image,
+    VkImageLayout old_layout,
+    VkImageLayout new_layout);
+
+// Records a copy of tightly packed pixels into the image's first mip level, which must be a transfer destination.
+void vulkan_image_copy_from_buffer(
+    vulkan_context* context,
+    vulkan_image* image,
+    VkBuffer buffer,
+    vulkan_command_buffer* command_buffer);
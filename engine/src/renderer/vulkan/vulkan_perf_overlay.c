@@ -0,0 +1,275 @@
+#include "vulkan_perf_overlay.h"
+
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+#include "vulkan_image.h"
+#include "vulkan_pipeline.h"
+#include "vulkan_utils.h"
+
+#include "core/logger.h"
+#include "math/kmath.h"
+#include "renderer/debug_font.h"
+
+#include <stddef.h>
+
+// Uploads the atlas through a staging buffer and leaves it ready for sampling.
+static b8 upload_atlas(vulkan_context* context) {
+    vulkan_image_create(
+        context,
+        VK_IMAGE_TYPE_2D,
+        DEBUG_FONT_ATLAS_WIDTH,
+        DEBUG_FONT_ATLAS_HEIGHT,
+        VK_FORMAT_R8_UNORM,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        TRUE,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        &context->overlay_atlas);
+    if (!context->overlay_atlas.view) {
+        return FALSE;
+    }
+
+    vulkan_buffer staging;
+    if (!vulkan_buffer_create(
+            context,
+            DEBUG_FONT_ATLAS_WIDTH * DEBUG_FONT_ATLAS_HEIGHT,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            TRUE,
+            &staging)) {
+        return FALSE;
+    }
+    debug_font_atlas_build(staging.mapped);
+
+    vulkan_command_buffer command_buffer;
+    VkCommandPool pool = context->device.graphics_command_pool;
+    vulkan_command_buffer_allocate_and_begin_single_use(context, pool, TRUE, &command_buffer);
+    vulkan_image_transition_layout(context, &command_buffer, &context->overlay_atlas, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vulkan_image_copy_from_buffer(context, &context->overlay_atlas, staging.handle, &command_buffer);
+    vulkan_image_transition_layout(context, &command_buffer, &context->overlay_atlas, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // Waits for the queue, so the staging buffer is free to go.
+    vulkan_command_buffer_end_and_free_single_use(context, pool, &command_buffer);
+    vulkan_buffer_destroy(context, &staging);
+    return TRUE;
+}
+
+// A sampler and a single descriptor set binding the atlas to the fragment stage.
+static b8 create_descriptors(vulkan_context* context) {
+    VkDevice device = context->device.logical_device;
+
+    // Nearest, so glyph edges stay sharp at whole multiples of the font size.
+    VkSamplerCreateInfo sampler_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = 0.0f;
+    VkResult result = vkCreateSampler(device, &sampler_info, context->allocator, &context->overlay_sampler);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreateSampler failed: '%s'", vulkan_result_string(result, TRUE));
+        return FALSE;
+    }
+
+    VkDescriptorSetLayoutBinding binding = {0};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    result = vkCreateDescriptorSetLayout(device, &layout_info, context->allocator, &context->overlay_set_layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreateDescriptorSetLayout failed: '%s'", vulkan_result_string(result, TRUE));
+        return FALSE;
+    }
+
+    VkDescriptorPoolSize pool_size;
+    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_size.descriptorCount = 1;
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    result = vkCreateDescriptorPool(device, &pool_info, context->allocator, &context->overlay_descriptor_pool);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreateDescriptorPool failed: '%s'", vulkan_result_string(result, TRUE));
+        return FALSE;
+    }
+
+    VkDescriptorSetAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocate_info.descriptorPool = context->overlay_descriptor_pool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &context->overlay_set_layout;
+    result = vkAllocateDescriptorSets(device, &allocate_info, &context->overlay_descriptor_set);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkAllocateDescriptorSets failed: '%s'", vulkan_result_string(result, TRUE));
+        return FALSE;
+    }
+
+    // The atlas never changes, so the set is written once.
+    VkDescriptorImageInfo image_info;
+    image_info.sampler = context->overlay_sampler;
+    image_info.imageView = context->overlay_atlas.view;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet = context->overlay_descriptor_set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(device, 1, &write, 0, 0);
+    return TRUE;
+}
+
+static b8 create_pipeline(vulkan_context* context) {
+    VkShaderModule vertex_shader = 0;
+    VkShaderModule fragment_shader = 0;
+    if (!vulkan_shader_module_create(context, "perf_overlay.vert.spv", &vertex_shader) ||
+        !vulkan_shader_module_create(context, "perf_overlay.frag.spv", &fragment_shader)) {
+        if (vertex_shader) {
+            vkDestroyShaderModule(context->device.logical_device, vertex_shader, context->allocator);
+        }
+        return FALSE;
+    }
+
+    VkVertexInputAttributeDescription attributes[3];
+    attributes[0].location = 0;
+    attributes[0].binding = 0;
+    attributes[0].format = VK_FORMAT_R32G32_SFLOAT;
+    attributes[0].offset = offsetof(overlay_vertex, position);
+    attributes[1].location = 1;
+    attributes[1].binding = 0;
+    attributes[1].format = VK_FORMAT_R32G32_SFLOAT;
+    attributes[1].offset = offsetof(overlay_vertex, texcoord);
+    attributes[2].location = 2;
+    attributes[2].binding = 0;
+    attributes[2].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attributes[2].offset = offsetof(overlay_vertex, color);
+
+    vulkan_pipeline_config config = {0};
+    config.vertex_shader = vertex_shader;
+    config.fragment_shader = fragment_shader;
+    config.vertex_stride = sizeof(overlay_vertex);
+    config.attribute_count = 3;
+    config.attributes = attributes;
+    config.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    config.depth_test = FALSE;
+    config.depth_write = FALSE;
+    config.blend = TRUE;
+    config.push_constant_size = sizeof(mat4);
+    config.descriptor_set_layout_count = 1;
+    config.descriptor_set_layouts = &context->overlay_set_layout;
+    b8 created = vulkan_graphics_pipeline_create(context, &context->main_renderpass, &config, &context->overlay_pipeline);
+
+    // The pipeline keeps what it needs of the modules.
+    vkDestroyShaderModule(context->device.logical_device, vertex_shader, context->allocator);
+    vkDestroyShaderModule(context->device.logical_device, fragment_shader, context->allocator);
+    return created;
+}
+
+void* vulkan_perf_overlay_create(vulkan_context* context, u64 size) {
+    // Host coherent, so what the frontend writes needs no flushing.
+    if (!upload_atlas(context) ||
+        !create_descriptors(context) ||
+        !create_pipeline(context) ||
+        !vulkan_buffer_create(
+            context,
+            size,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            TRUE,
+            &context->overlay_vertex_buffer)) {
+        vulkan_perf_overlay_destroy(context);
+        return 0;
+    }
+
+    KDEBUG("Vulkan performance overlay created.");
+    return context->overlay_vertex_buffer.mapped;
+}
+
+void vulkan_perf_overlay_destroy(vulkan_context* context) {
+    VkDevice device = context->device.logical_device;
+    vulkan_buffer_destroy(context, &context->overlay_vertex_buffer);
+    vulkan_pipeline_destroy(context, &context->overlay_pipeline);
+    // Destroying the pool frees its set.
+    if (context->overlay_descriptor_pool) {
+        vkDestroyDescriptorPool(device, context->overlay_descriptor_pool, context->allocator);
+        context->overlay_descriptor_pool = 0;
+        context->overlay_descriptor_set = 0;
+    }
+    if (context->overlay_set_layout) {
+        vkDestroyDescriptorSetLayout(device, context->overlay_set_layout, context->allocator);
+        context->overlay_set_layout = 0;
+    }
+    if (context->overlay_sampler) {
+        vkDestroySampler(device, context->overlay_sampler, context->allocator);
+        context->overlay_sampler = 0;
+    }
+    vulkan_image_destroy(context, &context->overlay_atlas);
+}
+
+void vulkan_timestamps_create(vulkan_context* context) {
+    context->timestamp_pool = 0;
+    context->timestamps_pending = 0;
+    context->gpu_frame_ms_valid = FALSE;
+    if (!context->device.properties.limits.timestampComputeAndGraphics) {
+        KINFO("The device cannot time the graphics queue. GPU frame times will not be known.");
+        return;
+    }
+
+    // One bit of timestamps_pending per command buffer.
+    context->timestamp_slot_count = context->swapchain.image_count < 32 ? context->swapchain.image_count : 32;
+    VkQueryPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = context->timestamp_slot_count * 2;
+    VkResult result = vkCreateQueryPool(context->device.logical_device, &pool_info, context->allocator, &context->timestamp_pool);
+    if (!vulkan_result_is_success(result)) {
+        KWARN("vkCreateQueryPool failed: '%s'. GPU frame times will not be known.", vulkan_result_string(result, TRUE));
+        context->timestamp_pool = 0;
+    }
+}
+
+void vulkan_timestamps_destroy(vulkan_context* context) {
+    if (context->timestamp_pool) {
+        vkDestroyQueryPool(context->device.logical_device, context->timestamp_pool, context->allocator);
+        context->timestamp_pool = 0;
+    }
+}
+
+void vulkan_timestamps_begin(vulkan_context* context, vulkan_command_buffer* command_buffer, u32 index) {
+    if (!context->timestamp_pool || index >= context->timestamp_slot_count) {
+        return;
+    }
+
+    u32 bit = 1u << index;
+    if (context->timestamps_pending & bit) {
+        u64 ticks[2];
+        VkResult result = vkGetQueryPoolResults(
+            context->device.logical_device,
+            context->timestamp_pool,
+            index * 2, 2,
+            sizeof(ticks), ticks, sizeof(u64),
+            VK_QUERY_RESULT_64_BIT);
+        // Not ready yet only costs a sample; the last one stands.
+        if (result == VK_SUCCESS && ticks[1] >= ticks[0]) {
+            // timestampPeriod is in nanoseconds per tick.
+            context->gpu_frame_ms = (f64)(ticks[1] - ticks[0]) * context->device.properties.limits.timestampPeriod / 1000000.0;
+            context->gpu_frame_ms_valid = TRUE;
+        }
+    }
+
+    vkCmdResetQueryPool(command_buffer->handle, context->timestamp_pool, index * 2, 2);
+    vkCmdWriteTimestamp(command_buffer->handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, context->timestamp_pool, index * 2);
+    context->timestamps_pending |= bit;
+}
+
+void vulkan_timestamps_end(vulkan_context* context, vulkan_command_buffer* command_buffer, u32 index) {
+    if (!context->timestamp_pool || index >= context->timestamp_slot_count) {
+        return;
+    }
+    vkCmdWriteTimestamp(command_buffer->handle, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, context->timestamp_pool, index * 2 + 1);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+/**
+ * Uploads the debug font atlas, and creates the persistently mapped vertex
+ * buffer the overlay is written into and a pipeline to draw it.
+ * @returns The buffer's mapped memory, or 0 on failure.
+ */
+void* vulkan_perf_overlay_create(vulkan_context* context, u64 size);
+
+void vulkan_perf_overlay_destroy(vulkan_context* context);
+
+/**
+ * Creates a timestamp query pool with a start and end query for each
+ * command buffer. Leaves timestamp_pool 0 if the device cannot time the
+ * graphics queue, which every other timestamp function then ignores.
+ */
+void vulkan_timestamps_create(vulkan_context* context);
+
+void vulkan_timestamps_destroy(vulkan_context* context);
+
+/**
+ * Reads back the timestamps a command buffer wrote when it was last
+ * submitted, if the GPU has finished with them, then records a reset and
+ * the start timestamp for its new work. Never waits.
+ */
+void vulkan_timestamps_begin(vulkan_context* context, vulkan_command_buffer* command_buffer, u32 index);
+
+// Records the end timestamp of a command buffer's work.
+void vulkan_timestamps_end(vulkan_context* context, vulkan_command_buffer* command_buffer, u32 index);
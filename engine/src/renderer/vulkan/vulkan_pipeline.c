@@ -0,0 +1,161 @@
+#include "vulkan_pipeline.h"
+
+#include "vulkan_utils.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "systems/resource_system.h"
+
+b8 vulkan_graphics_pipeline_create(
+    vulkan_context* context,
+    vulkan_renderpass* renderpass,
+    const vulkan_pipeline_config* config,
+    vulkan_pipeline* out_pipeline) {
+    kzero_memory(out_pipeline, sizeof(vulkan_pipeline));
+
+    // Layout
+    VkPushConstantRange push_constant_range;
+    push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = config->push_constant_size;
+
+    VkPipelineLayoutCreateInfo layout_info = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    if (config->push_constant_size) {
+        layout_info.pushConstantRangeCount = 1;
+        layout_info.pPushConstantRanges = &push_constant_range;
+    }
+    layout_info.setLayoutCount = config->descriptor_set_layout_count;
+    layout_info.pSetLayouts = config->descriptor_set_layouts;
+    VkResult result = vkCreatePipelineLayout(context->device.logical_device, &layout_info, context->allocator, &out_pipeline->layout);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreatePipelineLayout failed: '%s'", vulkan_result_string(result, TRUE));
+        return FALSE;
+    }
+
+    // Shader stages
+    VkPipelineShaderStageCreateInfo stages[2];
+    kzero_memory(stages, sizeof(stages));
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = config->vertex_shader;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = config->fragment_shader;
+    stages[1].pName = "main";
+
+    // Vertex input
+    VkVertexInputBindingDescription binding;
+    binding.binding = 0;
+    binding.stride = config->vertex_stride;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.pVertexBindingDescriptions = &binding;
+    vertex_input.vertexAttributeDescriptionCount = config->attribute_count;
+    vertex_input.pVertexAttributeDescriptions = config->attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+    input_assembly.topology = config->topology;
+    input_assembly.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor are set when the frame begins.
+    VkPipelineViewportStateCreateInfo viewport_state = {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    VkDynamicState dynamic_states[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic_state = {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = {VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling = {VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depth_stencil = {VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+    depth_stencil.depthTestEnable = config->depth_test ? VK_TRUE : VK_FALSE;
+    depth_stencil.depthWriteEnable = config->depth_write ? VK_TRUE : VK_FALSE;
+    depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendAttachmentState blend_attachment;
+    kzero_memory(&blend_attachment, sizeof(blend_attachment));
+    blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    if (config->blend) {
+        blend_attachment.blendEnable = VK_TRUE;
+        blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+        blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
+
+    VkPipelineColorBlendStateCreateInfo color_blend = {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+    color_blend.attachmentCount = 1;
+    color_blend.pAttachments = &blend_attachment;
+
+    VkGraphicsPipelineCreateInfo pipeline_info = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    pipeline_info.stageCount = 2;
+    pipeline_info.pStages = stages;
+    pipeline_info.pVertexInputState = &vertex_input;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &rasterizer;
+    pipeline_info.pMultisampleState = &multisampling;
+    pipeline_info.pDepthStencilState = &depth_stencil;
+    pipeline_info.pColorBlendState = &color_blend;
+    pipeline_info.pDynamicState = &dynamic_state;
+    pipeline_info.layout = out_pipeline->layout;
+    pipeline_info.renderPass = renderpass->handle;
+    pipeline_info.subpass = 0;
+
+    result = vkCreateGraphicsPipelines(context->device.logical_device, VK_NULL_HANDLE, 1, &pipeline_info, context->allocator, &out_pipeline->handle);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreateGraphicsPipelines failed: '%s'", vulkan_result_string(result, TRUE));
+        vulkan_pipeline_destroy(context, out_pipeline);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void vulkan_pipeline_destroy(vulkan_context* context, vulkan_pipeline* pipeline) {
+    if (pipeline->handle) {
+        vkDestroyPipeline(context->device.logical_device, pipeline->handle, context->allocator);
+        pipeline->handle = 0;
+    }
+    if (pipeline->layout) {
+        vkDestroyPipelineLayout(context->device.logical_device, pipeline->layout, context->allocator);
+        pipeline->layout = 0;
+    }
+}
+
+b8 vulkan_shader_module_create(vulkan_context* context, const char* name, VkShaderModule* out_module) {
+    resource_handle handle = resource_system_acquire(RESOURCE_TYPE_SHADER, name);
+    const resource* shader_resource = resource_system_get(handle);
+    if (!shader_resource) {
+        KERROR("Shader '%s' could not be loaded.", name);
+        resource_system_release(handle);
+        return FALSE;
+    }
+
+    const shader_resource_data* shader = shader_resource->data;
+    VkShaderModuleCreateInfo module_info = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    module_info.codeSize = shader->code_size;
+    module_info.pCode = shader->code;
+    VkResult result = vkCreateShaderModule(context->device.logical_device, &module_info, context->allocator, out_module);
+
+    // The module keeps its own copy of the code.
+    resource_system_release(handle);
+    if (!vulkan_result_is_success(result)) {
+        KERROR("vkCreateShaderModule failed for '%s': '%s'", name, vulkan_result_string(result, TRUE));
+        return FALSE;
+    }
+    return TRUE;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "vulkan_types.inl"
+
+typedef struct vulkan_pipeline_config {
+    VkShaderModule vertex_shader;
+    VkShaderModule fragment_shader;
+    // A single interleaved vertex binding.
+    u32 vertex_stride;
+    u32 attribute_count;
+    const VkVertexInputAttributeDescription* attributes;
+    VkPrimitiveTopology topology;
+    b8 depth_test;
+    b8 depth_write;
+    // Alpha blending.
+    b8 blend;
+    // Bytes of push constants, seen by the vertex stage. Zero for none.
+    u32 push_constant_size;
+    u32 descriptor_set_layout_count;
+    const VkDescriptorSetLayout* descriptor_set_layouts;
+} vulkan_pipeline_config;
+
+/**
+ * Creates a graphics pipeline for the first subpass of a renderpass. Viewport
+ * and scissor are dynamic, as the backend sets them each frame.
+ * @returns FALSE on failure, leaving nothing to destroy.
+ */
+b8 vulkan_graphics_pipeline_create(
+    vulkan_context* context,
+    vulkan_renderpass* renderpass,
+    const vulkan_pipeline_config* config,
+    vulkan_pipeline* out_pipeline);
+
+void vulkan_pipeline_destroy(vulkan_context* context, vulkan_pipeline* pipeline);
+
+/**
+ * Creates a shader module from a SPIR-V shader resource, loading it if need be.
+ * @returns FALSE if the shader could not be loaded or the module created.
+ */
+b8 vulkan_shader_module_create(vulkan_context* context, const char* name, VkShaderModule* out_module);
@@ -90,7 +90,7 @@ void vulkan_swapchain_present(
 
 void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swapchain) {
     VkExtent2D swapchain_extent = {width, height};
-    swapchain->max_frames_in_flight = 2;
+    swapchain->max_frames_in_flight = context->config.max_frames_in_flight;
 
     // Choose a swap surface format.
     b8 found = FALSE;
@@ -109,14 +109,30 @@ void create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* sw
         swapchain->image_format = context->device.swapchain_support.formats[0];
     }
 
+    // FIFO is always supported, so it is the fallback for whatever was configured.
+    VkPresentModeKHR wanted_mode = VK_PRESENT_MODE_FIFO_KHR;
+    switch (context->config.present_mode) {
+        case RENDERER_PRESENT_MODE_MAILBOX:
+            wanted_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+            break;
+        case RENDERER_PRESENT_MODE_IMMEDIATE:
+            wanted_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            break;
+        default:
+            break;
+    }
+
     VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
     for (u32 i = 0; i < context->device.swapchain_support.present_mode_count; ++i) {
         VkPresentModeKHR mode = context->device.swapchain_support.present_modes[i];
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
+        if (mode == wanted_mode) {
             present_mode = mode;
             break;
         }
     }
+    if (present_mode != wanted_mode) {
+        KWARN("Configured present mode is not supported, falling back to FIFO.");
+    }
 
     // Requery swapchain support.
     vulkan_device_query_swapchain_support(
@@ -2,6 +2,7 @@
 
 #include "defines.h"
 #include "core/asserts.h"
+#include "renderer/renderer_types.inl"
 
 #include <vulkan/vulkan.h>
 // checks the given expression's return value against VK_SUCCESS.
@@ -24,6 +25,19 @@ typedef struct vulkan_image {
     u32 height;
 } vulkan_image;
 
+typedef struct vulkan_buffer {
+    VkBuffer handle;
+    VkDeviceMemory memory;
+    u64 size;
+    // Set while the memory is mapped.
+    void* mapped;
+} vulkan_buffer;
+
+typedef struct vulkan_pipeline {
+    VkPipeline handle;
+    VkPipelineLayout layout;
+} vulkan_pipeline;
+
 typedef struct vulkan_fence {
     VkFence handle;
     b8 is_signaled;
@@ -127,6 +141,10 @@ typedef struct vulkan_context {
 
     // The framebuffer size generation at the last swapchain creation, used to detect when the swapchain needs to be recreated.
     u64 framebuffer_size_last_generation;
+
+    // Copy of the frontend's renderer settings.
+    renderer_config config;
+
     VkInstance instance;
     VkAllocationCallbacks* allocator;
     VkSurfaceKHR surface;
@@ -151,5 +169,29 @@ typedef struct vulkan_context {
     u32 image_index;
     u32 current_frame;
     b8 recreating_swapchain;
+
+    // Debug geometry. Created once the frontend maps memory for it.
+    vulkan_buffer debug_vertex_buffer;
+    vulkan_pipeline debug_pipelines[DEBUG_DRAW_TYPE_COUNT];
+
+    // The performance overlay. Created once the frontend maps memory for it.
+    vulkan_buffer overlay_vertex_buffer;
+    vulkan_pipeline overlay_pipeline;
+    // The debug font atlas, sampled by every overlay quad.
+    vulkan_image overlay_atlas;
+    VkSampler overlay_sampler;
+    VkDescriptorSetLayout overlay_set_layout;
+    VkDescriptorPool overlay_descriptor_pool;
+    VkDescriptorSet overlay_descriptor_set;
+
+    // A timestamp at the start and end of each command buffer's work. 0 if the device cannot time the graphics queue.
+    VkQueryPool timestamp_pool;
+    u32 timestamp_slot_count;
+    // Bit n is set while command buffer n's timestamps have been written and not yet read.
+    u32 timestamps_pending;
+    // GPU time of the most recently read frame, once one has been.
+    f64 gpu_frame_ms;
+    b8 gpu_frame_ms_valid;
+
     i32 (*find_memory_index)(u32 type_filter, u32 property_flags);
 } vulkan_context;
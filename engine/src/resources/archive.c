@@ -0,0 +1,201 @@
+#include "resources/archive.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+#if KOHI_USE_LZ4
+#include <lz4.h>
+#endif
+#if KOHI_USE_ZSTD
+#include <zstd.h>
+#endif
+
+// The most a compressed entry may expand by. Neither LZ4 nor zstd gets near it on real assets.
+#define ARCHIVE_MAX_EXPANSION 1024
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+u64 archive_path_hash(const char* path) {
+    if (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+
+    u64 hash = FNV_OFFSET_BASIS;
+    for (const char* c = path; *c; ++c) {
+        u8 value = *c == '\\' ? '/' : (u8)*c;
+        hash ^= value;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Compares paths with the same normalization as archive_path_hash.
+static b8 paths_equal(const char* path, const char* stored) {
+    if (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+    for (; *path && *stored; ++path, ++stored) {
+        char c = *path == '\\' ? '/' : *path;
+        if (c != *stored) {
+            return FALSE;
+        }
+    }
+    return *path == *stored;
+}
+
+static b8 range_valid(u64 offset, u64 size, u64 file_size) {
+    return offset <= file_size && size <= file_size - offset;
+}
+
+b8 archive_open(const char* path, archive* out_archive) {
+    kzero_memory(out_archive, sizeof(archive));
+
+    if (!platform_map_file(path, FILE_MAP_HINT_RANDOM, &out_archive->file)) {
+        return FALSE;
+    }
+
+    const u8* base = out_archive->file.data;
+    u64 file_size = out_archive->file.size;
+    const archive_header* header = (const archive_header*)base;
+
+    if (file_size < sizeof(archive_header) || header->magic != ARCHIVE_MAGIC) {
+        KERROR("'%s' is not an asset archive.", path);
+        archive_close(out_archive);
+        return FALSE;
+    }
+    if (header->version != ARCHIVE_VERSION) {
+        KERROR("Archive '%s' is version %u, expected version %u.", path, header->version, ARCHIVE_VERSION);
+        archive_close(out_archive);
+        return FALSE;
+    }
+
+    // Everything below is trusted after this, so check it all up front.
+    u32 bucket_count = header->bucket_count;
+    if (bucket_count == 0 || (bucket_count & (bucket_count - 1)) != 0 ||
+        !range_valid(header->entries_offset, (u64)header->entry_count * sizeof(archive_entry), file_size) ||
+        !range_valid(header->buckets_offset, ((u64)bucket_count + 1) * sizeof(u32), file_size) ||
+        header->names_offset > header->data_offset || header->data_offset > file_size) {
+        KERROR("Archive '%s' has a corrupt header.", path);
+        archive_close(out_archive);
+        return FALSE;
+    }
+
+    const archive_entry* entries = (const archive_entry*)(base + header->entries_offset);
+    const u32* buckets = (const u32*)(base + header->buckets_offset);
+    const char* names = (const char*)(base + header->names_offset);
+    u64 names_size = header->data_offset - header->names_offset;
+    // Every path starts inside the names and the names end with a terminator, so no path runs past them.
+    if (header->entry_count && (names_size == 0 || names[names_size - 1] != 0)) {
+        KERROR("Archive '%s' has corrupt paths.", path);
+        archive_close(out_archive);
+        return FALSE;
+    }
+    for (u32 i = 0; i < header->entry_count; ++i) {
+        const archive_entry* entry = &entries[i];
+        // Stored entries are copied size bytes straight out of the file. LZ4 takes sizes as i32.
+        b8 size_valid = entry->compression == ARCHIVE_COMPRESSION_NONE
+                            ? entry->size == entry->stored_size
+                            : entry->size / ARCHIVE_MAX_EXPANSION <= entry->stored_size && entry->size <= I32_MAX;
+        if (!range_valid(entry->offset, entry->stored_size, file_size) || entry->name_offset >= names_size || !size_valid) {
+            KERROR("Archive '%s' has a corrupt entry at index %u.", path, i);
+            archive_close(out_archive);
+            return FALSE;
+        }
+    }
+    for (u32 i = 0; i <= bucket_count; ++i) {
+        if (buckets[i] > header->entry_count || (i > 0 && buckets[i] < buckets[i - 1])) {
+            KERROR("Archive '%s' has a corrupt hash index.", path);
+            archive_close(out_archive);
+            return FALSE;
+        }
+    }
+
+    out_archive->header = header;
+    out_archive->entries = entries;
+    out_archive->buckets = buckets;
+    out_archive->names = names;
+
+    // log2 of the bucket count gives how many of the hash's top bits select a bucket.
+    u32 bucket_bits = 0;
+    while ((1u << bucket_bits) < bucket_count) {
+        bucket_bits++;
+    }
+    out_archive->bucket_shift = 64 - bucket_bits;
+
+    KINFO("Opened archive '%s' with %u entries.", path, header->entry_count);
+    return TRUE;
+}
+
+void archive_close(archive* a) {
+    platform_unmap_file(&a->file);
+    kzero_memory(a, sizeof(archive));
+}
+
+const archive_entry* archive_find(const archive* a, const char* path) {
+    if (!a->header) {
+        return 0;
+    }
+
+    u64 hash = archive_path_hash(path);
+    // A shift by 64 is undefined, which is what a single bucket would need.
+    u64 bucket = a->bucket_shift < 64 ? hash >> a->bucket_shift : 0;
+    u32 end = a->buckets[bucket + 1];
+    for (u32 i = a->buckets[bucket]; i < end; ++i) {
+        const archive_entry* entry = &a->entries[i];
+        if (entry->path_hash == hash) {
+            // The builder rejects colliding paths, but a lookup of a path which is not in the archive may still collide.
+            return paths_equal(path, a->names + entry->name_offset) ? entry : 0;
+        }
+        if (entry->path_hash > hash) {
+            break;
+        }
+    }
+    return 0;
+}
+
+const char* archive_entry_path(const archive* a, const archive_entry* entry) {
+    return a->names + entry->name_offset;
+}
+
+const void* archive_entry_data(const archive* a, const archive_entry* entry) {
+    return (const u8*)a->file.data + entry->offset;
+}
+
+b8 archive_read(const archive* a, const archive_entry* entry, void* out_buffer, u64 buffer_size) {
+    if (buffer_size < entry->size) {
+        KERROR("archive_read: buffer of %llu bytes is too small for '%s' (%llu bytes).", buffer_size, archive_entry_path(a, entry), entry->size);
+        return FALSE;
+    }
+
+    const void* data = archive_entry_data(a, entry);
+    switch (entry->compression) {
+        case ARCHIVE_COMPRESSION_NONE:
+            kcopy_memory(out_buffer, data, entry->size);
+            return TRUE;
+#if KOHI_USE_LZ4
+        case ARCHIVE_COMPRESSION_LZ4: {
+            i32 result = LZ4_decompress_safe(data, out_buffer, (i32)entry->stored_size, (i32)entry->size);
+            if (result < 0 || (u64)result != entry->size) {
+                KERROR("archive_read: failed to decompress '%s'.", archive_entry_path(a, entry));
+                return FALSE;
+            }
+            return TRUE;
+        }
+#endif
+#if KOHI_USE_ZSTD
+        case ARCHIVE_COMPRESSION_ZSTD: {
+            size_t result = ZSTD_decompress(out_buffer, entry->size, data, entry->stored_size);
+            if (ZSTD_isError(result) || result != entry->size) {
+                KERROR("archive_read: failed to decompress '%s'.", archive_entry_path(a, entry));
+                return FALSE;
+            }
+            return TRUE;
+        }
+#endif
+        default:
+            KERROR("archive_read: '%s' uses compression %u, which this build does not support.", archive_entry_path(a, entry), entry->compression);
+            return FALSE;
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/platform.h"
+
+/*
+Packed asset archive.
+
+Many assets are packed into one file so that loading them does not cost an
+open and a seek per file. The archive is mapped read-only, and every lookup
+and read works straight on the mapping.
+
+File layout, all little endian:
+    archive_header
+    archive_entry[entry_count]    sorted by path_hash
+    u32 buckets[bucket_count + 1]
+    path names                    NUL-terminated, referenced by name_offset
+    blobs                         each aligned to header.alignment
+
+An entry is found by hashing its path. The top bits of the hash select a
+bucket. buckets[b] is the index of the first entry in that bucket, and
+buckets[b + 1] is one past its last. There are at least as many buckets as
+entries, so a lookup checks one or two entries on average.
+*/
+
+#define ARCHIVE_MAGIC 0x4B41504B  // "KPAK"
+#define ARCHIVE_VERSION 1
+
+typedef enum archive_compression {
+    ARCHIVE_COMPRESSION_NONE = 0,
+    // Requires the engine to be built with KOHI_USE_LZ4.
+    ARCHIVE_COMPRESSION_LZ4 = 1,
+    // Requires the engine to be built with KOHI_USE_ZSTD.
+    ARCHIVE_COMPRESSION_ZSTD = 2,
+} archive_compression;
+
+typedef struct archive_header {
+    u32 magic;
+    u32 version;
+    u32 entry_count;
+    // Always a power of two.
+    u32 bucket_count;
+    u64 entries_offset;
+    u64 buckets_offset;
+    u64 names_offset;
+    u64 data_offset;
+    // The alignment of every blob, in bytes.
+    u32 alignment;
+    u32 reserved;
+} archive_header;
+
+STATIC_ASSERT(sizeof(archive_header) == 56, "archive_header must match the file format.");
+
+typedef struct archive_entry {
+    u64 path_hash;
+    // Offset of the blob from the start of the file.
+    u64 offset;
+    // The blob's size as stored, i.e. compressed if it is compressed.
+    u64 stored_size;
+    // The size of the data once decompressed.
+    u64 size;
+    // Offset of the path from names_offset.
+    u32 name_offset;
+    // One of archive_compression.
+    u32 compression;
+} archive_entry;
+
+STATIC_ASSERT(sizeof(archive_entry) == 40, "archive_entry must match the file format.");
+
+// An opened archive. Every pointer into it stays valid until archive_close.
+typedef struct archive {
+    mapped_file file;
+    const archive_header* header;
+    const archive_entry* entries;
+    const u32* buckets;
+    const char* names;
+    // The right shift which turns a path hash into a bucket index.
+    u32 bucket_shift;
+} archive;
+
+/**
+ * Hashes a path as the archive does (64-bit FNV-1a). Backslashes are
+ * treated as forward slashes and a leading "./" is ignored, so paths
+ * written either way find the same entry.
+ */
+KAPI u64 archive_path_hash(const char* path);
+
+/**
+ * Opens and validates an archive.
+ * @param path The path of the archive file.
+ * @param out_archive A pointer to hold the opened archive.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 archive_open(const char* path, archive* out_archive);
+
+KAPI void archive_close(archive* a);
+
+/**
+ * Finds the entry for the given path.
+ * @returns A pointer to the entry, or 0 if the archive does not contain the path.
+ */
+KAPI const archive_entry* archive_find(const archive* a, const char* path);
+
+// Returns the path an entry was packed under.
+KAPI const char* archive_entry_path(const archive* a, const archive_entry* entry);
+
+/**
+ * Returns the entry's data exactly as stored, without copying it. This is
+ * the asset itself unless the entry is compressed.
+ */
+KAPI const void* archive_entry_data(const archive* a, const archive_entry* entry);
+
+/**
+ * Copies an entry's data into a buffer, decompressing it if needed.
+ * @param out_buffer The destination. Must hold at least entry->size bytes.
+ * @param buffer_size The size of out_buffer in bytes.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 archive_read(const archive* a, const archive_entry* entry, void* out_buffer, u64 buffer_size);
@@ -0,0 +1,183 @@
+#include "audio_decoder.h"
+
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_IEEE_FLOAT 0x0003
+#define WAV_FORMAT_IMA_ADPCM 0x0011
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+static const i8 adpcm_index_table[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static const i16 adpcm_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+// WAV files are little endian, and may put fields anywhere.
+static u16 read_u16(const u8* p) {
+    return (u16)(p[0] | (p[1] << 8));
+}
+
+static u32 read_u32(const u8* p) {
+    return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+b8 audio_wav_parse(const void* data, u64 size, audio_format* out_format, u64* out_data_offset, u64* out_data_size) {
+    const u8* bytes = data;
+    if (size < 12 || read_u32(bytes) != 0x46464952 || read_u32(bytes + 8) != 0x45564157) {  // "RIFF", "WAVE"
+        return FALSE;
+    }
+
+    b8 have_format = FALSE;
+    u64 pos = 12;
+    while (pos + 8 <= size) {
+        u32 id = read_u32(bytes + pos);
+        u32 chunk_size = read_u32(bytes + pos + 4);
+        u64 body = pos + 8;
+
+        if (id == 0x20746D66) {  // "fmt "
+            if (chunk_size < 16 || body + 16 > size) {
+                return FALSE;
+            }
+            u16 tag = read_u16(bytes + body);
+            u32 channels = read_u16(bytes + body + 2);
+            u32 block_align = read_u16(bytes + body + 12);
+            u32 bits = read_u16(bytes + body + 14);
+            // Extensible formats keep the real tag at the start of their sub-format GUID.
+            if (tag == WAV_FORMAT_EXTENSIBLE && chunk_size >= 40 && body + 26 <= size) {
+                tag = read_u16(bytes + body + 24);
+            }
+            if (channels < 1 || channels > 2 || block_align == 0) {
+                return FALSE;
+            }
+
+            out_format->channel_count = channels;
+            out_format->sample_rate = read_u32(bytes + body + 4);
+            out_format->block_align = block_align;
+            if (tag == WAV_FORMAT_PCM && bits == 16 && block_align == channels * 2) {
+                out_format->encoding = AUDIO_ENCODING_PCM16;
+                out_format->frames_per_block = 1;
+            } else if (tag == WAV_FORMAT_IEEE_FLOAT && bits == 32 && block_align == channels * 4) {
+                out_format->encoding = AUDIO_ENCODING_FLOAT32;
+                out_format->frames_per_block = 1;
+            } else if (tag == WAV_FORMAT_IMA_ADPCM && bits == 4 && block_align > channels * 4 && block_align % (channels * 4) == 0) {
+                // A header per channel holding the first sample, then 2 samples per byte.
+                out_format->encoding = AUDIO_ENCODING_IMA_ADPCM;
+                out_format->frames_per_block = (block_align - channels * 4) * 2 / channels + 1;
+                if (out_format->frames_per_block > AUDIO_DECODER_MAX_BLOCK_FRAMES) {
+                    return FALSE;
+                }
+            } else {
+                return FALSE;
+            }
+            have_format = out_format->sample_rate != 0;
+        } else if (id == 0x61746164) {  // "data"
+            if (!have_format) {
+                return FALSE;
+            }
+            *out_data_offset = body;
+            *out_data_size = chunk_size;
+            return TRUE;
+        }
+
+        // Chunks are padded to an even size.
+        pos = body + chunk_size + (chunk_size & 1);
+    }
+    return FALSE;
+}
+
+// A partial ADPCM block of at least the channel headers decodes its whole groups of samples.
+static u32 adpcm_block_frames(const audio_format* format, u32 size) {
+    u32 channels = format->channel_count;
+    u32 frames = 1 + (size - channels * 4) / (channels * 4) * 8;
+    return frames < format->frames_per_block ? frames : format->frames_per_block;
+}
+
+// Decodes a whole or partial ADPCM block of at least the channel headers.
+static u32 decode_adpcm_block(const audio_format* format, const u8* data, u32 size, f32* out) {
+    u32 channels = format->channel_count;
+    i32 predictor[2];
+    i32 index[2];
+    for (u32 c = 0; c < channels; ++c) {
+        predictor[c] = (i16)read_u16(data + c * 4);
+        index[c] = data[c * 4 + 2] > 88 ? 88 : data[c * 4 + 2];
+        out[c] = predictor[c] / 32768.0f;
+    }
+
+    // Each channel in turn has 4 bytes, 8 samples, low nibble first.
+    u32 frames = adpcm_block_frames(format, size);
+    const u8* p = data + channels * 4;
+    for (u32 group = 0; 1 + group * 8 < frames; ++group) {
+        for (u32 c = 0; c < channels; ++c) {
+            for (u32 i = 0; i < 8; ++i) {
+                u32 frame = 1 + group * 8 + i;
+                u8 nibble = (p[i / 2] >> ((i & 1) * 4)) & 0x0F;
+                i32 step = adpcm_step_table[index[c]];
+                i32 diff = step >> 3;
+                if (nibble & 4) {
+                    diff += step;
+                }
+                if (nibble & 2) {
+                    diff += step >> 1;
+                }
+                if (nibble & 1) {
+                    diff += step >> 2;
+                }
+                predictor[c] += (nibble & 8) ? -diff : diff;
+                predictor[c] = KCLAMP(predictor[c], -32768, 32767);
+                index[c] = KCLAMP(index[c] + adpcm_index_table[nibble], 0, 88);
+                if (frame < frames) {
+                    out[frame * channels + c] = predictor[c] / 32768.0f;
+                }
+            }
+            p += 4;
+        }
+    }
+    return frames;
+}
+
+u32 audio_decode_frame_count(const audio_format* format, u32 size) {
+    if (format->encoding != AUDIO_ENCODING_IMA_ADPCM) {
+        return size / format->block_align;
+    }
+    u32 frames = size / format->block_align * format->frames_per_block;
+    u32 remainder = size % format->block_align;
+    if (remainder >= format->channel_count * 4) {
+        frames += adpcm_block_frames(format, remainder);
+    }
+    return frames;
+}
+
+u32 audio_decode_blocks(const audio_format* format, const u8* data, u32 size, f32* out_frames) {
+    u32 channels = format->channel_count;
+    switch (format->encoding) {
+        case AUDIO_ENCODING_PCM16: {
+            u32 samples = size / 2 / channels * channels;
+            for (u32 i = 0; i < samples; ++i) {
+                out_frames[i] = (i16)read_u16(data + i * 2) / 32768.0f;
+            }
+            return samples / channels;
+        }
+        case AUDIO_ENCODING_FLOAT32: {
+            u32 samples = size / 4 / channels * channels;
+            for (u32 i = 0; i < samples; ++i) {
+                u32 bits = read_u32(data + i * 4);
+                f32 value;
+                __builtin_memcpy(&value, &bits, sizeof(f32));
+                out_frames[i] = value;
+            }
+            return samples / channels;
+        }
+        case AUDIO_ENCODING_IMA_ADPCM: {
+            u32 frames = 0;
+            for (u32 offset = 0; offset + channels * 4 <= size; offset += format->block_align) {
+                u32 block_size = size - offset < format->block_align ? size - offset : format->block_align;
+                frames += decode_adpcm_block(format, data + offset, block_size, out_frames + frames * channels);
+            }
+            return frames;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Decodes sample data from WAV files: 16-bit PCM, 32-bit float, and IMA
+ADPCM, which packs each sample into 4 bits. Sound is decoded a block at a
+time to interleaved floats from -1 to 1, so a file can be decoded whole, or
+bit by bit as it streams in.
+*/
+
+typedef enum audio_encoding {
+    AUDIO_ENCODING_PCM16,
+    AUDIO_ENCODING_FLOAT32,
+    AUDIO_ENCODING_IMA_ADPCM
+} audio_encoding;
+
+typedef struct audio_format {
+    audio_encoding encoding;
+    // 1 or 2.
+    u32 channel_count;
+    u32 sample_rate;
+    // Bytes in a block, the smallest part of the data which decodes on its own. A single frame for PCM.
+    u32 block_align;
+    u32 frames_per_block;
+} audio_format;
+
+// The most frames an ADPCM block may hold, to bound streaming buffers.
+#define AUDIO_DECODER_MAX_BLOCK_FRAMES 8192
+
+/**
+ * Reads the format of a WAV file and finds its sample data.
+ * @param data The file, or enough of its start to reach the sample data.
+ * @param out_data_offset The offset of the sample data in the file.
+ * @param out_data_size The size of the sample data, which may run past the end of data.
+ * @returns FALSE if this is not a WAV file in a supported encoding.
+ */
+b8 audio_wav_parse(const void* data, u64 size, audio_format* out_format, u64* out_data_offset, u64* out_data_size);
+
+// The number of frames audio_decode_blocks decodes from size bytes.
+u32 audio_decode_frame_count(const audio_format* format, u32 size);
+
+/**
+ * Decodes blocks of sample data. A partial block at the end is decoded as far as it goes.
+ * @param out_frames Room for frames_per_block frames, of channel_count floats, for each block in size.
+ * @returns The number of frames written.
+ */
+u32 audio_decode_blocks(const audio_format* format, const u8* data, u32 size, f32* out_frames);
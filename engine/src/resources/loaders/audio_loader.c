@@ -0,0 +1,55 @@
+#include "audio_loader.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "resources/audio_decoder.h"
+
+static b8 audio_loader_load(struct resource_loader* self, const char* name, const void* file_data, u64 file_size, resource* out_resource) {
+    audio_format format;
+    u64 data_offset;
+    u64 data_size;
+    if (!audio_wav_parse(file_data, file_size, &format, &data_offset, &data_size)) {
+        KERROR("Sound '%s' is not a WAV file in a supported encoding.", name);
+        return FALSE;
+    }
+    // Files cut short keep what they have.
+    if (data_size > file_size - data_offset) {
+        data_size = file_size - data_offset;
+    }
+    if (data_size > 0xFFFFFFFF) {
+        KERROR("Sound '%s' is too long to load whole. Stream it instead.", name);
+        return FALSE;
+    }
+    u32 frame_count = audio_decode_frame_count(&format, (u32)data_size);
+    if (frame_count == 0) {
+        KERROR("Sound '%s' has no samples.", name);
+        return FALSE;
+    }
+
+    audio_resource_data* sound = kallocate(sizeof(audio_resource_data), MEMORY_TAG_AUDIO);
+    sound->channel_count = format.channel_count;
+    sound->sample_rate = format.sample_rate;
+    sound->frame_count = frame_count;
+    // The silent frame after the last is left zeroed.
+    sound->frames = kallocate(sizeof(f32) * format.channel_count * ((u64)frame_count + 1), MEMORY_TAG_AUDIO);
+    audio_decode_blocks(&format, (const u8*)file_data + data_offset, (u32)data_size, sound->frames);
+
+    out_resource->data = sound;
+    out_resource->data_size = sizeof(audio_resource_data);
+    return TRUE;
+}
+
+static void audio_loader_unload(struct resource_loader* self, resource* resource) {
+    audio_resource_data* sound = resource->data;
+    kfree(sound->frames, sizeof(f32) * sound->channel_count * ((u64)sound->frame_count + 1), MEMORY_TAG_AUDIO);
+    kfree(sound, sizeof(audio_resource_data), MEMORY_TAG_AUDIO);
+}
+
+resource_loader audio_resource_loader_create() {
+    resource_loader loader = {};
+    loader.type = RESOURCE_TYPE_AUDIO;
+    loader.type_path = "sounds";
+    loader.load = audio_loader_load;
+    loader.unload = audio_loader_unload;
+    return loader;
+}
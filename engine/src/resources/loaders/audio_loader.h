@@ -0,0 +1,5 @@
+#pragma once
+
+#include "resources/resource_types.h"
+
+resource_loader audio_resource_loader_create();
@@ -0,0 +1,27 @@
+#include "binary_loader.h"
+
+#include "core/kmemory.h"
+
+static b8 binary_loader_load(struct resource_loader* self, const char* name, const void* file_data, u64 file_size, resource* out_resource) {
+    // Always allocate at least one byte so an empty file still has valid data.
+    u64 size = file_size ? file_size : 1;
+    u8* data = kallocate(size, MEMORY_TAG_RESOURCE);
+    kcopy_memory(data, file_data, file_size);
+
+    out_resource->data = data;
+    out_resource->data_size = file_size;
+    return TRUE;
+}
+
+static void binary_loader_unload(struct resource_loader* self, resource* resource) {
+    kfree(resource->data, resource->data_size ? resource->data_size : 1, MEMORY_TAG_RESOURCE);
+}
+
+resource_loader binary_resource_loader_create() {
+    resource_loader loader = {};
+    loader.type = RESOURCE_TYPE_BINARY;
+    loader.type_path = "";
+    loader.load = binary_loader_load;
+    loader.unload = binary_loader_unload;
+    return loader;
+}
@@ -0,0 +1,202 @@
+#include "image_loader.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+// Supported formats: uncompressed or RLE-compressed TGA (true-color or
+// grayscale) and binary PPM (P6). Everything is expanded to RGBA8.
+//
+// The result is CPU memory only. Nothing is uploaded to the GPU here; whoever
+// makes a texture out of it uploads it through a staging buffer, as the
+// performance overlay does with its font atlas.
+
+#define TGA_HEADER_SIZE 18
+
+static u8* allocate_pixels(u32 width, u32 height) {
+    return kallocate((u64)width * height * 4, MEMORY_TAG_TEXTURE);
+}
+
+static b8 decode_ppm(const char* name, const u8* data, u64 size, image_resource_data* out_image) {
+    // Header: "P6", width, height, max value, separated by whitespace, with # comments allowed.
+    u64 pos = 2;
+    u32 values[3] = {0};
+    for (u32 v = 0; v < 3; ++v) {
+        for (;;) {
+            while (pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\r' || data[pos] == '\n')) {
+                pos++;
+            }
+            if (pos < size && data[pos] == '#') {
+                while (pos < size && data[pos] != '\n') {
+                    pos++;
+                }
+                continue;
+            }
+            break;
+        }
+        if (pos >= size || data[pos] < '0' || data[pos] > '9') {
+            KERROR("Image '%s' has a malformed PPM header.", name);
+            return FALSE;
+        }
+        while (pos < size && data[pos] >= '0' && data[pos] <= '9') {
+            values[v] = values[v] * 10 + (data[pos] - '0');
+            pos++;
+        }
+    }
+    // A single whitespace character separates the header from the pixels.
+    pos++;
+
+    u32 width = values[0];
+    u32 height = values[1];
+    if (values[2] != 255 || width == 0 || height == 0 || pos > size || size - pos < (u64)width * height * 3) {
+        KERROR("Image '%s' is not an 8-bit PPM or is truncated.", name);
+        return FALSE;
+    }
+
+    u8* pixels = allocate_pixels(width, height);
+    const u8* source = data + pos;
+    u64 pixel_count = (u64)width * height;
+    for (u64 i = 0; i < pixel_count; ++i) {
+        pixels[i * 4 + 0] = source[i * 3 + 0];
+        pixels[i * 4 + 1] = source[i * 3 + 1];
+        pixels[i * 4 + 2] = source[i * 3 + 2];
+        pixels[i * 4 + 3] = 255;
+    }
+
+    out_image->width = width;
+    out_image->height = height;
+    out_image->pixels = pixels;
+    return TRUE;
+}
+
+// Writes one TGA pixel (BGR, BGRA or grayscale) as RGBA.
+static void tga_store(u8* out, const u8* in, u32 bytes_per_pixel) {
+    if (bytes_per_pixel == 1) {
+        out[0] = out[1] = out[2] = in[0];
+        out[3] = 255;
+    } else {
+        out[0] = in[2];
+        out[1] = in[1];
+        out[2] = in[0];
+        out[3] = bytes_per_pixel == 4 ? in[3] : 255;
+    }
+}
+
+static b8 decode_tga(const char* name, const u8* data, u64 size, image_resource_data* out_image) {
+    if (size < TGA_HEADER_SIZE) {
+        KERROR("Image '%s' is too small to be a TGA.", name);
+        return FALSE;
+    }
+
+    u8 id_length = data[0];
+    u8 color_map_type = data[1];
+    u8 image_type = data[2];
+    u32 width = data[12] | (data[13] << 8);
+    u32 height = data[14] | (data[15] << 8);
+    u32 bits_per_pixel = data[16];
+    u8 descriptor = data[17];
+
+    // 2: true-color, 3: grayscale, 10/11: their RLE variants.
+    b8 rle = image_type == 10 || image_type == 11;
+    b8 supported_type = image_type == 2 || image_type == 3 || rle;
+    u32 bytes_per_pixel = bits_per_pixel / 8;
+    b8 supported_depth = bytes_per_pixel == 1 || bytes_per_pixel == 3 || bytes_per_pixel == 4;
+    if (color_map_type != 0 || !supported_type || !supported_depth || width == 0 || height == 0) {
+        KERROR("Image '%s' is not a supported TGA (type %u, %u bits per pixel).", name, image_type, bits_per_pixel);
+        return FALSE;
+    }
+
+    u64 pos = TGA_HEADER_SIZE + id_length;
+    u64 pixel_count = (u64)width * height;
+    u8* pixels = allocate_pixels(width, height);
+
+    u64 written = 0;
+    while (written < pixel_count) {
+        u32 run = 1;
+        b8 repeat = FALSE;
+        if (rle) {
+            if (pos >= size) {
+                break;
+            }
+            u8 packet = data[pos++];
+            run = (packet & 0x7F) + 1;
+            repeat = (packet & 0x80) != 0;
+        }
+        if (written + run > pixel_count) {
+            break;
+        }
+
+        u64 needed = (u64)(repeat ? 1 : run) * bytes_per_pixel;
+        if (pos + needed > size) {
+            break;
+        }
+        for (u32 i = 0; i < run; ++i) {
+            tga_store(pixels + (written + i) * 4, data + pos + (repeat ? 0 : i * bytes_per_pixel), bytes_per_pixel);
+        }
+        pos += needed;
+        written += run;
+    }
+
+    if (written < pixel_count) {
+        KERROR("Image '%s' is truncated.", name);
+        kfree(pixels, pixel_count * 4, MEMORY_TAG_TEXTURE);
+        return FALSE;
+    }
+
+    // TGA rows run bottom to top unless bit 5 of the descriptor says otherwise. Flip to top to bottom.
+    if ((descriptor & 0x20) == 0) {
+        u64 row_size = (u64)width * 4;
+        for (u32 y = 0; y < height / 2; ++y) {
+            u8* top = pixels + y * row_size;
+            u8* bottom = pixels + (height - 1 - y) * row_size;
+            for (u64 x = 0; x < row_size; ++x) {
+                u8 temp = top[x];
+                top[x] = bottom[x];
+                bottom[x] = temp;
+            }
+        }
+    }
+
+    out_image->width = width;
+    out_image->height = height;
+    out_image->pixels = pixels;
+    return TRUE;
+}
+
+static b8 image_loader_load(struct resource_loader* self, const char* name, const void* file_data, u64 file_size, resource* out_resource) {
+    const u8* data = file_data;
+    image_resource_data image;
+    kzero_memory(&image, sizeof(image_resource_data));
+    image.channel_count = 4;
+
+    b8 result;
+    if (file_size >= 2 && data[0] == 'P' && data[1] == '6') {
+        result = decode_ppm(name, data, file_size, &image);
+    } else {
+        // TGA has no signature, so it is what is left.
+        result = decode_tga(name, data, file_size, &image);
+    }
+    if (!result) {
+        return FALSE;
+    }
+
+    image_resource_data* out_image = kallocate(sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
+    *out_image = image;
+    out_resource->data = out_image;
+    out_resource->data_size = sizeof(image_resource_data);
+    return TRUE;
+}
+
+static void image_loader_unload(struct resource_loader* self, resource* resource) {
+    image_resource_data* image = resource->data;
+    kfree(image->pixels, (u64)image->width * image->height * image->channel_count, MEMORY_TAG_TEXTURE);
+    kfree(image, sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
+}
+
+resource_loader image_resource_loader_create() {
+    resource_loader loader = {};
+    loader.type = RESOURCE_TYPE_IMAGE;
+    loader.type_path = "textures";
+    loader.load = image_loader_load;
+    loader.unload = image_loader_unload;
+    return loader;
+}
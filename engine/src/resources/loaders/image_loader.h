@@ -0,0 +1,5 @@
+#pragma once
+
+#include "resources/resource_types.h"
+
+resource_loader image_resource_loader_create();
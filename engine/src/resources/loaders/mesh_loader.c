@@ -0,0 +1,203 @@
+#include "mesh_loader.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "resources/mesh_format.h"
+#include "resources/mesh_import.h"
+
+// Loads .ksm files written by the mesh converter, which are already in GPU
+// layout. Anything else is imported as OBJ, which is far slower, and meant
+// for iterating on assets which have not been converted yet.
+
+static b8 ends_with(const char* str, const char* suffix) {
+    u64 length = string_length(str);
+    u64 suffix_length = string_length(suffix);
+    return length >= suffix_length && strings_equal(str + length - suffix_length, suffix);
+}
+
+static b8 section_valid(u64 offset, u64 size, u64 file_size) {
+    return offset % MESH_FILE_ALIGNMENT == 0 && offset <= file_size && size <= file_size - offset;
+}
+
+/**
+ * Checks that every level of detail's range lies within the indices, every
+ * index within the vertices, and likewise for the meshlets down to their
+ * local triangle indices, since everything from picking a level of detail to
+ * the GPU upload trusts them.
+ */
+static b8 ranges_valid(const mesh_file_header* header, const u8* file_data) {
+    const mesh_lod* lods = (const mesh_lod*)(file_data + header->lod_offset);
+    for (u32 i = 0; i < header->lod_count; ++i) {
+        if ((u64)lods[i].first_index + lods[i].index_count > header->index_count) {
+            return FALSE;
+        }
+    }
+
+    const u8* indices = file_data + header->index_offset;
+    if (header->index_size == 2) {
+        for (u32 i = 0; i < header->index_count; ++i) {
+            if (((const u16*)indices)[i] >= header->vertex_count) {
+                return FALSE;
+            }
+        }
+    } else {
+        for (u32 i = 0; i < header->index_count; ++i) {
+            if (((const u32*)indices)[i] >= header->vertex_count) {
+                return FALSE;
+            }
+        }
+    }
+
+    const mesh_meshlet* meshlets = (const mesh_meshlet*)(file_data + header->meshlet_offset);
+    const u8* meshlet_triangles = file_data + header->meshlet_triangles_offset;
+    for (u32 i = 0; i < header->meshlet_count; ++i) {
+        const mesh_meshlet* meshlet = &meshlets[i];
+        if ((u64)meshlet->vertex_offset + meshlet->vertex_count > header->meshlet_vertex_count ||
+            (u64)meshlet->triangle_offset + meshlet->triangle_count > header->meshlet_triangle_count) {
+            return FALSE;
+        }
+        // Triangle corners index the meshlet's own vertex list.
+        const u8* corners = meshlet_triangles + (u64)meshlet->triangle_offset * 3;
+        for (u64 c = 0; c < (u64)meshlet->triangle_count * 3; ++c) {
+            if (corners[c] >= meshlet->vertex_count) {
+                return FALSE;
+            }
+        }
+    }
+    const u32* meshlet_vertices = (const u32*)(file_data + header->meshlet_vertices_offset);
+    for (u32 i = 0; i < header->meshlet_vertex_count; ++i) {
+        if (meshlet_vertices[i] >= header->vertex_count) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static b8 load_ksm(const char* name, const void* file_data, u64 file_size, mesh_resource_data* out_mesh) {
+    const mesh_file_header* header = file_data;
+    if (file_size < sizeof(mesh_file_header) || header->magic != MESH_FILE_MAGIC) {
+        KERROR("Mesh '%s' is not a mesh file.", name);
+        return FALSE;
+    }
+    if (header->version != MESH_FILE_VERSION) {
+        KERROR("Mesh '%s' is version %u, expected version %u. Convert it again.", name, header->version, MESH_FILE_VERSION);
+        return FALSE;
+    }
+    static const u32 format_strides[MESH_VERTEX_FORMAT_COUNT] = {sizeof(mesh_vertex), sizeof(mesh_vertex_quantized)};
+    if (header->vertex_format >= MESH_VERTEX_FORMAT_COUNT || header->vertex_stride != format_strides[header->vertex_format]) {
+        KERROR("Mesh '%s' has unknown vertex format %u with stride %u.", name, header->vertex_format, header->vertex_stride);
+        return FALSE;
+    }
+    if ((header->index_size != 2 && header->index_size != 4) || header->lod_count == 0 ||
+        !section_valid(header->vertex_offset, (u64)header->vertex_count * header->vertex_stride, file_size) ||
+        !section_valid(header->index_offset, (u64)header->index_count * header->index_size, file_size) ||
+        !section_valid(header->lod_offset, (u64)header->lod_count * sizeof(mesh_lod), file_size) ||
+        !section_valid(header->meshlet_offset, (u64)header->meshlet_count * sizeof(mesh_meshlet), file_size) ||
+        !section_valid(header->meshlet_vertices_offset, (u64)header->meshlet_vertex_count * sizeof(u32), file_size) ||
+        !section_valid(header->meshlet_triangles_offset, (u64)header->meshlet_triangle_count * 3, file_size)) {
+        KERROR("Mesh '%s' is corrupt.", name);
+        return FALSE;
+    }
+    if (!ranges_valid(header, file_data)) {
+        KERROR("Mesh '%s' has indices, levels of detail or meshlets out of range.", name);
+        return FALSE;
+    }
+
+    // The one copy: straight from the mapped file into the block the mesh keeps.
+    u8* block = kallocate(file_size, MEMORY_TAG_MESH);
+    kcopy_memory(block, file_data, file_size);
+
+    out_mesh->block = block;
+    out_mesh->block_size = file_size;
+    out_mesh->vertex_format = header->vertex_format;
+    out_mesh->vertex_stride = header->vertex_stride;
+    out_mesh->vertex_count = header->vertex_count;
+    out_mesh->vertices = block + header->vertex_offset;
+    out_mesh->index_size = header->index_size;
+    out_mesh->index_count = header->index_count;
+    out_mesh->indices = block + header->index_offset;
+    out_mesh->lod_count = header->lod_count;
+    out_mesh->lods = (mesh_lod*)(block + header->lod_offset);
+    out_mesh->meshlet_count = header->meshlet_count;
+    out_mesh->meshlets = header->meshlet_count ? (mesh_meshlet*)(block + header->meshlet_offset) : 0;
+    out_mesh->meshlet_vertices = header->meshlet_count ? (u32*)(block + header->meshlet_vertices_offset) : 0;
+    out_mesh->meshlet_triangles = header->meshlet_count ? block + header->meshlet_triangles_offset : 0;
+    kcopy_memory(out_mesh->bounds_min, header->bounds_min, sizeof(f32) * 3);
+    kcopy_memory(out_mesh->bounds_max, header->bounds_max, sizeof(f32) * 3);
+    return TRUE;
+}
+
+static b8 load_obj(const char* name, const void* file_data, u64 file_size, mesh_resource_data* out_mesh) {
+    mesh_geometry geometry;
+    if (!mesh_import_obj(name, file_data, file_size, &geometry)) {
+        return FALSE;
+    }
+
+    // Same single block as a mesh file, so unloading is the same.
+    u64 vertex_size = sizeof(mesh_vertex) * geometry.vertex_count;
+    u64 index_size = sizeof(u32) * geometry.index_count;
+    u64 block_size = vertex_size + index_size + sizeof(mesh_lod);
+    u8* block = kallocate(block_size, MEMORY_TAG_MESH);
+    kcopy_memory(block, geometry.vertices, vertex_size);
+    kcopy_memory(block + vertex_size, geometry.indices, index_size);
+
+    out_mesh->block = block;
+    out_mesh->block_size = block_size;
+    out_mesh->vertex_format = MESH_VERTEX_FORMAT_FULL;
+    out_mesh->vertex_stride = sizeof(mesh_vertex);
+    out_mesh->vertex_count = geometry.vertex_count;
+    out_mesh->vertices = block;
+    out_mesh->index_size = sizeof(u32);
+    out_mesh->index_count = geometry.index_count;
+    out_mesh->indices = block + vertex_size;
+    out_mesh->lod_count = 1;
+    out_mesh->lods = (mesh_lod*)(block + vertex_size + index_size);
+    out_mesh->lods[0].index_count = geometry.index_count;
+
+    for (u32 axis = 0; axis < 3; ++axis) {
+        out_mesh->bounds_min[axis] = geometry.vertices[0].position[axis];
+        out_mesh->bounds_max[axis] = geometry.vertices[0].position[axis];
+    }
+    for (u32 i = 1; i < geometry.vertex_count; ++i) {
+        for (u32 axis = 0; axis < 3; ++axis) {
+            f32 value = geometry.vertices[i].position[axis];
+            out_mesh->bounds_min[axis] = value < out_mesh->bounds_min[axis] ? value : out_mesh->bounds_min[axis];
+            out_mesh->bounds_max[axis] = value > out_mesh->bounds_max[axis] ? value : out_mesh->bounds_max[axis];
+        }
+    }
+
+    mesh_geometry_destroy(&geometry);
+    return TRUE;
+}
+
+static b8 mesh_loader_load(struct resource_loader* self, const char* name, const void* file_data, u64 file_size, resource* out_resource) {
+    mesh_resource_data mesh;
+    kzero_memory(&mesh, sizeof(mesh_resource_data));
+
+    b8 result = ends_with(name, MESH_FILE_EXTENSION) ? load_ksm(name, file_data, file_size, &mesh) : load_obj(name, file_data, file_size, &mesh);
+    if (!result) {
+        return FALSE;
+    }
+
+    mesh_resource_data* out_mesh = kallocate(sizeof(mesh_resource_data), MEMORY_TAG_MESH);
+    *out_mesh = mesh;
+    out_resource->data = out_mesh;
+    out_resource->data_size = sizeof(mesh_resource_data);
+    return TRUE;
+}
+
+static void mesh_loader_unload(struct resource_loader* self, resource* resource) {
+    mesh_resource_data* mesh = resource->data;
+    kfree(mesh->block, mesh->block_size, MEMORY_TAG_MESH);
+    kfree(mesh, sizeof(mesh_resource_data), MEMORY_TAG_MESH);
+}
+
+resource_loader mesh_resource_loader_create() {
+    resource_loader loader = {};
+    loader.type = RESOURCE_TYPE_MESH;
+    loader.type_path = "models";
+    loader.load = mesh_loader_load;
+    loader.unload = mesh_loader_unload;
+    return loader;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "resources/resource_types.h"
+
+resource_loader mesh_resource_loader_create();
@@ -0,0 +1,37 @@
+#include "shader_loader.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#define SPIRV_MAGIC 0x07230203
+
+static b8 shader_loader_load(struct resource_loader* self, const char* name, const void* file_data, u64 file_size, resource* out_resource) {
+    if (file_size < 4 || file_size % 4 != 0 || *(const u32*)file_data != SPIRV_MAGIC) {
+        KERROR("Shader '%s' is not a SPIR-V module.", name);
+        return FALSE;
+    }
+
+    shader_resource_data* shader = kallocate(sizeof(shader_resource_data), MEMORY_TAG_SHADER);
+    shader->code_size = file_size;
+    shader->code = kallocate(file_size, MEMORY_TAG_SHADER);
+    kcopy_memory(shader->code, file_data, file_size);
+
+    out_resource->data = shader;
+    out_resource->data_size = sizeof(shader_resource_data);
+    return TRUE;
+}
+
+static void shader_loader_unload(struct resource_loader* self, resource* resource) {
+    shader_resource_data* shader = resource->data;
+    kfree(shader->code, shader->code_size, MEMORY_TAG_SHADER);
+    kfree(shader, sizeof(shader_resource_data), MEMORY_TAG_SHADER);
+}
+
+resource_loader shader_resource_loader_create() {
+    resource_loader loader = {};
+    loader.type = RESOURCE_TYPE_SHADER;
+    loader.type_path = "shaders";
+    loader.load = shader_loader_load;
+    loader.unload = shader_loader_unload;
+    return loader;
+}
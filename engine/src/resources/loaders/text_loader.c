@@ -0,0 +1,27 @@
+#include "text_loader.h"
+
+#include "core/kmemory.h"
+
+static b8 text_loader_load(struct resource_loader* self, const char* name, const void* file_data, u64 file_size, resource* out_resource) {
+    // One extra byte for the terminator.
+    char* text = kallocate(file_size + 1, MEMORY_TAG_STRING);
+    kcopy_memory(text, file_data, file_size);
+    text[file_size] = 0;
+
+    out_resource->data = text;
+    out_resource->data_size = file_size + 1;
+    return TRUE;
+}
+
+static void text_loader_unload(struct resource_loader* self, resource* resource) {
+    kfree(resource->data, resource->data_size, MEMORY_TAG_STRING);
+}
+
+resource_loader text_resource_loader_create() {
+    resource_loader loader = {};
+    loader.type = RESOURCE_TYPE_TEXT;
+    loader.type_path = "";
+    loader.load = text_loader_load;
+    loader.unload = text_loader_unload;
+    return loader;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "resources/resource_types.h"
+
+/*
+Binary static mesh file (.ksm).
+
+Written offline by the mesh converter, with the vertex and index data in
+the layout the GPU takes it in, so loading one needs no parsing: the file
+is mapped, copied once, and its section pointers fixed up.
+
+File layout, all little endian, every section starting on a 16-byte boundary:
+    mesh_file_header
+    vertex data             vertex_count * vertex_stride bytes
+    index data              index_count * index_size bytes
+    mesh_lod[lod_count]     finest first
+    mesh_meshlet[meshlet_count]
+    u32 meshlet vertices[meshlet_vertex_count]
+    u8 meshlet triangles[meshlet_triangle_count * 3]
+*/
+
+#define MESH_FILE_MAGIC 0x4D53534B  // "KSSM"
+#define MESH_FILE_VERSION 1
+#define MESH_FILE_ALIGNMENT 16
+#define MESH_FILE_EXTENSION ".ksm"
+
+typedef struct mesh_file_header {
+    u32 magic;
+    u32 version;
+    // One of mesh_vertex_format.
+    u32 vertex_format;
+    u32 vertex_stride;
+    u32 vertex_count;
+    // 2 or 4 bytes.
+    u32 index_size;
+    u32 index_count;
+    u32 lod_count;
+    u32 meshlet_count;
+    u32 meshlet_vertex_count;
+    u32 meshlet_triangle_count;
+    u32 reserved;
+    f32 bounds_min[4];
+    f32 bounds_max[4];
+    u64 vertex_offset;
+    u64 index_offset;
+    u64 lod_offset;
+    u64 meshlet_offset;
+    u64 meshlet_vertices_offset;
+    u64 meshlet_triangles_offset;
+} mesh_file_header;
+
+STATIC_ASSERT(sizeof(mesh_file_header) == 128, "mesh_file_header must match the file format.");
+STATIC_ASSERT(sizeof(mesh_vertex) == 32, "mesh_vertex must match the file format.");
+STATIC_ASSERT(sizeof(mesh_vertex_quantized) == 24, "mesh_vertex_quantized must match the file format.");
+STATIC_ASSERT(sizeof(mesh_lod) == 16, "mesh_lod must match the file format.");
+STATIC_ASSERT(sizeof(mesh_meshlet) == 32, "mesh_meshlet must match the file format.");
+
+// The largest meshlet the converter builds. Matches the common mesh shader limits.
+#define MESH_MESHLET_MAX_VERTICES 64
+#define MESH_MESHLET_MAX_TRIANGLES 124
+
+// The most levels of detail the converter builds, including the full mesh.
+// Each has about half the triangles of the one before.
+#define MESH_MAX_LODS 8
@@ -0,0 +1,210 @@
+#include "mesh_import.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include <stdlib.h>
+
+typedef struct obj_corner {
+    // 1-based, 0 if absent.
+    u32 position;
+    u32 texcoord;
+    u32 normal;
+} obj_corner;
+
+typedef struct obj_vertex_map {
+    obj_corner* keys;
+    u32* values;
+    u32 mask;
+} obj_vertex_map;
+
+static u32 corner_hash(obj_corner c) {
+    u32 hash = c.position * 73856093u;
+    hash ^= c.texcoord * 19349663u;
+    hash ^= c.normal * 83492791u;
+    return hash;
+}
+
+static const char* skip_spaces(const char* c) {
+    while (*c == ' ' || *c == '\t') {
+        c++;
+    }
+    return c;
+}
+
+static const char* next_line(const char* c) {
+    while (*c && *c != '\n') {
+        c++;
+    }
+    return *c ? c + 1 : c;
+}
+
+// Resolves an OBJ index, which may be negative to count back from the end, to a 1-based index.
+static u32 resolve_index(long index, u64 count) {
+    if (index < 0) {
+        index = (long)count + index + 1;
+    }
+    return (index > 0 && (u64)index <= count) ? (u32)index : 0;
+}
+
+b8 mesh_import_obj(const char* name, const void* data, u64 size, mesh_geometry* out_geometry) {
+    kzero_memory(out_geometry, sizeof(mesh_geometry));
+
+    // The C number parsers need a terminated string.
+    char* text = kallocate(size + 1, MEMORY_TAG_STRING);
+    kcopy_memory(text, data, size);
+
+    f32* positions = darray_create(f32);
+    f32* texcoords = darray_create(f32);
+    f32* normals = darray_create(f32);
+    obj_corner* corners = darray_create(obj_corner);
+    // The current face's corners. Reused for every face, so polygons of any size fit.
+    obj_corner* face = darray_create(obj_corner);
+    b8 success = TRUE;
+
+    for (const char* line = text; *line; line = next_line(line)) {
+        const char* c = skip_spaces(line);
+        char* end;
+        if (c[0] == 'v' && (c[1] == ' ' || c[1] == '\t')) {
+            c += 2;
+            for (u32 i = 0; i < 3; ++i) {
+                f32 value = strtof(c, &end);
+                c = end;
+                darray_push(positions, value);
+            }
+        } else if (c[0] == 'v' && c[1] == 't') {
+            c += 2;
+            for (u32 i = 0; i < 2; ++i) {
+                f32 value = strtof(c, &end);
+                c = end;
+                darray_push(texcoords, value);
+            }
+        } else if (c[0] == 'v' && c[1] == 'n') {
+            c += 2;
+            for (u32 i = 0; i < 3; ++i) {
+                f32 value = strtof(c, &end);
+                c = end;
+                darray_push(normals, value);
+            }
+        } else if (c[0] == 'f' && (c[1] == ' ' || c[1] == '\t')) {
+            c += 2;
+            darray_clear(face);
+            for (;;) {
+                c = skip_spaces(c);
+                if (*c == '\n' || *c == '\r' || *c == 0) {
+                    break;
+                }
+                obj_corner corner = {};
+                corner.position = resolve_index(strtol(c, &end, 10), darray_length(positions) / 3);
+                if (end == c || corner.position == 0) {
+                    KERROR("Mesh '%s' has a face with an invalid position index.", name);
+                    success = FALSE;
+                    break;
+                }
+                c = end;
+                if (*c == '/') {
+                    c++;
+                    if (*c != '/') {
+                        corner.texcoord = resolve_index(strtol(c, &end, 10), darray_length(texcoords) / 2);
+                        c = end;
+                    }
+                    if (*c == '/') {
+                        c++;
+                        corner.normal = resolve_index(strtol(c, &end, 10), darray_length(normals) / 3);
+                        c = end;
+                    }
+                }
+                darray_push(face, corner);
+            }
+            if (!success) {
+                break;
+            }
+            // Triangulate as a fan around the first corner.
+            u32 face_count = (u32)darray_length(face);
+            for (u32 i = 2; i < face_count; ++i) {
+                darray_push(corners, face[0]);
+                darray_push(corners, face[i - 1]);
+                darray_push(corners, face[i]);
+            }
+        }
+    }
+
+    u32 corner_count = (u32)darray_length(corners);
+    if (success && corner_count == 0) {
+        KERROR("Mesh '%s' has no faces.", name);
+        success = FALSE;
+    }
+
+    if (success) {
+        mesh_geometry* mesh = out_geometry;
+        mesh->index_count = corner_count;
+        mesh->indices = kallocate(sizeof(u32) * corner_count, MEMORY_TAG_MESH);
+        // Every corner could be unique; the array is trimmed below.
+        mesh_vertex* vertices = kallocate(sizeof(mesh_vertex) * corner_count, MEMORY_TAG_MESH);
+
+        obj_vertex_map map;
+        u32 map_size = 1;
+        while (map_size < corner_count * 2) {
+            map_size <<= 1;
+        }
+        map.keys = kallocate(sizeof(obj_corner) * map_size, MEMORY_TAG_MESH);
+        map.values = kallocate(sizeof(u32) * map_size, MEMORY_TAG_MESH);
+        map.mask = map_size - 1;
+        kset_memory(map.values, 0xFF, sizeof(u32) * map_size);
+
+        u32 vertex_count = 0;
+        for (u32 i = 0; i < corner_count; ++i) {
+            obj_corner corner = corners[i];
+            u32 slot = corner_hash(corner) & map.mask;
+            while (map.values[slot] != INVALID_ID) {
+                obj_corner key = map.keys[slot];
+                if (key.position == corner.position && key.texcoord == corner.texcoord && key.normal == corner.normal) {
+                    break;
+                }
+                slot = (slot + 1) & map.mask;
+            }
+
+            if (map.values[slot] == INVALID_ID) {
+                mesh_vertex* v = &vertices[vertex_count];
+                kzero_memory(v, sizeof(mesh_vertex));
+                kcopy_memory(v->position, &positions[(corner.position - 1) * 3], sizeof(f32) * 3);
+                if (corner.texcoord) {
+                    kcopy_memory(v->texcoord, &texcoords[(corner.texcoord - 1) * 2], sizeof(f32) * 2);
+                }
+                if (corner.normal) {
+                    kcopy_memory(v->normal, &normals[(corner.normal - 1) * 3], sizeof(f32) * 3);
+                }
+                map.keys[slot] = corner;
+                map.values[slot] = vertex_count++;
+            }
+            mesh->indices[i] = map.values[slot];
+        }
+
+        kfree(map.keys, sizeof(obj_corner) * map_size, MEMORY_TAG_MESH);
+        kfree(map.values, sizeof(u32) * map_size, MEMORY_TAG_MESH);
+
+        mesh->vertex_count = vertex_count;
+        mesh->vertices = kallocate(sizeof(mesh_vertex) * vertex_count, MEMORY_TAG_MESH);
+        kcopy_memory(mesh->vertices, vertices, sizeof(mesh_vertex) * vertex_count);
+        kfree(vertices, sizeof(mesh_vertex) * corner_count, MEMORY_TAG_MESH);
+    }
+
+    darray_destroy(positions);
+    darray_destroy(texcoords);
+    darray_destroy(normals);
+    darray_destroy(corners);
+    darray_destroy(face);
+    kfree(text, size + 1, MEMORY_TAG_STRING);
+    return success;
+}
+
+void mesh_geometry_destroy(mesh_geometry* geometry) {
+    if (geometry->vertices) {
+        kfree(geometry->vertices, sizeof(mesh_vertex) * geometry->vertex_count, MEMORY_TAG_MESH);
+    }
+    if (geometry->indices) {
+        kfree(geometry->indices, sizeof(u32) * geometry->index_count, MEMORY_TAG_MESH);
+    }
+    kzero_memory(geometry, sizeof(mesh_geometry));
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "resources/resource_types.h"
+
+/**
+ * Triangle geometry in the plain float vertex layout, as produced by the
+ * importers. Used offline by the mesh converter, and at runtime when a mesh
+ * is loaded straight from a source format.
+ */
+typedef struct mesh_geometry {
+    u32 vertex_count;
+    mesh_vertex* vertices;
+    u32 index_count;
+    u32* indices;
+} mesh_geometry;
+
+/**
+ * Imports Wavefront OBJ geometry: positions, texture coordinates, normals
+ * and polygon faces, which are triangulated as fans. Corners which share
+ * the same position/texcoord/normal triple share one vertex.
+ * @param name The name used in error messages.
+ * @param data The OBJ text. Need not be terminated.
+ * @param size The size of data in bytes.
+ * @param out_geometry A pointer to hold the geometry. Free with mesh_geometry_destroy.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 mesh_import_obj(const char* name, const void* data, u64 size, mesh_geometry* out_geometry);
+
+KAPI void mesh_geometry_destroy(mesh_geometry* geometry);
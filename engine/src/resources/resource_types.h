@@ -0,0 +1,182 @@
+#pragma once
+
+#include "defines.h"
+
+typedef enum resource_type {
+    // Plain text, NUL-terminated.
+    RESOURCE_TYPE_TEXT,
+    // Raw bytes, exactly as stored.
+    RESOURCE_TYPE_BINARY,
+    // An image decoded to 8-bit channels. Data is image_resource_data.
+    RESOURCE_TYPE_IMAGE,
+    // Triangle mesh geometry. Data is mesh_resource_data.
+    RESOURCE_TYPE_MESH,
+    // A SPIR-V shader module. Data is shader_resource_data.
+    RESOURCE_TYPE_SHADER,
+    // A sound decoded whole from a WAV file. Data is audio_resource_data.
+    RESOURCE_TYPE_AUDIO,
+    // Handled by a loader registered with a custom type name.
+    RESOURCE_TYPE_CUSTOM
+} resource_type;
+
+/**
+ * A handle to a resource owned by the resource system. The generation makes
+ * a handle go stale once its resource is released, so a slot that gets
+ * reused is never mistaken for the old resource.
+ */
+typedef struct resource_handle {
+    u32 index;
+    u32 generation;
+} resource_handle;
+
+// Generation 0 is never handed out, so a zeroed handle is invalid.
+#define INVALID_RESOURCE_GENERATION 0
+
+typedef enum resource_state {
+    RESOURCE_STATE_UNLOADED,
+    // Being read and decoded on a job thread.
+    RESOURCE_STATE_LOADING,
+    // Decoded and waiting for its turn to be finalized on the main thread.
+    RESOURCE_STATE_FINALIZING,
+    RESOURCE_STATE_LOADED,
+    RESOURCE_STATE_FAILED
+} resource_state;
+
+typedef struct resource {
+    u32 loader_id;
+    // The name the resource was acquired with.
+    const char* name;
+    // Where the data was read from.
+    char* full_path;
+    // The size of data in bytes.
+    u64 data_size;
+    // The loaded data. What it points to depends on the resource type.
+    void* data;
+} resource;
+
+typedef struct image_resource_data {
+    // 4 (RGBA), whatever the source had.
+    u8 channel_count;
+    u32 width;
+    u32 height;
+    // Rows top to bottom, in CPU memory. The loader does not upload them.
+    u8* pixels;
+} image_resource_data;
+
+// The layout of a vertex in a mesh's vertex data.
+typedef enum mesh_vertex_format {
+    // mesh_vertex: 32-bit float position, normal and texcoord. 32 bytes.
+    MESH_VERTEX_FORMAT_FULL = 0,
+    // mesh_vertex_quantized: 32-bit float position, snorm16 normal and half
+    // float texcoord. 24 bytes.
+    MESH_VERTEX_FORMAT_QUANTIZED = 1,
+    MESH_VERTEX_FORMAT_COUNT
+} mesh_vertex_format;
+
+typedef struct mesh_vertex {
+    f32 position[3];
+    f32 normal[3];
+    f32 texcoord[2];
+} mesh_vertex;
+
+typedef struct mesh_vertex_quantized {
+    f32 position[3];
+    // Signed normalized, w is unused and 0.
+    i16 normal[4];
+    // IEEE half floats.
+    u16 texcoord[2];
+} mesh_vertex_quantized;
+
+// A range of the index buffer drawing the mesh at one level of detail.
+typedef struct mesh_lod {
+    u32 first_index;
+    u32 index_count;
+    // The object-space error of this level compared to the full mesh.
+    f32 error;
+    u32 reserved;
+} mesh_lod;
+
+// A small cluster of triangles with its own vertex list, for cluster culling.
+typedef struct mesh_meshlet {
+    // Offset into the meshlet vertex list, which holds indices into the vertex data.
+    u32 vertex_offset;
+    // Offset into the meshlet triangle list, in triangles of 3 local u8 indices.
+    u32 triangle_offset;
+    u32 vertex_count;
+    u32 triangle_count;
+    // A bounding sphere of the meshlet's positions.
+    f32 center[3];
+    f32 radius;
+} mesh_meshlet;
+
+/**
+ * Mesh data in the layout the GPU takes it in. Everything is held in one
+ * block, which is what a mesh file read from disk is copied into.
+ */
+typedef struct mesh_resource_data {
+    mesh_vertex_format vertex_format;
+    u32 vertex_stride;
+    u32 vertex_count;
+    void* vertices;
+    // 2 or 4 bytes.
+    u32 index_size;
+    u32 index_count;
+    void* indices;
+    // Always at least one, the full detail mesh, at index 0.
+    u32 lod_count;
+    mesh_lod* lods;
+    // Meshlets are optional.
+    u32 meshlet_count;
+    mesh_meshlet* meshlets;
+    u32* meshlet_vertices;
+    u8* meshlet_triangles;
+    f32 bounds_min[3];
+    f32 bounds_max[3];
+
+    // The block holding everything above.
+    void* block;
+    u64 block_size;
+} mesh_resource_data;
+
+typedef struct shader_resource_data {
+    // The size of code in bytes. Always a multiple of 4.
+    u64 code_size;
+    u32* code;
+} shader_resource_data;
+
+typedef struct audio_resource_data {
+    // 1 or 2, interleaved.
+    u32 channel_count;
+    u32 sample_rate;
+    u32 frame_count;
+    // Samples from -1 to 1. A silent frame follows the last, so interpolating past it needs no check.
+    f32* frames;
+} audio_resource_data;
+
+/**
+ * Loads one type of resource. load runs on a job thread and must only decode
+ * the bytes it is given. Anything which has to happen on the main thread,
+ * such as creating GPU objects, goes in finalize, which the resource system
+ * runs under a per-frame time budget.
+ */
+typedef struct resource_loader {
+    // Assigned on registration.
+    u32 id;
+    resource_type type;
+    // The type name when type is RESOURCE_TYPE_CUSTOM.
+    const char* custom_type;
+    // The folder below the asset base path this loader's resources live in.
+    const char* type_path;
+
+    /**
+     * Decodes file data into out_resource->data. Runs on a job thread.
+     * @returns TRUE on success; otherwise FALSE.
+     */
+    b8 (*load)(struct resource_loader* self, const char* name, const void* file_data, u64 file_size, resource* out_resource);
+
+    // Completes a loaded resource on the main thread. Optional.
+    b8 (*finalize)(struct resource_loader* self, resource* resource);
+
+    // Releases everything load and finalize created.
+    void (*unload)(struct resource_loader* self, resource* resource);
+} resource_loader;
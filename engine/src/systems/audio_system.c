@@ -0,0 +1,898 @@
+#include "audio_system.h"
+
+#include "audio/audio_mixer.h"
+#include "containers/spsc_queue.h"
+#include "core/clock.h"
+#include "core/event.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "math/kmath.h"
+#include "platform/async_io.h"
+#include "platform/platform.h"
+#include "resources/audio_decoder.h"
+#include "systems/resource_system.h"
+
+// Chunks of a stream in memory at once: one being decoded, the rest read ahead.
+#define AUDIO_STREAM_CHUNK_COUNT 4
+// Roughly the bytes in a chunk, rounded to whole blocks of the sound.
+#define AUDIO_STREAM_CHUNK_SIZE 32768
+// Read ahead of a stream's first chunk, to find its format and data.
+#define AUDIO_STREAM_HEADER_SIZE 4096
+
+// Async read user data: the magic in the top bits, then the sound's index, then the chunk slot.
+#define AUDIO_READ_MAGIC 0xA0D1ull
+#define AUDIO_READ_HEADER_SLOT 0xFFFF
+
+// Positions this close before a limit count as past it, so rounding never reads beyond it.
+#define AUDIO_POSITION_EPSILON 0.000001
+
+typedef struct audio_stream {
+    async_file file;
+    u8* header;
+    b8 header_requested;
+    b8 header_ready;
+    // Set when the file is unusable or cut short. Already playing voices end at end_seq.
+    b8 failed;
+
+    audio_format format;
+    u64 data_offset;
+    u64 data_size;
+    u32 chunk_size;
+    u32 chunks_in_file;
+
+    // Chunk seq is held in slot seq % AUDIO_STREAM_CHUNK_COUNT.
+    u8* chunks;
+    u32 chunk_bytes[AUDIO_STREAM_CHUNK_COUNT];
+    u32 chunk_seq[AUDIO_STREAM_CHUNK_COUNT];
+    b8 chunk_ready[AUDIO_STREAM_CHUNK_COUNT];
+
+    // Owned by the game thread. Chunks requested so far, and reads not yet completed.
+    u32 requested;
+    u32 in_flight;
+    // Set when a voice finishes, to read from the start again once the reads in flight are done.
+    b8 restart_pending;
+    // Chunks readable by the mixing thread. Written by the game thread.
+    u32 filled;
+    // Chunks the mixing thread has finished with, whose slots can be read into again.
+    u32 consumed;
+    // The chunk after the last one played. Endless while looping.
+    u32 end_seq;
+
+    // Owned by the mixing thread while a voice plays the stream. The decoded
+    // chunk sits after the last frame of the one before it, to interpolate
+    // across the seam, and ahead of a silent frame at the very end.
+    f32* decoded;
+    u32 decoded_capacity;
+    u32 decoded_frames;
+    b8 decoded_valid;
+    b8 decoded_last;
+} audio_stream;
+
+typedef struct audio_sound_entry {
+    u32 generation;
+    b8 in_use;
+    // Released, but still playing.
+    b8 release_pending;
+    u32 voice_count;
+    // Loaded sounds.
+    resource_handle resource;
+    // Streamed sounds.
+    audio_stream* stream;
+    b8 stream_playing;
+} audio_sound_entry;
+
+// The game thread's side of a voice.
+typedef struct audio_voice_slot {
+    u32 generation;
+    b8 in_use;
+    u32 sound;
+} audio_voice_slot;
+
+// The mixing thread's side of a voice.
+typedef struct mixer_voice {
+    b8 active;
+    b8 looping;
+    b8 stopping;
+    const f32* frames;
+    u32 frame_count;
+    u32 channel_count;
+    audio_stream* stream;
+    // Source frames per output frame, before pitch.
+    f64 rate;
+    f32 pitch;
+    f32 volume;
+    f32 pan;
+    audio_mix_params params;
+} mixer_voice;
+
+typedef enum audio_command_type {
+    AUDIO_COMMAND_PLAY,
+    AUDIO_COMMAND_STOP,
+    AUDIO_COMMAND_SET_VOLUME,
+    AUDIO_COMMAND_SET_PITCH,
+    AUDIO_COMMAND_SET_MASTER_VOLUME
+} audio_command_type;
+
+typedef struct audio_command {
+    audio_command_type type;
+    u32 voice;
+    f32 volume;
+    f32 pan;
+    f32 pitch;
+    b8 loop;
+    // Play only.
+    const f32* frames;
+    u32 frame_count;
+    u32 channel_count;
+    u32 sample_rate;
+    audio_stream* stream;
+} audio_command;
+
+typedef struct audio_system_state {
+    audio_system_config config;
+    char stream_base_path[256];
+    audio_device device;
+    kthread thread;
+    b8 running;
+
+    audio_sound_entry sounds[AUDIO_MAX_SOUNDS];
+    audio_voice_slot* voice_slots;
+
+    // Game thread to mixing thread, then the indices of finished voices back.
+    spsc_queue commands;
+    spsc_queue finished;
+
+    // Owned by the mixing thread.
+    mixer_voice* voices;
+    f32 master_volume;
+    f32* mix_buffer;
+    i16* output_buffer;
+    u32 mix_scope;
+} audio_system_state;
+
+static b8 is_initialized = FALSE;
+static audio_system_state state;
+
+static audio_sound_entry* sound_get(audio_sound sound) {
+    if (!is_initialized || sound.generation == 0 || sound.index >= AUDIO_MAX_SOUNDS) {
+        return 0;
+    }
+    audio_sound_entry* entry = &state.sounds[sound.index];
+    return entry->in_use && !entry->release_pending && entry->generation == sound.generation ? entry : 0;
+}
+
+static audio_voice_slot* voice_get(audio_voice voice) {
+    if (!is_initialized || voice.generation == 0 || voice.index >= state.config.max_voices) {
+        return 0;
+    }
+    audio_voice_slot* slot = &state.voice_slots[voice.index];
+    return slot->in_use && slot->generation == voice.generation ? slot : 0;
+}
+
+// ------------------------------------------
+// Mixing thread
+// ------------------------------------------
+
+// Output frames from position before reaching limit, with a little slack for rounding.
+static u32 frames_before(f64 position, f64 step, f64 limit, u32 max_count) {
+    f64 room = (limit - AUDIO_POSITION_EPSILON - position) / step;
+    if (room <= 0) {
+        return 0;
+    }
+    if (room >= max_count) {
+        return max_count;
+    }
+    u32 count = (u32)room;
+    return count < room ? count + 1 : count;
+}
+
+// Equal power panning, so a sound is as loud in the middle as at either side.
+static void voice_target_gains(const mixer_voice* voice, f32* out_left, f32* out_right) {
+    if (voice->stopping) {
+        *out_left = 0;
+        *out_right = 0;
+        return;
+    }
+    f32 angle = (KCLAMP(voice->pan, -1.0f, 1.0f) + 1.0f) * 0.25f * K_PI;
+    f32 volume = voice->volume * state.master_volume;
+    *out_left = volume * kcos(angle);
+    *out_right = volume * ksin(angle);
+}
+
+// Mixes a loaded sound. Returns FALSE once it has ended.
+static b8 mix_loaded_voice(mixer_voice* voice, f64 step, u32 count, f32* out) {
+    audio_mix_params* params = &voice->params;
+    f64 last = voice->frame_count - 1;
+    u32 done = 0;
+    while (done < count) {
+        if (!voice->looping) {
+            // The silent frame after the last is there to interpolate towards.
+            u32 n = frames_before(params->position, step, voice->frame_count, count - done);
+            if (n == 0) {
+                return FALSE;
+            }
+            audio_mix(voice->frames, voice->channel_count, params, n, out + done * 2);
+            done += n;
+        } else if (params->position < last) {
+            u32 n = frames_before(params->position, step, last, count - done);
+            if (n == 0) {
+                // Within rounding of the seam.
+                params->position = last;
+                continue;
+            }
+            audio_mix(voice->frames, voice->channel_count, params, n, out + done * 2);
+            done += n;
+        } else if (params->position < voice->frame_count) {
+            // Across the seam, from the last frame to the first, a frame at a time.
+            f32 seam[4];
+            for (u32 c = 0; c < voice->channel_count; ++c) {
+                seam[c] = voice->frames[(u64)(voice->frame_count - 1) * voice->channel_count + c];
+                seam[voice->channel_count + c] = voice->frames[c];
+            }
+            params->position -= last;
+            audio_mix_scalar(seam, voice->channel_count, params, 1, out + done * 2);
+            params->position += last;
+            done++;
+        } else {
+            params->position -= voice->frame_count;
+        }
+    }
+    return TRUE;
+}
+
+// Decodes the stream's next chunk if it has arrived. Returns FALSE if it has not.
+static b8 stream_decode_next(audio_stream* stream) {
+    u32 seq = stream->consumed;
+    if (seq >= __atomic_load_n(&stream->filled, __ATOMIC_ACQUIRE)) {
+        return FALSE;
+    }
+    u32 slot = seq % AUDIO_STREAM_CHUNK_COUNT;
+    u32 channels = stream->format.channel_count;
+    // The previous chunk's last frame moves to the front.
+    if (stream->decoded_frames > 0) {
+        kcopy_memory(stream->decoded, stream->decoded + (u64)stream->decoded_frames * channels, sizeof(f32) * channels);
+    } else {
+        kzero_memory(stream->decoded, sizeof(f32) * channels);
+    }
+    stream->decoded_frames = audio_decode_blocks(&stream->format, stream->chunks + (u64)slot * stream->chunk_size, stream->chunk_bytes[slot], stream->decoded + channels);
+    kzero_memory(stream->decoded + (u64)(stream->decoded_frames + 1) * channels, sizeof(f32) * channels);
+    stream->decoded_last = seq + 1 >= __atomic_load_n(&stream->end_seq, __ATOMIC_ACQUIRE);
+    stream->decoded_valid = TRUE;
+    // The slot is free to read into again.
+    __atomic_store_n(&stream->consumed, seq + 1, __ATOMIC_RELEASE);
+    return TRUE;
+}
+
+// Mixes a streamed sound. A chunk which has not arrived in time is silence,
+// and the sound carries on from where it was once it does. Returns FALSE once it has ended.
+static b8 mix_streamed_voice(mixer_voice* voice, f64 step, u32 count, f32* out) {
+    audio_stream* stream = voice->stream;
+    audio_mix_params* params = &voice->params;
+    u32 done = 0;
+    while (done < count) {
+        if (!stream->decoded_valid) {
+            if (stream->consumed >= __atomic_load_n(&stream->end_seq, __ATOMIC_ACQUIRE)) {
+                return FALSE;
+            }
+            if (!stream_decode_next(stream)) {
+                break;
+            }
+        }
+        // Positions are in the decoded buffer, whose first frame is the last chunk's.
+        f64 limit = stream->decoded_frames + (stream->decoded_last ? 1 : 0);
+        u32 n = frames_before(params->position, step, limit, count - done);
+        if (n == 0) {
+            if (stream->decoded_last) {
+                return FALSE;
+            }
+            params->position -= stream->decoded_frames;
+            stream->decoded_valid = FALSE;
+            continue;
+        }
+        audio_mix(stream->decoded, voice->channel_count, params, n, out + done * 2);
+        done += n;
+    }
+    return TRUE;
+}
+
+static void mixer_apply_command(const audio_command* command) {
+    if (command->type == AUDIO_COMMAND_SET_MASTER_VOLUME) {
+        state.master_volume = command->volume;
+        return;
+    }
+    mixer_voice* voice = &state.voices[command->voice];
+    switch (command->type) {
+        case AUDIO_COMMAND_PLAY: {
+            kzero_memory(voice, sizeof(mixer_voice));
+            voice->active = TRUE;
+            voice->looping = command->loop;
+            voice->frames = command->frames;
+            voice->frame_count = command->frame_count;
+            voice->channel_count = command->channel_count;
+            voice->stream = command->stream;
+            voice->rate = (f64)command->sample_rate / state.config.device.sample_rate;
+            voice->pitch = command->pitch;
+            voice->volume = command->volume;
+            voice->pan = command->pan;
+            if (voice->stream) {
+                // Frame 1 of the decoded buffer is the first of the sound.
+                voice->stream->decoded_frames = 0;
+                voice->stream->decoded_valid = FALSE;
+                voice->params.position = 1.0;
+            }
+            // Sounds start at full volume, rather than fading in over the block.
+            voice_target_gains(voice, &voice->params.gain[0], &voice->params.gain[1]);
+        } break;
+        case AUDIO_COMMAND_STOP:
+            voice->stopping = TRUE;
+            break;
+        case AUDIO_COMMAND_SET_VOLUME:
+            voice->volume = command->volume;
+            voice->pan = command->pan;
+            break;
+        case AUDIO_COMMAND_SET_PITCH:
+            voice->pitch = command->pitch;
+            break;
+        default:
+            break;
+    }
+}
+
+static void mixer_mix_block(u32 count) {
+    f32* out = state.mix_buffer;
+    kzero_memory(out, sizeof(f32) * 2 * count);
+    for (u32 i = 0; i < state.config.max_voices; ++i) {
+        mixer_voice* voice = &state.voices[i];
+        if (!voice->active) {
+            continue;
+        }
+        // Gains ramp to their targets over the block.
+        f32 target[2];
+        voice_target_gains(voice, &target[0], &target[1]);
+        voice->params.gain_step[0] = (target[0] - voice->params.gain[0]) / count;
+        voice->params.gain_step[1] = (target[1] - voice->params.gain[1]) / count;
+        voice->params.step = voice->rate * voice->pitch;
+
+        b8 playing = voice->stream ? mix_streamed_voice(voice, voice->params.step, count, out) : mix_loaded_voice(voice, voice->params.step, count, out);
+        voice->params.gain[0] = target[0];
+        voice->params.gain[1] = target[1];
+        // Stopped voices have faded out by now.
+        if (!playing || voice->stopping) {
+            voice->active = FALSE;
+            spsc_queue_push(&state.finished, &i);
+        }
+    }
+}
+
+static u32 audio_thread_run(void* params) {
+    u32 count = state.config.frames_per_block;
+    while (__atomic_load_n(&state.running, __ATOMIC_ACQUIRE)) {
+        f64 start = clock_get_current_time();
+        audio_command command;
+        while (spsc_queue_pop(&state.commands, &command)) {
+            mixer_apply_command(&command);
+        }
+
+        mixer_mix_block(count);
+        audio_convert_to_i16(state.mix_buffer, count * 2, state.output_buffer);
+        profiler_record(state.mix_scope, clock_get_current_time() - start);
+
+        // Blocks for as long as the block takes to play.
+        if (!state.device.write(&state.device, state.output_buffer, count)) {
+            KERROR("The audio device failed to take a block. Audio has stopped.");
+            break;
+        }
+    }
+    return 0;
+}
+
+// ------------------------------------------
+// Streams
+// ------------------------------------------
+
+static u64 stream_read_user_data(u32 sound_index, u32 slot) {
+    return (AUDIO_READ_MAGIC << 48) | ((u64)sound_index << 32) | slot;
+}
+
+static void stream_destroy(audio_stream* stream) {
+    if (stream->file.is_valid) {
+        async_io_close(&stream->file);
+    }
+    if (stream->header) {
+        kfree(stream->header, AUDIO_STREAM_HEADER_SIZE, MEMORY_TAG_AUDIO);
+    }
+    if (stream->chunks) {
+        kfree(stream->chunks, (u64)stream->chunk_size * AUDIO_STREAM_CHUNK_COUNT, MEMORY_TAG_AUDIO);
+    }
+    if (stream->decoded) {
+        kfree(stream->decoded, sizeof(f32) * stream->decoded_capacity, MEMORY_TAG_AUDIO);
+    }
+    kfree(stream, sizeof(audio_stream), MEMORY_TAG_AUDIO);
+}
+
+// Reads the format and sizes the chunks to it.
+static b8 stream_parse_header(audio_stream* stream, u32 bytes_read) {
+    if (!audio_wav_parse(stream->header, bytes_read, &stream->format, &stream->data_offset, &stream->data_size) || stream->data_size == 0) {
+        return FALSE;
+    }
+    u32 block_align = stream->format.block_align;
+    u32 blocks = AUDIO_STREAM_CHUNK_SIZE / block_align;
+    stream->chunk_size = (blocks > 0 ? blocks : 1) * block_align;
+    stream->chunks_in_file = (u32)((stream->data_size + stream->chunk_size - 1) / stream->chunk_size);
+    stream->end_seq = stream->chunks_in_file;
+    stream->chunks = kallocate((u64)stream->chunk_size * AUDIO_STREAM_CHUNK_COUNT, MEMORY_TAG_AUDIO);
+    // Room for the previous chunk's last frame and the silent one at the end.
+    stream->decoded_capacity = (audio_decode_frame_count(&stream->format, stream->chunk_size) + 2) * stream->format.channel_count;
+    stream->decoded = kallocate(sizeof(f32) * stream->decoded_capacity, MEMORY_TAG_AUDIO);
+    return TRUE;
+}
+
+// Keeps the stream's free chunk slots reading.
+static void stream_service(u32 sound_index, audio_stream* stream) {
+    if (!stream->header_requested) {
+        async_read_request request = {stream->file, 0, AUDIO_STREAM_HEADER_SIZE, stream->header, stream_read_user_data(sound_index, AUDIO_READ_HEADER_SLOT)};
+        if (async_io_submit_reads(1, &request)) {
+            stream->header_requested = TRUE;
+            stream->in_flight++;
+        }
+        return;
+    }
+    if (!stream->header_ready || stream->failed) {
+        return;
+    }
+    if (stream->restart_pending) {
+        // Reads from before may still land in the slots.
+        if (stream->in_flight > 0) {
+            return;
+        }
+        stream->requested = 0;
+        stream->filled = 0;
+        stream->consumed = 0;
+        stream->end_seq = stream->chunks_in_file;
+        kzero_memory(stream->chunk_ready, sizeof(stream->chunk_ready));
+        stream->restart_pending = FALSE;
+    }
+
+    u32 consumed = __atomic_load_n(&stream->consumed, __ATOMIC_ACQUIRE);
+    async_read_request requests[AUDIO_STREAM_CHUNK_COUNT];
+    u32 count = 0;
+    while (stream->requested + count < stream->end_seq && stream->requested + count < consumed + AUDIO_STREAM_CHUNK_COUNT) {
+        u32 seq = stream->requested + count;
+        u32 slot = seq % AUDIO_STREAM_CHUNK_COUNT;
+        u64 offset = (u64)(seq % stream->chunks_in_file) * stream->chunk_size;
+        u64 size = stream->data_size - offset < stream->chunk_size ? stream->data_size - offset : stream->chunk_size;
+        stream->chunk_seq[slot] = seq;
+        stream->chunk_ready[slot] = FALSE;
+        async_read_request* request = &requests[count++];
+        request->file = stream->file;
+        request->offset = stream->data_offset + offset;
+        request->size = size;
+        request->buffer = stream->chunks + (u64)slot * stream->chunk_size;
+        request->user_data = stream_read_user_data(sound_index, slot);
+    }
+    // Tried again next frame if the queue is full.
+    if (count > 0 && async_io_submit_reads(count, requests)) {
+        stream->requested += count;
+        stream->in_flight += count;
+    }
+}
+
+static void stream_fail(audio_stream* stream, u32 end_seq) {
+    stream->failed = TRUE;
+    if (end_seq < stream->end_seq) {
+        __atomic_store_n(&stream->end_seq, end_seq, __ATOMIC_RELEASE);
+    }
+}
+
+static void stream_read_completed(u32 sound_index, audio_stream* stream, u32 slot, u32 bytes_read, i32 error) {
+    if (slot == AUDIO_READ_HEADER_SLOT) {
+        if (error != 0 || !stream_parse_header(stream, bytes_read)) {
+            KERROR("Streamed sound %u is not a WAV file in a supported encoding.", sound_index);
+            stream->failed = TRUE;
+            return;
+        }
+        stream->header_ready = TRUE;
+        return;
+    }
+
+    u32 seq = stream->chunk_seq[slot];
+    u64 offset = (u64)(seq % stream->chunks_in_file) * stream->chunk_size;
+    u64 expected = stream->data_size - offset < stream->chunk_size ? stream->data_size - offset : stream->chunk_size;
+    if (error != 0 || bytes_read == 0) {
+        KERROR("Failed to read streamed sound %u. It ends here.", sound_index);
+        stream_fail(stream, seq);
+        return;
+    }
+    if (bytes_read < expected) {
+        KWARN("Streamed sound %u is shorter than its header says.", sound_index);
+        stream_fail(stream, seq + 1);
+    }
+    stream->chunk_bytes[slot] = bytes_read;
+    stream->chunk_ready[slot] = TRUE;
+
+    // Reads may complete out of order. Chunks are handed over in order.
+    u32 filled = stream->filled;
+    while (filled < stream->requested && stream->chunk_ready[filled % AUDIO_STREAM_CHUNK_COUNT]) {
+        stream->chunk_ready[filled % AUDIO_STREAM_CHUNK_COUNT] = FALSE;
+        filled++;
+    }
+    __atomic_store_n(&stream->filled, filled, __ATOMIC_RELEASE);
+}
+
+static b8 audio_system_on_read(u16 code, void* sender, void* listener_inst, event_context context) {
+    u64 user_data = context.data.u64[0];
+    if ((user_data >> 48) != AUDIO_READ_MAGIC) {
+        return FALSE;
+    }
+    u32 sound_index = (u32)(user_data >> 32) & 0xFFFF;
+    u32 slot = (u32)user_data & 0xFFFF;
+    audio_stream* stream = sound_index < AUDIO_MAX_SOUNDS ? state.sounds[sound_index].stream : 0;
+    if (stream) {
+        stream->in_flight--;
+        // Reads of a stream which is restarting are of no use.
+        if (!stream->restart_pending) {
+            stream_read_completed(sound_index, stream, slot, context.data.u32[2], context.data.i32[3]);
+        }
+    }
+    return TRUE;
+}
+
+// ------------------------------------------
+// Game thread
+// ------------------------------------------
+
+static void sound_free(u32 index) {
+    audio_sound_entry* entry = &state.sounds[index];
+    if (entry->stream) {
+        stream_destroy(entry->stream);
+    } else {
+        resource_system_release(entry->resource);
+    }
+    entry->in_use = FALSE;
+    entry->release_pending = FALSE;
+    entry->stream = 0;
+    entry->stream_playing = FALSE;
+    entry->voice_count = 0;
+}
+
+// Frees a released sound once nothing uses it.
+static void sound_try_free(u32 index) {
+    audio_sound_entry* entry = &state.sounds[index];
+    if (entry->in_use && entry->release_pending && entry->voice_count == 0 && (!entry->stream || entry->stream->in_flight == 0)) {
+        sound_free(index);
+    }
+}
+
+static audio_sound sound_allocate() {
+    audio_sound handle = {INVALID_ID, 0};
+    for (u32 i = 0; i < AUDIO_MAX_SOUNDS; ++i) {
+        audio_sound_entry* entry = &state.sounds[i];
+        if (!entry->in_use) {
+            entry->in_use = TRUE;
+            entry->generation++;
+            if (entry->generation == 0) {
+                entry->generation = 1;
+            }
+            handle.index = i;
+            handle.generation = entry->generation;
+            return handle;
+        }
+    }
+    KERROR("No more than %u sounds can exist at once.", AUDIO_MAX_SOUNDS);
+    return handle;
+}
+
+static b8 command_push(const audio_command* command) {
+    if (!spsc_queue_push(&state.commands, command)) {
+        KWARN("The audio command queue is full. A command was dropped.");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+b8 audio_system_initialize(audio_system_config config) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    if (config.frames_per_block == 0 || config.max_voices == 0 || config.device.sample_rate == 0) {
+        KERROR("audio_system_initialize requires a frames_per_block, max_voices and sample_rate above zero.");
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(audio_system_state));
+    state.config = config;
+    string_format(state.stream_base_path, sizeof(state.stream_base_path), "%s", config.stream_base_path ? config.stream_base_path : ".");
+    state.config.stream_base_path = state.stream_base_path;
+    state.master_volume = 1.0f;
+
+    if (!audio_device_create(&config.device, &state.device)) {
+        KERROR("Failed to create the audio device.");
+        return FALSE;
+    }
+
+    // Every voice may be told a few things between blocks.
+    spsc_queue_create(sizeof(audio_command), config.max_voices * 4 + 64, &state.commands);
+    // A voice finishes at most once before its slot is freed, so this never fills.
+    spsc_queue_create(sizeof(u32), config.max_voices, &state.finished);
+    state.voice_slots = kallocate(sizeof(audio_voice_slot) * config.max_voices, MEMORY_TAG_AUDIO);
+    state.voices = kallocate(sizeof(mixer_voice) * config.max_voices, MEMORY_TAG_AUDIO);
+    state.mix_buffer = kallocate(sizeof(f32) * 2 * config.frames_per_block, MEMORY_TAG_AUDIO);
+    state.output_buffer = kallocate(sizeof(i16) * 2 * config.frames_per_block, MEMORY_TAG_AUDIO);
+    state.mix_scope = profiler_scope_register("audio_mix");
+
+    event_register(EVENT_CODE_ASYNC_READ_COMPLETED, &state, audio_system_on_read);
+
+    // The platform has no way to raise a thread's priority, so the mixing
+    // thread relies on blocks being short and the device's pacing.
+    state.running = TRUE;
+    if (!kthread_create(audio_thread_run, 0, &state.thread)) {
+        KERROR("Failed to create the audio mixing thread.");
+        state.running = FALSE;
+        is_initialized = TRUE;
+        audio_system_shutdown();
+        return FALSE;
+    }
+
+    KINFO("Audio system started: %u Hz, %u frames a block, %u voices.", config.device.sample_rate, config.frames_per_block, config.max_voices);
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void audio_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    if (state.running) {
+        __atomic_store_n(&state.running, FALSE, __ATOMIC_RELEASE);
+        kthread_wait(&state.thread);
+    }
+
+    // Streams cannot be closed under reads still in flight.
+    for (u32 i = 0; i < AUDIO_MAX_SOUNDS; ++i) {
+        audio_sound_entry* entry = &state.sounds[i];
+        if (!entry->in_use) {
+            continue;
+        }
+        if (!entry->release_pending) {
+            KWARN("Sound %u still exists at audio system shutdown.", i);
+        }
+        if (entry->stream) {
+            while (entry->stream->in_flight > 0 && async_io_outstanding_count() > 0) {
+                async_io_update();
+                platform_sleep(1);
+            }
+            // Whatever did not complete was not delivered; the file must stay open under it.
+            if (entry->stream->in_flight > 0) {
+                entry->stream->file.is_valid = FALSE;
+            }
+        }
+        sound_free(i);
+    }
+    event_unregister(EVENT_CODE_ASYNC_READ_COMPLETED, &state, audio_system_on_read);
+
+    audio_device_destroy(&state.device);
+    spsc_queue_destroy(&state.commands);
+    spsc_queue_destroy(&state.finished);
+    kfree(state.voice_slots, sizeof(audio_voice_slot) * state.config.max_voices, MEMORY_TAG_AUDIO);
+    kfree(state.voices, sizeof(mixer_voice) * state.config.max_voices, MEMORY_TAG_AUDIO);
+    kfree(state.mix_buffer, sizeof(f32) * 2 * state.config.frames_per_block, MEMORY_TAG_AUDIO);
+    kfree(state.output_buffer, sizeof(i16) * 2 * state.config.frames_per_block, MEMORY_TAG_AUDIO);
+    is_initialized = FALSE;
+}
+
+void audio_system_update() {
+    if (!is_initialized) {
+        return;
+    }
+
+    u32 index;
+    while (spsc_queue_pop(&state.finished, &index)) {
+        audio_voice_slot* slot = &state.voice_slots[index];
+        audio_sound_entry* entry = &state.sounds[slot->sound];
+        entry->voice_count--;
+        if (entry->stream) {
+            // Read from the start again, so the stream can be played again as soon as this event.
+            entry->stream_playing = FALSE;
+            entry->stream->restart_pending = TRUE;
+            if (!entry->release_pending) {
+                stream_service(slot->sound, entry->stream);
+            }
+        }
+        sound_try_free(slot->sound);
+
+        slot->in_use = FALSE;
+        event_context context = {};
+        context.data.u32[0] = index;
+        context.data.u32[1] = slot->generation;
+        event_fire(EVENT_CODE_SOUND_FINISHED, 0, context);
+    }
+
+    for (u32 i = 0; i < AUDIO_MAX_SOUNDS; ++i) {
+        audio_sound_entry* entry = &state.sounds[i];
+        if (!entry->in_use || !entry->stream) {
+            continue;
+        }
+        if (entry->release_pending) {
+            sound_try_free(i);
+        } else {
+            stream_service(i, entry->stream);
+        }
+    }
+}
+
+audio_sound audio_sound_load(const char* name) {
+    audio_sound handle = {INVALID_ID, 0};
+    if (!is_initialized) {
+        return handle;
+    }
+    resource_handle resource = resource_system_acquire_async(RESOURCE_TYPE_AUDIO, name, 0, 0);
+    if (resource.generation == INVALID_RESOURCE_GENERATION) {
+        return handle;
+    }
+    handle = sound_allocate();
+    if (handle.generation == 0) {
+        resource_system_release(resource);
+        return handle;
+    }
+    state.sounds[handle.index].resource = resource;
+    return handle;
+}
+
+audio_sound audio_sound_open_stream(const char* name) {
+    audio_sound handle = {INVALID_ID, 0};
+    if (!is_initialized) {
+        return handle;
+    }
+    char path[512];
+    string_format(path, sizeof(path), "%s/%s", state.stream_base_path, name);
+    async_file file;
+    if (!async_io_open(path, &file)) {
+        KERROR("Unable to open '%s' to stream.", path);
+        return handle;
+    }
+    handle = sound_allocate();
+    if (handle.generation == 0) {
+        async_io_close(&file);
+        return handle;
+    }
+    audio_stream* stream = kallocate(sizeof(audio_stream), MEMORY_TAG_AUDIO);
+    stream->file = file;
+    stream->header = kallocate(AUDIO_STREAM_HEADER_SIZE, MEMORY_TAG_AUDIO);
+    state.sounds[handle.index].stream = stream;
+    // Starts reading the header now, and the first chunks once it arrives.
+    stream_service(handle.index, stream);
+    return handle;
+}
+
+void audio_sound_release(audio_sound sound) {
+    audio_sound_entry* entry = sound_get(sound);
+    if (!entry) {
+        return;
+    }
+    entry->release_pending = TRUE;
+    sound_try_free(sound.index);
+}
+
+b8 audio_sound_is_ready(audio_sound sound) {
+    audio_sound_entry* entry = sound_get(sound);
+    if (!entry) {
+        return FALSE;
+    }
+    if (entry->stream) {
+        return entry->stream->header_ready && !entry->stream->failed;
+    }
+    return resource_system_get_state(entry->resource) == RESOURCE_STATE_LOADED;
+}
+
+audio_voice audio_play(audio_sound sound, f32 volume, f32 pan, f32 pitch, b8 loop) {
+    audio_voice handle = {INVALID_ID, 0};
+    audio_sound_entry* entry = sound_get(sound);
+    if (!entry || pitch <= 0) {
+        return handle;
+    }
+
+    audio_command command = {};
+    command.type = AUDIO_COMMAND_PLAY;
+    command.volume = volume;
+    command.pan = pan;
+    command.pitch = pitch;
+    command.loop = loop;
+    if (entry->stream) {
+        audio_stream* stream = entry->stream;
+        // A stream which just finished is back once its first chunks are read again.
+        if (!stream->header_ready || stream->failed || stream->restart_pending || entry->stream_playing) {
+            return handle;
+        }
+        command.stream = stream;
+        command.channel_count = stream->format.channel_count;
+        command.sample_rate = stream->format.sample_rate;
+    } else {
+        const resource* res = resource_system_get(entry->resource);
+        if (!res) {
+            return handle;
+        }
+        const audio_resource_data* data = res->data;
+        command.frames = data->frames;
+        command.frame_count = data->frame_count;
+        command.channel_count = data->channel_count;
+        command.sample_rate = data->sample_rate;
+    }
+
+    for (u32 i = 0; i < state.config.max_voices; ++i) {
+        audio_voice_slot* slot = &state.voice_slots[i];
+        if (slot->in_use) {
+            continue;
+        }
+        command.voice = i;
+        if (entry->stream) {
+            // The mixing thread reads no further than this.
+            __atomic_store_n(&entry->stream->end_seq, loop ? U32_MAX : entry->stream->chunks_in_file, __ATOMIC_RELEASE);
+        }
+        if (!command_push(&command)) {
+            return handle;
+        }
+        slot->in_use = TRUE;
+        slot->generation++;
+        if (slot->generation == 0) {
+            slot->generation = 1;
+        }
+        slot->sound = sound.index;
+        entry->voice_count++;
+        if (entry->stream) {
+            entry->stream_playing = TRUE;
+        }
+        handle.index = i;
+        handle.generation = slot->generation;
+        return handle;
+    }
+    return handle;
+}
+
+void audio_voice_stop(audio_voice voice) {
+    if (!voice_get(voice)) {
+        return;
+    }
+    audio_command command = {};
+    command.type = AUDIO_COMMAND_STOP;
+    command.voice = voice.index;
+    command_push(&command);
+}
+
+void audio_voice_set_volume(audio_voice voice, f32 volume, f32 pan) {
+    if (!voice_get(voice)) {
+        return;
+    }
+    audio_command command = {};
+    command.type = AUDIO_COMMAND_SET_VOLUME;
+    command.voice = voice.index;
+    command.volume = volume;
+    command.pan = pan;
+    command_push(&command);
+}
+
+void audio_voice_set_pitch(audio_voice voice, f32 pitch) {
+    if (!voice_get(voice) || pitch <= 0) {
+        return;
+    }
+    audio_command command = {};
+    command.type = AUDIO_COMMAND_SET_PITCH;
+    command.voice = voice.index;
+    command.pitch = pitch;
+    command_push(&command);
+}
+
+b8 audio_voice_is_playing(audio_voice voice) {
+    return voice_get(voice) != 0;
+}
+
+void audio_set_master_volume(f32 volume) {
+    if (!is_initialized) {
+        return;
+    }
+    audio_command command = {};
+    command.type = AUDIO_COMMAND_SET_MASTER_VOLUME;
+    command.volume = volume;
+    command_push(&command);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "audio/audio_device.h"
+
+/*
+Plays sounds on a thread of its own, which mixes a block of frames at a
+time and hands it to the device. The game thread never waits on it: calls
+here queue commands which the mixing thread picks up before its next
+block, and voices which have finished are reported back the same way,
+during audio_system_update.
+
+Sounds are either loaded, decoded whole in the background by the resource
+system, or streamed, read a chunk at a time through async I/O and decoded
+on the mixing thread as they play, for music and other long sounds.
+*/
+
+// The most sounds which can exist at once.
+#define AUDIO_MAX_SOUNDS 256
+
+typedef struct audio_system_config {
+    audio_device_config device;
+    // Frames mixed at a time. Commands take effect at the start of a block.
+    u32 frames_per_block;
+    // The most sounds which can play at once.
+    u32 max_voices;
+    // The folder streamed sounds are opened from.
+    const char* stream_base_path;
+} audio_system_config;
+
+// Generation 0 is never handed out, so zeroed handles are invalid.
+typedef struct audio_sound {
+    u32 index;
+    u32 generation;
+} audio_sound;
+
+typedef struct audio_voice {
+    u32 index;
+    u32 generation;
+} audio_voice;
+
+b8 audio_system_initialize(audio_system_config config);
+void audio_system_shutdown();
+
+/**
+ * Frees the voices which have finished, firing EVENT_CODE_SOUND_FINISHED for
+ * each, and keeps streams read ahead. Called once per frame by the
+ * application, after async_io_update.
+ */
+void audio_system_update();
+
+/**
+ * Starts a sound loading in the background through the resource system.
+ * @param name The file name below the resource system's sounds folder.
+ * @returns The sound, or an invalid handle on failure.
+ */
+KAPI audio_sound audio_sound_load(const char* name);
+
+/**
+ * Opens a sound to be streamed, and starts reading its beginning. A
+ * streamed sound plays on one voice at a time.
+ * @param name The file name below the stream base path.
+ * @returns The sound, or an invalid handle on failure.
+ */
+KAPI audio_sound audio_sound_open_stream(const char* name);
+
+// Releases a sound. Voices playing it carry on, and it is freed once they finish.
+KAPI void audio_sound_release(audio_sound sound);
+
+// Whether a sound has loaded, so it can be played. FALSE once it has failed to.
+KAPI b8 audio_sound_is_ready(audio_sound sound);
+
+/**
+ * Starts a sound playing.
+ * @param volume From 0, silent, to 1, as loud as the sound was recorded.
+ * @param pan From -1, the left speaker only, to 1, the right only.
+ * @param pitch The playback speed, which is resampled to the device's rate. 1 is as recorded.
+ * @param loop Whether the sound repeats until stopped.
+ * @returns The voice playing it, or an invalid handle if the sound is not ready, or no voice is free.
+ */
+KAPI audio_voice audio_play(audio_sound sound, f32 volume, f32 pan, f32 pitch, b8 loop);
+
+// Fades a voice out over a block and frees it. Stale voices are ignored.
+KAPI void audio_voice_stop(audio_voice voice);
+KAPI void audio_voice_set_volume(audio_voice voice, f32 volume, f32 pan);
+KAPI void audio_voice_set_pitch(audio_voice voice, f32 pitch);
+
+// Whether a voice is still playing, until its EVENT_CODE_SOUND_FINISHED is fired.
+KAPI b8 audio_voice_is_playing(audio_voice voice);
+
+// Scales the volume of every voice.
+KAPI void audio_set_master_volume(f32 volume);
@@ -0,0 +1,317 @@
+#include "config_system.h"
+
+#include "core/event.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#include <stdlib.h>
+
+#define MAX_WATCHED_CONFIGS 8
+#define MAX_CONFIG_PATH 256
+
+typedef struct watched_config {
+    b8 in_use;
+    b8 watching;
+    u32 watch_id;
+    char path[MAX_CONFIG_PATH];
+    const config_binding* bindings;
+    u32 binding_count;
+} watched_config;
+
+typedef struct config_system_state {
+    watched_config configs[MAX_WATCHED_CONFIGS];
+} config_system_state;
+
+static b8 is_initialized = FALSE;
+static config_system_state state;
+
+static b8 config_on_file_written(u16 code, void* sender, void* listener_inst, event_context context);
+
+b8 config_system_initialize() {
+    if (is_initialized) {
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(config_system_state));
+    event_register(EVENT_CODE_WATCHED_FILE_WRITTEN, &state, config_on_file_written);
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void config_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    for (u32 i = 0; i < MAX_WATCHED_CONFIGS; ++i) {
+        if (state.configs[i].in_use) {
+            config_unwatch(i);
+        }
+    }
+    event_unregister(EVENT_CODE_WATCHED_FILE_WRITTEN, &state, config_on_file_written);
+    is_initialized = FALSE;
+}
+
+static b8 parse_integer(kstring_view text, i64 min, i64 max, i64* out_value) {
+    u64 i = 0;
+    b8 negative = FALSE;
+    if (i < text.length && (text.str[i] == '-' || text.str[i] == '+')) {
+        negative = text.str[i] == '-';
+        i++;
+    }
+    if (i == text.length) {
+        return FALSE;
+    }
+
+    i64 value = 0;
+    for (; i < text.length; ++i) {
+        char c = text.str[i];
+        if (c < '0' || c > '9') {
+            return FALSE;
+        }
+        value = value * 10 + (c - '0');
+        if (value > max - min) {
+            return FALSE;
+        }
+    }
+    value = negative ? -value : value;
+    if (value < min || value > max) {
+        return FALSE;
+    }
+    *out_value = value;
+    return TRUE;
+}
+
+static b8 parse_float(kstring_view text, f32* out_value) {
+    // strtod needs a terminator, which the mapped text does not have.
+    char buffer[64];
+    if (text.length == 0 || text.length >= sizeof(buffer)) {
+        return FALSE;
+    }
+    kcopy_memory(buffer, text.str, text.length);
+    buffer[text.length] = 0;
+    char* end = 0;
+    f64 value = strtod(buffer, &end);
+    if (end != buffer + text.length) {
+        return FALSE;
+    }
+    *out_value = (f32)value;
+    return TRUE;
+}
+
+static b8 parse_bool(kstring_view text, b8* out_value) {
+    static const char* true_names[] = {"true", "yes", "on", "1"};
+    static const char* false_names[] = {"false", "no", "off", "0"};
+    for (u32 i = 0; i < 4; ++i) {
+        if (string_view_equals_cstr(text, true_names[i])) {
+            *out_value = TRUE;
+            return TRUE;
+        }
+        if (string_view_equals_cstr(text, false_names[i])) {
+            *out_value = FALSE;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static b8 apply_value(const config_binding* binding, kstring_view value) {
+    i64 integer;
+    switch (binding->type) {
+        case CONFIG_VALUE_BOOL:
+            return parse_bool(value, (b8*)binding->target);
+        case CONFIG_VALUE_I16:
+            if (!parse_integer(value, -32768, 32767, &integer)) {
+                return FALSE;
+            }
+            *(i16*)binding->target = (i16)integer;
+            return TRUE;
+        case CONFIG_VALUE_I32:
+            if (!parse_integer(value, -2147483647LL - 1, 2147483647LL, &integer)) {
+                return FALSE;
+            }
+            *(i32*)binding->target = (i32)integer;
+            return TRUE;
+        case CONFIG_VALUE_U32:
+            if (!parse_integer(value, 0, 4294967295LL, &integer)) {
+                return FALSE;
+            }
+            *(u32*)binding->target = (u32)integer;
+            return TRUE;
+        case CONFIG_VALUE_F32:
+            return parse_float(value, (f32*)binding->target);
+        case CONFIG_VALUE_STRING: {
+            if (binding->string_capacity == 0) {
+                return FALSE;
+            }
+            u64 length = value.length < binding->string_capacity - 1 ? value.length : binding->string_capacity - 1;
+            kcopy_memory(binding->target, value.str, length);
+            ((char*)binding->target)[length] = 0;
+            return TRUE;
+        }
+        case CONFIG_VALUE_ENUM:
+            for (u32 i = 0; i < binding->enum_count; ++i) {
+                if (string_view_equals_cstr(value, binding->enum_names[i])) {
+                    *(u32*)binding->target = i;
+                    return TRUE;
+                }
+            }
+            return FALSE;
+    }
+    return FALSE;
+}
+
+static const config_binding* find_binding(kstring_view section, kstring_view key, const config_binding* bindings, u32 binding_count) {
+    for (u32 i = 0; i < binding_count; ++i) {
+        const config_binding* binding = &bindings[i];
+        const char* binding_section = binding->section ? binding->section : "";
+        if (string_view_equals_cstr(key, binding->key) && string_view_equals_cstr(section, binding_section)) {
+            return binding;
+        }
+    }
+    return 0;
+}
+
+b8 config_parse(const char* source_name, const char* text, u64 length, const config_binding* bindings, u32 binding_count) {
+    b8 clean = TRUE;
+    kstring_view section = string_view_from("", 0);
+    kstring_view remaining = string_view_from(text, length);
+    u32 line_number = 0;
+
+    while (remaining.length > 0) {
+        i64 newline = string_view_find_char(remaining, '\n');
+        u64 line_length = newline < 0 ? remaining.length : (u64)newline;
+        kstring_view line = string_view_trim(string_view_from(remaining.str, line_length));
+        remaining = string_view_substring(remaining, line_length + 1, remaining.length);
+        line_number++;
+
+        if (line.length == 0 || line.str[0] == ';' || line.str[0] == '#') {
+            continue;
+        }
+
+        if (line.str[0] == '[') {
+            i64 close = string_view_find_char(line, ']');
+            if (close < 0) {
+                KWARN("%s:%u: Section header is missing ']'.", source_name, line_number);
+                clean = FALSE;
+                continue;
+            }
+            section = string_view_trim(string_view_substring(line, 1, (u64)close - 1));
+            continue;
+        }
+
+        i64 equals = string_view_find_char(line, '=');
+        if (equals < 0) {
+            KWARN("%s:%u: Expected 'key = value'.", source_name, line_number);
+            clean = FALSE;
+            continue;
+        }
+        kstring_view key = string_view_trim(string_view_substring(line, 0, (u64)equals));
+        kstring_view value = string_view_trim(string_view_substring(line, (u64)equals + 1, line.length));
+
+        if (value.length > 0 && value.str[0] == '"') {
+            // Quoted values keep everything up to the closing quote, comment characters included.
+            kstring_view inner = string_view_substring(value, 1, value.length);
+            i64 quote = string_view_find_char(inner, '"');
+            if (quote < 0) {
+                KWARN("%s:%u: Missing closing quote.", source_name, line_number);
+                clean = FALSE;
+                continue;
+            }
+            value = string_view_substring(inner, 0, (u64)quote);
+        } else {
+            // Anything after a comment character is dropped.
+            for (u64 i = 0; i < value.length; ++i) {
+                if (value.str[i] == ';' || value.str[i] == '#') {
+                    value = string_view_trim(string_view_substring(value, 0, i));
+                    break;
+                }
+            }
+        }
+
+        const config_binding* binding = find_binding(section, key, bindings, binding_count);
+        if (!binding) {
+            KWARN("%s:%u: Unknown setting '%.*s' in section '%.*s'.", source_name, line_number, KSV_ARG(key), KSV_ARG(section));
+            clean = FALSE;
+            continue;
+        }
+        if (!apply_value(binding, value)) {
+            KWARN("%s:%u: Invalid value '%.*s' for '%.*s'. Keeping the previous value.", source_name, line_number, KSV_ARG(value), KSV_ARG(key));
+            clean = FALSE;
+        }
+    }
+    return clean;
+}
+
+b8 config_load(const char* path, const config_binding* bindings, u32 binding_count) {
+    mapped_file file;
+    if (!platform_map_file(path, FILE_MAP_HINT_SEQUENTIAL, &file)) {
+        return FALSE;
+    }
+    config_parse(path, file.data, file.size, bindings, binding_count);
+    platform_unmap_file(&file);
+    return TRUE;
+}
+
+b8 config_watch(const char* path, const config_binding* bindings, u32 binding_count, u32* out_config_id) {
+    *out_config_id = INVALID_ID;
+    if (!is_initialized) {
+        return FALSE;
+    }
+
+    watched_config* config = 0;
+    for (u32 i = 0; i < MAX_WATCHED_CONFIGS; ++i) {
+        if (!state.configs[i].in_use) {
+            config = &state.configs[i];
+            *out_config_id = i;
+            break;
+        }
+    }
+    if (!config) {
+        KERROR("Too many config files are being watched. Unable to watch '%s'.", path);
+        return config_load(path, bindings, binding_count);
+    }
+
+    kzero_memory(config, sizeof(watched_config));
+    config->in_use = TRUE;
+    string_format(config->path, sizeof(config->path), "%s", path);
+    config->bindings = bindings;
+    config->binding_count = binding_count;
+
+    b8 loaded = config_load(path, bindings, binding_count);
+    config->watching = platform_watch_file(path, &config->watch_id);
+    if (!config->watching) {
+        KWARN("Unable to watch config file '%s', changes to it will not be picked up.", path);
+    }
+    return loaded;
+}
+
+void config_unwatch(u32 config_id) {
+    if (config_id >= MAX_WATCHED_CONFIGS || !state.configs[config_id].in_use) {
+        return;
+    }
+    watched_config* config = &state.configs[config_id];
+    if (config->watching) {
+        platform_unwatch_file(config->watch_id);
+    }
+    kzero_memory(config, sizeof(watched_config));
+}
+
+static b8 config_on_file_written(u16 code, void* sender, void* listener_inst, event_context context) {
+    for (u32 i = 0; i < MAX_WATCHED_CONFIGS; ++i) {
+        watched_config* config = &state.configs[i];
+        if (!config->in_use || !config->watching || config->watch_id != context.data.u32[0]) {
+            continue;
+        }
+
+        if (config_load(config->path, config->bindings, config->binding_count)) {
+            KINFO("Config file '%s' reloaded.", config->path);
+            event_context reloaded = {};
+            reloaded.data.u32[0] = i;
+            event_fire(EVENT_CODE_CONFIG_RELOADED, 0, reloaded);
+        }
+    }
+
+    // Not handled, other watchers may want the same event.
+    return FALSE;
+}
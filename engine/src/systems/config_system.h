@@ -0,0 +1,70 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+Config files are INI style:
+
+    ; Comments start with ';' or '#'.
+    [window]
+    width = 1280
+    name = "Kohi Engine Testbed"
+
+Each key a program cares about is bound to a field of one of its structs
+with a config_binding, and parsing writes straight into those fields. Keys
+with no binding, and values which do not parse, are reported and skipped,
+leaving the field as it was, so fields should hold their defaults first.
+*/
+
+typedef enum config_value_type {
+    // true/false, yes/no, on/off or 1/0. The field is a b8.
+    CONFIG_VALUE_BOOL,
+    CONFIG_VALUE_I16,
+    CONFIG_VALUE_I32,
+    CONFIG_VALUE_U32,
+    CONFIG_VALUE_F32,
+    // Copied into a char buffer of string_capacity bytes, truncating if needed.
+    CONFIG_VALUE_STRING,
+    // One of enum_names, stored as its index. The field is an enum (or a u32).
+    CONFIG_VALUE_ENUM,
+} config_value_type;
+
+typedef struct config_binding {
+    // The section the key is in, or 0 for keys before the first section.
+    const char* section;
+    const char* key;
+    config_value_type type;
+    void* target;
+    u32 string_capacity;
+    const char* const* enum_names;
+    u32 enum_count;
+} config_binding;
+
+b8 config_system_initialize();
+void config_system_shutdown();
+
+/**
+ * Parses config text into the bound fields in a single pass, without allocating.
+ * @param source_name The name used in warnings, usually the file path.
+ * @param text The text. Need not be terminated.
+ * @param length The length of the text in bytes.
+ * @returns TRUE if every line parsed; FALSE if anything was skipped.
+ */
+KAPI b8 config_parse(const char* source_name, const char* text, u64 length, const config_binding* bindings, u32 binding_count);
+
+/**
+ * Maps a config file and parses it into the bound fields.
+ * @returns TRUE if the file was read; otherwise FALSE.
+ */
+KAPI b8 config_load(const char* path, const config_binding* bindings, u32 binding_count);
+
+/**
+ * Loads a config file, then watches it and parses it again whenever it is
+ * written, firing EVENT_CODE_CONFIG_RELOADED afterwards. The bindings are
+ * not copied, and must stay valid until config_unwatch.
+ * @param out_config_id A pointer to hold the id the reload event carries.
+ * @returns TRUE if the file was loaded; otherwise FALSE. It is watched either way.
+ */
+KAPI b8 config_watch(const char* path, const config_binding* bindings, u32 binding_count, u32* out_config_id);
+
+KAPI void config_unwatch(u32 config_id);
@@ -0,0 +1,250 @@
+#include "ecs_scheduler.h"
+
+#include "containers/darray.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "systems/job_system.h"
+
+// Each system's chunks are split into about this many batches per thread.
+#define ECS_SCHEDULER_BATCHES_PER_THREAD 4
+
+typedef struct scheduled_system {
+    ecs_system_config config;
+    kname name;
+    u32 profiler_scope;
+    b8 enabled;
+    // The systems this one waits for, one bit each.
+    u64 dependencies;
+
+    // The chunks matched this frame. darray
+    ecs_view* views;
+    u32 batch_size;
+    // One per batch, so batches record without locking.
+    ecs_command_buffer* buffers;
+    u32 buffer_count;
+    // The number of buffers used this frame.
+    u32 batch_count;
+} scheduled_system;
+
+typedef struct ecs_scheduler_state {
+    scheduled_system systems[ECS_SCHEDULER_MAX_SYSTEMS];
+    u32 system_count;
+    u32 total_scope;
+
+    // For the frame being run, one bit per system.
+    u64 claimed;
+    u64 done;
+    f32 delta_time;
+} ecs_scheduler_state;
+
+static b8 is_initialized = FALSE;
+static ecs_scheduler_state state;
+
+b8 ecs_scheduler_initialize() {
+    if (is_initialized) {
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(ecs_scheduler_state));
+    state.total_scope = profiler_scope_register("ecs");
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void ecs_scheduler_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    for (u32 i = 0; i < state.system_count; ++i) {
+        scheduled_system* s = &state.systems[i];
+        for (u32 b = 0; b < s->buffer_count; ++b) {
+            ecs_command_buffer_destroy(&s->buffers[b]);
+        }
+        if (s->buffers) {
+            kfree(s->buffers, sizeof(ecs_command_buffer) * s->buffer_count, MEMORY_TAG_ENTITY);
+        }
+        darray_destroy(s->views);
+    }
+    kzero_memory(&state, sizeof(ecs_scheduler_state));
+    is_initialized = FALSE;
+}
+
+u32 ecs_scheduler_register(const ecs_system_config* config) {
+    if (!is_initialized) {
+        return INVALID_ID;
+    }
+    if (state.system_count == ECS_SCHEDULER_MAX_SYSTEMS) {
+        KERROR("ecs_scheduler_register: no room for system '%s', the limit is %u.", config->name, ECS_SCHEDULER_MAX_SYSTEMS);
+        return INVALID_ID;
+    }
+    if (!config->run) {
+        KERROR("ecs_scheduler_register: system '%s' has no run function.", config->name);
+        return INVALID_ID;
+    }
+
+    u32 index = state.system_count++;
+    scheduled_system* s = &state.systems[index];
+    kzero_memory(s, sizeof(scheduled_system));
+    s->config = *config;
+    s->config.reads |= config->query.all & ~config->writes;
+    s->name = kname_intern(config->name);
+    s->config.name = kname_string(s->name);
+    s->profiler_scope = profiler_scope_register(config->name);
+    s->enabled = TRUE;
+    s->views = darray_create(ecs_view);
+
+    // Reads can share with reads; anything else touching the same component must wait.
+    for (u32 i = 0; i < index; ++i) {
+        const ecs_system_config* earlier = &state.systems[i].config;
+        if ((earlier->writes & (s->config.reads | s->config.writes)) || (earlier->reads & s->config.writes)) {
+            s->dependencies |= 1ULL << i;
+        }
+    }
+    return index;
+}
+
+void ecs_scheduler_set_enabled(u32 system, b8 enabled) {
+    if (is_initialized && system < state.system_count) {
+        state.systems[system].enabled = enabled;
+    }
+}
+
+static void system_batch(void* context, u32 begin, u32 end) {
+    scheduled_system* s = context;
+    ecs_system_context system_context;
+    system_context.delta_time = state.delta_time;
+    system_context.commands = &s->buffers[begin / s->batch_size];
+    system_context.user_data = s->config.user_data;
+    for (u32 i = begin; i < end; ++i) {
+        s->config.run(&s->views[i], &system_context);
+    }
+}
+
+static void system_execute(u32 index) {
+    scheduled_system* s = &state.systems[index];
+    f64 start = clock_get_current_time();
+
+    // No structural changes happen until playback, so the matched chunks hold for the frame.
+    darray_clear(s->views);
+    ecs_iterator it = {0};
+    it.query = s->config.query;
+    while (ecs_query_next(&it)) {
+        darray_push(s->views, it.view);
+    }
+
+    u32 count = (u32)darray_length(s->views);
+    u32 target_batches = (job_system_thread_count() + 1) * ECS_SCHEDULER_BATCHES_PER_THREAD;
+    s->batch_size = count > target_batches ? (count + target_batches - 1) / target_batches : 1;
+    s->batch_count = (count + s->batch_size - 1) / s->batch_size;
+    if (s->batch_count > s->buffer_count) {
+        ecs_command_buffer* buffers = kallocate(sizeof(ecs_command_buffer) * s->batch_count, MEMORY_TAG_ENTITY);
+        if (s->buffers) {
+            kcopy_memory(buffers, s->buffers, sizeof(ecs_command_buffer) * s->buffer_count);
+            kfree(s->buffers, sizeof(ecs_command_buffer) * s->buffer_count, MEMORY_TAG_ENTITY);
+        }
+        for (u32 i = s->buffer_count; i < s->batch_count; ++i) {
+            ecs_command_buffer_create(&buffers[i]);
+        }
+        s->buffers = buffers;
+        s->buffer_count = s->batch_count;
+    }
+
+    job_system_parallel_for(system_batch, s, count, s->batch_size);
+
+    profiler_record(s->profiler_scope, clock_get_current_time() - start);
+    __atomic_or_fetch(&state.done, 1ULL << index, __ATOMIC_ACQ_REL);
+}
+
+// Unclaimed systems whose dependencies are all done.
+static u64 ready_systems() {
+    u64 done = __atomic_load_n(&state.done, __ATOMIC_ACQUIRE);
+    u64 claimed = __atomic_load_n(&state.claimed, __ATOMIC_ACQUIRE);
+    u64 ready = 0;
+    for (u32 i = 0; i < state.system_count; ++i) {
+        if (!(claimed & (1ULL << i)) && (state.systems[i].dependencies & ~done) == 0) {
+            ready |= 1ULL << i;
+        }
+    }
+    return ready;
+}
+
+// Claims and runs one ready system. Returns FALSE if none was left to claim.
+static b8 run_one_ready() {
+    for (;;) {
+        u64 ready = ready_systems();
+        if (!ready) {
+            return FALSE;
+        }
+        while (ready) {
+            u32 index = (u32)__builtin_ctzll(ready);
+            u64 bit = 1ULL << index;
+            if (!(__atomic_fetch_or(&state.claimed, bit, __ATOMIC_ACQ_REL) & bit)) {
+                system_execute(index);
+                return TRUE;
+            }
+            ready &= ~bit;
+        }
+    }
+}
+
+static void scheduler_drain();
+
+static void scheduler_participant(void* context, u32 begin, u32 end) {
+    if (run_one_ready()) {
+        scheduler_drain();
+    }
+}
+
+/*
+Runs ready systems until none are left. Whoever finishes a system looks
+again, so systems it unblocked are never missed. When several are ready at
+once, they fan out across the job system, one participant each, so
+independent systems run side by side.
+*/
+static void scheduler_drain() {
+    for (;;) {
+        u64 ready = ready_systems();
+        if (!ready) {
+            return;
+        }
+        u32 ready_count = (u32)__builtin_popcountll(ready);
+        if (ready_count > 1) {
+            job_system_parallel_for(scheduler_participant, 0, ready_count, 1);
+        } else {
+            run_one_ready();
+        }
+    }
+}
+
+void ecs_scheduler_run(f32 delta_time) {
+    if (!is_initialized || state.system_count == 0) {
+        return;
+    }
+    f64 start = clock_get_current_time();
+
+    // Disabled systems count as already done, so nothing waits on them.
+    u64 skipped = 0;
+    for (u32 i = 0; i < state.system_count; ++i) {
+        state.systems[i].batch_count = 0;
+        if (!state.systems[i].enabled) {
+            skipped |= 1ULL << i;
+        }
+    }
+    state.delta_time = delta_time;
+    state.done = skipped;
+    state.claimed = skipped;
+
+    scheduler_drain();
+
+    // In registration order, then batch order, so the result is the same however the work was split.
+    for (u32 i = 0; i < state.system_count; ++i) {
+        scheduled_system* s = &state.systems[i];
+        for (u32 b = 0; b < s->batch_count; ++b) {
+            ecs_command_buffer_playback(&s->buffers[b]);
+        }
+    }
+
+    profiler_record(state.total_scope, clock_get_current_time() - start);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "systems/ecs_system.h"
+
+/*
+Runs ECS systems each frame, concurrently where they can be. Each system
+declares the components it reads and writes; a system waits for every
+system registered before it which writes something it touches, or touches
+something it writes. Systems with no such conflict run at the same time,
+and each system's chunks are spread across the job system too.
+*/
+
+// The most systems which can be registered.
+#define ECS_SCHEDULER_MAX_SYSTEMS 64
+
+typedef struct ecs_system_context {
+    f32 delta_time;
+    /**
+     * Where structural changes are recorded. They are played back once
+     * every system has run, in registration order.
+     */
+    ecs_command_buffer* commands;
+    void* user_data;
+} ecs_system_context;
+
+/**
+ * Runs a system over one chunk matched by its query, from any thread.
+ * Only components declared as written may be written.
+ */
+typedef void (*pfn_ecs_system_run)(const ecs_view* view, const ecs_system_context* context);
+
+typedef struct ecs_system_config {
+    // Used for profiler timings and logging.
+    const char* name;
+    ecs_query query;
+    ecs_signature reads;
+    ecs_signature writes;
+    pfn_ecs_system_run run;
+    void* user_data;
+} ecs_system_config;
+
+b8 ecs_scheduler_initialize();
+void ecs_scheduler_shutdown();
+
+/**
+ * Registers a system. Components in the query's all set which are not
+ * written are treated as read.
+ * @returns The system's ID, or INVALID_ID if no more can be registered.
+ */
+KAPI u32 ecs_scheduler_register(const ecs_system_config* config);
+
+// Disabled systems are skipped, and nothing waits on them.
+KAPI void ecs_scheduler_set_enabled(u32 system, b8 enabled);
+
+/**
+ * Runs every enabled system once, then plays back their commands. Called
+ * once per frame by the application, after the game has updated.
+ */
+void ecs_scheduler_run(f32 delta_time);
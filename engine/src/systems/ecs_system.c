@@ -0,0 +1,589 @@
+#include "ecs_system.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/logger.h"
+#include "systems/job_system.h"
+
+// Chunks start on a cache line.
+#define ECS_CHUNK_ALIGNMENT 64
+// Columns start 16-byte aligned, so SIMD types (vec4, mat4) can be components.
+#define ECS_COLUMN_ALIGNMENT 16
+// The generation of handles returned by ecs_command_buffer_create_entity, whose
+// index is into the buffer's created entities. Live entities never have this bit.
+#define ECS_PENDING_GENERATION 0x80000000u
+
+typedef struct ecs_component_info {
+    kname name;
+    u32 size;
+} ecs_component_info;
+
+typedef struct ecs_chunk {
+    // ECS_CHUNK_SIZE bytes, aligned within block.
+    u8* memory;
+    void* block;
+    u32 count;
+} ecs_chunk;
+
+/*
+Chunk layout: an entity column, then one column per component with data,
+each holding chunk_capacity elements. Entities are kept packed, so only the
+last chunk is ever partly full.
+*/
+typedef struct ecs_archetype {
+    ecs_signature signature;
+    u32 component_count;
+    component_id components[ECS_MAX_COMPONENTS];
+    // Offset of each component's column in a chunk, by component_id.
+    u16 columns[ECS_MAX_COMPONENTS];
+    u32 chunk_capacity;
+    u32 count;
+    // darray
+    ecs_chunk* chunks;
+    // The archetype with a component added or removed, by component_id, once looked up.
+    u32 add_edges[ECS_MAX_COMPONENTS];
+    u32 remove_edges[ECS_MAX_COMPONENTS];
+} ecs_archetype;
+
+typedef struct ecs_record {
+    u32 generation;
+    // INVALID_ID while the record is free.
+    u32 archetype;
+    // The next free record, while free.
+    u32 chunk;
+    u32 row;
+} ecs_record;
+
+typedef struct ecs_system_state {
+    u32 capacity;
+    ecs_record* records;
+    u32 first_free_record;
+    u32 entity_count;
+
+    ecs_component_info components[ECS_MAX_COMPONENTS];
+    u32 component_count;
+
+    // darray of ecs_archetype*. The first has no components.
+    ecs_archetype** archetypes;
+} ecs_system_state;
+
+typedef enum ecs_command_type {
+    ECS_COMMAND_CREATE,
+    ECS_COMMAND_DESTROY,
+    ECS_COMMAND_ADD,
+    ECS_COMMAND_REMOVE
+} ecs_command_type;
+
+// Followed by data_size bytes of component data, then padding to 8 bytes.
+typedef struct ecs_command {
+    ecs_command_type type;
+    component_id component;
+    entity target;
+    u32 data_size;
+    u32 has_data;
+} ecs_command;
+
+typedef struct ecs_parallel_context {
+    const ecs_view* views;
+    pfn_ecs_view callback;
+    void* context;
+} ecs_parallel_context;
+
+static b8 is_initialized = FALSE;
+static ecs_system_state state;
+
+static u32 align_up(u32 value, u32 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static u32 archetype_create(ecs_signature signature) {
+    ecs_archetype* a = kallocate(sizeof(ecs_archetype), MEMORY_TAG_ENTITY);
+    a->signature = signature;
+    u32 data_size = 0;
+    for (u32 i = 0; i < state.component_count; ++i) {
+        if (signature & ECS_COMPONENT_BIT(i)) {
+            a->components[a->component_count++] = i;
+            data_size += state.components[i].size;
+        }
+    }
+    for (u32 i = 0; i < ECS_MAX_COMPONENTS; ++i) {
+        a->columns[i] = INVALID_ID_U16;
+        a->add_edges[i] = INVALID_ID;
+        a->remove_edges[i] = INVALID_ID;
+    }
+
+    // Start from the capacity which ignores alignment padding, then back off until it fits.
+    u32 capacity = ECS_CHUNK_SIZE / (sizeof(entity) + data_size);
+    while (capacity > 0) {
+        u32 offset = sizeof(entity) * capacity;
+        for (u32 i = 0; i < a->component_count; ++i) {
+            u32 size = state.components[a->components[i]].size;
+            offset = align_up(offset, ECS_COLUMN_ALIGNMENT);
+            a->columns[a->components[i]] = (u16)offset;
+            offset += size * capacity;
+        }
+        if (offset <= ECS_CHUNK_SIZE) {
+            break;
+        }
+        capacity--;
+    }
+    if (capacity == 0) {
+        KERROR("ecs: components totalling %u bytes do not fit in a chunk.", data_size);
+        kfree(a, sizeof(ecs_archetype), MEMORY_TAG_ENTITY);
+        return INVALID_ID;
+    }
+    a->chunk_capacity = capacity;
+    a->chunks = darray_create(ecs_chunk);
+
+    u32 index = (u32)darray_length(state.archetypes);
+    darray_push(state.archetypes, a);
+    return index;
+}
+
+static void archetype_destroy(ecs_archetype* a) {
+    u32 chunk_count = (u32)darray_length(a->chunks);
+    for (u32 i = 0; i < chunk_count; ++i) {
+        kfree(a->chunks[i].block, ECS_CHUNK_SIZE + ECS_CHUNK_ALIGNMENT, MEMORY_TAG_ENTITY);
+    }
+    darray_destroy(a->chunks);
+    kfree(a, sizeof(ecs_archetype), MEMORY_TAG_ENTITY);
+}
+
+static u32 archetype_find(ecs_signature signature) {
+    u32 count = (u32)darray_length(state.archetypes);
+    for (u32 i = 0; i < count; ++i) {
+        if (state.archetypes[i]->signature == signature) {
+            return i;
+        }
+    }
+    return archetype_create(signature);
+}
+
+// The archetype of an entity in archetype_index once the component is added, or removed.
+static u32 archetype_neighbour(u32 archetype_index, component_id component, b8 add) {
+    ecs_archetype* a = state.archetypes[archetype_index];
+    u32* edge = add ? &a->add_edges[component] : &a->remove_edges[component];
+    if (*edge == INVALID_ID) {
+        ecs_signature bit = ECS_COMPONENT_BIT(component);
+        *edge = archetype_find(add ? (a->signature | bit) : (a->signature & ~bit));
+    }
+    return *edge;
+}
+
+static u8* column_element(const ecs_archetype* a, const ecs_chunk* chunk, component_id component, u32 row) {
+    return chunk->memory + a->columns[component] + (u64)state.components[component].size * row;
+}
+
+// Appends an entity to an archetype, leaving its components uninitialized.
+static void archetype_push(u32 archetype_index, entity e, u32* out_chunk, u32* out_row) {
+    ecs_archetype* a = state.archetypes[archetype_index];
+    u32 chunk_count = (u32)darray_length(a->chunks);
+    if (chunk_count == 0 || a->chunks[chunk_count - 1].count == a->chunk_capacity) {
+        ecs_chunk chunk;
+        chunk.block = kallocate(ECS_CHUNK_SIZE + ECS_CHUNK_ALIGNMENT, MEMORY_TAG_ENTITY);
+        chunk.memory = (u8*)(((u64)chunk.block + ECS_CHUNK_ALIGNMENT - 1) & ~(u64)(ECS_CHUNK_ALIGNMENT - 1));
+        chunk.count = 0;
+        darray_push(a->chunks, chunk);
+        chunk_count++;
+    }
+    ecs_chunk* chunk = &a->chunks[chunk_count - 1];
+    ((entity*)chunk->memory)[chunk->count] = e;
+    *out_chunk = chunk_count - 1;
+    *out_row = chunk->count;
+    chunk->count++;
+    a->count++;
+}
+
+// Removes a row by moving the archetype's last entity into it, keeping chunks packed.
+static void archetype_remove(u32 archetype_index, u32 chunk_index, u32 row) {
+    ecs_archetype* a = state.archetypes[archetype_index];
+    u32 last_chunk_index = (u32)darray_length(a->chunks) - 1;
+    ecs_chunk* last = &a->chunks[last_chunk_index];
+    u32 last_row = last->count - 1;
+
+    if (chunk_index != last_chunk_index || row != last_row) {
+        ecs_chunk* chunk = &a->chunks[chunk_index];
+        entity moved = ((entity*)last->memory)[last_row];
+        ((entity*)chunk->memory)[row] = moved;
+        for (u32 i = 0; i < a->component_count; ++i) {
+            component_id c = a->components[i];
+            kcopy_memory(column_element(a, chunk, c, row), column_element(a, last, c, last_row), state.components[c].size);
+        }
+        state.records[moved.index].chunk = chunk_index;
+        state.records[moved.index].row = row;
+    }
+
+    last->count--;
+    a->count--;
+    if (last->count == 0) {
+        kfree(last->block, ECS_CHUNK_SIZE + ECS_CHUNK_ALIGNMENT, MEMORY_TAG_ENTITY);
+        ecs_chunk popped;
+        darray_pop(a->chunks, &popped);
+    }
+}
+
+// Moves an entity to another archetype, carrying over the components both have.
+static void entity_move(entity e, u32 to) {
+    ecs_record* record = &state.records[e.index];
+    ecs_archetype* src = state.archetypes[record->archetype];
+    ecs_archetype* dst = state.archetypes[to];
+
+    u32 chunk_index, row;
+    archetype_push(to, e, &chunk_index, &row);
+    const ecs_chunk* src_chunk = &src->chunks[record->chunk];
+    const ecs_chunk* dst_chunk = &dst->chunks[chunk_index];
+    for (u32 i = 0; i < dst->component_count; ++i) {
+        component_id c = dst->components[i];
+        if (src->signature & ECS_COMPONENT_BIT(c)) {
+            kcopy_memory(column_element(dst, dst_chunk, c, row), column_element(src, src_chunk, c, record->row), state.components[c].size);
+        }
+    }
+
+    archetype_remove(record->archetype, record->chunk, record->row);
+    record->archetype = to;
+    record->chunk = chunk_index;
+    record->row = row;
+}
+
+b8 ecs_system_initialize(u32 max_entity_count) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    if (max_entity_count == 0 || max_entity_count == INVALID_ID) {
+        KERROR("ecs_system_initialize requires a max_entity_count above zero.");
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(ecs_system_state));
+    state.capacity = max_entity_count;
+    state.records = kallocate(sizeof(ecs_record) * max_entity_count, MEMORY_TAG_ENTITY);
+    for (u32 i = 0; i < max_entity_count; ++i) {
+        state.records[i].generation = 0;
+        state.records[i].archetype = INVALID_ID;
+        state.records[i].chunk = i + 1 < max_entity_count ? i + 1 : INVALID_ID;
+    }
+    state.first_free_record = 0;
+
+    state.archetypes = darray_create(ecs_archetype*);
+    archetype_create(0);
+
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void ecs_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    u32 archetype_count = (u32)darray_length(state.archetypes);
+    for (u32 i = 0; i < archetype_count; ++i) {
+        archetype_destroy(state.archetypes[i]);
+    }
+    darray_destroy(state.archetypes);
+    kfree(state.records, sizeof(ecs_record) * state.capacity, MEMORY_TAG_ENTITY);
+    kzero_memory(&state, sizeof(ecs_system_state));
+    is_initialized = FALSE;
+}
+
+component_id ecs_component_register(const char* name, u32 size) {
+    if (!is_initialized) {
+        return INVALID_ID;
+    }
+    if (state.component_count == ECS_MAX_COMPONENTS) {
+        KERROR("ecs_component_register: no room for component '%s', the limit is %u.", name, ECS_MAX_COMPONENTS);
+        return INVALID_ID;
+    }
+    if (size > ECS_CHUNK_SIZE / 2) {
+        KERROR("ecs_component_register: component '%s' is %u bytes, the limit is %u.", name, size, ECS_CHUNK_SIZE / 2);
+        return INVALID_ID;
+    }
+    component_id id = state.component_count++;
+    state.components[id].name = kname_intern(name);
+    state.components[id].size = size;
+    return id;
+}
+
+entity ecs_entity_create() {
+    entity e = {0};
+    if (!is_initialized) {
+        return e;
+    }
+    if (state.first_free_record == INVALID_ID) {
+        KERROR("ecs_entity_create: all %u entities are in use.", state.capacity);
+        return e;
+    }
+    e.index = state.first_free_record;
+    ecs_record* record = &state.records[e.index];
+    state.first_free_record = record->chunk;
+
+    // Skip generation 0 when wrapping, so zeroed handles stay invalid, and
+    // wrap before the pending bit, so live and pending handles never collide.
+    record->generation = (record->generation + 1) & ~ECS_PENDING_GENERATION;
+    if (record->generation == 0) {
+        record->generation = 1;
+    }
+    e.generation = record->generation;
+    record->archetype = 0;
+    archetype_push(0, e, &record->chunk, &record->row);
+    state.entity_count++;
+    return e;
+}
+
+b8 ecs_entity_is_valid(entity e) {
+    return is_initialized && e.generation != 0 && e.index < state.capacity &&
+           state.records[e.index].generation == e.generation && state.records[e.index].archetype != INVALID_ID;
+}
+
+void ecs_entity_destroy(entity e) {
+    if (!ecs_entity_is_valid(e)) {
+        return;
+    }
+    ecs_record* record = &state.records[e.index];
+    archetype_remove(record->archetype, record->chunk, record->row);
+    record->archetype = INVALID_ID;
+    record->chunk = state.first_free_record;
+    state.first_free_record = e.index;
+    state.entity_count--;
+}
+
+b8 ecs_component_add(entity e, component_id component, const void* data) {
+    if (!ecs_entity_is_valid(e) || component >= state.component_count) {
+        return FALSE;
+    }
+    ecs_record* record = &state.records[e.index];
+    if (!(state.archetypes[record->archetype]->signature & ECS_COMPONENT_BIT(component))) {
+        u32 to = archetype_neighbour(record->archetype, component, TRUE);
+        if (to == INVALID_ID) {
+            return FALSE;
+        }
+        entity_move(e, to);
+    }
+
+    u32 size = state.components[component].size;
+    if (size) {
+        ecs_archetype* a = state.archetypes[record->archetype];
+        u8* element = column_element(a, &a->chunks[record->chunk], component, record->row);
+        if (data) {
+            kcopy_memory(element, data, size);
+        } else {
+            kzero_memory(element, size);
+        }
+    }
+    return TRUE;
+}
+
+void ecs_component_remove(entity e, component_id component) {
+    if (!ecs_component_has(e, component)) {
+        return;
+    }
+    // Removing a component always leads to an archetype with fewer, so it can't fail.
+    entity_move(e, archetype_neighbour(state.records[e.index].archetype, component, FALSE));
+}
+
+b8 ecs_component_has(entity e, component_id component) {
+    if (!ecs_entity_is_valid(e) || component >= state.component_count) {
+        return FALSE;
+    }
+    return (state.archetypes[state.records[e.index].archetype]->signature & ECS_COMPONENT_BIT(component)) != 0;
+}
+
+void* ecs_component_get(entity e, component_id component) {
+    if (!ecs_component_has(e, component) || state.components[component].size == 0) {
+        return 0;
+    }
+    const ecs_record* record = &state.records[e.index];
+    const ecs_archetype* a = state.archetypes[record->archetype];
+    return column_element(a, &a->chunks[record->chunk], component, record->row);
+}
+
+u32 ecs_entity_count() {
+    return state.entity_count;
+}
+
+static b8 query_matches(const ecs_query* query, ecs_signature signature) {
+    return (signature & query->all) == query->all && (signature & query->none) == 0;
+}
+
+b8 ecs_query_next(ecs_iterator* iterator) {
+    if (!is_initialized) {
+        return FALSE;
+    }
+    u32 archetype_count = (u32)darray_length(state.archetypes);
+    while (iterator->archetype_index < archetype_count) {
+        const ecs_archetype* a = state.archetypes[iterator->archetype_index];
+        if (query_matches(&iterator->query, a->signature) && iterator->chunk_index < darray_length(a->chunks)) {
+            const ecs_chunk* chunk = &a->chunks[iterator->chunk_index];
+            iterator->view.count = chunk->count;
+            iterator->view.entities = (const entity*)chunk->memory;
+            iterator->view.archetype = a;
+            iterator->view.memory = chunk->memory;
+            iterator->chunk_index++;
+            return TRUE;
+        }
+        iterator->archetype_index++;
+        iterator->chunk_index = 0;
+    }
+    return FALSE;
+}
+
+static void parallel_views(void* context, u32 begin, u32 end) {
+    ecs_parallel_context* p = context;
+    for (u32 i = begin; i < end; ++i) {
+        p->callback(&p->views[i], p->context);
+    }
+}
+
+void ecs_query_each_parallel(ecs_query query, pfn_ecs_view callback, void* context) {
+    ecs_view* views = darray_create(ecs_view);
+    ecs_iterator it = {0};
+    it.query = query;
+    while (ecs_query_next(&it)) {
+        darray_push(views, it.view);
+    }
+
+    // Chunks are big enough to be a batch each.
+    ecs_parallel_context p = {views, callback, context};
+    job_system_parallel_for(parallel_views, &p, (u32)darray_length(views), 1);
+    darray_destroy(views);
+}
+
+u32 ecs_query_count(ecs_query query) {
+    if (!is_initialized) {
+        return 0;
+    }
+    u32 count = 0;
+    u32 archetype_count = (u32)darray_length(state.archetypes);
+    for (u32 i = 0; i < archetype_count; ++i) {
+        if (query_matches(&query, state.archetypes[i]->signature)) {
+            count += state.archetypes[i]->count;
+        }
+    }
+    return count;
+}
+
+void* ecs_view_column(const ecs_view* view, component_id component) {
+    if (component >= ECS_MAX_COMPONENTS || !(view->archetype->signature & ECS_COMPONENT_BIT(component)) ||
+        state.components[component].size == 0) {
+        return 0;
+    }
+    return view->memory + view->archetype->columns[component];
+}
+
+void ecs_command_buffer_create(ecs_command_buffer* out_buffer) {
+    kzero_memory(out_buffer, sizeof(ecs_command_buffer));
+}
+
+void ecs_command_buffer_destroy(ecs_command_buffer* buffer) {
+    if (buffer->data) {
+        kfree(buffer->data, buffer->capacity, MEMORY_TAG_ENTITY);
+    }
+    kzero_memory(buffer, sizeof(ecs_command_buffer));
+}
+
+static void command_push(ecs_command_buffer* buffer, ecs_command_type type, entity target, component_id component, const void* data, u32 data_size) {
+    u64 record_size = (sizeof(ecs_command) + data_size + 7) & ~7ULL;
+    if (buffer->size + record_size > buffer->capacity) {
+        u64 capacity = buffer->capacity ? buffer->capacity : 1024;
+        while (buffer->size + record_size > capacity) {
+            capacity *= 2;
+        }
+        u8* data_new = kallocate(capacity, MEMORY_TAG_ENTITY);
+        if (buffer->data) {
+            kcopy_memory(data_new, buffer->data, buffer->size);
+            kfree(buffer->data, buffer->capacity, MEMORY_TAG_ENTITY);
+        }
+        buffer->data = data_new;
+        buffer->capacity = capacity;
+    }
+
+    ecs_command* command = (ecs_command*)(buffer->data + buffer->size);
+    command->type = type;
+    command->component = component;
+    command->target = target;
+    command->data_size = data_size;
+    command->has_data = data != 0;
+    if (data) {
+        kcopy_memory(command + 1, data, data_size);
+    }
+    buffer->size += record_size;
+}
+
+entity ecs_command_buffer_create_entity(ecs_command_buffer* buffer) {
+    entity pending = {buffer->pending_count++, ECS_PENDING_GENERATION};
+    command_push(buffer, ECS_COMMAND_CREATE, pending, INVALID_ID, 0, 0);
+    return pending;
+}
+
+// A zeroed handle is never an entity, live or pending, so recording one is a caller bug.
+static b8 command_target_valid(const char* function, entity e) {
+    if (e.generation == 0) {
+        KERROR("%s: entity handle is zeroed.", function);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void ecs_command_buffer_destroy_entity(ecs_command_buffer* buffer, entity e) {
+    if (!command_target_valid("ecs_command_buffer_destroy_entity", e)) {
+        return;
+    }
+    command_push(buffer, ECS_COMMAND_DESTROY, e, INVALID_ID, 0, 0);
+}
+
+void ecs_command_buffer_add_component(ecs_command_buffer* buffer, entity e, component_id component, const void* data) {
+    if (!command_target_valid("ecs_command_buffer_add_component", e)) {
+        return;
+    }
+    if (component >= state.component_count) {
+        KERROR("ecs_command_buffer_add_component: unknown component %u.", component);
+        return;
+    }
+    command_push(buffer, ECS_COMMAND_ADD, e, component, data, data ? state.components[component].size : 0);
+}
+
+void ecs_command_buffer_remove_component(ecs_command_buffer* buffer, entity e, component_id component) {
+    if (!command_target_valid("ecs_command_buffer_remove_component", e)) {
+        return;
+    }
+    command_push(buffer, ECS_COMMAND_REMOVE, e, component, 0, 0);
+}
+
+void ecs_command_buffer_playback(ecs_command_buffer* buffer) {
+    // The entities created so far, indexed by their pending handles.
+    entity* created = 0;
+    if (buffer->pending_count) {
+        created = kallocate(sizeof(entity) * buffer->pending_count, MEMORY_TAG_ENTITY);
+    }
+
+    u64 offset = 0;
+    while (offset < buffer->size) {
+        const ecs_command* command = (const ecs_command*)(buffer->data + offset);
+        offset += (sizeof(ecs_command) + command->data_size + 7) & ~7ULL;
+
+        entity target = command->target;
+        if (target.generation == ECS_PENDING_GENERATION && command->type != ECS_COMMAND_CREATE) {
+            target = target.index < buffer->pending_count ? created[target.index] : (entity){0};
+        }
+        switch (command->type) {
+            case ECS_COMMAND_CREATE:
+                created[target.index] = ecs_entity_create();
+                break;
+            case ECS_COMMAND_DESTROY:
+                ecs_entity_destroy(target);
+                break;
+            case ECS_COMMAND_ADD:
+                ecs_component_add(target, command->component, command->has_data ? (const void*)(command + 1) : 0);
+                break;
+            case ECS_COMMAND_REMOVE:
+                ecs_component_remove(target, command->component);
+                break;
+        }
+    }
+
+    if (created) {
+        kfree(created, sizeof(entity) * buffer->pending_count, MEMORY_TAG_ENTITY);
+    }
+    buffer->size = 0;
+    buffer->pending_count = 0;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+An archetype entity component system. Entities with the same set of
+components share an archetype, whose component data lives in 16 KiB chunks,
+one contiguous column per component, so queries walk memory linearly.
+
+Structural changes (creating and destroying entities, adding and removing
+components) move entities between chunks. They must happen on the main
+thread and never while a query is being iterated; elsewhere, record them in
+a command buffer and play it back once iteration is done.
+*/
+
+// The size of each chunk of component data, in bytes.
+#define ECS_CHUNK_SIZE 16384
+// The most component types which can be registered, one bit each in a signature.
+#define ECS_MAX_COMPONENTS 64
+
+/**
+ * An entity. Like resource handles, handles go stale once their entity is
+ * destroyed; generation 0 is never handed out, so a zeroed handle is invalid.
+ */
+typedef struct entity {
+    u32 index;
+    u32 generation;
+} entity;
+
+typedef u32 component_id;
+
+// A set of components, one bit per component_id.
+typedef u64 ecs_signature;
+
+#define ECS_COMPONENT_BIT(id) (1ULL << (id))
+
+/**
+ * Matches every archetype which has all components in all and none of the
+ * components in none.
+ */
+typedef struct ecs_query {
+    ecs_signature all;
+    ecs_signature none;
+} ecs_query;
+
+/**
+ * The entities of one chunk matched by a query. Component columns are
+ * fetched with ecs_view_column, and hold count elements each.
+ */
+typedef struct ecs_view {
+    u32 count;
+    const entity* entities;
+    const struct ecs_archetype* archetype;
+    u8* memory;
+} ecs_view;
+
+// Steps through the chunks matched by a query. Zero it, set query, then call ecs_query_next.
+typedef struct ecs_iterator {
+    ecs_query query;
+    u32 archetype_index;
+    u32 chunk_index;
+    ecs_view view;
+} ecs_iterator;
+
+/**
+ * Called for each chunk of a parallel query, from any thread.
+ * Component data may be written, but structural changes must go through a
+ * command buffer.
+ */
+typedef void (*pfn_ecs_view)(const ecs_view* view, void* context);
+
+/**
+ * Structural changes, recorded to be made later by ecs_command_buffer_playback.
+ * Each thread should record into a buffer of its own.
+ */
+typedef struct ecs_command_buffer {
+    u8* data;
+    u64 size;
+    u64 capacity;
+    // Entities created by this buffer so far, before playback.
+    u32 pending_count;
+} ecs_command_buffer;
+
+/**
+ * Reserves storage for entity records.
+ * @param max_entity_count The most entities which can exist at once.
+ */
+b8 ecs_system_initialize(u32 max_entity_count);
+void ecs_system_shutdown();
+
+/**
+ * Registers a component type. Components are plain data, copied by value
+ * when entities move between archetypes. A size of zero makes a tag, which
+ * can be queried but holds no data.
+ * @param name A name to log the component by.
+ * @param size The size of the component, in bytes.
+ * @returns The component's ID, or INVALID_ID if no more can be registered.
+ */
+KAPI component_id ecs_component_register(const char* name, u32 size);
+
+// Creates an entity without components.
+KAPI entity ecs_entity_create();
+KAPI void ecs_entity_destroy(entity e);
+KAPI b8 ecs_entity_is_valid(entity e);
+
+/**
+ * Adds a component to an entity, or overwrites it if already present.
+ * @param data The value of the component, or 0 to zero it.
+ * @returns FALSE if the entity or component is invalid.
+ */
+KAPI b8 ecs_component_add(entity e, component_id component, const void* data);
+KAPI void ecs_component_remove(entity e, component_id component);
+KAPI b8 ecs_component_has(entity e, component_id component);
+
+/**
+ * The entity's component, or 0 if it has none, or the component is a tag.
+ * The pointer is only valid until the next structural change.
+ */
+KAPI void* ecs_component_get(entity e, component_id component);
+
+// The number of entities alive.
+KAPI u32 ecs_entity_count();
+
+/**
+ * Advances to the next chunk matched by the iterator's query.
+ * @returns FALSE once there are no more.
+ */
+KAPI b8 ecs_query_next(ecs_iterator* iterator);
+
+/**
+ * Runs callback for each matching chunk, spread across the job system,
+ * and returns once all have run.
+ */
+KAPI void ecs_query_each_parallel(ecs_query query, pfn_ecs_view callback, void* context);
+
+// The number of entities matched by a query.
+KAPI u32 ecs_query_count(ecs_query query);
+
+/**
+ * A component's column in a view, holding view->count elements,
+ * or 0 if the view's archetype does not have it.
+ */
+KAPI void* ecs_view_column(const ecs_view* view, component_id component);
+
+KAPI void ecs_command_buffer_create(ecs_command_buffer* out_buffer);
+KAPI void ecs_command_buffer_destroy(ecs_command_buffer* buffer);
+
+/**
+ * Records the creation of an entity. The returned handle has a generation
+ * reserved for pending entities, so it is not a live entity, but it may be
+ * passed to the other record functions of the same buffer to act on the
+ * entity once it exists. Zeroed handles are rejected by every record function.
+ */
+KAPI entity ecs_command_buffer_create_entity(ecs_command_buffer* buffer);
+KAPI void ecs_command_buffer_destroy_entity(ecs_command_buffer* buffer, entity e);
+// The data is copied into the buffer; pass 0 to zero the component.
+KAPI void ecs_command_buffer_add_component(ecs_command_buffer* buffer, entity e, component_id component, const void* data);
+KAPI void ecs_command_buffer_remove_component(ecs_command_buffer* buffer, entity e, component_id component);
+
+/**
+ * Makes the recorded changes, in the order they were recorded, then empties
+ * the buffer. Main thread only, with no query being iterated. Changes to
+ * entities which have since been destroyed are skipped.
+ */
+KAPI void ecs_command_buffer_playback(ecs_command_buffer* buffer);
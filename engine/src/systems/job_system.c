@@ -0,0 +1,347 @@
+#include "job_system.h"
+
+#include "core/kmemory.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kthread.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// The number of jobs which can be queued, running or waiting for their callbacks at once.
+#define JOB_QUEUE_CAPACITY 1024
+#define MAX_JOB_THREADS 15
+
+typedef struct job_result_entry {
+    job_info info;
+    b8 success;
+} job_result_entry;
+
+typedef struct job_system_state {
+    kthread threads[MAX_JOB_THREADS];
+    u32 thread_count;
+
+    // Guards everything below.
+    kmutex mutex;
+    // Counts the jobs in the queue; workers sleep on it.
+    ksemaphore job_semaphore;
+    b8 running;
+
+    job_info queue[JOB_QUEUE_CAPACITY];
+    u32 queue_head;
+    u32 queue_count;
+
+    job_result_entry results[JOB_QUEUE_CAPACITY];
+    u32 results_head;
+    u32 results_count;
+
+    // Jobs submitted whose callbacks have not been dispatched yet. Bounds both rings.
+    u32 outstanding;
+} job_system_state;
+
+/*
+A parallel_for shared between its caller and the helper jobs it queues.
+Helpers may only start once the loop is done, so the last of the caller and
+the helpers to let go of it frees it.
+*/
+typedef struct parallel_for_task {
+    pfn_job_range range;
+    void* context;
+    u32 count;
+    u32 batch_size;
+    // The next index to be claimed.
+    u32 next;
+    // Items whose batch has run.
+    u32 completed;
+    // The caller, plus every helper queued.
+    u32 references;
+} parallel_for_task;
+
+static b8 is_initialized = FALSE;
+static job_system_state state;
+
+static b8 parallel_for_help(void* params, void* result_data);
+
+static void free_job(job_info* info) {
+    if (info->param_data) {
+        kfree(info->param_data, info->param_data_size, MEMORY_TAG_JOB);
+    }
+    if (info->result_data) {
+        kfree(info->result_data, info->result_data_size, MEMORY_TAG_JOB);
+    }
+}
+
+static u32 job_thread_run(void* params) {
+    for (;;) {
+        ksemaphore_wait(&state.job_semaphore, 0);
+
+        kmutex_lock(&state.mutex);
+        if (state.queue_count == 0) {
+            b8 running = state.running;
+            kmutex_unlock(&state.mutex);
+            if (!running) {
+                break;
+            }
+            continue;
+        }
+        job_info info = state.queue[state.queue_head];
+        state.queue_head = (state.queue_head + 1) % JOB_QUEUE_CAPACITY;
+        state.queue_count--;
+        kmutex_unlock(&state.mutex);
+
+        b8 success = info.entry_point(info.param_data, info.result_data);
+
+        // parallel_for helpers have no callbacks to dispatch.
+        if (info.entry_point == parallel_for_help) {
+            continue;
+        }
+
+        kmutex_lock(&state.mutex);
+        job_result_entry* entry = &state.results[(state.results_head + state.results_count) % JOB_QUEUE_CAPACITY];
+        entry->info = info;
+        entry->success = success;
+        state.results_count++;
+        kmutex_unlock(&state.mutex);
+    }
+    return 0;
+}
+
+b8 job_system_initialize(u8 max_job_thread_count) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    kzero_memory(&state, sizeof(job_system_state));
+
+    // Leave a core for the main thread.
+    i32 thread_count = platform_get_processor_count() - 1;
+    if (thread_count > max_job_thread_count) {
+        thread_count = max_job_thread_count;
+    }
+    if (thread_count > MAX_JOB_THREADS) {
+        thread_count = MAX_JOB_THREADS;
+    }
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+
+    if (!kmutex_create(&state.mutex)) {
+        KERROR("Failed to create the job system mutex.");
+        return FALSE;
+    }
+    if (!ksemaphore_create(&state.job_semaphore, 0)) {
+        KERROR("Failed to create the job system semaphore.");
+        kmutex_destroy(&state.mutex);
+        return FALSE;
+    }
+
+    state.running = TRUE;
+    for (i32 i = 0; i < thread_count; ++i) {
+        if (!kthread_create(job_thread_run, 0, &state.threads[i])) {
+            KERROR("Failed to create job thread %i.", i);
+            break;
+        }
+        state.thread_count++;
+    }
+    if (state.thread_count == 0) {
+        ksemaphore_destroy(&state.job_semaphore);
+        kmutex_destroy(&state.mutex);
+        return FALSE;
+    }
+
+    KINFO("Job system started with %u threads.", state.thread_count);
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void job_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+
+    // Workers only exit once the queue is empty, so everything queued still runs.
+    kmutex_lock(&state.mutex);
+    state.running = FALSE;
+    kmutex_unlock(&state.mutex);
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        ksemaphore_signal(&state.job_semaphore);
+    }
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        kthread_wait(&state.threads[i]);
+    }
+
+    // Let the owners of the finished jobs release whatever they produced.
+    job_system_update();
+
+    ksemaphore_destroy(&state.job_semaphore);
+    kmutex_destroy(&state.mutex);
+    is_initialized = FALSE;
+}
+
+void job_system_update() {
+    if (!is_initialized || state.outstanding == 0) {
+        return;
+    }
+
+    // Callbacks run outside the lock, since they may well submit more jobs.
+    for (;;) {
+        kmutex_lock(&state.mutex);
+        if (state.results_count == 0) {
+            kmutex_unlock(&state.mutex);
+            break;
+        }
+        job_result_entry entry = state.results[state.results_head];
+        state.results_head = (state.results_head + 1) % JOB_QUEUE_CAPACITY;
+        state.results_count--;
+        kmutex_unlock(&state.mutex);
+
+        state.outstanding--;
+        pfn_job_on_complete callback = entry.success ? entry.info.on_success : entry.info.on_fail;
+        if (callback) {
+            callback(entry.info.result_data);
+        }
+        free_job(&entry.info);
+    }
+}
+
+job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size) {
+    job_info info;
+    info.entry_point = entry_point;
+    info.on_success = on_success;
+    info.on_fail = on_fail;
+
+    info.param_data_size = param_data_size;
+    info.param_data = 0;
+    if (param_data_size) {
+        info.param_data = kallocate(param_data_size, MEMORY_TAG_JOB);
+        if (param_data) {
+            kcopy_memory(info.param_data, param_data, param_data_size);
+        }
+    }
+
+    info.result_data_size = result_data_size;
+    info.result_data = 0;
+    if (result_data_size) {
+        info.result_data = kallocate(result_data_size, MEMORY_TAG_JOB);
+    }
+    return info;
+}
+
+b8 job_system_submit(job_info info) {
+    if (!is_initialized || !state.running) {
+        KERROR("job_system_submit called while the job system is not running.");
+        free_job(&info);
+        return FALSE;
+    }
+    if (state.outstanding >= JOB_QUEUE_CAPACITY) {
+        KERROR("job_system_submit: the job queue is full (%u jobs).", JOB_QUEUE_CAPACITY);
+        free_job(&info);
+        return FALSE;
+    }
+
+    kmutex_lock(&state.mutex);
+    if (state.queue_count >= JOB_QUEUE_CAPACITY) {
+        // Only possible while parallel_for helpers fill the queue.
+        kmutex_unlock(&state.mutex);
+        KERROR("job_system_submit: the job queue is full (%u jobs).", JOB_QUEUE_CAPACITY);
+        free_job(&info);
+        return FALSE;
+    }
+    state.queue[(state.queue_head + state.queue_count) % JOB_QUEUE_CAPACITY] = info;
+    state.queue_count++;
+    kmutex_unlock(&state.mutex);
+    state.outstanding++;
+
+    ksemaphore_signal(&state.job_semaphore);
+    return TRUE;
+}
+
+u32 job_system_thread_count() {
+    return state.thread_count;
+}
+
+static void parallel_for_run(parallel_for_task* task) {
+    for (;;) {
+        u32 begin = __atomic_fetch_add(&task->next, task->batch_size, __ATOMIC_RELAXED);
+        if (begin >= task->count) {
+            break;
+        }
+        u32 end = begin + task->batch_size < task->count ? begin + task->batch_size : task->count;
+        task->range(task->context, begin, end);
+        __atomic_fetch_add(&task->completed, end - begin, __ATOMIC_RELEASE);
+    }
+}
+
+static void parallel_for_release(parallel_for_task* task) {
+    if (__atomic_sub_fetch(&task->references, 1, __ATOMIC_ACQ_REL) == 0) {
+        kfree(task, sizeof(parallel_for_task), MEMORY_TAG_JOB);
+    }
+}
+
+static b8 parallel_for_help(void* params, void* result_data) {
+    parallel_for_task* task = params;
+    parallel_for_run(task);
+    parallel_for_release(task);
+    return TRUE;
+}
+
+void job_system_parallel_for(pfn_job_range range, void* context, u32 count, u32 batch_size) {
+    if (count == 0) {
+        return;
+    }
+    u32 thread_count = is_initialized && state.running ? state.thread_count : 0;
+    if (batch_size == 0) {
+        // A few batches per thread, so uneven batches even out.
+        u32 batch_count = (thread_count + 1) * 4;
+        batch_size = (count + batch_count - 1) / batch_count;
+    }
+    u32 batch_count = (count + batch_size - 1) / batch_size;
+
+    if (thread_count == 0 || batch_count < 2) {
+        // Still batch by batch, as callers may index per-batch results by begin / batch_size.
+        for (u32 begin = 0; begin < count; begin += batch_size) {
+            range(context, begin, count - begin < batch_size ? count : begin + batch_size);
+        }
+        return;
+    }
+
+    parallel_for_task* task = kallocate(sizeof(parallel_for_task), MEMORY_TAG_JOB);
+    task->range = range;
+    task->context = context;
+    task->count = count;
+    task->batch_size = batch_size;
+    task->next = 0;
+    task->completed = 0;
+
+    // The caller takes a batch too, so one helper fewer than batches is enough.
+    u32 helper_count = batch_count - 1 < thread_count ? batch_count - 1 : thread_count;
+    task->references = 1 + helper_count;
+
+    // Helpers go in the job queue directly, skipping job_create's copies and the callback bookkeeping.
+    job_info helper = {};
+    helper.entry_point = parallel_for_help;
+    helper.param_data = task;
+    u32 queued = 0;
+    kmutex_lock(&state.mutex);
+    for (; queued < helper_count && state.queue_count < JOB_QUEUE_CAPACITY; ++queued) {
+        state.queue[(state.queue_head + state.queue_count) % JOB_QUEUE_CAPACITY] = helper;
+        state.queue_count++;
+    }
+    kmutex_unlock(&state.mutex);
+    if (queued < helper_count) {
+        __atomic_sub_fetch(&task->references, helper_count - queued, __ATOMIC_RELAXED);
+    }
+    for (u32 i = 0; i < queued; ++i) {
+        ksemaphore_signal(&state.job_semaphore);
+    }
+
+    parallel_for_run(task);
+
+    // Whatever is left is already running on workers, and is short.
+    u32 spins = 0;
+    while (__atomic_load_n(&task->completed, __ATOMIC_ACQUIRE) < count) {
+        if (++spins > 1024) {
+            platform_sleep(0);
+        }
+    }
+
+    parallel_for_release(task);
+}
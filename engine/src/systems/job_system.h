@@ -0,0 +1,95 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Runs work on a pool of worker threads. A job's entry point runs on a
+ * worker; its completion callback runs later on the main thread, during
+ * job_system_update, so it is free to touch engine state.
+ */
+
+/**
+ * A job's entry point. Runs on a worker thread.
+ * @param params The job's parameter data.
+ * @param result_data Where the job writes its result. Handed to the completion callback.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+typedef b8 (*pfn_job_start)(void* params, void* result_data);
+
+/**
+ * Invoked on the main thread once a job has finished.
+ * @param result_data The result written by the job.
+ */
+typedef void (*pfn_job_on_complete)(void* result_data);
+
+/**
+ * A range of a parallel loop. Runs on a worker thread or the calling thread.
+ * @param context The context passed to job_system_parallel_for.
+ * @param begin The first index of the range.
+ * @param end One past the last index of the range.
+ */
+typedef void (*pfn_job_range)(void* context, u32 begin, u32 end);
+
+typedef struct job_info {
+    pfn_job_start entry_point;
+    // Invoked if the entry point returned TRUE. Optional.
+    pfn_job_on_complete on_success;
+    // Invoked if the entry point returned FALSE. Optional.
+    pfn_job_on_complete on_fail;
+
+    // Owned by the job system once submitted.
+    void* param_data;
+    u32 param_data_size;
+    void* result_data;
+    u32 result_data_size;
+} job_info;
+
+/**
+ * Starts the worker threads.
+ * @param max_job_thread_count The most worker threads to start. The number of cores also limits it.
+ */
+b8 job_system_initialize(u8 max_job_thread_count);
+
+/**
+ * Runs every job still queued, dispatches the completion callbacks, then stops the workers.
+ */
+void job_system_shutdown();
+
+/**
+ * Dispatches the completion callbacks of every job finished since the last call.
+ * Called once per frame by the application.
+ */
+void job_system_update();
+
+/**
+ * Creates a job. The parameter data is copied, so it need not outlive this call.
+ * @param entry_point The function to run on a worker thread.
+ * @param on_success Invoked on the main thread if the job succeeds. Optional.
+ * @param on_fail Invoked on the main thread if the job fails. Optional.
+ * @param param_data The data passed to the entry point. Optional.
+ * @param param_data_size The size of param_data in bytes.
+ * @param result_data_size The size of the result the job writes, in bytes.
+ * @returns The job, ready to be submitted.
+ */
+KAPI job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size);
+
+/**
+ * Queues a job to be run by the next free worker. Must be called from the main thread.
+ * @returns TRUE if the job was queued; otherwise FALSE.
+ */
+KAPI b8 job_system_submit(job_info info);
+
+/**
+ * Splits [0, count) into batches and runs them across the workers and the
+ * calling thread, returning once every batch has run. Unlike jobs, batches
+ * have no callbacks, and may be started from any thread. Batches run in
+ * no particular order, so they must not depend on each other.
+ * @param range The function each batch is passed to.
+ * @param context Passed to every batch. Must stay valid until this returns.
+ * @param count The number of items.
+ * @param batch_size The most items in one batch. 0 picks one from the thread count.
+ */
+KAPI void job_system_parallel_for(pfn_job_range range, void* context, u32 count, u32 batch_size);
+
+// Returns the number of worker threads.
+KAPI u32 job_system_thread_count();
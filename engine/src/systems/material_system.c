@@ -0,0 +1,345 @@
+#include "material_system.h"
+
+#include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/logger.h"
+#include "systems/resource_system.h"
+
+// Parameter blocks are padded to this, as elements of a uniform array are.
+#define MATERIAL_PARAMETER_ALIGNMENT 16
+#define MATERIAL_INITIAL_CAPACITY 16
+
+typedef struct material_pipeline {
+    kname vertex_shader;
+    kname fragment_shader;
+    // The materials using it. Free once this drops to zero.
+    u32 material_count;
+} material_pipeline;
+
+typedef struct material {
+    u32 generation;
+    b8 in_use;
+    kname name;
+    u32 pipeline;
+    resource_handle vertex_shader;
+    resource_handle fragment_shader;
+    u32 parameter_size;
+    u32 stride;
+    u8* defaults;
+
+    // The instances' parameters, packed: removing one moves the last into its place.
+    u8* parameters;
+    // The instance slot of each row.
+    u32* row_slots;
+    u32 count;
+    u32 capacity;
+    // The system's change count when the parameters last changed. Never repeats, even once the slot is reused.
+    u64 version;
+} material;
+
+typedef struct material_instance_slot {
+    u32 generation;
+    // INVALID_ID while the slot is free.
+    u32 material;
+    u32 row;
+    u32 next_free;
+} material_instance_slot;
+
+typedef struct material_system_state {
+    material materials[MATERIAL_MAX_COUNT];
+    material_pipeline pipelines[MATERIAL_MAX_COUNT];
+    u32 pipeline_count;
+
+    u32 instance_capacity;
+    material_instance_slot* instances;
+    u32 first_free_instance;
+    // Counts every change to any material's parameters.
+    u64 change_count;
+} material_system_state;
+
+static b8 is_initialized = FALSE;
+static material_system_state* state = 0;
+
+static material* material_get(material_handle handle) {
+    if (!is_initialized || handle.generation == 0 || handle.index >= MATERIAL_MAX_COUNT) {
+        return 0;
+    }
+    material* m = &state->materials[handle.index];
+    return m->in_use && m->generation == handle.generation ? m : 0;
+}
+
+static material_instance_slot* instance_get(material_instance instance) {
+    if (!is_initialized || instance.generation == 0 || instance.index >= state->instance_capacity) {
+        return 0;
+    }
+    material_instance_slot* slot = &state->instances[instance.index];
+    return slot->generation == instance.generation && slot->material != INVALID_ID ? slot : 0;
+}
+
+static void mark_changed(material* m) {
+    m->version = ++state->change_count;
+}
+
+// Finds the pipeline for a pair of shaders, or takes a free one.
+static u32 pipeline_acquire(kname vertex_shader, kname fragment_shader) {
+    u32 free_index = INVALID_ID;
+    for (u32 i = 0; i < state->pipeline_count; ++i) {
+        material_pipeline* p = &state->pipelines[i];
+        if (p->material_count == 0) {
+            if (free_index == INVALID_ID) {
+                free_index = i;
+            }
+        } else if (p->vertex_shader == vertex_shader && p->fragment_shader == fragment_shader) {
+            p->material_count++;
+            return i;
+        }
+    }
+    if (free_index == INVALID_ID) {
+        free_index = state->pipeline_count++;
+    }
+    material_pipeline* p = &state->pipelines[free_index];
+    p->vertex_shader = vertex_shader;
+    p->fragment_shader = fragment_shader;
+    p->material_count = 1;
+    return free_index;
+}
+
+b8 material_system_initialize(u32 max_instance_count) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    if (max_instance_count == 0 || max_instance_count == INVALID_ID) {
+        KERROR("material_system_initialize requires a max_instance_count above zero.");
+        return FALSE;
+    }
+
+    state = kallocate(sizeof(material_system_state), MEMORY_TAG_MATERIAL_INSTANCE);
+    state->instance_capacity = max_instance_count;
+    state->instances = kallocate(sizeof(material_instance_slot) * max_instance_count, MEMORY_TAG_MATERIAL_INSTANCE);
+    for (u32 i = 0; i < max_instance_count; ++i) {
+        state->instances[i].material = INVALID_ID;
+        state->instances[i].next_free = i + 1 < max_instance_count ? i + 1 : INVALID_ID;
+    }
+    state->first_free_instance = 0;
+
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void material_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    for (u32 i = 0; i < MATERIAL_MAX_COUNT; ++i) {
+        material* m = &state->materials[i];
+        if (m->in_use) {
+            KWARN("Material '%s' still exists at shutdown.", kname_string(m->name));
+            material_handle handle = {i, m->generation};
+            material_destroy(handle);
+        }
+    }
+    kfree(state->instances, sizeof(material_instance_slot) * state->instance_capacity, MEMORY_TAG_MATERIAL_INSTANCE);
+    kfree(state, sizeof(material_system_state), MEMORY_TAG_MATERIAL_INSTANCE);
+    state = 0;
+    is_initialized = FALSE;
+}
+
+material_handle material_create(const material_config* config) {
+    material_handle handle = {0};
+    if (!is_initialized) {
+        return handle;
+    }
+    if (!config->vertex_shader || !config->fragment_shader) {
+        KERROR("material_create: material '%s' needs both a vertex and a fragment shader.", config->name);
+        return handle;
+    }
+
+    u32 index = INVALID_ID;
+    for (u32 i = 0; i < MATERIAL_MAX_COUNT; ++i) {
+        if (!state->materials[i].in_use) {
+            index = i;
+            break;
+        }
+    }
+    if (index == INVALID_ID) {
+        KERROR("material_create: no room for material '%s', the limit is %u.", config->name, MATERIAL_MAX_COUNT);
+        return handle;
+    }
+
+    resource_handle vertex_shader = resource_system_acquire_async(RESOURCE_TYPE_SHADER, config->vertex_shader, 0, 0);
+    resource_handle fragment_shader = resource_system_acquire_async(RESOURCE_TYPE_SHADER, config->fragment_shader, 0, 0);
+    if (vertex_shader.generation == INVALID_RESOURCE_GENERATION || fragment_shader.generation == INVALID_RESOURCE_GENERATION) {
+        KERROR("material_create: the shaders of material '%s' could not be loaded.", config->name);
+        resource_system_release(vertex_shader);
+        resource_system_release(fragment_shader);
+        return handle;
+    }
+
+    material* m = &state->materials[index];
+    u32 generation = m->generation + 1;
+    kzero_memory(m, sizeof(material));
+    // Skip generation 0 when wrapping, so zeroed handles stay invalid.
+    m->generation = generation ? generation : 1;
+    m->in_use = TRUE;
+    m->name = kname_intern(config->name);
+    m->pipeline = pipeline_acquire(kname_intern(config->vertex_shader), kname_intern(config->fragment_shader));
+    m->vertex_shader = vertex_shader;
+    m->fragment_shader = fragment_shader;
+    m->parameter_size = config->parameter_size;
+    m->stride = (config->parameter_size + MATERIAL_PARAMETER_ALIGNMENT - 1) & ~(MATERIAL_PARAMETER_ALIGNMENT - 1);
+    if (m->stride) {
+        m->defaults = kallocate(m->stride, MEMORY_TAG_MATERIAL_INSTANCE);
+        if (config->default_parameters) {
+            kcopy_memory(m->defaults, config->default_parameters, config->parameter_size);
+        }
+    }
+    mark_changed(m);
+
+    handle.index = index;
+    handle.generation = m->generation;
+    return handle;
+}
+
+void material_destroy(material_handle handle) {
+    material* m = material_get(handle);
+    if (!m) {
+        return;
+    }
+    for (u32 row = 0; row < m->count; ++row) {
+        material_instance_slot* slot = &state->instances[m->row_slots[row]];
+        slot->material = INVALID_ID;
+        slot->next_free = state->first_free_instance;
+        state->first_free_instance = m->row_slots[row];
+    }
+    if (m->capacity) {
+        kfree(m->parameters, (u64)m->stride * m->capacity, MEMORY_TAG_MATERIAL_INSTANCE);
+        kfree(m->row_slots, sizeof(u32) * m->capacity, MEMORY_TAG_MATERIAL_INSTANCE);
+    }
+    if (m->defaults) {
+        kfree(m->defaults, m->stride, MEMORY_TAG_MATERIAL_INSTANCE);
+    }
+    resource_system_release(m->vertex_shader);
+    resource_system_release(m->fragment_shader);
+    state->pipelines[m->pipeline].material_count--;
+
+    // Keep the generation, so handles to the old material stay stale once the index is reused.
+    u32 generation = m->generation;
+    kzero_memory(m, sizeof(material));
+    m->generation = generation;
+}
+
+material_instance material_instance_create(material_handle handle) {
+    material_instance instance = {0};
+    material* m = material_get(handle);
+    if (!m) {
+        return instance;
+    }
+    if (state->first_free_instance == INVALID_ID) {
+        KERROR("material_instance_create: all %u instances are in use.", state->instance_capacity);
+        return instance;
+    }
+
+    if (m->count == m->capacity) {
+        u32 capacity = m->capacity ? m->capacity * 2 : MATERIAL_INITIAL_CAPACITY;
+        u8* parameters = kallocate((u64)m->stride * capacity, MEMORY_TAG_MATERIAL_INSTANCE);
+        u32* row_slots = kallocate(sizeof(u32) * capacity, MEMORY_TAG_MATERIAL_INSTANCE);
+        if (m->capacity) {
+            kcopy_memory(parameters, m->parameters, (u64)m->stride * m->count);
+            kcopy_memory(row_slots, m->row_slots, sizeof(u32) * m->count);
+            kfree(m->parameters, (u64)m->stride * m->capacity, MEMORY_TAG_MATERIAL_INSTANCE);
+            kfree(m->row_slots, sizeof(u32) * m->capacity, MEMORY_TAG_MATERIAL_INSTANCE);
+        }
+        m->parameters = parameters;
+        m->row_slots = row_slots;
+        m->capacity = capacity;
+    }
+
+    u32 index = state->first_free_instance;
+    material_instance_slot* slot = &state->instances[index];
+    state->first_free_instance = slot->next_free;
+    slot->generation++;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->material = handle.index;
+    slot->row = m->count++;
+
+    m->row_slots[slot->row] = index;
+    if (m->stride) {
+        kcopy_memory(m->parameters + (u64)m->stride * slot->row, m->defaults, m->stride);
+    }
+    mark_changed(m);
+
+    instance.index = index;
+    instance.generation = slot->generation;
+    return instance;
+}
+
+void material_instance_destroy(material_instance instance) {
+    material_instance_slot* slot = instance_get(instance);
+    if (!slot) {
+        return;
+    }
+    material* m = &state->materials[slot->material];
+    u32 last = m->count - 1;
+    if (slot->row != last) {
+        kcopy_memory(m->parameters + (u64)m->stride * slot->row, m->parameters + (u64)m->stride * last, m->stride);
+        m->row_slots[slot->row] = m->row_slots[last];
+        state->instances[m->row_slots[slot->row]].row = slot->row;
+    }
+    m->count--;
+    mark_changed(m);
+
+    slot->material = INVALID_ID;
+    slot->next_free = state->first_free_instance;
+    state->first_free_instance = instance.index;
+}
+
+b8 material_instance_is_valid(material_instance instance) {
+    return instance_get(instance) != 0;
+}
+
+void material_instance_set_parameters(material_instance instance, const void* parameters) {
+    void* target = material_instance_parameters(instance);
+    if (target) {
+        kcopy_memory(target, parameters, state->materials[state->instances[instance.index].material].parameter_size);
+    }
+}
+
+void* material_instance_parameters(material_instance instance) {
+    material_instance_slot* slot = instance_get(instance);
+    if (!slot) {
+        return 0;
+    }
+    material* m = &state->materials[slot->material];
+    // Handing out the pointer may mean a change, so the version moves on.
+    mark_changed(m);
+    return m->parameters + (u64)m->stride * slot->row;
+}
+
+b8 material_instance_resolve(material_instance instance, u32* out_material, u32* out_pipeline, u32* out_row) {
+    material_instance_slot* slot = instance_get(instance);
+    if (!slot) {
+        return FALSE;
+    }
+    *out_material = slot->material;
+    *out_pipeline = state->materials[slot->material].pipeline;
+    *out_row = slot->row;
+    return TRUE;
+}
+
+b8 material_batch_describe(u32 index, render_batch* out_batch) {
+    if (!is_initialized || index >= MATERIAL_MAX_COUNT || !state->materials[index].in_use) {
+        return FALSE;
+    }
+    const material* m = &state->materials[index];
+    out_batch->pipeline = m->pipeline;
+    out_batch->vertex_shader = m->vertex_shader;
+    out_batch->fragment_shader = m->fragment_shader;
+    out_batch->material = index;
+    out_batch->parameters = m->parameters;
+    out_batch->parameter_stride = m->stride;
+    out_batch->parameter_count = m->count;
+    out_batch->parameters_version = m->version;
+    return TRUE;
+}
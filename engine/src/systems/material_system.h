@@ -0,0 +1,76 @@
+#pragma once
+
+#include "renderer/renderer_types.inl"
+
+/*
+Materials pair a vertex and fragment shader with a block of parameters.
+The parameters of all of a material's instances are kept in one array, laid
+out as a uniform array, and changes are tracked per material rather than per
+instance, so a backend can upload each changed material once. None does yet;
+see render_batch.parameters_version. Materials with the same shaders share a
+pipeline, which the renderer sorts draws by.
+*/
+
+// The most materials which can exist at once.
+#define MATERIAL_MAX_COUNT 1024
+
+typedef struct material_config {
+    // Used for logging.
+    const char* name;
+    // Shader resource names, loaded in the background.
+    const char* vertex_shader;
+    const char* fragment_shader;
+    // The size of one instance's parameters, in bytes. Padded to 16 in the array.
+    u32 parameter_size;
+    // What new instances start with. Optional; zeroed if absent.
+    const void* default_parameters;
+} material_config;
+
+/**
+ * Reserves storage for material instances.
+ * @param max_instance_count The most instances which can exist at once, across all materials.
+ */
+b8 material_system_initialize(u32 max_instance_count);
+void material_system_shutdown();
+
+/**
+ * Creates a material, starting its shaders loading.
+ * @returns The material, or an invalid handle on failure.
+ */
+KAPI material_handle material_create(const material_config* config);
+
+// Destroys a material along with all of its instances.
+KAPI void material_destroy(material_handle material);
+
+/**
+ * Creates an instance of a material, with the material's default parameters.
+ * @returns The instance, or an invalid handle if there is no room left.
+ */
+KAPI material_instance material_instance_create(material_handle material);
+KAPI void material_instance_destroy(material_instance instance);
+KAPI b8 material_instance_is_valid(material_instance instance);
+
+// Replaces an instance's parameters with parameter_size bytes from parameters.
+KAPI void material_instance_set_parameters(material_instance instance, const void* parameters);
+
+/**
+ * An instance's parameters, to be changed in place. The pointer is only valid
+ * until the next instance of the same material is created or destroyed.
+ */
+KAPI void* material_instance_parameters(material_instance instance);
+
+/**
+ * Finds where an instance's parameters are, for grouping draws.
+ * @param out_material The material's index, which is also its batch's.
+ * @param out_pipeline The pipeline, shared by materials with the same shaders.
+ * @param out_row The instance's index in the material's parameter array.
+ * @returns FALSE if the instance is stale.
+ */
+b8 material_instance_resolve(material_instance instance, u32* out_material, u32* out_pipeline, u32* out_row);
+
+/**
+ * Describes a material's parameter array and shaders for a batch. The
+ * batch's position in the packet is left untouched.
+ * @returns FALSE if the material index is not in use.
+ */
+b8 material_batch_describe(u32 material, render_batch* out_batch);
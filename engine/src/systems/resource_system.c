@@ -0,0 +1,686 @@
+#include "resource_system.h"
+
+#include "containers/darray.h"
+#include "core/clock.h"
+#include "core/kmemory.h"
+#include "core/kname.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "resources/archive.h"
+#include "systems/job_system.h"
+
+#include "resources/loaders/audio_loader.h"
+#include "resources/loaders/binary_loader.h"
+#include "resources/loaders/image_loader.h"
+#include "resources/loaders/mesh_loader.h"
+#include "resources/loaders/shader_loader.h"
+#include "resources/loaders/text_loader.h"
+
+#define MAX_LOADER_COUNT 32
+#define MAX_RESOURCE_PATH 512
+
+typedef struct resource_waiter {
+    void* listener;
+    pfn_resource_loaded callback;
+} resource_waiter;
+
+typedef struct resource_entry {
+    u32 generation;
+    u32 ref_count;
+    // The loader in the high half and the interned path in the low half.
+    // Identifies the resource for deduplication.
+    u64 key;
+    resource_state state;
+    resource res;
+    // Callbacks waiting on an asynchronous load. darray, created on demand.
+    resource_waiter* waiters;
+} resource_entry;
+
+typedef struct pending_finalize {
+    u32 index;
+    u32 generation;
+} pending_finalize;
+
+typedef struct resource_system_state {
+    resource_system_config config;
+
+    resource_loader loaders[MAX_LOADER_COUNT];
+    u32 loader_count;
+
+    resource_entry* entries;
+    u32* free_indices;
+    u32 free_count;
+
+    // Open addressing from key to entry index + 1, so 0 marks an empty slot.
+    u32* lookup;
+    u32 lookup_mask;
+
+    b8 archive_mounted;
+    archive archive;
+
+    // Resources decoded by jobs, awaiting finalization in order. darray, read from finalize_head.
+    pending_finalize* finalize_queue;
+    u32 finalize_head;
+} resource_system_state;
+
+typedef struct load_job_params {
+    u32 index;
+    u32 generation;
+    u32 loader_index;
+} load_job_params;
+
+typedef struct load_job_result {
+    u32 index;
+    u32 generation;
+    u64 data_size;
+    void* data;
+} load_job_result;
+
+static b8 is_initialized = FALSE;
+static resource_system_state state;
+
+// Builds the path of a resource relative to the asset base path. out_path must hold MAX_RESOURCE_PATH characters.
+// Paths are normalized the same way as archive paths, so each file has one key however it is named.
+static void build_relative_path(const resource_loader* loader, const char* name, char* out_path) {
+    while (name[0] == '.' && (name[1] == '/' || name[1] == '\\')) {
+        name += 2;
+    }
+    if (loader->type_path[0]) {
+        string_format(out_path, MAX_RESOURCE_PATH, "%s/%s", loader->type_path, name);
+    } else {
+        string_format(out_path, MAX_RESOURCE_PATH, "%s", name);
+    }
+    for (char* c = out_path; *c; ++c) {
+        if (*c == '\\') {
+            *c = '/';
+        }
+    }
+}
+
+static b8 make_key(u32 loader_index, const char* path, u64* out_key) {
+    // Without an interned name of its own, every such path would share one key, and so one resource.
+    kname path_name = kname_intern(path);
+    if (path_name == KNAME_NONE) {
+        return FALSE;
+    }
+    // Keeping the loader in the key keeps two loaders sharing a folder from sharing resources.
+    *out_key = ((u64)loader_index << 32) | path_name;
+    return TRUE;
+}
+
+static u32 lookup_slot(u64 key) {
+    return (u32)(key ^ (key >> 32)) & state.lookup_mask;
+}
+
+static u32 lookup_find(u64 key) {
+    for (u32 slot = lookup_slot(key);; slot = (slot + 1) & state.lookup_mask) {
+        u32 value = state.lookup[slot];
+        if (value == 0) {
+            return INVALID_ID;
+        }
+        if (state.entries[value - 1].key == key) {
+            return value - 1;
+        }
+    }
+}
+
+static void lookup_insert(u64 key, u32 index) {
+    u32 slot = lookup_slot(key);
+    while (state.lookup[slot] != 0) {
+        slot = (slot + 1) & state.lookup_mask;
+    }
+    state.lookup[slot] = index + 1;
+}
+
+static void lookup_remove(u64 key) {
+    u32 slot = lookup_slot(key);
+    while (state.lookup[slot] != 0 && state.entries[state.lookup[slot] - 1].key != key) {
+        slot = (slot + 1) & state.lookup_mask;
+    }
+    if (state.lookup[slot] == 0) {
+        return;
+    }
+
+    // Shift later members of the same probe run back so lookups never stop early at the hole.
+    u32 hole = slot;
+    for (u32 next = (hole + 1) & state.lookup_mask; state.lookup[next] != 0; next = (next + 1) & state.lookup_mask) {
+        u32 home = lookup_slot(state.entries[state.lookup[next] - 1].key);
+        // Move it if its home is not within (hole, next], taking wrap-around into account.
+        b8 stays = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!stays) {
+            state.lookup[hole] = state.lookup[next];
+            hole = next;
+        }
+    }
+    state.lookup[hole] = 0;
+}
+
+static resource_entry* get_entry(resource_handle handle) {
+    if (!is_initialized || handle.generation == INVALID_RESOURCE_GENERATION || handle.index >= state.config.max_resource_count) {
+        return 0;
+    }
+    resource_entry* entry = &state.entries[handle.index];
+    return entry->generation == handle.generation ? entry : 0;
+}
+
+static resource_handle make_handle(u32 index) {
+    resource_handle handle = {index, state.entries[index].generation};
+    return handle;
+}
+
+static resource_handle invalid_handle() {
+    resource_handle handle = {INVALID_ID, INVALID_RESOURCE_GENERATION};
+    return handle;
+}
+
+static void free_entry(u32 index) {
+    resource_entry* entry = &state.entries[index];
+    lookup_remove(entry->key);
+    if (entry->res.full_path) {
+        kfree(entry->res.full_path, string_length(entry->res.full_path) + 1, MEMORY_TAG_STRING);
+    }
+    if (entry->waiters) {
+        darray_destroy(entry->waiters);
+    }
+
+    u32 generation = entry->generation + 1;
+    kzero_memory(entry, sizeof(resource_entry));
+    // Skip the invalid generation on wrap-around.
+    entry->generation = generation == INVALID_RESOURCE_GENERATION ? 1 : generation;
+    state.free_indices[state.free_count++] = index;
+}
+
+static void unload_entry(resource_entry* entry) {
+    if (entry->res.data) {
+        resource_loader* loader = &state.loaders[entry->res.loader_id];
+        loader->unload(loader, &entry->res);
+        entry->res.data = 0;
+        entry->res.data_size = 0;
+    }
+}
+
+static void notify_waiters(u32 index, b8 success) {
+    resource_entry* entry = &state.entries[index];
+    if (!entry->waiters) {
+        return;
+    }
+
+    // Detach the list first, since a callback may acquire or release this very resource.
+    resource_waiter* waiters = entry->waiters;
+    entry->waiters = 0;
+    resource_handle handle = make_handle(index);
+    u64 count = darray_length(waiters);
+    for (u64 i = 0; i < count; ++i) {
+        waiters[i].callback(handle, success, waiters[i].listener);
+    }
+    darray_destroy(waiters);
+}
+
+static void add_waiter(resource_entry* entry, void* listener, pfn_resource_loaded callback) {
+    if (!callback) {
+        return;
+    }
+    if (!entry->waiters) {
+        entry->waiters = darray_create(resource_waiter);
+    }
+    resource_waiter waiter = {listener, callback};
+    darray_push(entry->waiters, waiter);
+}
+
+/**
+ * Reads a resource's file, from the archive if it has it and otherwise from
+ * disk. Either way the data is used in place wherever possible: loose files
+ * are mapped, as are uncompressed archive entries, so the loader's own copy
+ * is the only one made. Release with release_resource_file.
+ */
+typedef struct resource_file {
+    const void* data;
+    u64 size;
+    // Set when the data had to be decompressed into a buffer.
+    void* owned;
+    // Set when the data is a mapping of a loose file.
+    mapped_file mapping;
+} resource_file;
+
+static b8 read_resource_file(const char* relative_path, const char* full_path, resource_file* out_file) {
+    kzero_memory(out_file, sizeof(resource_file));
+
+    if (state.archive_mounted) {
+        const archive_entry* entry = archive_find(&state.archive, relative_path);
+        if (entry) {
+            out_file->size = entry->size;
+            if (entry->compression == ARCHIVE_COMPRESSION_NONE) {
+                out_file->data = archive_entry_data(&state.archive, entry);
+                return TRUE;
+            }
+            out_file->owned = kallocate(entry->size ? entry->size : 1, MEMORY_TAG_RESOURCE);
+            if (!archive_read(&state.archive, entry, out_file->owned, entry->size)) {
+                kfree(out_file->owned, entry->size ? entry->size : 1, MEMORY_TAG_RESOURCE);
+                out_file->owned = 0;
+                return FALSE;
+            }
+            out_file->data = out_file->owned;
+            return TRUE;
+        }
+    }
+
+    // Loaders read their file front to back, once.
+    if (!platform_map_file(full_path, FILE_MAP_HINT_SEQUENTIAL | FILE_MAP_HINT_WILLNEED, &out_file->mapping)) {
+        return FALSE;
+    }
+    out_file->data = out_file->mapping.data;
+    out_file->size = out_file->mapping.size;
+    return TRUE;
+}
+
+static void release_resource_file(resource_file* file) {
+    if (file->owned) {
+        kfree(file->owned, file->size ? file->size : 1, MEMORY_TAG_RESOURCE);
+    }
+    platform_unmap_file(&file->mapping);
+    kzero_memory(file, sizeof(resource_file));
+}
+
+// Reads and decodes a resource. Safe to call from a job thread.
+static b8 load_resource(resource_loader* loader, const char* name, const char* full_path, resource* out_resource) {
+    char relative_path[MAX_RESOURCE_PATH];
+    build_relative_path(loader, name, relative_path);
+
+    resource_file file;
+    if (!read_resource_file(relative_path, full_path, &file)) {
+        return FALSE;
+    }
+
+    // An empty file still gets a valid pointer.
+    static const u8 empty = 0;
+    b8 result = loader->load(loader, name, file.data ? file.data : &empty, file.size, out_resource);
+    release_resource_file(&file);
+    if (!result) {
+        KERROR("Failed to load resource '%s'.", full_path);
+    }
+    return result;
+}
+
+static b8 finalize_entry(u32 index) {
+    resource_entry* entry = &state.entries[index];
+    resource_loader* loader = &state.loaders[entry->res.loader_id];
+    if (loader->finalize && !loader->finalize(loader, &entry->res)) {
+        KERROR("Failed to finalize resource '%s'.", entry->res.full_path);
+        unload_entry(entry);
+        entry->state = RESOURCE_STATE_FAILED;
+        return FALSE;
+    }
+    entry->state = RESOURCE_STATE_LOADED;
+    return TRUE;
+}
+
+static b8 load_job_start(void* params, void* result_data) {
+    load_job_params* load_params = params;
+    load_job_result* result = result_data;
+    result->index = load_params->index;
+    result->generation = load_params->generation;
+
+    // The entry is not freed while it is loading, and its name and path do not change.
+    resource_entry* entry = &state.entries[load_params->index];
+    resource loaded;
+    kzero_memory(&loaded, sizeof(resource));
+    loaded.loader_id = load_params->loader_index;
+    loaded.name = entry->res.name;
+    loaded.full_path = entry->res.full_path;
+    if (!load_resource(&state.loaders[load_params->loader_index], entry->res.name, entry->res.full_path, &loaded)) {
+        return FALSE;
+    }
+    result->data = loaded.data;
+    result->data_size = loaded.data_size;
+    return TRUE;
+}
+
+static void load_job_on_success(void* result_data) {
+    load_job_result* result = result_data;
+    resource_entry* entry = &state.entries[result->index];
+    entry->res.data = result->data;
+    entry->res.data_size = result->data_size;
+
+    // Everyone lost interest while it was loading.
+    if (entry->ref_count == 0) {
+        unload_entry(entry);
+        free_entry(result->index);
+        return;
+    }
+
+    entry->state = RESOURCE_STATE_FINALIZING;
+    pending_finalize pending = {result->index, result->generation};
+    darray_push(state.finalize_queue, pending);
+}
+
+static void load_job_on_fail(void* result_data) {
+    load_job_result* result = result_data;
+    resource_entry* entry = &state.entries[result->index];
+    if (entry->ref_count == 0) {
+        free_entry(result->index);
+        return;
+    }
+    entry->state = RESOURCE_STATE_FAILED;
+    notify_waiters(result->index, FALSE);
+}
+
+static i32 find_loader(resource_type type, const char* custom_type) {
+    for (u32 i = 0; i < state.loader_count; ++i) {
+        resource_loader* loader = &state.loaders[i];
+        if (loader->type != type) {
+            continue;
+        }
+        if (type != RESOURCE_TYPE_CUSTOM || (custom_type && loader->custom_type && strings_equal(loader->custom_type, custom_type))) {
+            return (i32)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Finds or creates the entry for a resource and takes a reference to it.
+ * out_created is set if the entry is new and still has to be loaded.
+ */
+static u32 acquire_entry(u32 loader_index, const char* name, b8* out_created) {
+    resource_loader* loader = &state.loaders[loader_index];
+    char relative_path[MAX_RESOURCE_PATH];
+    build_relative_path(loader, name, relative_path);
+
+    *out_created = FALSE;
+    u64 key;
+    if (!make_key(loader_index, relative_path, &key)) {
+        KERROR("Unable to intern the name of '%s', so it cannot be acquired.", relative_path);
+        return INVALID_ID;
+    }
+    u32 index = lookup_find(key);
+    if (index != INVALID_ID) {
+        state.entries[index].ref_count++;
+        return index;
+    }
+
+    if (state.free_count == 0) {
+        KERROR("The resource system is full (%u resources). Unable to acquire '%s'.", state.config.max_resource_count, relative_path);
+        return INVALID_ID;
+    }
+    kname resource_name = kname_intern(name);
+    if (resource_name == KNAME_NONE) {
+        KERROR("Unable to intern the name of '%s', so it cannot be acquired.", relative_path);
+        return INVALID_ID;
+    }
+
+    index = state.free_indices[--state.free_count];
+    resource_entry* entry = &state.entries[index];
+    entry->key = key;
+    entry->ref_count = 1;
+    entry->state = RESOURCE_STATE_LOADING;
+    entry->res.loader_id = loader_index;
+    // Names are interned, so they need no freeing.
+    entry->res.name = kname_string(resource_name);
+    char full_path[MAX_RESOURCE_PATH];
+    string_format(full_path, sizeof(full_path), "%s/%s", state.config.asset_base_path, relative_path);
+    entry->res.full_path = string_duplicate(full_path);
+    lookup_insert(key, index);
+
+    *out_created = TRUE;
+    return index;
+}
+
+static resource_handle acquire_async(i32 loader_index, const char* name, void* listener, pfn_resource_loaded callback) {
+    if (!is_initialized || loader_index < 0 || !name) {
+        KERROR("Unable to acquire resource '%s': no loader for its type.", name ? name : "");
+        return invalid_handle();
+    }
+
+    b8 created;
+    u32 index = acquire_entry((u32)loader_index, name, &created);
+    if (index == INVALID_ID) {
+        return invalid_handle();
+    }
+    resource_entry* entry = &state.entries[index];
+    resource_handle handle = make_handle(index);
+
+    if (created) {
+        load_job_params params = {index, entry->generation, (u32)loader_index};
+        job_info job = job_create(load_job_start, load_job_on_success, load_job_on_fail, &params, sizeof(load_job_params), sizeof(load_job_result));
+        if (!job_system_submit(job)) {
+            free_entry(index);
+            return invalid_handle();
+        }
+    }
+
+    if (entry->state == RESOURCE_STATE_LOADED || entry->state == RESOURCE_STATE_FAILED) {
+        if (callback) {
+            callback(handle, entry->state == RESOURCE_STATE_LOADED, listener);
+        }
+    } else {
+        add_waiter(entry, listener, callback);
+    }
+    return handle;
+}
+
+b8 resource_system_initialize(resource_system_config config) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    if (config.max_resource_count == 0) {
+        KERROR("resource_system_initialize - config.max_resource_count must be > 0.");
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(resource_system_state));
+    state.config = config;
+
+    state.entries = kallocate(sizeof(resource_entry) * config.max_resource_count, MEMORY_TAG_RESOURCE);
+    state.free_indices = kallocate(sizeof(u32) * config.max_resource_count, MEMORY_TAG_RESOURCE);
+    // Handed out from the back, so the lowest indices are used first.
+    for (u32 i = 0; i < config.max_resource_count; ++i) {
+        state.entries[i].generation = 1;
+        state.free_indices[i] = config.max_resource_count - 1 - i;
+    }
+    state.free_count = config.max_resource_count;
+
+    // Keep the table at most half full so probe runs stay short.
+    u32 lookup_size = 1;
+    while (lookup_size < config.max_resource_count * 2) {
+        lookup_size <<= 1;
+    }
+    state.lookup = kallocate(sizeof(u32) * lookup_size, MEMORY_TAG_RESOURCE);
+    state.lookup_mask = lookup_size - 1;
+
+    state.finalize_queue = darray_create(pending_finalize);
+
+    if (config.archive_path && filesystem_exists(config.archive_path)) {
+        state.archive_mounted = archive_open(config.archive_path, &state.archive);
+    }
+
+    is_initialized = TRUE;
+
+    // Built-in loaders.
+    resource_system_register_loader(text_resource_loader_create());
+    resource_system_register_loader(binary_resource_loader_create());
+    resource_system_register_loader(image_resource_loader_create());
+    resource_system_register_loader(mesh_resource_loader_create());
+    resource_system_register_loader(shader_resource_loader_create());
+    resource_system_register_loader(audio_resource_loader_create());
+
+    KINFO("Resource system initialized with base path '%s'%s.", config.asset_base_path, state.archive_mounted ? " and an asset archive" : "");
+    return TRUE;
+}
+
+void resource_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+
+    // NOTE: The job system is shut down first, so nothing is loading any more.
+    for (u32 i = 0; i < state.config.max_resource_count; ++i) {
+        resource_entry* entry = &state.entries[i];
+        if (entry->res.name) {
+            if (entry->ref_count > 0) {
+                KWARN("Resource '%s' is still acquired %u time(s) at shutdown.", entry->res.full_path, entry->ref_count);
+            }
+            unload_entry(entry);
+            free_entry(i);
+        }
+    }
+
+    if (state.archive_mounted) {
+        archive_close(&state.archive);
+    }
+    darray_destroy(state.finalize_queue);
+    kfree(state.lookup, sizeof(u32) * (state.lookup_mask + 1), MEMORY_TAG_RESOURCE);
+    kfree(state.free_indices, sizeof(u32) * state.config.max_resource_count, MEMORY_TAG_RESOURCE);
+    kfree(state.entries, sizeof(resource_entry) * state.config.max_resource_count, MEMORY_TAG_RESOURCE);
+    is_initialized = FALSE;
+}
+
+void resource_system_update() {
+    if (!is_initialized) {
+        return;
+    }
+
+    clock budget_clock;
+    clock_start(&budget_clock);
+
+    // At least one resource is finalized per frame, however long it takes, so loading always progresses.
+    u32 length = (u32)darray_length(state.finalize_queue);
+    while (state.finalize_head < length) {
+        pending_finalize pending = state.finalize_queue[state.finalize_head++];
+        resource_entry* entry = &state.entries[pending.index];
+        // Released, and possibly reused, while waiting.
+        if (entry->generation != pending.generation || entry->state != RESOURCE_STATE_FINALIZING) {
+            continue;
+        }
+
+        b8 success = finalize_entry(pending.index);
+        notify_waiters(pending.index, success);
+
+        clock_update(&budget_clock);
+        if (budget_clock.elapsed >= state.config.finalize_budget_seconds) {
+            break;
+        }
+        // Callbacks may have queued more.
+        length = (u32)darray_length(state.finalize_queue);
+    }
+
+    if (state.finalize_head >= darray_length(state.finalize_queue)) {
+        darray_clear(state.finalize_queue);
+        state.finalize_head = 0;
+    }
+}
+
+b8 resource_system_register_loader(resource_loader loader) {
+    if (!is_initialized) {
+        return FALSE;
+    }
+    if (!loader.load || !loader.unload || !loader.type_path) {
+        KERROR("resource_system_register_loader - loader requires load, unload and type_path.");
+        return FALSE;
+    }
+
+    // Replacing keeps the slot, and so the id, of the loader being replaced.
+    i32 existing = find_loader(loader.type, loader.custom_type);
+    u32 index;
+    if (existing >= 0) {
+        index = (u32)existing;
+    } else {
+        if (state.loader_count >= MAX_LOADER_COUNT) {
+            KERROR("resource_system_register_loader - no room for more loaders.");
+            return FALSE;
+        }
+        index = state.loader_count++;
+    }
+    loader.id = index;
+    state.loaders[index] = loader;
+    return TRUE;
+}
+
+resource_handle resource_system_acquire(resource_type type, const char* name) {
+    i32 loader_index = is_initialized ? find_loader(type, 0) : -1;
+    if (loader_index < 0 || !name) {
+        KERROR("Unable to acquire resource '%s': no loader for its type.", name ? name : "");
+        return invalid_handle();
+    }
+
+    b8 created;
+    u32 index = acquire_entry((u32)loader_index, name, &created);
+    if (index == INVALID_ID) {
+        return invalid_handle();
+    }
+    resource_entry* entry = &state.entries[index];
+    resource_handle handle = make_handle(index);
+
+    if (created) {
+        resource loaded;
+        kzero_memory(&loaded, sizeof(resource));
+        if (!load_resource(&state.loaders[loader_index], entry->res.name, entry->res.full_path, &loaded)) {
+            entry->ref_count = 0;
+            free_entry(index);
+            return invalid_handle();
+        }
+        entry->res.data = loaded.data;
+        entry->res.data_size = loaded.data_size;
+        entry->state = RESOURCE_STATE_FINALIZING;
+    } else {
+        // Already being loaded asynchronously. Wait for the job, dispatching completions meanwhile.
+        while (entry->state == RESOURCE_STATE_LOADING) {
+            job_system_update();
+            platform_sleep(1);
+        }
+    }
+
+    // Finalize now rather than waiting for its turn in the queue, which then skips it.
+    if (entry->state == RESOURCE_STATE_FINALIZING) {
+        b8 success = finalize_entry(index);
+        notify_waiters(index, success);
+    }
+
+    if (entry->state != RESOURCE_STATE_LOADED) {
+        resource_system_release(handle);
+        return invalid_handle();
+    }
+    return handle;
+}
+
+resource_handle resource_system_acquire_async(resource_type type, const char* name, void* listener, pfn_resource_loaded callback) {
+    return acquire_async(is_initialized ? find_loader(type, 0) : -1, name, listener, callback);
+}
+
+resource_handle resource_system_acquire_custom_async(const char* custom_type, const char* name, void* listener, pfn_resource_loaded callback) {
+    return acquire_async(is_initialized ? find_loader(RESOURCE_TYPE_CUSTOM, custom_type) : -1, name, listener, callback);
+}
+
+void resource_system_release(resource_handle handle) {
+    resource_entry* entry = get_entry(handle);
+    if (!entry || entry->ref_count == 0) {
+        KWARN("resource_system_release called with an invalid or released handle.");
+        return;
+    }
+
+    entry->ref_count--;
+    if (entry->ref_count > 0) {
+        return;
+    }
+
+    // A loading resource is freed by its job once it completes.
+    if (entry->state == RESOURCE_STATE_LOADING) {
+        return;
+    }
+    unload_entry(entry);
+    free_entry(handle.index);
+}
+
+const resource* resource_system_get(resource_handle handle) {
+    resource_entry* entry = get_entry(handle);
+    if (!entry || entry->state != RESOURCE_STATE_LOADED) {
+        return 0;
+    }
+    return &entry->res;
+}
+
+resource_state resource_system_get_state(resource_handle handle) {
+    resource_entry* entry = get_entry(handle);
+    return entry ? entry->state : RESOURCE_STATE_UNLOADED;
+}
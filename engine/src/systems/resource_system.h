@@ -0,0 +1,80 @@
+#pragma once
+
+#include "resources/resource_types.h"
+
+typedef struct resource_system_config {
+    // The most resources which can be held at once.
+    u32 max_resource_count;
+    // The folder loose asset files are loaded from.
+    const char* asset_base_path;
+    // An asset archive searched before asset_base_path. Optional.
+    const char* archive_path;
+    // Main thread time each frame may spend finalizing loaded resources, in seconds.
+    f64 finalize_budget_seconds;
+} resource_system_config;
+
+/**
+ * Invoked on the main thread once an asynchronously acquired resource has
+ * loaded or failed to.
+ * @param handle The handle the resource was acquired with.
+ * @param success TRUE if the resource is ready to use.
+ * @param listener The listener passed when acquiring.
+ */
+typedef void (*pfn_resource_loaded)(resource_handle handle, b8 success, void* listener);
+
+b8 resource_system_initialize(resource_system_config config);
+void resource_system_shutdown();
+
+/**
+ * Finalizes loaded resources on the main thread until the frame's budget
+ * is spent, invoking their callbacks. Called once per frame by the application.
+ */
+void resource_system_update();
+
+/**
+ * Registers a loader. Replaces the built-in loader for its type, if any.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+KAPI b8 resource_system_register_loader(resource_loader loader);
+
+/**
+ * Acquires a resource, loading it on the calling thread if it is not loaded
+ * already. Every acquire must be matched by a release.
+ * @param type The type of resource.
+ * @param name The file name below the loader's type path.
+ * @returns A handle to the loaded resource, or an invalid handle on failure.
+ */
+KAPI resource_handle resource_system_acquire(resource_type type, const char* name);
+
+/**
+ * Acquires a resource, loading it on a job thread if it is not loaded
+ * already. Acquiring the same name again shares the one load. The callback
+ * is invoked when the resource is ready, or immediately if it already is.
+ * Every acquire must be matched by a release, even if the load fails.
+ * @param type The type of resource.
+ * @param name The file name below the loader's type path.
+ * @param listener Passed to the callback. Optional.
+ * @param callback Invoked on the main thread when the load finishes. Optional.
+ * @returns A handle to the resource, or an invalid handle if it could not be queued.
+ */
+KAPI resource_handle resource_system_acquire_async(resource_type type, const char* name, void* listener, pfn_resource_loaded callback);
+
+/**
+ * As resource_system_acquire_async, for a resource handled by a loader
+ * registered with RESOURCE_TYPE_CUSTOM and the given type name.
+ */
+KAPI resource_handle resource_system_acquire_custom_async(const char* custom_type, const char* name, void* listener, pfn_resource_loaded callback);
+
+/**
+ * Releases a resource. It is unloaded once the last acquire has been released.
+ */
+KAPI void resource_system_release(resource_handle handle);
+
+/**
+ * Returns the loaded resource for a handle.
+ * @returns The resource, or 0 if the handle is stale or the resource is not loaded yet.
+ */
+KAPI const resource* resource_system_get(resource_handle handle);
+
+// Returns the load state of a handle. Stale handles are RESOURCE_STATE_UNLOADED.
+KAPI resource_state resource_system_get_state(resource_handle handle);
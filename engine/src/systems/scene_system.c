@@ -0,0 +1,562 @@
+#include "scene_system.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+#include "renderer/renderer_frontend.h"
+#include "resources/resource_types.h"
+
+// How far each instance's box in the tree extends past its bounds, so small moves need no reinsertion.
+#define SCENE_AABB_MARGIN 0.1f
+// Entries a traversal stack holds before moving to the heap. Balancing keeps the tree far shallower than this.
+#define SCENE_STACK_SIZE 128
+
+typedef struct scene_node {
+    // For leaves, the instance's bounds plus the margin.
+    aabb box;
+    // The next free node, while free.
+    u32 parent;
+    // INVALID_ID for leaves.
+    u32 left;
+    u32 right;
+    // The slot of a leaf's instance.
+    u32 slot;
+    // 0 for leaves, -1 while free.
+    i32 height;
+} scene_node;
+
+typedef struct scene_slot {
+    u32 generation;
+    // INVALID_ID while the slot is free.
+    u32 leaf;
+    u32 next_free;
+    const mesh_resource_data* mesh;
+    vec3 position;
+    f32 scale;
+    aabb bounds;
+    void* user_data;
+    material_instance material;
+} scene_slot;
+
+typedef struct scene_system_state {
+    u32 capacity;
+    scene_slot* slots;
+    u32 first_free_slot;
+
+    // Twice the capacity: a leaf per instance, plus one fewer internal node.
+    u32 node_capacity;
+    scene_node* nodes;
+    u32 first_free_node;
+    u32 root;
+} scene_system_state;
+
+typedef void (*pfn_scene_visit)(const scene_slot* slot, void* context);
+
+typedef struct scene_collect_context {
+    scene_instance* out_instances;
+    u32 max_count;
+    u32 count;
+} scene_collect_context;
+
+static b8 is_initialized = FALSE;
+static scene_system_state state;
+
+static u32 node_allocate() {
+    u32 index = state.first_free_node;
+    scene_node* node = &state.nodes[index];
+    state.first_free_node = node->parent;
+    node->parent = INVALID_ID;
+    node->left = INVALID_ID;
+    node->right = INVALID_ID;
+    node->slot = INVALID_ID;
+    node->height = 0;
+    return index;
+}
+
+static void node_free(u32 index) {
+    state.nodes[index].parent = state.first_free_node;
+    state.nodes[index].height = -1;
+    state.first_free_node = index;
+}
+
+/**
+ * A traversal stack. It starts in local storage and moves to the heap only
+ * if it outgrows it, since balancing keeps the tree shallow but does not
+ * bound its height.
+ */
+typedef struct scene_stack {
+    u32* items;
+    u32 count;
+    u32 capacity;
+    u32 local[SCENE_STACK_SIZE];
+} scene_stack;
+
+static void stack_create(scene_stack* stack) {
+    stack->items = stack->local;
+    stack->count = 0;
+    stack->capacity = SCENE_STACK_SIZE;
+}
+
+static void stack_destroy(scene_stack* stack) {
+    if (stack->items != stack->local) {
+        kfree(stack->items, sizeof(u32) * stack->capacity, MEMORY_TAG_SCENE);
+    }
+}
+
+static void stack_push(scene_stack* stack, u32 value) {
+    if (stack->count == stack->capacity) {
+        u32* items = kallocate(sizeof(u32) * stack->capacity * 2, MEMORY_TAG_SCENE);
+        kcopy_memory(items, stack->items, sizeof(u32) * stack->count);
+        stack_destroy(stack);
+        stack->items = items;
+        stack->capacity *= 2;
+    }
+    stack->items[stack->count++] = value;
+}
+
+static u32 stack_pop(scene_stack* stack) {
+    return stack->items[--stack->count];
+}
+
+static b8 node_is_leaf(const scene_node* node) {
+    return node->left == INVALID_ID;
+}
+
+static void node_refit(u32 index) {
+    scene_node* node = &state.nodes[index];
+    const scene_node* left = &state.nodes[node->left];
+    const scene_node* right = &state.nodes[node->right];
+    node->box = aabb_union(left->box, right->box);
+    node->height = 1 + (left->height > right->height ? left->height : right->height);
+}
+
+static void replace_child(u32 parent, u32 old_child, u32 new_child) {
+    if (parent == INVALID_ID) {
+        state.root = new_child;
+    } else if (state.nodes[parent].left == old_child) {
+        state.nodes[parent].left = new_child;
+    } else {
+        state.nodes[parent].right = new_child;
+    }
+}
+
+/*
+If one child of a is taller than the other by more than one, rotates the
+taller child up into a's place. Returns the root of the subtree afterwards.
+*/
+static u32 balance(u32 a) {
+    scene_node* node_a = &state.nodes[a];
+    if (node_is_leaf(node_a) || node_a->height < 2) {
+        return a;
+    }
+
+    u32 b = node_a->left;
+    u32 c = node_a->right;
+    i32 skew = state.nodes[c].height - state.nodes[b].height;
+    if (skew >= -1 && skew <= 1) {
+        return a;
+    }
+
+    // The taller child rises; the shorter grandchild beneath it moves down to a.
+    u32 up = skew > 1 ? c : b;
+    u32 other = skew > 1 ? b : c;
+    scene_node* node_up = &state.nodes[up];
+    u32 f = node_up->left;
+    u32 g = node_up->right;
+
+    node_up->left = a;
+    node_up->parent = node_a->parent;
+    node_a->parent = up;
+    replace_child(node_up->parent, a, up);
+
+    u32 tall = state.nodes[f].height > state.nodes[g].height ? f : g;
+    u32 short_ = tall == f ? g : f;
+    node_up->right = tall;
+    node_a->left = other;
+    node_a->right = short_;
+    state.nodes[short_].parent = a;
+    state.nodes[other].parent = a;
+
+    node_refit(a);
+    node_refit(up);
+    return up;
+}
+
+static void insert_leaf(u32 leaf) {
+    if (state.root == INVALID_ID) {
+        state.root = leaf;
+        state.nodes[leaf].parent = INVALID_ID;
+        return;
+    }
+
+    // Walk down to the sibling whose box grows least, by surface area.
+    aabb leaf_box = state.nodes[leaf].box;
+    u32 index = state.root;
+    while (!node_is_leaf(&state.nodes[index])) {
+        const scene_node* node = &state.nodes[index];
+        f32 area = aabb_surface_area(node->box);
+        f32 combined_area = aabb_surface_area(aabb_union(node->box, leaf_box));
+        // Pairing with this node makes a new parent; descending grows this node's box.
+        f32 cost = 2.0f * combined_area;
+        f32 inherited = 2.0f * (combined_area - area);
+
+        f32 child_costs[2];
+        u32 children[2] = {node->left, node->right};
+        for (u32 i = 0; i < 2; ++i) {
+            const scene_node* child = &state.nodes[children[i]];
+            f32 grown = aabb_surface_area(aabb_union(child->box, leaf_box));
+            child_costs[i] = (node_is_leaf(child) ? grown : grown - aabb_surface_area(child->box)) + inherited;
+        }
+        if (cost < child_costs[0] && cost < child_costs[1]) {
+            break;
+        }
+        index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+
+    u32 sibling = index;
+    u32 old_parent = state.nodes[sibling].parent;
+    u32 new_parent = node_allocate();
+    scene_node* parent = &state.nodes[new_parent];
+    parent->parent = old_parent;
+    parent->left = sibling;
+    parent->right = leaf;
+    replace_child(old_parent, sibling, new_parent);
+    state.nodes[sibling].parent = new_parent;
+    state.nodes[leaf].parent = new_parent;
+
+    for (index = new_parent; index != INVALID_ID; index = state.nodes[index].parent) {
+        index = balance(index);
+        node_refit(index);
+    }
+}
+
+static void remove_leaf(u32 leaf) {
+    if (leaf == state.root) {
+        state.root = INVALID_ID;
+        return;
+    }
+
+    // The sibling takes the parent's place.
+    u32 parent = state.nodes[leaf].parent;
+    u32 grandparent = state.nodes[parent].parent;
+    u32 sibling = state.nodes[parent].left == leaf ? state.nodes[parent].right : state.nodes[parent].left;
+    replace_child(grandparent, parent, sibling);
+    state.nodes[sibling].parent = grandparent;
+    node_free(parent);
+
+    for (u32 index = grandparent; index != INVALID_ID; index = state.nodes[index].parent) {
+        index = balance(index);
+        node_refit(index);
+    }
+}
+
+static aabb instance_bounds(const mesh_resource_data* mesh, vec3 position, f32 scale) {
+    vec3 a = vec3_add(position, vec3_mul_scalar(vec3_create(mesh->bounds_min[0], mesh->bounds_min[1], mesh->bounds_min[2]), scale));
+    vec3 b = vec3_add(position, vec3_mul_scalar(vec3_create(mesh->bounds_max[0], mesh->bounds_max[1], mesh->bounds_max[2]), scale));
+    return (aabb){vec3_min(a, b), vec3_max(a, b)};
+}
+
+static scene_slot* slot_get(scene_instance instance) {
+    if (!is_initialized || instance.generation == 0 || instance.index >= state.capacity) {
+        return 0;
+    }
+    scene_slot* slot = &state.slots[instance.index];
+    if (slot->generation != instance.generation || slot->leaf == INVALID_ID) {
+        return 0;
+    }
+    return slot;
+}
+
+static scene_instance slot_handle(const scene_slot* slot) {
+    scene_instance instance;
+    instance.index = (u32)(slot - state.slots);
+    instance.generation = slot->generation;
+    return instance;
+}
+
+b8 scene_system_initialize(u32 max_instance_count) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    if (max_instance_count == 0 || max_instance_count >= INVALID_ID / 2) {
+        KERROR("scene_system_initialize requires a max_instance_count above zero.");
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(scene_system_state));
+    state.capacity = max_instance_count;
+    state.slots = kallocate(sizeof(scene_slot) * max_instance_count, MEMORY_TAG_SCENE);
+    for (u32 i = 0; i < max_instance_count; ++i) {
+        state.slots[i].leaf = INVALID_ID;
+        state.slots[i].next_free = i + 1 < max_instance_count ? i + 1 : INVALID_ID;
+    }
+    state.first_free_slot = 0;
+
+    state.node_capacity = max_instance_count * 2;
+    state.nodes = kallocate(sizeof(scene_node) * state.node_capacity, MEMORY_TAG_SCENE);
+    for (u32 i = 0; i < state.node_capacity; ++i) {
+        state.nodes[i].parent = i + 1 < state.node_capacity ? i + 1 : INVALID_ID;
+        state.nodes[i].height = -1;
+    }
+    state.first_free_node = 0;
+    state.root = INVALID_ID;
+
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void scene_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    kfree(state.slots, sizeof(scene_slot) * state.capacity, MEMORY_TAG_SCENE);
+    kfree(state.nodes, sizeof(scene_node) * state.node_capacity, MEMORY_TAG_SCENE);
+    kzero_memory(&state, sizeof(scene_system_state));
+    is_initialized = FALSE;
+}
+
+scene_instance scene_instance_create(const struct mesh_resource_data* mesh, vec3 position, f32 scale, void* user_data) {
+    scene_instance instance = {0};
+    if (!is_initialized || !mesh) {
+        return instance;
+    }
+    if (state.first_free_slot == INVALID_ID) {
+        KERROR("scene_instance_create: all %u instances are in use.", state.capacity);
+        return instance;
+    }
+
+    u32 index = state.first_free_slot;
+    scene_slot* slot = &state.slots[index];
+    state.first_free_slot = slot->next_free;
+
+    // Skip generation 0 when wrapping, so zeroed handles stay invalid.
+    slot->generation++;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->mesh = mesh;
+    slot->position = position;
+    slot->scale = scale;
+    slot->bounds = instance_bounds(mesh, position, scale);
+    slot->user_data = user_data;
+    kzero_memory(&slot->material, sizeof(material_instance));
+
+    slot->leaf = node_allocate();
+    state.nodes[slot->leaf].box = aabb_expanded(slot->bounds, SCENE_AABB_MARGIN);
+    state.nodes[slot->leaf].slot = index;
+    insert_leaf(slot->leaf);
+
+    instance.index = index;
+    instance.generation = slot->generation;
+    return instance;
+}
+
+void scene_instance_destroy(scene_instance instance) {
+    scene_slot* slot = slot_get(instance);
+    if (!slot) {
+        return;
+    }
+    remove_leaf(slot->leaf);
+    node_free(slot->leaf);
+    slot->leaf = INVALID_ID;
+    slot->mesh = 0;
+    slot->user_data = 0;
+    slot->next_free = state.first_free_slot;
+    state.first_free_slot = instance.index;
+}
+
+b8 scene_instance_is_valid(scene_instance instance) {
+    return slot_get(instance) != 0;
+}
+
+void scene_instance_set_transform(scene_instance instance, vec3 position, f32 scale) {
+    scene_slot* slot = slot_get(instance);
+    if (!slot) {
+        return;
+    }
+    slot->position = position;
+    slot->scale = scale;
+    slot->bounds = instance_bounds(slot->mesh, position, scale);
+
+    // Still within the margin, so the tree needs no change.
+    if (aabb_contains(state.nodes[slot->leaf].box, slot->bounds)) {
+        return;
+    }
+    remove_leaf(slot->leaf);
+    state.nodes[slot->leaf].box = aabb_expanded(slot->bounds, SCENE_AABB_MARGIN);
+    insert_leaf(slot->leaf);
+}
+
+aabb scene_instance_bounds(scene_instance instance) {
+    scene_slot* slot = slot_get(instance);
+    if (!slot) {
+        return (aabb){vec3_zero(), vec3_zero()};
+    }
+    return slot->bounds;
+}
+
+void* scene_instance_user_data(scene_instance instance) {
+    scene_slot* slot = slot_get(instance);
+    return slot ? slot->user_data : 0;
+}
+
+void scene_instance_set_material(scene_instance instance, material_instance material) {
+    scene_slot* slot = slot_get(instance);
+    if (slot) {
+        slot->material = material;
+    }
+}
+
+static void collect(const scene_slot* slot, void* context) {
+    scene_collect_context* c = context;
+    if (c->count < c->max_count) {
+        c->out_instances[c->count] = slot_handle(slot);
+    }
+    c->count++;
+}
+
+/*
+Visits the instances in a frustum. Each node carries the planes its box
+still straddles: a box fully inside a plane passes it for the whole subtree,
+and a box inside all six accepts its subtree without further tests.
+*/
+static void visit_frustum(const frustum* f, pfn_scene_visit visit, void* context) {
+    if (!is_initialized || state.root == INVALID_ID) {
+        return;
+    }
+    // Each entry is a node, pushed after the plane mask it inherits.
+    scene_stack stack;
+    stack_create(&stack);
+    stack_push(&stack, 0x3F);
+    stack_push(&stack, state.root);
+
+    while (stack.count > 0) {
+        const scene_node* node = &state.nodes[stack_pop(&stack)];
+        u8 mask = (u8)stack_pop(&stack);
+        b8 leaf = node_is_leaf(node);
+        // Leaves are tested on the instance's own bounds rather than the enlarged box.
+        aabb box = leaf ? state.slots[node->slot].bounds : node->box;
+
+        b8 outside = FALSE;
+        for (u32 i = 0; i < 6 && mask; ++i) {
+            if (!(mask & (1 << i))) {
+                continue;
+            }
+            const vec4* p = &f->planes[i];
+            f32 far_distance = p->x * (p->x >= 0 ? box.max.x : box.min.x) +
+                               p->y * (p->y >= 0 ? box.max.y : box.min.y) +
+                               p->z * (p->z >= 0 ? box.max.z : box.min.z) + p->w;
+            if (far_distance < 0) {
+                outside = TRUE;
+                break;
+            }
+            f32 near_distance = p->x * (p->x >= 0 ? box.min.x : box.max.x) +
+                                p->y * (p->y >= 0 ? box.min.y : box.max.y) +
+                                p->z * (p->z >= 0 ? box.min.z : box.max.z) + p->w;
+            if (near_distance >= 0) {
+                mask &= ~(1 << i);
+            }
+        }
+        if (outside) {
+            continue;
+        }
+
+        if (leaf) {
+            visit(&state.slots[node->slot], context);
+        } else {
+            stack_push(&stack, mask);
+            stack_push(&stack, node->left);
+            stack_push(&stack, mask);
+            stack_push(&stack, node->right);
+        }
+    }
+    stack_destroy(&stack);
+}
+
+u32 scene_query_frustum(const frustum* f, scene_instance* out_instances, u32 max_count) {
+    scene_collect_context c = {out_instances, max_count, 0};
+    visit_frustum(f, collect, &c);
+    return c.count;
+}
+
+u32 scene_query_aabb(aabb box, scene_instance* out_instances, u32 max_count) {
+    scene_collect_context c = {out_instances, max_count, 0};
+    if (!is_initialized || state.root == INVALID_ID) {
+        return 0;
+    }
+    scene_stack stack;
+    stack_create(&stack);
+    stack_push(&stack, state.root);
+    while (stack.count > 0) {
+        const scene_node* node = &state.nodes[stack_pop(&stack)];
+        if (!aabb_overlaps(node->box, box)) {
+            continue;
+        }
+        if (node_is_leaf(node)) {
+            const scene_slot* slot = &state.slots[node->slot];
+            if (aabb_overlaps(slot->bounds, box)) {
+                collect(slot, &c);
+            }
+        } else {
+            stack_push(&stack, node->left);
+            stack_push(&stack, node->right);
+        }
+    }
+    stack_destroy(&stack);
+    return c.count;
+}
+
+b8 scene_raycast(vec3 origin, vec3 direction, f32 max_distance, scene_hit* out_hit) {
+    if (!is_initialized || state.root == INVALID_ID) {
+        return FALSE;
+    }
+    // Zero components get a huge reciprocal rather than infinity, which would make 0 * inf.
+    vec3 inverse;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 d = direction.elements[axis];
+        inverse.elements[axis] = d != 0.0f ? 1.0f / d : 1e30f;
+    }
+
+    f32 nearest = max_distance;
+    const scene_slot* hit = 0;
+    scene_stack stack;
+    stack_create(&stack);
+    stack_push(&stack, state.root);
+    while (stack.count > 0) {
+        const scene_node* node = &state.nodes[stack_pop(&stack)];
+        f32 t;
+        // Nodes further than the nearest hit so far can't hold a nearer one.
+        if (!aabb_intersects_ray(node->box, origin, inverse, nearest, &t)) {
+            continue;
+        }
+        if (node_is_leaf(node)) {
+            const scene_slot* slot = &state.slots[node->slot];
+            if (aabb_intersects_ray(slot->bounds, origin, inverse, nearest, &t)) {
+                nearest = t;
+                hit = slot;
+            }
+        } else {
+            stack_push(&stack, node->left);
+            stack_push(&stack, node->right);
+        }
+    }
+    stack_destroy(&stack);
+
+    if (!hit) {
+        return FALSE;
+    }
+    out_hit->instance = slot_handle(hit);
+    out_hit->distance = nearest;
+    return TRUE;
+}
+
+static void submit(const scene_slot* slot, void* context) {
+    renderer_submit_mesh_material(slot->mesh, slot->position.elements, slot->scale, slot->material);
+    (*(u32*)context)++;
+}
+
+u32 scene_submit_visible(const frustum* f) {
+    u32 count = 0;
+    visit_frustum(f, submit, &count);
+    return count;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "math/math_types.h"
+#include "renderer/renderer_types.inl"
+
+struct mesh_resource_data;
+
+/*
+Holds the renderable instances of the scene in a bounding volume hierarchy,
+so visibility and gameplay queries visit O(log n + k) nodes rather than
+every instance. The tree is kept up to date incrementally: each instance
+sits in a slightly enlarged box, and only moves which leave it reinsert
+the instance; the tree rebalances itself as instances come and go.
+*/
+
+/**
+ * An instance in the scene. Like resource handles, handles go stale once
+ * their instance is destroyed, and a zeroed handle is invalid.
+ */
+typedef struct scene_instance {
+    u32 index;
+    u32 generation;
+} scene_instance;
+
+typedef struct scene_hit {
+    scene_instance instance;
+    // The distance along the ray to where it enters the instance's bounds.
+    f32 distance;
+} scene_hit;
+
+/**
+ * Reserves storage for the scene.
+ * @param max_instance_count The most instances which can exist at once.
+ */
+b8 scene_system_initialize(u32 max_instance_count);
+void scene_system_shutdown();
+
+/**
+ * Adds a mesh to the scene. The mesh must stay loaded while the instance exists.
+ * @param user_data Returned by scene_instance_user_data, e.g. the entity the instance belongs to.
+ * @returns The instance, or an invalid handle if there is no room left.
+ */
+KAPI scene_instance scene_instance_create(const struct mesh_resource_data* mesh, vec3 position, f32 scale, void* user_data);
+KAPI void scene_instance_destroy(scene_instance instance);
+KAPI b8 scene_instance_is_valid(scene_instance instance);
+
+KAPI void scene_instance_set_transform(scene_instance instance, vec3 position, f32 scale);
+
+// The instance's bounds in world space.
+KAPI aabb scene_instance_bounds(scene_instance instance);
+KAPI void* scene_instance_user_data(scene_instance instance);
+
+// The material the instance is drawn with. Instances start without one.
+KAPI void scene_instance_set_material(scene_instance instance, material_instance material);
+
+/**
+ * Finds the instances whose bounds may be inside a frustum.
+ * @param out_instances Filled with up to max_count instances.
+ * @returns The number found, which may be more than max_count.
+ */
+KAPI u32 scene_query_frustum(const frustum* f, scene_instance* out_instances, u32 max_count);
+
+/**
+ * Finds the instances whose bounds overlap a box.
+ * @param out_instances Filled with up to max_count instances.
+ * @returns The number found, which may be more than max_count.
+ */
+KAPI u32 scene_query_aabb(aabb box, scene_instance* out_instances, u32 max_count);
+
+/**
+ * Finds the nearest instance whose bounds a ray enters.
+ * @param direction Need not be normalized; distances are in multiples of it.
+ * @returns TRUE if anything was hit within max_distance.
+ */
+KAPI b8 scene_raycast(vec3 origin, vec3 direction, f32 max_distance, scene_hit* out_hit);
+
+/**
+ * Submits every instance which may be inside the frustum to the renderer
+ * for the next frame.
+ * @returns The number submitted.
+ */
+KAPI u32 scene_submit_visible(const frustum* f);
@@ -0,0 +1,485 @@
+#include "transform_system.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "math/kmath.h"
+#include "systems/job_system.h"
+
+// Below this many transforms, one thread is faster than handing out batches.
+#define TRANSFORM_PARALLEL_THRESHOLD 4096
+// Roughly how many transforms each parallel batch covers.
+#define TRANSFORM_BATCH_SIZE 1024
+
+typedef enum transform_flag_bits {
+    // Position, rotation or scale changed since the last update.
+    TRANSFORM_FLAG_LOCAL_DIRTY = 0x1,
+    // Some descendant is LOCAL_DIRTY, so the subtree cannot be skipped.
+    TRANSFORM_FLAG_SUBTREE_DIRTY = 0x2,
+    // The world matrix was recomputed by the update in progress.
+    TRANSFORM_FLAG_WORLD_CHANGED = 0x4,
+} transform_flag_bits;
+
+/*
+Per-transform data, structure-of-arrays, in hierarchy order: each transform
+is followed by its descendants, so every parent precedes its children and
+each subtree is one contiguous range, ending at subtree_ends. Handles map
+onto this through slots, as the order changes whenever the hierarchy does.
+*/
+typedef struct transform_arrays {
+    vec3* positions;
+    quat* rotations;
+    vec3* scales;
+    mat4* world;
+    // Index of the parent in these arrays, or INVALID_ID for roots.
+    u32* parents;
+    // One past the index of the last descendant.
+    u32* subtree_ends;
+    u32* slots;
+    u8* flags;
+} transform_arrays;
+
+typedef struct transform_slot {
+    u32 generation;
+    // Index in the arrays, or INVALID_ID while the slot is free.
+    u32 index;
+    // The hierarchy, by slot. Roots are siblings of each other.
+    u32 parent;
+    u32 first_child;
+    u32 next_sibling;
+    u32 prev_sibling;
+} transform_slot;
+
+typedef struct transform_system_state {
+    u32 capacity;
+    transform_slot* slots;
+    // Free slots are chained through next_sibling.
+    u32 first_free_slot;
+    u32 first_root;
+
+    // Entries in use, including those of transforms destroyed since the last update.
+    u32 count;
+    transform_arrays arrays;
+    // Where the arrays are rebuilt in hierarchy order, then swapped with them.
+    transform_arrays back;
+    // Set by anything which changes the hierarchy, until the order is rebuilt.
+    b8 order_dirty;
+
+    // The index of each root, in order.
+    u32* roots;
+    u32 root_count;
+
+    u32 last_update_count;
+} transform_system_state;
+
+static b8 is_initialized = FALSE;
+static transform_system_state state;
+
+static void arrays_allocate(transform_arrays* a, u32 capacity) {
+    a->positions = kallocate(sizeof(vec3) * capacity, MEMORY_TAG_TRANSFORM);
+    a->rotations = kallocate(sizeof(quat) * capacity, MEMORY_TAG_TRANSFORM);
+    a->scales = kallocate(sizeof(vec3) * capacity, MEMORY_TAG_TRANSFORM);
+    a->world = kallocate(sizeof(mat4) * capacity, MEMORY_TAG_TRANSFORM);
+    a->parents = kallocate(sizeof(u32) * capacity, MEMORY_TAG_TRANSFORM);
+    a->subtree_ends = kallocate(sizeof(u32) * capacity, MEMORY_TAG_TRANSFORM);
+    a->slots = kallocate(sizeof(u32) * capacity, MEMORY_TAG_TRANSFORM);
+    a->flags = kallocate(sizeof(u8) * capacity, MEMORY_TAG_TRANSFORM);
+}
+
+static void arrays_free(transform_arrays* a, u32 capacity) {
+    kfree(a->positions, sizeof(vec3) * capacity, MEMORY_TAG_TRANSFORM);
+    kfree(a->rotations, sizeof(quat) * capacity, MEMORY_TAG_TRANSFORM);
+    kfree(a->scales, sizeof(vec3) * capacity, MEMORY_TAG_TRANSFORM);
+    kfree(a->world, sizeof(mat4) * capacity, MEMORY_TAG_TRANSFORM);
+    kfree(a->parents, sizeof(u32) * capacity, MEMORY_TAG_TRANSFORM);
+    kfree(a->subtree_ends, sizeof(u32) * capacity, MEMORY_TAG_TRANSFORM);
+    kfree(a->slots, sizeof(u32) * capacity, MEMORY_TAG_TRANSFORM);
+    kfree(a->flags, sizeof(u8) * capacity, MEMORY_TAG_TRANSFORM);
+}
+
+b8 transform_system_initialize(u32 max_transform_count) {
+    if (is_initialized) {
+        return FALSE;
+    }
+    if (max_transform_count == 0 || max_transform_count == INVALID_ID) {
+        KERROR("transform_system_initialize requires a max_transform_count above zero.");
+        return FALSE;
+    }
+
+    kzero_memory(&state, sizeof(transform_system_state));
+    state.capacity = max_transform_count;
+    state.slots = kallocate(sizeof(transform_slot) * max_transform_count, MEMORY_TAG_TRANSFORM);
+    for (u32 i = 0; i < max_transform_count; ++i) {
+        transform_slot* slot = &state.slots[i];
+        slot->generation = 0;
+        slot->index = INVALID_ID;
+        slot->next_sibling = i + 1 < max_transform_count ? i + 1 : INVALID_ID;
+    }
+    state.first_free_slot = 0;
+    state.first_root = INVALID_ID;
+
+    arrays_allocate(&state.arrays, max_transform_count);
+    arrays_allocate(&state.back, max_transform_count);
+    state.roots = kallocate(sizeof(u32) * max_transform_count, MEMORY_TAG_TRANSFORM);
+
+    is_initialized = TRUE;
+    return TRUE;
+}
+
+void transform_system_shutdown() {
+    if (!is_initialized) {
+        return;
+    }
+    arrays_free(&state.arrays, state.capacity);
+    arrays_free(&state.back, state.capacity);
+    kfree(state.roots, sizeof(u32) * state.capacity, MEMORY_TAG_TRANSFORM);
+    kfree(state.slots, sizeof(transform_slot) * state.capacity, MEMORY_TAG_TRANSFORM);
+    kzero_memory(&state, sizeof(transform_system_state));
+    is_initialized = FALSE;
+}
+
+// Returns the slot of a live transform, or INVALID_ID.
+static u32 slot_of(transform_handle handle) {
+    if (!is_initialized || handle.generation == 0 || handle.index >= state.capacity) {
+        return INVALID_ID;
+    }
+    transform_slot* slot = &state.slots[handle.index];
+    if (slot->generation != handle.generation || slot->index == INVALID_ID) {
+        return INVALID_ID;
+    }
+    return handle.index;
+}
+
+static void link(u32 slot_index, u32 parent) {
+    transform_slot* slot = &state.slots[slot_index];
+    u32* first = parent == INVALID_ID ? &state.first_root : &state.slots[parent].first_child;
+    slot->parent = parent;
+    slot->prev_sibling = INVALID_ID;
+    slot->next_sibling = *first;
+    if (*first != INVALID_ID) {
+        state.slots[*first].prev_sibling = slot_index;
+    }
+    *first = slot_index;
+}
+
+static void unlink(u32 slot_index) {
+    transform_slot* slot = &state.slots[slot_index];
+    if (slot->prev_sibling != INVALID_ID) {
+        state.slots[slot->prev_sibling].next_sibling = slot->next_sibling;
+    } else if (slot->parent != INVALID_ID) {
+        state.slots[slot->parent].first_child = slot->next_sibling;
+    } else {
+        state.first_root = slot->next_sibling;
+    }
+    if (slot->next_sibling != INVALID_ID) {
+        state.slots[slot->next_sibling].prev_sibling = slot->prev_sibling;
+    }
+}
+
+static void rebuild_order();
+
+// Flags a transform for update, and its ancestors as having a dirty subtree.
+static void mark_dirty(u32 index) {
+    transform_arrays* a = &state.arrays;
+    a->flags[index] |= TRANSFORM_FLAG_LOCAL_DIRTY;
+    for (u32 parent = a->parents[index]; parent != INVALID_ID; parent = a->parents[parent]) {
+        if (a->flags[parent] & TRANSFORM_FLAG_SUBTREE_DIRTY) {
+            // Its ancestors were marked along with it.
+            break;
+        }
+        a->flags[parent] |= TRANSFORM_FLAG_SUBTREE_DIRTY;
+    }
+}
+
+transform_handle transform_create(transform_handle parent) {
+    transform_handle handle = {INVALID_ID, 0};
+    if (!is_initialized) {
+        return handle;
+    }
+
+    u32 parent_slot = INVALID_ID;
+    if (parent.generation != 0) {
+        parent_slot = slot_of(parent);
+        if (parent_slot == INVALID_ID) {
+            KERROR("transform_create: the parent transform is not valid.");
+            return handle;
+        }
+    }
+
+    // Entries of destroyed transforms are normally reclaimed by the next update.
+    if (state.count >= state.capacity && state.order_dirty) {
+        rebuild_order();
+    }
+    if (state.first_free_slot == INVALID_ID || state.count >= state.capacity) {
+        KERROR("transform_create: no room left for more than %u transforms.", state.capacity);
+        return handle;
+    }
+
+    u32 slot_index = state.first_free_slot;
+    transform_slot* slot = &state.slots[slot_index];
+    state.first_free_slot = slot->next_sibling;
+    slot->generation++;
+    if (slot->generation == 0) {
+        slot->generation = 1;
+    }
+    slot->first_child = INVALID_ID;
+    link(slot_index, parent_slot);
+
+    // Appending keeps parents ahead of children, but not subtrees contiguous.
+    u32 index = state.count++;
+    slot->index = index;
+    transform_arrays* a = &state.arrays;
+    a->positions[index] = vec3_zero();
+    a->rotations[index] = quat_identity();
+    a->scales[index] = vec3_one();
+    a->world[index] = mat4_identity();
+    a->parents[index] = parent_slot == INVALID_ID ? INVALID_ID : state.slots[parent_slot].index;
+    a->subtree_ends[index] = index + 1;
+    a->slots[index] = slot_index;
+    a->flags[index] = 0;
+    mark_dirty(index);
+    state.order_dirty = TRUE;
+
+    handle.index = slot_index;
+    handle.generation = slot->generation;
+    return handle;
+}
+
+void transform_destroy(transform_handle transform) {
+    u32 top = slot_of(transform);
+    if (top == INVALID_ID) {
+        return;
+    }
+    unlink(top);
+
+    // Free the whole subtree, walking it through the links.
+    u32 slot_index = top;
+    while (slot_index != INVALID_ID) {
+        transform_slot* slot = &state.slots[slot_index];
+        if (slot->first_child != INVALID_ID) {
+            // Detach the child so this slot is a leaf when it comes around again.
+            u32 child = slot->first_child;
+            slot->first_child = state.slots[child].next_sibling;
+            state.slots[child].parent = slot_index;
+            slot_index = child;
+            continue;
+        }
+
+        u32 parent = slot_index == top ? INVALID_ID : slot->parent;
+        state.arrays.slots[slot->index] = INVALID_ID;
+        slot->index = INVALID_ID;
+        slot->next_sibling = state.first_free_slot;
+        state.first_free_slot = slot_index;
+        slot_index = parent;
+    }
+    state.order_dirty = TRUE;
+}
+
+b8 transform_is_valid(transform_handle transform) {
+    return slot_of(transform) != INVALID_ID;
+}
+
+b8 transform_set_parent(transform_handle transform, transform_handle parent) {
+    u32 slot_index = slot_of(transform);
+    if (slot_index == INVALID_ID) {
+        return FALSE;
+    }
+    u32 parent_slot = INVALID_ID;
+    if (parent.generation != 0) {
+        parent_slot = slot_of(parent);
+        if (parent_slot == INVALID_ID) {
+            KERROR("transform_set_parent: the parent transform is not valid.");
+            return FALSE;
+        }
+        for (u32 ancestor = parent_slot; ancestor != INVALID_ID; ancestor = state.slots[ancestor].parent) {
+            if (ancestor == slot_index) {
+                KERROR("transform_set_parent: a transform cannot be parented to itself or its descendants.");
+                return FALSE;
+            }
+        }
+    }
+
+    unlink(slot_index);
+    link(slot_index, parent_slot);
+
+    u32 index = state.slots[slot_index].index;
+    state.arrays.parents[index] = parent_slot == INVALID_ID ? INVALID_ID : state.slots[parent_slot].index;
+    mark_dirty(index);
+    state.order_dirty = TRUE;
+    return TRUE;
+}
+
+void transform_set_position(transform_handle transform, vec3 position) {
+    u32 slot_index = slot_of(transform);
+    if (slot_index != INVALID_ID) {
+        u32 index = state.slots[slot_index].index;
+        state.arrays.positions[index] = position;
+        mark_dirty(index);
+    }
+}
+
+void transform_set_rotation(transform_handle transform, quat rotation) {
+    u32 slot_index = slot_of(transform);
+    if (slot_index != INVALID_ID) {
+        u32 index = state.slots[slot_index].index;
+        state.arrays.rotations[index] = rotation;
+        mark_dirty(index);
+    }
+}
+
+void transform_set_scale(transform_handle transform, vec3 scale) {
+    u32 slot_index = slot_of(transform);
+    if (slot_index != INVALID_ID) {
+        u32 index = state.slots[slot_index].index;
+        state.arrays.scales[index] = scale;
+        mark_dirty(index);
+    }
+}
+
+vec3 transform_get_position(transform_handle transform) {
+    u32 slot_index = slot_of(transform);
+    return slot_index != INVALID_ID ? state.arrays.positions[state.slots[slot_index].index] : vec3_zero();
+}
+
+quat transform_get_rotation(transform_handle transform) {
+    u32 slot_index = slot_of(transform);
+    return slot_index != INVALID_ID ? state.arrays.rotations[state.slots[slot_index].index] : quat_identity();
+}
+
+vec3 transform_get_scale(transform_handle transform) {
+    u32 slot_index = slot_of(transform);
+    return slot_index != INVALID_ID ? state.arrays.scales[state.slots[slot_index].index] : vec3_one();
+}
+
+const mat4* transform_get_world(transform_handle transform) {
+    u32 slot_index = slot_of(transform);
+    return slot_index != INVALID_ID ? &state.arrays.world[state.slots[slot_index].index] : 0;
+}
+
+u32 transform_system_last_update_count() {
+    return state.last_update_count;
+}
+
+/*
+Rewrites the arrays in hierarchy order by walking the links depth first,
+dropping the entries of destroyed transforms. Only runs after the hierarchy
+has changed.
+*/
+static void rebuild_order() {
+    transform_arrays* from = &state.arrays;
+    transform_arrays* to = &state.back;
+    u32 count = 0;
+    state.root_count = 0;
+
+    u32 slot_index = state.first_root;
+    while (slot_index != INVALID_ID) {
+        transform_slot* slot = &state.slots[slot_index];
+        u32 old = slot->index;
+        to->positions[count] = from->positions[old];
+        to->rotations[count] = from->rotations[old];
+        to->scales[count] = from->scales[old];
+        to->world[count] = from->world[old];
+        to->flags[count] = from->flags[old] & TRANSFORM_FLAG_LOCAL_DIRTY;
+        to->slots[count] = slot_index;
+        // Parents come first, so theirs is already the new index.
+        to->parents[count] = slot->parent == INVALID_ID ? INVALID_ID : state.slots[slot->parent].index;
+        if (slot->parent == INVALID_ID) {
+            state.roots[state.root_count++] = count;
+        }
+        slot->index = count++;
+
+        if (slot->first_child != INVALID_ID) {
+            slot_index = slot->first_child;
+            continue;
+        }
+
+        // A leaf. Close every subtree it ends, up to the next sibling.
+        while (slot_index != INVALID_ID) {
+            to->subtree_ends[state.slots[slot_index].index] = count;
+            if (state.slots[slot_index].next_sibling != INVALID_ID) {
+                slot_index = state.slots[slot_index].next_sibling;
+                break;
+            }
+            slot_index = state.slots[slot_index].parent;
+        }
+    }
+
+    // Recompute the subtree flags, children to parents.
+    for (u32 i = count; i-- > 0;) {
+        u32 parent = to->parents[i];
+        if (parent != INVALID_ID && (to->flags[i] & (TRANSFORM_FLAG_LOCAL_DIRTY | TRANSFORM_FLAG_SUBTREE_DIRTY))) {
+            to->flags[parent] |= TRANSFORM_FLAG_SUBTREE_DIRTY;
+        }
+    }
+
+    transform_arrays rebuilt = *to;
+    state.back = state.arrays;
+    state.arrays = rebuilt;
+    state.count = count;
+    state.order_dirty = FALSE;
+}
+
+// Updates the transforms in [begin, end), which must be whole subtrees.
+static u32 update_range(u32 begin, u32 end) {
+    transform_arrays* a = &state.arrays;
+    u32 updated = 0;
+    u32 i = begin;
+    while (i < end) {
+        u8 flags = a->flags[i];
+        u32 parent = a->parents[i];
+        b8 parent_changed = parent != INVALID_ID && (a->flags[parent] & TRANSFORM_FLAG_WORLD_CHANGED);
+
+        if (!parent_changed && !(flags & (TRANSFORM_FLAG_LOCAL_DIRTY | TRANSFORM_FLAG_SUBTREE_DIRTY))) {
+            // Nothing in this subtree moved.
+            i = a->subtree_ends[i];
+            continue;
+        }
+
+        if (parent_changed || (flags & TRANSFORM_FLAG_LOCAL_DIRTY)) {
+            mat4* world = &a->world[i];
+            *world = mat4_from_trs(a->positions[i], a->rotations[i], a->scales[i]);
+            if (parent != INVALID_ID) {
+                mat4_mul_batch(world, &a->world[parent], world, 1);
+            }
+            a->flags[i] = TRANSFORM_FLAG_WORLD_CHANGED;
+            updated++;
+        } else {
+            a->flags[i] = 0;
+        }
+        ++i;
+    }
+
+    // WORLD_CHANGED only matters to children during the pass.
+    kzero_memory(&a->flags[begin], end - begin);
+    return updated;
+}
+
+// Updates a run of roots, each with its subtree. Roots are independent of each other.
+static void update_roots(void* context, u32 first_root, u32 end_root) {
+    u32 begin = state.roots[first_root];
+    u32 end = state.arrays.subtree_ends[state.roots[end_root - 1]];
+    u32 updated = update_range(begin, end);
+    __atomic_fetch_add(&state.last_update_count, updated, __ATOMIC_RELAXED);
+}
+
+void transform_system_update() {
+    if (!is_initialized) {
+        return;
+    }
+    if (state.order_dirty) {
+        rebuild_order();
+    }
+
+    state.last_update_count = 0;
+    if (state.root_count == 0) {
+        return;
+    }
+
+    if (state.count < TRANSFORM_PARALLEL_THRESHOLD || state.root_count < 2) {
+        update_roots(0, 0, state.root_count);
+        return;
+    }
+
+    // Batches of whole roots, sized by the average subtree.
+    u32 roots_per_batch = (u32)(((u64)state.root_count * TRANSFORM_BATCH_SIZE) / state.count);
+    job_system_parallel_for(update_roots, 0, state.root_count, roots_per_batch ? roots_per_batch : 1);
+}
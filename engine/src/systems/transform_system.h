@@ -0,0 +1,66 @@
+#pragma once
+
+#include "math/math_types.h"
+
+/**
+ * A transform in the hierarchy. Like resource handles, handles go stale
+ * once their transform is destroyed; generation 0 is never handed out, so
+ * a zeroed handle is invalid, and stands for "no parent" where one is taken.
+ */
+typedef struct transform_handle {
+    u32 index;
+    u32 generation;
+} transform_handle;
+
+/**
+ * Reserves storage for the hierarchy.
+ * @param max_transform_count The most transforms which can exist at once.
+ */
+b8 transform_system_initialize(u32 max_transform_count);
+void transform_system_shutdown();
+
+/**
+ * Brings the world matrix of every transform which changed, or whose
+ * ancestors did, up to date. Called once per frame by the application,
+ * after the game has updated.
+ */
+void transform_system_update();
+
+/**
+ * Creates a transform at the origin with no rotation and a scale of one.
+ * @param parent The transform to be a child of, or a zeroed handle for none.
+ * @returns The transform, or an invalid handle if there is no room left.
+ */
+KAPI transform_handle transform_create(transform_handle parent);
+
+// Destroys a transform along with all of its descendants.
+KAPI void transform_destroy(transform_handle transform);
+
+KAPI b8 transform_is_valid(transform_handle transform);
+
+/**
+ * Moves a transform, with its descendants, under a new parent. Its local
+ * values are kept, so it moves in the world along with its new parent.
+ * @param parent The new parent, or a zeroed handle for none.
+ * @returns FALSE if parent is the transform itself or one of its descendants.
+ */
+KAPI b8 transform_set_parent(transform_handle transform, transform_handle parent);
+
+KAPI void transform_set_position(transform_handle transform, vec3 position);
+KAPI void transform_set_rotation(transform_handle transform, quat rotation);
+KAPI void transform_set_scale(transform_handle transform, vec3 scale);
+
+// Position, rotation and scale, relative to the parent.
+KAPI vec3 transform_get_position(transform_handle transform);
+KAPI quat transform_get_rotation(transform_handle transform);
+KAPI vec3 transform_get_scale(transform_handle transform);
+
+/**
+ * The local-to-world matrix, as of the last transform_system_update.
+ * The pointer is only valid until transforms are next updated or created,
+ * either of which may reorder storage.
+ */
+KAPI const mat4* transform_get_world(transform_handle transform);
+
+// The number of world matrices the last update recomputed.
+KAPI u32 transform_system_last_update_count();
@@ -3,10 +3,12 @@
 set -e
 mkdir -p ../bin
 
-# Get a list of all the .c files.
-cFilenames=$(find . -type f -name "*.c")
+# The game code is built as its own library so the engine can hot-reload it.
+libAssembly="testbed_lib"
+libFilenames="src/game.c"
 
 assembly="testbed"
+cFilenames="src/entry.c"
 compilerFlags="-g -mmacosx-version-min=10.15"
 
 # Include paths - reference the engine
@@ -27,6 +29,10 @@ $(pkg-config --libs glfw3) \
 
 defines="-D_DEBUG -DVK_USE_PLATFORM_METAL_EXT"
 
+echo "Building $libAssembly..."
+clang $libFilenames $compilerFlags -shared -fPIC -o ../bin/lib$libAssembly.dylib $defines $includeFlags $linkerFlags
+install_name_tool -id "@rpath/lib$libAssembly.dylib" ../bin/lib$libAssembly.dylib
+
 echo "Building $assembly..."
 clang $cFilenames $compilerFlags -o ../bin/$assembly $defines $includeFlags $linkerFlags
 
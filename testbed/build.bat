@@ -2,20 +2,21 @@ REM Build script for testbed
 @ECHO OFF
 SetLocal EnableDelayedExpansion
 
-REM Get a list of all the .c files.
-SET cFilenames=
-FOR /R %%f in (*.c) do (
-    SET cFilenames=!cFilenames! %%f
-)
-
-REM echo "Files:" %cFilenames%
+REM The game code is built as its own library so the engine can hot-reload it.
+SET libAssembly=testbed_lib
+SET libFilenames=src/game.c
+SET libExports=-Xlinker /EXPORT:game_initialize -Xlinker /EXPORT:game_update -Xlinker /EXPORT:game_render -Xlinker /EXPORT:game_on_resize
 
 SET assembly=testbed
+SET cFilenames=src/entry.c
 SET compilerFlags=-g 
 REM -Wall -Werror
 SET includeFlags=-Isrc -I../engine/src/
 SET linkerFlags=-L../bin/ -lengine.lib
 SET defines=-D_DEBUG -DKIMPORT
 
+ECHO "Building %libAssembly%%..."
+clang %libFilenames% %compilerFlags% -shared -o ../bin/%libAssembly%.dll %defines% %includeFlags% %linkerFlags% %libExports%
+
 ECHO "Building %assembly%%..."
 clang %cFilenames% %compilerFlags% -o ../bin/%assembly%.exe %defines% %includeFlags% %linkerFlags%
\ No newline at end of file
@@ -4,19 +4,25 @@ set echo on
 
 mkdir -p ../bin
 
-# Get a list of all the .c files.
-cFilenames=$(find . -type f -name "*.c")
-
-# echo "Files:" $cFilenames
-
-assembly="testbed"
 compilerFlags="-g -fdeclspec -fPIC" 
 # -fms-extensions 
 # -Wall -Werror
 includeFlags="-Isrc -I../engine/src/"
-linkerFlags="-L../bin/ -lengine -Wl,-rpath,."
 defines="-D_DEBUG -DKIMPORT"
 
+# The game code is built as its own library so the engine can hot-reload it.
+libAssembly="testbed_lib"
+libFilenames="src/game.c"
+libLinkerFlags="-L../bin/ -lengine -Wl,-rpath,."
+
+echo "Building $libAssembly..."
+echo clang $libFilenames $compilerFlags -shared -o ../bin/lib$libAssembly.so $defines $includeFlags $libLinkerFlags
+clang $libFilenames $compilerFlags -shared -o ../bin/lib$libAssembly.so $defines $includeFlags $libLinkerFlags
+
+assembly="testbed"
+cFilenames="src/entry.c"
+linkerFlags="-L../bin/ -lengine -ldl -Wl,-rpath,."
+
 echo "Building $assembly..."
 echo clang $cFilenames $compilerFlags -o ../bin/$assembly $defines $includeFlags $linkerFlags
-clang $cFilenames $compilerFlags -o ../bin/$assembly $defines $includeFlags $linkerFlags
\ No newline at end of file
+clang $cFilenames $compilerFlags -o ../bin/$assembly $defines $includeFlags $linkerFlags
@@ -2,6 +2,7 @@
 
 #include <entry.h>
 #include <core/kmemory.h>
+#include <core/game_module.h>
 
 // Define the function to create a game
 b8 create_game(game* out_game) {
@@ -11,12 +12,18 @@ b8 create_game(game* out_game) {
     out_game->app_config.start_width = 1280;
     out_game->app_config.start_height = 720;
     out_game->app_config.name = "Kohi Engine Testbed";
-    out_game->update = game_update;
-    out_game->render = game_render;
-    out_game->initialize = game_initialize;
-    out_game->on_resize = game_on_resize;
+    out_game->app_config.renderer.present_mode = RENDERER_PRESENT_MODE_MAILBOX;
+    out_game->app_config.renderer.max_frames_in_flight = 2;
+    out_game->app_config.renderer.require_discrete_gpu = false;
+    // Anything set in here overrides the values above.
+    out_game->app_config.config_path = "../assets/config/testbed.ini";
 
-    // Create the game state.
+    // The game code lives in its own library so it can be hot-reloaded.
+    if (!game_module_load("testbed_lib", out_game)) {
+        return false;
+    }
+
+    // Create the game state. This is owned here, not by the library, so it survives reloads.
     out_game->state = kallocate(sizeof(game_state), MEMORY_TAG_GAME);
 
     return true;
@@ -0,0 +1,30 @@
+#!/bin/bash
+# Build script for tools - macOS
+set -e
+mkdir -p ../bin
+
+# Get a list of all the .c files.
+cFilenames=$(find . -type f -name "*.c")
+
+assembly="tools"
+compilerFlags="-g -mmacosx-version-min=10.15"
+includeFlags="-Isrc -I../engine/src"
+linkerFlags="-L../bin -lengine -Wl,-rpath,@executable_path"
+defines="-D_DEBUG"
+
+# Archive compression is optional and only built when the libraries are present.
+if pkg-config --exists liblz4; then
+    defines="$defines -DKOHI_USE_LZ4=1"
+    linkerFlags="$linkerFlags $(pkg-config --libs liblz4)"
+    includeFlags="$includeFlags $(pkg-config --cflags liblz4)"
+fi
+if pkg-config --exists libzstd; then
+    defines="$defines -DKOHI_USE_ZSTD=1"
+    linkerFlags="$linkerFlags $(pkg-config --libs libzstd)"
+    includeFlags="$includeFlags $(pkg-config --cflags libzstd)"
+fi
+
+echo "Building $assembly..."
+clang $cFilenames $compilerFlags -o ../bin/$assembly $defines $includeFlags $linkerFlags
+
+echo "Tools build complete."
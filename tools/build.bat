@@ -0,0 +1,19 @@
+REM Build script for tools
+@ECHO OFF
+SetLocal EnableDelayedExpansion
+
+REM Get a list of all the .c files.
+SET cFilenames=
+FOR /R %%f in (*.c) do (
+    SET cFilenames=!cFilenames! %%f
+)
+
+SET assembly=tools
+SET compilerFlags=-g
+REM -Wall -Werror
+SET includeFlags=-Isrc -I../engine/src/
+SET linkerFlags=-L../bin/ -lengine.lib
+SET defines=-D_DEBUG -DKIMPORT -D_CRT_SECURE_NO_WARNINGS
+
+ECHO "Building %assembly%%..."
+clang %cFilenames% %compilerFlags% -o ../bin/%assembly%.exe %defines% %includeFlags% %linkerFlags%
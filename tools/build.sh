@@ -0,0 +1,32 @@
+#!/bin/bash
+# Build script for tools
+set echo on
+
+mkdir -p ../bin
+
+# Get a list of all the .c files.
+cFilenames=$(find . -type f -name "*.c")
+
+assembly="tools"
+compilerFlags="-g -fdeclspec -fPIC"
+# -fms-extensions
+# -Wall -Werror
+includeFlags="-Isrc -I../engine/src/"
+linkerFlags="-L../bin/ -lengine -lm -Wl,-rpath,."
+defines="-D_DEBUG -DKIMPORT"
+
+# Archive compression is optional and only built when the libraries are present.
+if pkg-config --exists liblz4
+then
+    defines="$defines -DKOHI_USE_LZ4=1"
+    linkerFlags="$linkerFlags -llz4"
+fi
+if pkg-config --exists libzstd
+then
+    defines="$defines -DKOHI_USE_ZSTD=1"
+    linkerFlags="$linkerFlags -lzstd"
+fi
+
+echo "Building $assembly..."
+echo clang $cFilenames $compilerFlags -o ../bin/$assembly $defines $includeFlags $linkerFlags
+clang $cFilenames $compilerFlags -o ../bin/$assembly $defines $includeFlags $linkerFlags
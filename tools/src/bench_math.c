@@ -0,0 +1,138 @@
+#include "bench_math.h"
+
+#include <core/kmemory.h>
+#include <core/logger.h>
+#include <math/kmath.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Results of the two paths may differ by rounding, as they sum in different orders.
+#define BENCH_MATH_TOLERANCE 1e-4f
+
+typedef struct bench_data {
+    u32 count;
+    mat4* a;
+    mat4* b;
+    mat4* matrices_out;
+    vec4* vectors;
+    vec4* vectors_out;
+    vec3* points;
+    vec3* points_out;
+} bench_data;
+
+typedef void (*bench_fn)(bench_data* data, b8 scalar);
+
+static f32 random_unit() {
+    return ((f32)rand() / (f32)RAND_MAX) * 2.0f - 1.0f;
+}
+
+static void bench_mat4_mul(bench_data* data, b8 scalar) {
+    if (scalar) {
+        mat4_mul_batch_scalar(data->a, data->b, data->matrices_out, data->count);
+    } else {
+        mat4_mul_batch(data->a, data->b, data->matrices_out, data->count);
+    }
+}
+
+static void bench_transform_vec4(bench_data* data, b8 scalar) {
+    if (scalar) {
+        mat4_transform_vec4_batch_scalar(data->a, data->vectors, data->vectors_out, data->count);
+    } else {
+        mat4_transform_vec4_batch(data->a, data->vectors, data->vectors_out, data->count);
+    }
+}
+
+static void bench_transform_point(bench_data* data, b8 scalar) {
+    if (scalar) {
+        mat4_transform_point_batch_scalar(data->a, data->points, data->points_out, data->count);
+    } else {
+        mat4_transform_point_batch(data->a, data->points, data->points_out, data->count);
+    }
+}
+
+static f64 time_run(bench_fn fn, bench_data* data, b8 scalar, u32 iterations) {
+    // One untimed run to warm the caches.
+    fn(data, scalar);
+    clock_t start = clock();
+    for (u32 i = 0; i < iterations; ++i) {
+        fn(data, scalar);
+    }
+    return (f64)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Runs both paths and compares their output, which is float_count floats at out.
+static b8 bench_op(const char* name, bench_fn fn, bench_data* data, const f32* out, u32 float_count, u32 iterations) {
+    u64 size = sizeof(f32) * float_count;
+    f32* expected = kallocate(size, MEMORY_TAG_ARRAY);
+
+    f64 scalar_seconds = time_run(fn, data, TRUE, iterations);
+    kcopy_memory(expected, out, size);
+    f64 vector_seconds = time_run(fn, data, FALSE, iterations);
+
+    f32 max_error = 0.0f;
+    for (u32 i = 0; i < float_count; ++i) {
+        max_error = kmax(max_error, kabs(out[i] - expected[i]));
+    }
+    kfree(expected, size, MEMORY_TAG_ARRAY);
+
+    f64 elements = (f64)data->count * iterations;
+    printf("%-20s %10.2f %10.2f %8.2fx %12g\n",
+           name,
+           scalar_seconds * 1e9 / elements,
+           vector_seconds * 1e9 / elements,
+           vector_seconds > 0 ? scalar_seconds / vector_seconds : 0.0,
+           max_error);
+
+    if (max_error > BENCH_MATH_TOLERANCE) {
+        KERROR("%s: the %s path disagrees with the scalar path by %g.", name, kmath_simd_path(), max_error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+b8 bench_math(u32 count, u32 iterations) {
+    if (count == 0 || iterations == 0) {
+        KERROR("bench_math requires a count and iterations above zero.");
+        return FALSE;
+    }
+
+    bench_data data = {};
+    data.count = count;
+    data.a = kallocate(sizeof(mat4) * count, MEMORY_TAG_ARRAY);
+    data.b = kallocate(sizeof(mat4) * count, MEMORY_TAG_ARRAY);
+    data.matrices_out = kallocate(sizeof(mat4) * count, MEMORY_TAG_ARRAY);
+    data.vectors = kallocate(sizeof(vec4) * count, MEMORY_TAG_ARRAY);
+    data.vectors_out = kallocate(sizeof(vec4) * count, MEMORY_TAG_ARRAY);
+    data.points = kallocate(sizeof(vec3) * count, MEMORY_TAG_ARRAY);
+    data.points_out = kallocate(sizeof(vec3) * count, MEMORY_TAG_ARRAY);
+
+    // Fixed seed, so runs are comparable.
+    srand(1);
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 j = 0; j < 16; ++j) {
+            data.a[i].data[j] = random_unit();
+            data.b[i].data[j] = random_unit();
+        }
+        data.vectors[i] = vec4_create(random_unit(), random_unit(), random_unit(), 1.0f);
+        data.points[i] = vec3_create(random_unit(), random_unit(), random_unit());
+    }
+
+    printf("kmath %s path, %u elements x %u iterations\n", kmath_simd_path(), count, iterations);
+    printf("%-20s %10s %10s %9s %12s\n", "operation", "scalar ns", "simd ns", "speedup", "max error");
+
+    b8 result = TRUE;
+    result &= bench_op("mat4_mul", bench_mat4_mul, &data, data.matrices_out[0].data, count * 16, iterations);
+    result &= bench_op("transform_vec4", bench_transform_vec4, &data, data.vectors_out[0].elements, count * 4, iterations);
+    result &= bench_op("transform_point", bench_transform_point, &data, data.points_out[0].elements, count * 3, iterations);
+
+    kfree(data.a, sizeof(mat4) * count, MEMORY_TAG_ARRAY);
+    kfree(data.b, sizeof(mat4) * count, MEMORY_TAG_ARRAY);
+    kfree(data.matrices_out, sizeof(mat4) * count, MEMORY_TAG_ARRAY);
+    kfree(data.vectors, sizeof(vec4) * count, MEMORY_TAG_ARRAY);
+    kfree(data.vectors_out, sizeof(vec4) * count, MEMORY_TAG_ARRAY);
+    kfree(data.points, sizeof(vec3) * count, MEMORY_TAG_ARRAY);
+    kfree(data.points_out, sizeof(vec3) * count, MEMORY_TAG_ARRAY);
+    return result;
+}
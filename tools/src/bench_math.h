@@ -0,0 +1,12 @@
+#pragma once
+
+#include <defines.h>
+
+/**
+ * Times the batched math operations on their vector path against their
+ * scalar fallback, and checks that both give the same results.
+ * @param count The number of elements in each batch.
+ * @param iterations How many times each batch is run.
+ * @returns TRUE if the results matched; otherwise FALSE.
+ */
+b8 bench_math(u32 count, u32 iterations);
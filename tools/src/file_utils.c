@@ -0,0 +1,35 @@
+#include "file_utils.h"
+
+#include <core/kmemory.h>
+#include <core/logger.h>
+
+#include <stdio.h>
+
+b8 file_read_all(const char* path, u8** out_data, u64* out_size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        KERROR("Unable to open '%s'.", path);
+        return FALSE;
+    }
+    fseek(file, 0, SEEK_END);
+    i64 size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return FALSE;
+    }
+
+    *out_data = kallocate(size + 1, MEMORY_TAG_ARRAY);
+    *out_size = (u64)size;
+    b8 result = fread(*out_data, 1, size, file) == (u64)size;
+    fclose(file);
+    if (!result) {
+        KERROR("Unable to read '%s'.", path);
+        kfree(*out_data, size + 1, MEMORY_TAG_ARRAY);
+    }
+    return result;
+}
+
+void file_free(u8* data, u64 size) {
+    kfree(data, size + 1, MEMORY_TAG_ARRAY);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <defines.h>
+
+/**
+ * Reads a whole file into a new buffer with one terminating zero byte past
+ * the end, so text can be parsed in place.
+ * @param out_data A pointer to hold the buffer. Free with file_free.
+ * @param out_size A pointer to hold the file size, not counting the terminator.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+b8 file_read_all(const char* path, u8** out_data, u64* out_size);
+
+void file_free(u8* data, u64 size);
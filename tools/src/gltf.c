@@ -0,0 +1,370 @@
+#include "gltf.h"
+
+#include "file_utils.h"
+#include "json.h"
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/logger.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define GLB_MAGIC 0x46546C67       // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A  // "JSON"
+#define GLB_CHUNK_BIN 0x004E4942   // "BIN\0"
+
+#define GLTF_COMPONENT_UNSIGNED_BYTE 5121
+#define GLTF_COMPONENT_UNSIGNED_SHORT 5123
+#define GLTF_COMPONENT_UNSIGNED_INT 5125
+#define GLTF_COMPONENT_FLOAT 5126
+
+#define GLTF_MODE_TRIANGLES 4
+
+#define GLTF_MAX_BUFFERS 16
+
+typedef struct gltf_buffer {
+    const u8* data;
+    u64 size;
+    // Set when the buffer was read from its own file.
+    u8* owned;
+} gltf_buffer;
+
+typedef struct gltf_context {
+    const char* path;
+    json_document document;
+    gltf_buffer buffers[GLTF_MAX_BUFFERS];
+    u32 buffer_count;
+} gltf_context;
+
+typedef struct gltf_accessor_view {
+    const u8* data;
+    u32 count;
+    u32 component_type;
+    u32 component_count;
+    u32 stride;
+    b8 normalized;
+} gltf_accessor_view;
+
+static u32 component_size(u32 component_type) {
+    switch (component_type) {
+        case GLTF_COMPONENT_UNSIGNED_BYTE:
+            return 1;
+        case GLTF_COMPONENT_UNSIGNED_SHORT:
+            return 2;
+        case GLTF_COMPONENT_UNSIGNED_INT:
+        case GLTF_COMPONENT_FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static u32 type_component_count(const json_value* type) {
+    if (json_string_equals(type, "SCALAR")) {
+        return 1;
+    } else if (json_string_equals(type, "VEC2")) {
+        return 2;
+    } else if (json_string_equals(type, "VEC3")) {
+        return 3;
+    } else if (json_string_equals(type, "VEC4")) {
+        return 4;
+    }
+    return 0;
+}
+
+static b8 load_buffers(gltf_context* ctx, const u8* glb_bin, u64 glb_bin_size) {
+    const json_value* buffers = json_get(&ctx->document, json_root(&ctx->document), "buffers");
+    u32 count = buffers ? buffers->child_count : 0;
+    if (count > GLTF_MAX_BUFFERS) {
+        KERROR("'%s' has more than %u buffers.", ctx->path, GLTF_MAX_BUFFERS);
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        const json_value* buffer = json_at(&ctx->document, buffers, i);
+        const json_value* uri = json_get(&ctx->document, buffer, "uri");
+        gltf_buffer* out = &ctx->buffers[i];
+        ctx->buffer_count++;
+
+        if (!uri) {
+            // The GLB binary chunk.
+            out->data = glb_bin;
+            out->size = glb_bin_size;
+            if (!glb_bin) {
+                KERROR("'%s' buffer %u has no uri and there is no binary chunk.", ctx->path, i);
+                return FALSE;
+            }
+            continue;
+        }
+        if (uri->string_length >= 5 && strncmp(uri->string, "data:", 5) == 0) {
+            KERROR("'%s' embeds buffer %u as a data URI, which is not supported. Export as .glb or with separate .bin files.", ctx->path, i);
+            return FALSE;
+        }
+
+        // Relative to the glTF file.
+        const char* slash = strrchr(ctx->path, '/');
+        i32 dir_length = slash ? (i32)(slash - ctx->path + 1) : 0;
+        char buffer_path[512];
+        snprintf(buffer_path, sizeof(buffer_path), "%.*s%.*s", dir_length, ctx->path, uri->string_length, uri->string);
+        if (!file_read_all(buffer_path, &out->owned, &out->size)) {
+            return FALSE;
+        }
+        out->data = out->owned;
+    }
+    return TRUE;
+}
+
+static b8 get_accessor(gltf_context* ctx, u32 accessor_index, u32 component_count, gltf_accessor_view* out_view) {
+    json_document* doc = &ctx->document;
+    const json_value* accessor = json_at(doc, json_get(doc, json_root(doc), "accessors"), accessor_index);
+    if (!accessor) {
+        KERROR("'%s' references missing accessor %u.", ctx->path, accessor_index);
+        return FALSE;
+    }
+
+    out_view->count = (u32)json_number(json_get(doc, accessor, "count"), 0);
+    out_view->component_type = (u32)json_number(json_get(doc, accessor, "componentType"), 0);
+    out_view->component_count = type_component_count(json_get(doc, accessor, "type"));
+    const json_value* normalized = json_get(doc, accessor, "normalized");
+    out_view->normalized = normalized && normalized->type == JSON_TYPE_BOOL && normalized->boolean;
+    u32 element_size = component_size(out_view->component_type) * out_view->component_count;
+    if (element_size == 0) {
+        KERROR("'%s' accessor %u has an unsupported type.", ctx->path, accessor_index);
+        return FALSE;
+    }
+    if (out_view->component_count != component_count) {
+        KERROR("'%s' accessor %u has %u components, expected %u.", ctx->path, accessor_index, out_view->component_count, component_count);
+        return FALSE;
+    }
+
+    const json_value* view_index = json_get(doc, accessor, "bufferView");
+    if (!view_index) {
+        KERROR("'%s' accessor %u is sparse or empty, which is not supported.", ctx->path, accessor_index);
+        return FALSE;
+    }
+    const json_value* view = json_at(doc, json_get(doc, json_root(doc), "bufferViews"), (u32)json_number(view_index, 0));
+    u32 buffer_index = (u32)json_number(json_get(doc, view, "buffer"), 0);
+    if (!view || buffer_index >= ctx->buffer_count) {
+        KERROR("'%s' accessor %u has an invalid buffer view.", ctx->path, accessor_index);
+        return FALSE;
+    }
+
+    u64 offset = (u64)json_number(json_get(doc, view, "byteOffset"), 0) + (u64)json_number(json_get(doc, accessor, "byteOffset"), 0);
+    out_view->stride = (u32)json_number(json_get(doc, view, "byteStride"), element_size);
+    gltf_buffer* buffer = &ctx->buffers[buffer_index];
+    if (out_view->count > 0 && (offset > buffer->size || (u64)out_view->stride * (out_view->count - 1) + element_size > buffer->size - offset)) {
+        KERROR("'%s' accessor %u runs past the end of its buffer.", ctx->path, accessor_index);
+        return FALSE;
+    }
+    out_view->data = buffer->data + offset;
+    return TRUE;
+}
+
+// Reads component c of element i as a float, normalizing integer types if the accessor says so.
+static f32 read_float(const gltf_accessor_view* view, u32 i, u32 c) {
+    const u8* element = view->data + (u64)view->stride * i;
+    switch (view->component_type) {
+        case GLTF_COMPONENT_FLOAT: {
+            f32 value;
+            kcopy_memory(&value, element + c * 4, 4);
+            return value;
+        }
+        case GLTF_COMPONENT_UNSIGNED_SHORT: {
+            u16 value;
+            kcopy_memory(&value, element + c * 2, 2);
+            return view->normalized ? value / 65535.0f : value;
+        }
+        case GLTF_COMPONENT_UNSIGNED_BYTE: {
+            u8 value = element[c];
+            return view->normalized ? value / 255.0f : value;
+        }
+        default:
+            return 0;
+    }
+}
+
+static u32 read_index(const gltf_accessor_view* view, u32 i) {
+    const u8* element = view->data + (u64)view->stride * i;
+    switch (view->component_type) {
+        case GLTF_COMPONENT_UNSIGNED_INT: {
+            u32 value;
+            kcopy_memory(&value, element, 4);
+            return value;
+        }
+        case GLTF_COMPONENT_UNSIGNED_SHORT: {
+            u16 value;
+            kcopy_memory(&value, element, 2);
+            return value;
+        }
+        default:
+            return element[0];
+    }
+}
+
+static b8 import_primitive(gltf_context* ctx, const json_value* primitive, mesh_vertex** vertices, u32** indices) {
+    json_document* doc = &ctx->document;
+    if ((u32)json_number(json_get(doc, primitive, "mode"), GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES) {
+        KWARN("'%s' has a primitive which is not a triangle list. Skipping it.", ctx->path);
+        return TRUE;
+    }
+
+    const json_value* attributes = json_get(doc, primitive, "attributes");
+    const json_value* position_index = json_get(doc, attributes, "POSITION");
+    if (!position_index) {
+        KWARN("'%s' has a primitive without positions. Skipping it.", ctx->path);
+        return TRUE;
+    }
+
+    gltf_accessor_view positions, normals, texcoords, index_view;
+    if (!get_accessor(ctx, (u32)json_number(position_index, 0), 3, &positions)) {
+        return FALSE;
+    }
+    const json_value* normal_index = json_get(doc, attributes, "NORMAL");
+    b8 has_normals = normal_index && get_accessor(ctx, (u32)json_number(normal_index, 0), 3, &normals) && normals.count == positions.count;
+    const json_value* texcoord_index = json_get(doc, attributes, "TEXCOORD_0");
+    b8 has_texcoords = texcoord_index && get_accessor(ctx, (u32)json_number(texcoord_index, 0), 2, &texcoords) && texcoords.count == positions.count;
+
+    u32 base_vertex = (u32)darray_length(*vertices);
+    for (u32 i = 0; i < positions.count; ++i) {
+        mesh_vertex v;
+        kzero_memory(&v, sizeof(mesh_vertex));
+        for (u32 c = 0; c < 3; ++c) {
+            v.position[c] = read_float(&positions, i, c);
+            if (has_normals) {
+                v.normal[c] = read_float(&normals, i, c);
+            }
+        }
+        if (has_texcoords) {
+            v.texcoord[0] = read_float(&texcoords, i, 0);
+            v.texcoord[1] = read_float(&texcoords, i, 1);
+        }
+        darray_push(*vertices, v);
+    }
+
+    const json_value* indices_index = json_get(doc, primitive, "indices");
+    if (indices_index) {
+        if (!get_accessor(ctx, (u32)json_number(indices_index, 0), 1, &index_view)) {
+            return FALSE;
+        }
+        for (u32 i = 0; i + 2 < index_view.count; i += 3) {
+            for (u32 corner = 0; corner < 3; ++corner) {
+                u32 index = read_index(&index_view, i + corner);
+                if (index >= positions.count) {
+                    KERROR("'%s' has an index out of range.", ctx->path);
+                    return FALSE;
+                }
+                darray_push(*indices, base_vertex + index);
+            }
+        }
+    } else {
+        // Unindexed: every three vertices are a triangle.
+        u32 corner_count = positions.count - positions.count % 3;
+        for (u32 i = 0; i < corner_count; ++i) {
+            darray_push(*indices, base_vertex + i);
+        }
+    }
+    return TRUE;
+}
+
+b8 gltf_import(const char* path, mesh_geometry* out_geometry) {
+    kzero_memory(out_geometry, sizeof(mesh_geometry));
+
+    u8* file = 0;
+    u64 file_size = 0;
+    if (!file_read_all(path, &file, &file_size)) {
+        return FALSE;
+    }
+
+    gltf_context ctx;
+    kzero_memory(&ctx, sizeof(gltf_context));
+    ctx.path = path;
+
+    const char* json_text = (const char*)file;
+    u64 json_length = file_size;
+    const u8* bin = 0;
+    u64 bin_size = 0;
+    b8 success = FALSE;
+    u8* json_copy = 0;
+
+    u32 magic = 0;
+    if (file_size >= 4) {
+        kcopy_memory(&magic, file, 4);
+    }
+    if (magic == GLB_MAGIC) {
+        // 12-byte header, then chunks of {u32 length, u32 type, data}.
+        u64 pos = 12;
+        while (pos + 8 <= file_size) {
+            u32 chunk_length, chunk_type;
+            kcopy_memory(&chunk_length, file + pos, 4);
+            kcopy_memory(&chunk_type, file + pos + 4, 4);
+            pos += 8;
+            if (chunk_length > file_size - pos) {
+                KERROR("'%s' has a truncated chunk.", path);
+                goto cleanup;
+            }
+            if (chunk_type == GLB_CHUNK_JSON) {
+                // The parser needs a terminator, which the chunk does not have.
+                json_copy = kallocate(chunk_length + 1, MEMORY_TAG_ARRAY);
+                kcopy_memory(json_copy, file + pos, chunk_length);
+                json_text = (const char*)json_copy;
+                json_length = chunk_length;
+            } else if (chunk_type == GLB_CHUNK_BIN) {
+                bin = file + pos;
+                bin_size = chunk_length;
+            }
+            pos += chunk_length;
+        }
+        if (!json_copy) {
+            KERROR("'%s' has no JSON chunk.", path);
+            goto cleanup;
+        }
+    }
+
+    if (!json_parse(json_text, json_length, &ctx.document)) {
+        KERROR("'%s' is not valid glTF.", path);
+        goto cleanup;
+    }
+    if (!load_buffers(&ctx, bin, bin_size)) {
+        goto cleanup;
+    }
+
+    mesh_vertex* vertices = darray_create(mesh_vertex);
+    u32* indices = darray_create(u32);
+    const json_value* meshes = json_get(&ctx.document, json_root(&ctx.document), "meshes");
+    success = TRUE;
+    for (u32 m = 0; success && meshes && m < meshes->child_count; ++m) {
+        const json_value* primitives = json_get(&ctx.document, json_at(&ctx.document, meshes, m), "primitives");
+        for (u32 p = 0; success && primitives && p < primitives->child_count; ++p) {
+            success = import_primitive(&ctx, json_at(&ctx.document, primitives, p), &vertices, &indices);
+        }
+    }
+    if (success && darray_length(indices) == 0) {
+        KERROR("'%s' contains no triangles.", path);
+        success = FALSE;
+    }
+
+    if (success) {
+        out_geometry->vertex_count = (u32)darray_length(vertices);
+        out_geometry->vertices = kallocate(sizeof(mesh_vertex) * out_geometry->vertex_count, MEMORY_TAG_MESH);
+        kcopy_memory(out_geometry->vertices, vertices, sizeof(mesh_vertex) * out_geometry->vertex_count);
+        out_geometry->index_count = (u32)darray_length(indices);
+        out_geometry->indices = kallocate(sizeof(u32) * out_geometry->index_count, MEMORY_TAG_MESH);
+        kcopy_memory(out_geometry->indices, indices, sizeof(u32) * out_geometry->index_count);
+    }
+    darray_destroy(vertices);
+    darray_destroy(indices);
+
+cleanup:
+    for (u32 i = 0; i < ctx.buffer_count; ++i) {
+        if (ctx.buffers[i].owned) {
+            file_free(ctx.buffers[i].owned, ctx.buffers[i].size);
+        }
+    }
+    json_destroy(&ctx.document);
+    if (json_copy) {
+        kfree(json_copy, json_length + 1, MEMORY_TAG_ARRAY);
+    }
+    file_free(file, file_size);
+    return success;
+}
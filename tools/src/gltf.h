@@ -0,0 +1,11 @@
+#pragma once
+
+#include <resources/mesh_import.h>
+
+/**
+ * Imports the triangle geometry of every mesh in a glTF 2.0 file (.gltf
+ * with external buffers, or .glb) into a single mesh. Node transforms are
+ * not applied, so meshes keep their own object space.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+b8 gltf_import(const char* path, mesh_geometry* out_geometry);
@@ -0,0 +1,235 @@
+#include "json.h"
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Deeper nesting than this is rejected rather than risking the stack.
+#define JSON_MAX_DEPTH 64
+
+typedef struct json_parser {
+    const char* text;
+    u64 length;
+    u64 pos;
+    json_document* document;
+} json_parser;
+
+static void skip_whitespace(json_parser* p) {
+    while (p->pos < p->length) {
+        char c = p->text[p->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        p->pos++;
+    }
+}
+
+static u32 add_value(json_parser* p, json_type type) {
+    json_value value;
+    kzero_memory(&value, sizeof(json_value));
+    value.type = type;
+    value.first_child = INVALID_ID;
+    value.next_sibling = INVALID_ID;
+    darray_push(p->document->values, value);
+    return (u32)darray_length(p->document->values) - 1;
+}
+
+// Parses a string starting at the opening quote, returning its contents without the quotes.
+static b8 parse_string(json_parser* p, const char** out_string, u32* out_length) {
+    p->pos++;
+    u64 start = p->pos;
+    while (p->pos < p->length && p->text[p->pos] != '"') {
+        if (p->text[p->pos] == '\\') {
+            p->pos++;
+        }
+        p->pos++;
+    }
+    if (p->pos >= p->length) {
+        return FALSE;
+    }
+    *out_string = p->text + start;
+    *out_length = (u32)(p->pos - start);
+    p->pos++;
+    return TRUE;
+}
+
+static b8 matches(json_parser* p, const char* literal) {
+    u64 length = string_length(literal);
+    if (p->pos + length > p->length) {
+        return FALSE;
+    }
+    for (u64 i = 0; i < length; ++i) {
+        if (p->text[p->pos + i] != literal[i]) {
+            return FALSE;
+        }
+    }
+    p->pos += length;
+    return TRUE;
+}
+
+static u32 parse_value(json_parser* p, u32 depth);
+
+// Parses the elements of an array or the members of an object into the value at index.
+static b8 parse_children(json_parser* p, u32 index, b8 is_object, u32 depth) {
+    char close = is_object ? '}' : ']';
+    p->pos++;
+    skip_whitespace(p);
+    if (p->pos < p->length && p->text[p->pos] == close) {
+        p->pos++;
+        return TRUE;
+    }
+
+    u32 last_child = INVALID_ID;
+    for (;;) {
+        skip_whitespace(p);
+        const char* key = 0;
+        u32 key_length = 0;
+        if (is_object) {
+            if (p->pos >= p->length || p->text[p->pos] != '"' || !parse_string(p, &key, &key_length)) {
+                return FALSE;
+            }
+            skip_whitespace(p);
+            if (p->pos >= p->length || p->text[p->pos] != ':') {
+                return FALSE;
+            }
+            p->pos++;
+        }
+
+        u32 child = parse_value(p, depth + 1);
+        if (child == INVALID_ID) {
+            return FALSE;
+        }
+        // Index, not pointer: the darray may have moved.
+        json_value* values = p->document->values;
+        values[child].key = key;
+        values[child].key_length = key_length;
+        if (last_child == INVALID_ID) {
+            values[index].first_child = child;
+        } else {
+            values[last_child].next_sibling = child;
+        }
+        values[index].child_count++;
+        last_child = child;
+
+        skip_whitespace(p);
+        if (p->pos >= p->length) {
+            return FALSE;
+        }
+        char c = p->text[p->pos++];
+        if (c == close) {
+            return TRUE;
+        }
+        if (c != ',') {
+            return FALSE;
+        }
+    }
+}
+
+static u32 parse_value(json_parser* p, u32 depth) {
+    if (depth > JSON_MAX_DEPTH) {
+        return INVALID_ID;
+    }
+    skip_whitespace(p);
+    if (p->pos >= p->length) {
+        return INVALID_ID;
+    }
+
+    char c = p->text[p->pos];
+    u32 index;
+    if (c == '{' || c == '[') {
+        index = add_value(p, c == '{' ? JSON_TYPE_OBJECT : JSON_TYPE_ARRAY);
+        if (!parse_children(p, index, c == '{', depth)) {
+            return INVALID_ID;
+        }
+    } else if (c == '"') {
+        index = add_value(p, JSON_TYPE_STRING);
+        const char* str;
+        u32 length;
+        if (!parse_string(p, &str, &length)) {
+            return INVALID_ID;
+        }
+        p->document->values[index].string = str;
+        p->document->values[index].string_length = length;
+    } else if (matches(p, "true")) {
+        index = add_value(p, JSON_TYPE_BOOL);
+        p->document->values[index].boolean = TRUE;
+    } else if (matches(p, "false")) {
+        index = add_value(p, JSON_TYPE_BOOL);
+    } else if (matches(p, "null")) {
+        index = add_value(p, JSON_TYPE_NULL);
+    } else {
+        // NOTE: strtod relies on the text being terminated, which the callers guarantee.
+        char* end;
+        f64 number = strtod(p->text + p->pos, &end);
+        if (end == p->text + p->pos || (u64)(end - p->text) > p->length) {
+            return INVALID_ID;
+        }
+        p->pos = end - p->text;
+        index = add_value(p, JSON_TYPE_NUMBER);
+        p->document->values[index].number = number;
+    }
+    return index;
+}
+
+b8 json_parse(const char* text, u64 length, json_document* out_document) {
+    out_document->values = darray_create(json_value);
+    json_parser p = {text, length, 0, out_document};
+    if (parse_value(&p, 0) != 0) {
+        KERROR("Malformed JSON near byte %llu.", p.pos);
+        json_destroy(out_document);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void json_destroy(json_document* document) {
+    if (document->values) {
+        darray_destroy(document->values);
+        document->values = 0;
+    }
+}
+
+const json_value* json_root(const json_document* document) {
+    return &document->values[0];
+}
+
+const json_value* json_get(const json_document* document, const json_value* object, const char* key) {
+    if (!object || object->type != JSON_TYPE_OBJECT) {
+        return 0;
+    }
+    u64 key_length = string_length(key);
+    for (u32 i = object->first_child; i != INVALID_ID; i = document->values[i].next_sibling) {
+        const json_value* member = &document->values[i];
+        if (member->key_length == key_length && strncmp(member->key, key, key_length) == 0) {
+            return member;
+        }
+    }
+    return 0;
+}
+
+const json_value* json_at(const json_document* document, const json_value* array, u32 index) {
+    if (!array || array->type != JSON_TYPE_ARRAY || index >= array->child_count) {
+        return 0;
+    }
+    u32 i = array->first_child;
+    while (index-- > 0) {
+        i = document->values[i].next_sibling;
+    }
+    return &document->values[i];
+}
+
+f64 json_number(const json_value* value, f64 default_value) {
+    return (value && value->type == JSON_TYPE_NUMBER) ? value->number : default_value;
+}
+
+b8 json_string_equals(const json_value* value, const char* str) {
+    if (!value || value->type != JSON_TYPE_STRING) {
+        return FALSE;
+    }
+    u64 length = string_length(str);
+    return value->string_length == length && strncmp(value->string, str, length) == 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <defines.h>
+
+// A small read-only JSON parser, enough for glTF. Strings are left in the
+// source text with their escapes undecoded.
+
+typedef enum json_type {
+    JSON_TYPE_NULL,
+    JSON_TYPE_BOOL,
+    JSON_TYPE_NUMBER,
+    JSON_TYPE_STRING,
+    JSON_TYPE_ARRAY,
+    JSON_TYPE_OBJECT
+} json_type;
+
+typedef struct json_value {
+    json_type type;
+    // The member name, when this is an object member.
+    const char* key;
+    u32 key_length;
+    const char* string;
+    u32 string_length;
+    f64 number;
+    b8 boolean;
+    // Children of arrays and objects, as a list linked through next_sibling. INVALID_ID ends it.
+    u32 first_child;
+    u32 child_count;
+    u32 next_sibling;
+} json_value;
+
+typedef struct json_document {
+    // darray of every value. The root is at index 0.
+    json_value* values;
+} json_document;
+
+/**
+ * Parses JSON text. The text must outlive the document, and must be
+ * terminated one byte past length.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+b8 json_parse(const char* text, u64 length, json_document* out_document);
+void json_destroy(json_document* document);
+
+const json_value* json_root(const json_document* document);
+
+// Returns the member of an object with the given name, or 0.
+const json_value* json_get(const json_document* document, const json_value* object, const char* key);
+
+// Returns the element of an array at the given index, or 0.
+const json_value* json_at(const json_document* document, const json_value* array, u32 index);
+
+// Returns the value as a number, or default_value if it is missing or not a number.
+f64 json_number(const json_value* value, f64 default_value);
+
+b8 json_string_equals(const json_value* value, const char* str);
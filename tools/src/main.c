@@ -0,0 +1,144 @@
+// Offline asset tools. Each command is one subcommand of this executable.
+
+#include "bench_math.h"
+#include "mesh_convert.h"
+#include "pack.h"
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <resources/archive.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void print_usage() {
+    printf(
+        "usage: tools <command> [arguments]\n"
+        "\n"
+        "commands:\n"
+        "  pack <input_dir> <output_file> [--align <bytes>] [--compress none|lz4|zstd]\n"
+        "      Packs every file below input_dir into an asset archive.\n"
+        "  list <archive>\n"
+        "      Lists the entries of an asset archive.\n"
+        "  mesh <input.obj|.gltf|.glb> <output.ksm> [--no-optimize] [--no-lods] [--quantize] [--meshlets]\n"
+        "      Converts a mesh into the binary GPU-layout mesh format. Triangles and\n"
+        "      vertices are reordered for the GPU unless --no-optimize is given, and\n"
+        "      simplified levels of detail are built unless --no-lods is given.\n"
+        "      --quantize stores 16-bit normals and texture coordinates.\n"
+        "  bench-math [count] [iterations]\n"
+        "      Times the batched math operations on their SIMD path against the\n"
+        "      scalar fallback. Defaults to 4096 elements and 1000 iterations.\n");
+}
+
+static i32 command_pack(i32 argc, char** argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    u32 alignment = 16;
+    u32 compression = ARCHIVE_COMPRESSION_NONE;
+    for (i32 i = 2; i < argc; ++i) {
+        if (strings_equal(argv[i], "--align") && i + 1 < argc) {
+            alignment = (u32)strtoul(argv[++i], 0, 10);
+        } else if (strings_equal(argv[i], "--compress") && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strings_equal(name, "none")) {
+                compression = ARCHIVE_COMPRESSION_NONE;
+            } else if (strings_equal(name, "lz4")) {
+#if KOHI_USE_LZ4
+                compression = ARCHIVE_COMPRESSION_LZ4;
+#else
+                KERROR("These tools were built without LZ4 support (KOHI_USE_LZ4).");
+                return 1;
+#endif
+            } else if (strings_equal(name, "zstd")) {
+#if KOHI_USE_ZSTD
+                compression = ARCHIVE_COMPRESSION_ZSTD;
+#else
+                KERROR("These tools were built without Zstandard support (KOHI_USE_ZSTD).");
+                return 1;
+#endif
+            } else {
+                KERROR("Unknown compression '%s'.", name);
+                return 1;
+            }
+        } else {
+            KERROR("Unknown argument '%s'.", argv[i]);
+            return 1;
+        }
+    }
+
+    return pack_directory(argv[0], argv[1], alignment, compression) ? 0 : 1;
+}
+
+static i32 command_list(i32 argc, char** argv) {
+    if (argc < 1) {
+        print_usage();
+        return 1;
+    }
+    return pack_list(argv[0]) ? 0 : 1;
+}
+
+static i32 command_mesh(i32 argc, char** argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    mesh_convert_options options = {};
+    options.optimize = TRUE;
+    options.lods = TRUE;
+    for (i32 i = 2; i < argc; ++i) {
+        if (strings_equal(argv[i], "--no-optimize")) {
+            options.optimize = FALSE;
+        } else if (strings_equal(argv[i], "--no-lods")) {
+            options.lods = FALSE;
+        } else if (strings_equal(argv[i], "--quantize")) {
+            options.quantize = TRUE;
+        } else if (strings_equal(argv[i], "--meshlets")) {
+            options.meshlets = TRUE;
+        } else {
+            KERROR("Unknown argument '%s'.", argv[i]);
+            return 1;
+        }
+    }
+
+    return mesh_convert(argv[0], argv[1], &options) ? 0 : 1;
+}
+
+static i32 command_bench_math(i32 argc, char** argv) {
+    u32 count = argc > 0 ? (u32)strtoul(argv[0], 0, 10) : 4096;
+    u32 iterations = argc > 1 ? (u32)strtoul(argv[1], 0, 10) : 1000;
+    return bench_math(count, iterations) ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    initialize_memory();
+
+    // Arguments after the command name are handed to the command.
+    const char* command = argv[1];
+    i32 result;
+    if (strings_equal(command, "pack")) {
+        result = command_pack(argc - 2, argv + 2);
+    } else if (strings_equal(command, "list")) {
+        result = command_list(argc - 2, argv + 2);
+    } else if (strings_equal(command, "mesh")) {
+        result = command_mesh(argc - 2, argv + 2);
+    } else if (strings_equal(command, "bench-math")) {
+        result = command_bench_math(argc - 2, argv + 2);
+    } else {
+        KERROR("Unknown command '%s'.", command);
+        print_usage();
+        result = 1;
+    }
+
+    shutdown_memory();
+    return result;
+}
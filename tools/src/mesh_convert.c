@@ -0,0 +1,254 @@
+#include "mesh_convert.h"
+
+#include "file_utils.h"
+#include "gltf.h"
+#include "mesh_optimize.h"
+#include "mesh_simplify.h"
+#include "meshlets.h"
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <resources/mesh_format.h>
+#include <resources/mesh_import.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static b8 ends_with(const char* str, const char* suffix) {
+    u64 length = string_length(str);
+    u64 suffix_length = string_length(suffix);
+    return length >= suffix_length && strings_equal(str + length - suffix_length, suffix);
+}
+
+static u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static b8 import_geometry(const char* path, mesh_geometry* out_geometry) {
+    if (ends_with(path, ".gltf") || ends_with(path, ".glb")) {
+        return gltf_import(path, out_geometry);
+    }
+
+    u8* data = 0;
+    u64 size = 0;
+    if (!file_read_all(path, &data, &size)) {
+        return FALSE;
+    }
+    b8 result = mesh_import_obj(path, data, size, out_geometry);
+    file_free(data, size);
+    return result;
+}
+
+// Levels with fewer triangles than this are not worth a draw of their own.
+#define LOD_MIN_TRIANGLES 32
+
+// Appends simplified levels of detail after the full mesh's indices, each
+// aiming for half the triangles of the one before, until simplification stops
+// paying off.
+static void build_lods(mesh_geometry* geometry, b8 optimize, mesh_lod* lods, u32* out_lod_count) {
+    u32 full_count = geometry->index_count;
+    u32* combined = darray_create(u32);
+    for (u32 i = 0; i < full_count; ++i) {
+        darray_push(combined, geometry->indices[i]);
+    }
+
+    u32* scratch = kallocate(sizeof(u32) * full_count, MEMORY_TAG_ARRAY);
+    u32 lod_count = 1;
+    while (lod_count < MESH_MAX_LODS) {
+        u32 previous_count = lods[lod_count - 1].index_count;
+        u32 target = (full_count >> lod_count) / 3 * 3;
+        if (target / 3 < LOD_MIN_TRIANGLES) {
+            break;
+        }
+
+        // Always simplified from the full mesh, so the error is measured against it.
+        f32 error = 0;
+        u32 count = mesh_simplify(geometry, target, scratch, &error);
+        if (count > previous_count / 4 * 3) {
+            // Mostly locked borders and seams left. Further levels would barely differ.
+            break;
+        }
+        if (optimize) {
+            mesh_optimize_vertex_cache(scratch, count, geometry->vertex_count);
+        }
+
+        mesh_lod* lod = &lods[lod_count++];
+        lod->first_index = (u32)darray_length(combined);
+        lod->index_count = count;
+        // Coarser levels never claim to be more accurate than finer ones.
+        lod->error = error > lods[lod_count - 2].error ? error : lods[lod_count - 2].error;
+        lod->reserved = 0;
+        for (u32 i = 0; i < count; ++i) {
+            darray_push(combined, scratch[i]);
+        }
+    }
+    kfree(scratch, sizeof(u32) * full_count, MEMORY_TAG_ARRAY);
+
+    kfree(geometry->indices, sizeof(u32) * geometry->index_count, MEMORY_TAG_MESH);
+    geometry->index_count = (u32)darray_length(combined);
+    geometry->indices = kallocate(sizeof(u32) * geometry->index_count, MEMORY_TAG_MESH);
+    kcopy_memory(geometry->indices, combined, sizeof(u32) * geometry->index_count);
+    darray_destroy(combined);
+    *out_lod_count = lod_count;
+}
+
+// Writes a section at the current position, then pads up to the next section boundary.
+static b8 write_section(FILE* file, const void* data, u64 size, u64* position) {
+    static const u8 zeros[MESH_FILE_ALIGNMENT] = {0};
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        return FALSE;
+    }
+    u64 padding = align_up(*position + size, MESH_FILE_ALIGNMENT) - (*position + size);
+    if (padding > 0 && fwrite(zeros, 1, padding, file) != padding) {
+        return FALSE;
+    }
+    *position += size + padding;
+    return TRUE;
+}
+
+b8 mesh_convert(const char* input_path, const char* output_path, const mesh_convert_options* options) {
+    mesh_geometry geometry;
+    if (!import_geometry(input_path, &geometry)) {
+        KERROR("Failed to import '%s'.", input_path);
+        return FALSE;
+    }
+
+    // Level 0 is the full mesh.
+    mesh_lod lods[MESH_MAX_LODS];
+    kzero_memory(lods, sizeof(lods));
+    lods[0].index_count = geometry.index_count;
+    u32 lod_count = 1;
+
+    u32 imported_vertex_count = geometry.vertex_count;
+    mesh_cache_stats before = {};
+    if (options->optimize) {
+        before = mesh_analyze_vertex_cache(geometry.indices, geometry.index_count, geometry.vertex_count, MESH_OPTIMIZE_CACHE_SIZE);
+        mesh_optimize_vertex_cache(geometry.indices, geometry.index_count, geometry.vertex_count);
+        mesh_optimize_overdraw(geometry.indices, geometry.index_count, geometry.vertices, geometry.vertex_count, 1.05f);
+    }
+
+    if (options->lods) {
+        build_lods(&geometry, options->optimize, lods, &lod_count);
+        for (u32 i = 1; i < lod_count; ++i) {
+            KINFO("LOD %u: %u triangles (%.1f%%), error %g.",
+                  i, lods[i].index_count / 3, 100.0f * lods[i].index_count / lods[0].index_count, lods[i].error);
+        }
+    }
+
+    if (options->optimize) {
+        // After the levels are built, so the full mesh's order decides the vertex order.
+        mesh_optimize_vertex_fetch(&geometry);
+
+        mesh_cache_stats after = mesh_analyze_vertex_cache(geometry.indices, lods[0].index_count, geometry.vertex_count, MESH_OPTIMIZE_CACHE_SIZE);
+        KINFO("Optimized '%s' for a %u entry vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %u unused vertices removed.",
+              input_path, MESH_OPTIMIZE_CACHE_SIZE, before.acmr, after.acmr, before.atvr, after.atvr, imported_vertex_count - geometry.vertex_count);
+    }
+
+    mesh_file_header header;
+    kzero_memory(&header, sizeof(mesh_file_header));
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertex_format = options->quantize ? MESH_VERTEX_FORMAT_QUANTIZED : MESH_VERTEX_FORMAT_FULL;
+    header.vertex_stride = options->quantize ? sizeof(mesh_vertex_quantized) : sizeof(mesh_vertex);
+    header.vertex_count = geometry.vertex_count;
+    header.index_count = geometry.index_count;
+    header.lod_count = lod_count;
+
+    for (u32 axis = 0; axis < 3; ++axis) {
+        header.bounds_min[axis] = geometry.vertices[0].position[axis];
+        header.bounds_max[axis] = geometry.vertices[0].position[axis];
+    }
+    for (u32 i = 1; i < geometry.vertex_count; ++i) {
+        for (u32 axis = 0; axis < 3; ++axis) {
+            f32 value = geometry.vertices[i].position[axis];
+            header.bounds_min[axis] = value < header.bounds_min[axis] ? value : header.bounds_min[axis];
+            header.bounds_max[axis] = value > header.bounds_max[axis] ? value : header.bounds_max[axis];
+        }
+    }
+
+    // 16-bit indices whenever every vertex can be reached with them.
+    void* indices = geometry.indices;
+    u16* short_indices = 0;
+    if (geometry.vertex_count <= 0xFFFF) {
+        header.index_size = sizeof(u16);
+        short_indices = kallocate(sizeof(u16) * geometry.index_count, MEMORY_TAG_ARRAY);
+        for (u32 i = 0; i < geometry.index_count; ++i) {
+            short_indices[i] = (u16)geometry.indices[i];
+        }
+        indices = short_indices;
+    } else {
+        header.index_size = sizeof(u32);
+    }
+
+    void* vertices = geometry.vertices;
+    mesh_vertex_quantized* quantized_vertices = 0;
+    if (options->quantize) {
+        quantized_vertices = kallocate(sizeof(mesh_vertex_quantized) * geometry.vertex_count, MEMORY_TAG_ARRAY);
+        mesh_quantize_vertices(geometry.vertices, geometry.vertex_count, quantized_vertices);
+        vertices = quantized_vertices;
+    }
+
+    meshlet_set meshlets;
+    kzero_memory(&meshlets, sizeof(meshlet_set));
+    if (options->meshlets) {
+        // Meshlets cover the full mesh only.
+        mesh_geometry full = geometry;
+        full.index_count = lods[0].index_count;
+        meshlets_build(&full, MESH_MESHLET_MAX_VERTICES, MESH_MESHLET_MAX_TRIANGLES, &meshlets);
+        header.meshlet_count = (u32)darray_length(meshlets.meshlets);
+        header.meshlet_vertex_count = (u32)darray_length(meshlets.vertices);
+        header.meshlet_triangle_count = (u32)darray_length(meshlets.triangles) / 3;
+    }
+
+    // Lay the sections out back to back, each on a 16-byte boundary.
+    u64 vertex_size = (u64)header.vertex_count * header.vertex_stride;
+    u64 index_size = (u64)header.index_count * header.index_size;
+    u64 lod_size = sizeof(mesh_lod) * header.lod_count;
+    u64 meshlet_size = sizeof(mesh_meshlet) * header.meshlet_count;
+    u64 meshlet_vertices_size = sizeof(u32) * header.meshlet_vertex_count;
+    u64 meshlet_triangles_size = (u64)header.meshlet_triangle_count * 3;
+    header.vertex_offset = align_up(sizeof(mesh_file_header), MESH_FILE_ALIGNMENT);
+    header.index_offset = align_up(header.vertex_offset + vertex_size, MESH_FILE_ALIGNMENT);
+    header.lod_offset = align_up(header.index_offset + index_size, MESH_FILE_ALIGNMENT);
+    header.meshlet_offset = align_up(header.lod_offset + lod_size, MESH_FILE_ALIGNMENT);
+    header.meshlet_vertices_offset = align_up(header.meshlet_offset + meshlet_size, MESH_FILE_ALIGNMENT);
+    header.meshlet_triangles_offset = align_up(header.meshlet_vertices_offset + meshlet_vertices_size, MESH_FILE_ALIGNMENT);
+
+    b8 success = FALSE;
+    FILE* file = fopen(output_path, "wb");
+    if (!file) {
+        KERROR("Unable to open '%s' for writing.", output_path);
+    } else {
+        u64 position = 0;
+        success = write_section(file, &header, sizeof(mesh_file_header), &position) &&
+                  write_section(file, vertices, vertex_size, &position) &&
+                  write_section(file, indices, index_size, &position) &&
+                  write_section(file, lods, lod_size, &position) &&
+                  write_section(file, meshlets.meshlets, meshlet_size, &position) &&
+                  write_section(file, meshlets.vertices, meshlet_vertices_size, &position) &&
+                  write_section(file, meshlets.triangles, meshlet_triangles_size, &position);
+        if (fclose(file) != 0) {
+            success = FALSE;
+        }
+        if (!success) {
+            KERROR("Failed to write '%s'.", output_path);
+        }
+    }
+
+    if (success) {
+        KINFO("Converted '%s': %u vertices of %u bytes, %u triangles, %u levels of detail, %u-bit indices, %u meshlets.",
+              input_path, header.vertex_count, header.vertex_stride, lods[0].index_count / 3, header.lod_count, header.index_size * 8, header.meshlet_count);
+    }
+
+    meshlet_set_destroy(&meshlets);
+    if (quantized_vertices) {
+        kfree(quantized_vertices, sizeof(mesh_vertex_quantized) * geometry.vertex_count, MEMORY_TAG_ARRAY);
+    }
+    if (short_indices) {
+        kfree(short_indices, sizeof(u16) * geometry.index_count, MEMORY_TAG_ARRAY);
+    }
+    mesh_geometry_destroy(&geometry);
+    return success;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <defines.h>
+
+typedef struct mesh_convert_options {
+    // Reorder triangles and vertices for the vertex cache, overdraw and vertex fetch.
+    b8 optimize;
+    // Build a chain of simplified levels of detail.
+    b8 lods;
+    // Write MESH_VERTEX_FORMAT_QUANTIZED vertices instead of full floats.
+    b8 quantize;
+    // Build the meshlet tables.
+    b8 meshlets;
+} mesh_convert_options;
+
+/**
+ * Converts an OBJ, glTF or GLB mesh into a .ksm mesh file.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+b8 mesh_convert(const char* input_path, const char* output_path, const mesh_convert_options* options);
@@ -0,0 +1,419 @@
+#include "mesh_optimize.h"
+
+#include <core/kmemory.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+#define NO_POSITION 0xFFFFFFFF
+
+mesh_cache_stats mesh_analyze_vertex_cache(const u32* indices, u32 index_count, u32 vertex_count, u32 cache_size) {
+    mesh_cache_stats stats = {};
+    if (index_count < 3 || vertex_count == 0) {
+        return stats;
+    }
+
+    // Each vertex remembers when it entered the cache. With a FIFO, it is
+    // still in there if fewer than cache_size misses have happened since.
+    u32* entered = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kset_memory(entered, 0xFF, sizeof(u32) * vertex_count);
+    u32 misses = 0;
+    for (u32 i = 0; i < index_count; ++i) {
+        u32 v = indices[i];
+        if (entered[v] == NO_POSITION || misses - entered[v] >= cache_size) {
+            entered[v] = misses++;
+        }
+    }
+    kfree(entered, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    stats.acmr = (f32)misses / (f32)(index_count / 3);
+    stats.atvr = (f32)misses / (f32)vertex_count;
+    return stats;
+}
+
+// Forsyth's scoring. The cache the scores model is smaller than the hardware
+// one on purpose; it is what the algorithm was tuned with.
+#define FORSYTH_CACHE_SIZE 32
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+
+static f32 forsyth_vertex_score(i32 cache_position, u32 live_triangles) {
+    if (live_triangles == 0) {
+        // Nothing left to draw with it.
+        return -1.0f;
+    }
+
+    f32 score = 0;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            // Used by the last triangle. Deliberately lower than the next few,
+            // so the strip does not keep turning back on itself.
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        } else {
+            f32 scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = powf(1.0f - (cache_position - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // Favour vertices with few triangles left, to finish them off rather than leave lone triangles behind.
+    score += FORSYTH_VALENCE_BOOST_SCALE * powf((f32)live_triangles, -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+void mesh_optimize_vertex_cache(u32* indices, u32 index_count, u32 vertex_count) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // Vertex to triangle adjacency, as offsets into one list.
+    u32* live_triangles = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* adjacency_offsets = kallocate(sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    u32* adjacency = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        live_triangles[indices[i]]++;
+    }
+    u32 offset = 0;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        adjacency_offsets[v] = offset;
+        offset += live_triangles[v];
+    }
+    adjacency_offsets[vertex_count] = offset;
+    u32* fill = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 t = 0; t < triangle_count; ++t) {
+        for (u32 c = 0; c < 3; ++c) {
+            u32 v = indices[t * 3 + c];
+            adjacency[adjacency_offsets[v] + fill[v]++] = t;
+        }
+    }
+    kfree(fill, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    i32* cache_position = kallocate(sizeof(i32) * vertex_count, MEMORY_TAG_ARRAY);
+    f32* vertex_score = kallocate(sizeof(f32) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        cache_position[v] = -1;
+        vertex_score[v] = forsyth_vertex_score(-1, live_triangles[v]);
+    }
+
+    f32* triangle_score = kallocate(sizeof(f32) * triangle_count, MEMORY_TAG_ARRAY);
+    b8* emitted = kallocate(sizeof(b8) * triangle_count, MEMORY_TAG_ARRAY);
+    for (u32 t = 0; t < triangle_count; ++t) {
+        triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+    }
+
+    u32* output = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    // Three extra slots for the vertices pushed in before the oldest fall out.
+    u32 cache[FORSYTH_CACHE_SIZE + 3];
+    u32 cache_count = 0;
+    // Where to resume a linear scan when nothing in the cache has triangles left.
+    u32 scan_cursor = 0;
+
+    u32 best = 0;
+    f32 best_score = triangle_score[0];
+    for (u32 t = 1; t < triangle_count; ++t) {
+        if (triangle_score[t] > best_score) {
+            best = t;
+            best_score = triangle_score[t];
+        }
+    }
+
+    for (u32 emitted_count = 0; emitted_count < triangle_count; ++emitted_count) {
+        if (best == NO_POSITION) {
+            // Nothing adjacent to the cache. Take the next triangle not yet drawn.
+            while (emitted[scan_cursor]) {
+                scan_cursor++;
+            }
+            best = scan_cursor;
+        }
+
+        emitted[best] = TRUE;
+        u32* tri = &indices[best * 3];
+        output[emitted_count * 3 + 0] = tri[0];
+        output[emitted_count * 3 + 1] = tri[1];
+        output[emitted_count * 3 + 2] = tri[2];
+
+        // Remove the triangle from its vertices' live lists.
+        for (u32 c = 0; c < 3; ++c) {
+            u32 v = tri[c];
+            u32* list = &adjacency[adjacency_offsets[v]];
+            for (u32 i = 0; i < live_triangles[v]; ++i) {
+                if (list[i] == best) {
+                    list[i] = list[live_triangles[v] - 1];
+                    live_triangles[v]--;
+                    break;
+                }
+            }
+        }
+
+        // Move the triangle's vertices to the front of the cache, in LRU order.
+        u32 new_cache[FORSYTH_CACHE_SIZE + 3];
+        u32 new_count = 0;
+        for (u32 c = 0; c < 3; ++c) {
+            b8 repeated = (c > 0 && tri[c] == tri[0]) || (c > 1 && tri[c] == tri[1]);
+            if (!repeated) {
+                new_cache[new_count++] = tri[c];
+            }
+        }
+        for (u32 i = 0; i < cache_count; ++i) {
+            u32 v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                new_cache[new_count++] = v;
+            }
+        }
+
+        // Rescore every vertex which is, or just was, in the cache.
+        for (u32 i = 0; i < new_count; ++i) {
+            u32 v = new_cache[i];
+            cache_position[v] = i < FORSYTH_CACHE_SIZE ? (i32)i : -1;
+            vertex_score[v] = forsyth_vertex_score(cache_position[v], live_triangles[v]);
+        }
+
+        // The next triangle is the best one touching the cache.
+        best = NO_POSITION;
+        best_score = -1.0f;
+        for (u32 i = 0; i < new_count; ++i) {
+            u32 v = new_cache[i];
+            u32* list = &adjacency[adjacency_offsets[v]];
+            for (u32 j = 0; j < live_triangles[v]; ++j) {
+                u32 t = list[j];
+                const u32* other = &indices[t * 3];
+                triangle_score[t] = vertex_score[other[0]] + vertex_score[other[1]] + vertex_score[other[2]];
+                if (triangle_score[t] > best_score) {
+                    best = t;
+                    best_score = triangle_score[t];
+                }
+            }
+        }
+
+        cache_count = new_count < FORSYTH_CACHE_SIZE ? new_count : FORSYTH_CACHE_SIZE;
+        kcopy_memory(cache, new_cache, sizeof(u32) * cache_count);
+    }
+
+    kcopy_memory(indices, output, sizeof(u32) * triangle_count * 3);
+
+    kfree(output, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(emitted, sizeof(b8) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(triangle_score, sizeof(f32) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(vertex_score, sizeof(f32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(cache_position, sizeof(i32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(adjacency, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(adjacency_offsets, sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(live_triangles, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+}
+
+typedef struct overdraw_cluster {
+    u32 first_triangle;
+    u32 triangle_count;
+    f32 sort_key;
+} overdraw_cluster;
+
+static i32 compare_clusters(const void* a, const void* b) {
+    // Descending: the most outward facing clusters draw first.
+    f32 ka = ((const overdraw_cluster*)a)->sort_key;
+    f32 kb = ((const overdraw_cluster*)b)->sort_key;
+    return ka < kb ? 1 : (ka > kb ? -1 : 0);
+}
+
+void mesh_optimize_overdraw(u32* indices, u32 index_count, const mesh_vertex* vertices, u32 vertex_count, f32 threshold) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count < 2) {
+        return;
+    }
+
+    // Clusters start wherever the cache-ordered triangles jump somewhere new,
+    // seen as a triangle whose vertices all miss the cache. Moving whole
+    // clusters around then costs little cache efficiency.
+    overdraw_cluster* clusters = kallocate(sizeof(overdraw_cluster) * triangle_count, MEMORY_TAG_ARRAY);
+    u32 cluster_count = 0;
+    u32* entered = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kset_memory(entered, 0xFF, sizeof(u32) * vertex_count);
+    u32 misses = 0;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        u32 triangle_misses = 0;
+        for (u32 c = 0; c < 3; ++c) {
+            u32 v = indices[t * 3 + c];
+            if (entered[v] == NO_POSITION || misses - entered[v] >= MESH_OPTIMIZE_CACHE_SIZE) {
+                entered[v] = misses++;
+                triangle_misses++;
+            }
+        }
+        if (t == 0 || triangle_misses == 3) {
+            clusters[cluster_count].first_triangle = t;
+            clusters[cluster_count].triangle_count = 0;
+            cluster_count++;
+        }
+        clusters[cluster_count - 1].triangle_count++;
+    }
+    kfree(entered, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    if (cluster_count < 2) {
+        kfree(clusters, sizeof(overdraw_cluster) * triangle_count, MEMORY_TAG_ARRAY);
+        return;
+    }
+
+    // The mesh centroid, weighted by area.
+    f32 mesh_center[3] = {0, 0, 0};
+    f32 mesh_area = 0;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        const f32* p0 = vertices[indices[t * 3 + 0]].position;
+        const f32* p1 = vertices[indices[t * 3 + 1]].position;
+        const f32* p2 = vertices[indices[t * 3 + 2]].position;
+        f32 e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        f32 e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        f32 n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        f32 area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (u32 axis = 0; axis < 3; ++axis) {
+            mesh_center[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+        }
+        mesh_area += area;
+    }
+    if (mesh_area > 0) {
+        for (u32 axis = 0; axis < 3; ++axis) {
+            mesh_center[axis] /= mesh_area;
+        }
+    }
+
+    // How far each cluster faces out from the centre: the dot product of its
+    // average normal with the direction from the mesh centroid to its own.
+    for (u32 i = 0; i < cluster_count; ++i) {
+        overdraw_cluster* cluster = &clusters[i];
+        f32 center[3] = {0, 0, 0};
+        f32 normal[3] = {0, 0, 0};
+        f32 area_sum = 0;
+        for (u32 t = cluster->first_triangle; t < cluster->first_triangle + cluster->triangle_count; ++t) {
+            const f32* p0 = vertices[indices[t * 3 + 0]].position;
+            const f32* p1 = vertices[indices[t * 3 + 1]].position;
+            const f32* p2 = vertices[indices[t * 3 + 2]].position;
+            f32 e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            f32 e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            f32 n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            f32 area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (u32 axis = 0; axis < 3; ++axis) {
+                center[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+                normal[axis] += n[axis];
+            }
+            area_sum += area;
+        }
+        f32 key = 0;
+        f32 normal_length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area_sum > 0 && normal_length > 0) {
+            for (u32 axis = 0; axis < 3; ++axis) {
+                key += (center[axis] / area_sum - mesh_center[axis]) * (normal[axis] / normal_length);
+            }
+        }
+        cluster->sort_key = key;
+    }
+
+    qsort(clusters, cluster_count, sizeof(overdraw_cluster), compare_clusters);
+
+    u32* output = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    u32 written = 0;
+    for (u32 i = 0; i < cluster_count; ++i) {
+        kcopy_memory(&output[written], &indices[clusters[i].first_triangle * 3], sizeof(u32) * clusters[i].triangle_count * 3);
+        written += clusters[i].triangle_count * 3;
+    }
+
+    // Only keep the new order if it stays within the allowed cache cost.
+    mesh_cache_stats before = mesh_analyze_vertex_cache(indices, triangle_count * 3, vertex_count, MESH_OPTIMIZE_CACHE_SIZE);
+    mesh_cache_stats after = mesh_analyze_vertex_cache(output, triangle_count * 3, vertex_count, MESH_OPTIMIZE_CACHE_SIZE);
+    if (after.acmr <= before.acmr * threshold) {
+        kcopy_memory(indices, output, sizeof(u32) * triangle_count * 3);
+    }
+
+    kfree(output, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(clusters, sizeof(overdraw_cluster) * triangle_count, MEMORY_TAG_ARRAY);
+}
+
+void mesh_optimize_vertex_fetch(mesh_geometry* geometry) {
+    u32 vertex_count = geometry->vertex_count;
+    u32* remap = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kset_memory(remap, 0xFF, sizeof(u32) * vertex_count);
+
+    mesh_vertex* vertices = kallocate(sizeof(mesh_vertex) * vertex_count, MEMORY_TAG_MESH);
+    u32 next = 0;
+    for (u32 i = 0; i < geometry->index_count; ++i) {
+        u32 v = geometry->indices[i];
+        if (remap[v] == NO_POSITION) {
+            remap[v] = next;
+            vertices[next++] = geometry->vertices[v];
+        }
+        geometry->indices[i] = remap[v];
+    }
+
+    // Unused vertices fall off the end.
+    kfree(geometry->vertices, sizeof(mesh_vertex) * vertex_count, MEMORY_TAG_MESH);
+    if (next < vertex_count) {
+        mesh_vertex* trimmed = kallocate(sizeof(mesh_vertex) * next, MEMORY_TAG_MESH);
+        kcopy_memory(trimmed, vertices, sizeof(mesh_vertex) * next);
+        kfree(vertices, sizeof(mesh_vertex) * vertex_count, MEMORY_TAG_MESH);
+        vertices = trimmed;
+    }
+    geometry->vertices = vertices;
+    geometry->vertex_count = next;
+
+    kfree(remap, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+}
+
+static i16 quantize_snorm16(f32 value) {
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (i16)lroundf(value * 32767.0f);
+}
+
+static u16 quantize_half(f32 value) {
+    union {
+        f32 f;
+        u32 u;
+    } bits;
+    bits.f = value;
+
+    u32 sign = (bits.u >> 16) & 0x8000;
+    i32 exponent = (i32)((bits.u >> 23) & 0xFF) - 127 + 15;
+    u32 mantissa = bits.u & 0x7FFFFF;
+
+    if (((bits.u >> 23) & 0xFF) == 0xFF) {
+        // Infinity, or NaN kept as a NaN.
+        return (u16)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 31) {
+        // Too large, clamp to the largest finite half.
+        return (u16)(sign | 0x7BFF);
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return (u16)sign;
+        }
+        // Denormal half. Round to nearest.
+        mantissa |= 0x800000;
+        u32 shift = (u32)(14 - exponent);
+        u32 half_mantissa = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) {
+            half_mantissa++;
+        }
+        return (u16)(sign | half_mantissa);
+    }
+
+    // Round to nearest. A carry out of the mantissa correctly bumps the exponent.
+    u32 half = sign | ((u32)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) {
+        half++;
+    }
+    return (u16)(half > (sign | 0x7BFF) ? (sign | 0x7BFF) : half);
+}
+
+void mesh_quantize_vertices(const mesh_vertex* vertices, u32 vertex_count, mesh_vertex_quantized* out_vertices) {
+    for (u32 i = 0; i < vertex_count; ++i) {
+        const mesh_vertex* in = &vertices[i];
+        mesh_vertex_quantized* out = &out_vertices[i];
+        out->position[0] = in->position[0];
+        out->position[1] = in->position[1];
+        out->position[2] = in->position[2];
+        out->normal[0] = quantize_snorm16(in->normal[0]);
+        out->normal[1] = quantize_snorm16(in->normal[1]);
+        out->normal[2] = quantize_snorm16(in->normal[2]);
+        out->normal[3] = 0;
+        out->texcoord[0] = quantize_half(in->texcoord[0]);
+        out->texcoord[1] = quantize_half(in->texcoord[1]);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <resources/mesh_import.h>
+
+// The FIFO cache size statistics are measured with. Roughly what current
+// GPUs behave like, for an index buffer ordered for a cache of this size.
+#define MESH_OPTIMIZE_CACHE_SIZE 32
+
+typedef struct mesh_cache_stats {
+    // Average cache miss ratio: vertices transformed per triangle. 0.5 is the
+    // best possible for a large regular grid, 3 the worst.
+    f32 acmr;
+    // Average transform to vertex ratio: vertices transformed per vertex. 1 is ideal.
+    f32 atvr;
+} mesh_cache_stats;
+
+/**
+ * Simulates a FIFO post-transform cache of the given size over an index buffer.
+ */
+mesh_cache_stats mesh_analyze_vertex_cache(const u32* indices, u32 index_count, u32 vertex_count, u32 cache_size);
+
+/**
+ * Reorders triangles for the post-transform vertex cache, using Tom
+ * Forsyth's linear-speed vertex cache optimization.
+ */
+void mesh_optimize_vertex_cache(u32* indices, u32 index_count, u32 vertex_count);
+
+/**
+ * Reorders clusters of triangles so that outward facing ones draw first,
+ * to cut overdraw, without losing more than the given factor of vertex cache
+ * efficiency (1.05 allows the ACMR to grow by 5%). Run after
+ * mesh_optimize_vertex_cache, whose ordering it splits into clusters.
+ */
+void mesh_optimize_overdraw(u32* indices, u32 index_count, const mesh_vertex* vertices, u32 vertex_count, f32 threshold);
+
+/**
+ * Reorders vertices into the order the index buffer first uses them, for
+ * vertex fetch locality, and drops unused vertices. Run last, since it
+ * depends on the final triangle order.
+ */
+void mesh_optimize_vertex_fetch(mesh_geometry* geometry);
+
+/**
+ * Converts vertices to MESH_VERTEX_FORMAT_QUANTIZED.
+ */
+void mesh_quantize_vertices(const mesh_vertex* vertices, u32 vertex_count, mesh_vertex_quantized* out_vertices);
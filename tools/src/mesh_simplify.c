@@ -0,0 +1,280 @@
+#include "mesh_simplify.h"
+
+#include <core/kmemory.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+// A symmetric 4x4 matrix: the weighted sum of squared distances to a set of
+// planes. Each plane is weighted by its triangle's area.
+typedef struct quadric {
+    f64 a00, a01, a02, a11, a12, a22;
+    f64 b0, b1, b2;
+    f64 c;
+    f64 weight;
+} quadric;
+
+typedef struct collapse {
+    u32 from;
+    u32 to;
+    f64 cost;
+} collapse;
+
+static void quadric_add_plane(quadric* q, f64 a, f64 b, f64 c, f64 d, f64 weight) {
+    q->a00 += weight * a * a;
+    q->a01 += weight * a * b;
+    q->a02 += weight * a * c;
+    q->a11 += weight * b * b;
+    q->a12 += weight * b * c;
+    q->a22 += weight * c * c;
+    q->b0 += weight * a * d;
+    q->b1 += weight * b * d;
+    q->b2 += weight * c * d;
+    q->c += weight * d * d;
+    q->weight += weight;
+}
+
+static void quadric_add(quadric* q, const quadric* other) {
+    q->a00 += other->a00;
+    q->a01 += other->a01;
+    q->a02 += other->a02;
+    q->a11 += other->a11;
+    q->a12 += other->a12;
+    q->a22 += other->a22;
+    q->b0 += other->b0;
+    q->b1 += other->b1;
+    q->b2 += other->b2;
+    q->c += other->c;
+    q->weight += other->weight;
+}
+
+// The weighted mean squared distance from a point to the quadric's planes.
+static f64 quadric_error(const quadric* q, const f32* p) {
+    if (q->weight <= 0) {
+        return 0;
+    }
+    f64 x = p[0], y = p[1], z = p[2];
+    f64 e = q->a00 * x * x + q->a11 * y * y + q->a22 * z * z +
+            2 * (q->a01 * x * y + q->a02 * x * z + q->a12 * y * z) +
+            2 * (q->b0 * x + q->b1 * y + q->b2 * z) + q->c;
+    // Rounding can take it slightly below zero.
+    return e > 0 ? e / q->weight : 0;
+}
+
+static void triangle_normal(const f32* p0, const f32* p1, const f32* p2, f64* out_normal) {
+    f64 e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    f64 e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    out_normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    out_normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    out_normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static i32 compare_u64(const void* a, const void* b) {
+    u64 ka = *(const u64*)a;
+    u64 kb = *(const u64*)b;
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+static i32 compare_collapses(const void* a, const void* b) {
+    f64 ka = ((const collapse*)a)->cost;
+    f64 kb = ((const collapse*)b)->cost;
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+static u64 edge_key(u32 a, u32 b) {
+    return a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
+}
+
+// Would moving `from` onto `to` flip or collapse any triangle around `from` which stays?
+static b8 collapse_flips(const mesh_geometry* geometry, const u32* indices, const u32* adjacency_offsets, const u32* adjacency, u32 from, u32 to) {
+    const f32* target = geometry->vertices[to].position;
+    for (u32 i = adjacency_offsets[from]; i < adjacency_offsets[from + 1]; ++i) {
+        const u32* tri = &indices[adjacency[i] * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) {
+            // Removed by the collapse.
+            continue;
+        }
+
+        const f32* before[3];
+        const f32* after[3];
+        for (u32 c = 0; c < 3; ++c) {
+            before[c] = geometry->vertices[tri[c]].position;
+            after[c] = tri[c] == from ? target : before[c];
+        }
+        f64 n0[3], n1[3];
+        triangle_normal(before[0], before[1], before[2], n0);
+        triangle_normal(after[0], after[1], after[2], n1);
+        if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+u32 mesh_simplify(const mesh_geometry* geometry, u32 target_index_count, u32* out_indices, f32* out_error) {
+    u32 vertex_count = geometry->vertex_count;
+    u32 full_index_count = geometry->index_count - geometry->index_count % 3;
+    u32 index_count = full_index_count;
+    kcopy_memory(out_indices, geometry->indices, sizeof(u32) * index_count);
+    *out_error = 0;
+    if (index_count <= target_index_count) {
+        return index_count;
+    }
+
+    // Each vertex's quadric holds the planes of the triangles around it in the full mesh.
+    quadric* quadrics = kallocate(sizeof(quadric) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < index_count; i += 3) {
+        const u32* tri = &geometry->indices[i];
+        const f32* p0 = geometry->vertices[tri[0]].position;
+        f64 n[3];
+        triangle_normal(p0, geometry->vertices[tri[1]].position, geometry->vertices[tri[2]].position, n);
+        f64 length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0) {
+            continue;
+        }
+        n[0] /= length;
+        n[1] /= length;
+        n[2] /= length;
+        f64 d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        for (u32 c = 0; c < 3; ++c) {
+            quadric_add_plane(&quadrics[tri[c]], n[0], n[1], n[2], d, length * 0.5);
+        }
+    }
+
+    // Vertices on an edge with only one triangle are locked. Attribute seams
+    // split vertices, so their edges are borders by index too.
+    u64* edges = kallocate(sizeof(u64) * full_index_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < index_count; i += 3) {
+        for (u32 c = 0; c < 3; ++c) {
+            edges[i + c] = edge_key(geometry->indices[i + c], geometry->indices[i + (c + 1) % 3]);
+        }
+    }
+    qsort(edges, index_count, sizeof(u64), compare_u64);
+    b8* locked = kallocate(sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < index_count;) {
+        u32 run = 1;
+        while (i + run < index_count && edges[i + run] == edges[i]) {
+            run++;
+        }
+        if (run == 1) {
+            locked[edges[i] >> 32] = TRUE;
+            locked[edges[i] & 0xFFFFFFFF] = TRUE;
+        }
+        i += run;
+    }
+    kfree(edges, sizeof(u64) * full_index_count, MEMORY_TAG_ARRAY);
+
+    u32* remap = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    b8* touched = kallocate(sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* adjacency_offsets = kallocate(sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    u32* adjacency = kallocate(sizeof(u32) * full_index_count, MEMORY_TAG_ARRAY);
+    collapse* collapses = kallocate(sizeof(collapse) * full_index_count, MEMORY_TAG_ARRAY);
+    f64 max_cost = 0;
+
+    // Each pass collapses the cheapest edges which do not share a vertex, then rebuilds.
+    while (index_count > target_index_count) {
+        // Vertex to triangle adjacency, for the flip test.
+        kzero_memory(adjacency_offsets, sizeof(u32) * (vertex_count + 1));
+        for (u32 i = 0; i < index_count; ++i) {
+            adjacency_offsets[out_indices[i] + 1]++;
+        }
+        for (u32 v = 0; v < vertex_count; ++v) {
+            adjacency_offsets[v + 1] += adjacency_offsets[v];
+        }
+        u32* fill = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+        for (u32 i = 0; i < index_count; ++i) {
+            u32 v = out_indices[i];
+            adjacency[adjacency_offsets[v] + fill[v]++] = i / 3;
+        }
+        kfree(fill, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+        // Every edge, in whichever direction is cheaper and allowed.
+        u32 collapse_count = 0;
+        for (u32 i = 0; i < index_count; i += 3) {
+            for (u32 c = 0; c < 3; ++c) {
+                u32 a = out_indices[i + c];
+                u32 b = out_indices[i + (c + 1) % 3];
+                if (a == b) {
+                    continue;
+                }
+                quadric q = quadrics[a];
+                quadric_add(&q, &quadrics[b]);
+                f64 cost_ab = locked[a] ? INFINITY : quadric_error(&q, geometry->vertices[b].position);
+                f64 cost_ba = locked[b] ? INFINITY : quadric_error(&q, geometry->vertices[a].position);
+                if (cost_ab == INFINITY && cost_ba == INFINITY) {
+                    continue;
+                }
+                collapse* out = &collapses[collapse_count++];
+                out->from = cost_ab <= cost_ba ? a : b;
+                out->to = cost_ab <= cost_ba ? b : a;
+                out->cost = cost_ab <= cost_ba ? cost_ab : cost_ba;
+            }
+        }
+        if (collapse_count == 0) {
+            break;
+        }
+        qsort(collapses, collapse_count, sizeof(collapse), compare_collapses);
+
+        // Each collapse removes about two triangles. Take only as many as are
+        // needed, so the pass does not overshoot the target by much.
+        u32 wanted = (index_count - target_index_count) / 6 + 1;
+        u32 applied = 0;
+        for (u32 v = 0; v < vertex_count; ++v) {
+            remap[v] = v;
+        }
+        kzero_memory(touched, sizeof(b8) * vertex_count);
+        for (u32 i = 0; i < collapse_count && applied < wanted; ++i) {
+            collapse* candidate = &collapses[i];
+            if (touched[candidate->from] || touched[candidate->to]) {
+                continue;
+            }
+            if (collapse_flips(geometry, out_indices, adjacency_offsets, adjacency, candidate->from, candidate->to)) {
+                continue;
+            }
+
+            // Neighbours of both ends are left alone until the next pass, since their triangles change.
+            for (u32 j = adjacency_offsets[candidate->from]; j < adjacency_offsets[candidate->from + 1]; ++j) {
+                const u32* tri = &out_indices[adjacency[j] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = TRUE;
+            }
+            for (u32 j = adjacency_offsets[candidate->to]; j < adjacency_offsets[candidate->to + 1]; ++j) {
+                const u32* tri = &out_indices[adjacency[j] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = TRUE;
+            }
+
+            remap[candidate->from] = candidate->to;
+            quadric_add(&quadrics[candidate->to], &quadrics[candidate->from]);
+            max_cost = candidate->cost > max_cost ? candidate->cost : max_cost;
+            applied++;
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        // Apply the collapses, dropping triangles which became degenerate.
+        u32 written = 0;
+        for (u32 i = 0; i < index_count; i += 3) {
+            u32 a = remap[out_indices[i]];
+            u32 b = remap[out_indices[i + 1]];
+            u32 c = remap[out_indices[i + 2]];
+            if (a != b && b != c && c != a) {
+                out_indices[written++] = a;
+                out_indices[written++] = b;
+                out_indices[written++] = c;
+            }
+        }
+        index_count = written;
+    }
+
+    kfree(collapses, sizeof(collapse) * full_index_count, MEMORY_TAG_ARRAY);
+    kfree(adjacency, sizeof(u32) * full_index_count, MEMORY_TAG_ARRAY);
+    kfree(adjacency_offsets, sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(touched, sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(remap, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(locked, sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(quadrics, sizeof(quadric) * vertex_count, MEMORY_TAG_ARRAY);
+
+    // The root of the mean squared distance is a distance.
+    *out_error = (f32)sqrt(max_cost);
+    return index_count;
+}
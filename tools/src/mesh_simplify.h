@@ -0,0 +1,17 @@
+#pragma once
+
+#include <resources/mesh_import.h>
+
+/**
+ * Simplifies a triangle list by quadric error edge collapse (Garland and
+ * Heckbert), collapsing vertices onto their neighbours so no new vertices
+ * are made and the vertex data can be shared with the full mesh. Vertices
+ * on borders and attribute seams are never moved, so the mesh keeps its
+ * outline and texture mapping.
+ * @param geometry The vertices, and the full mesh's indices, which quadrics are built from.
+ * @param target_index_count Stop once the result has this many indices or fewer.
+ * @param out_indices A buffer of at least geometry->index_count indices to hold the result.
+ * @param out_error A pointer to hold the object-space error of the result, as a distance.
+ * @returns The number of indices written to out_indices.
+ */
+u32 mesh_simplify(const mesh_geometry* geometry, u32 target_index_count, u32* out_indices, f32* out_error);
@@ -0,0 +1,95 @@
+#include "meshlets.h"
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+
+#include <math.h>
+
+#define MESHLET_NO_LOCAL 0xFF
+
+static void compute_bounds(const mesh_geometry* geometry, const meshlet_set* set, mesh_meshlet* meshlet) {
+    // Centre of the AABB, then the furthest vertex from it. Not minimal, but tight enough for culling.
+    f32 min[3] = {INFINITY, INFINITY, INFINITY};
+    f32 max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (u32 i = 0; i < meshlet->vertex_count; ++i) {
+        const f32* p = geometry->vertices[set->vertices[meshlet->vertex_offset + i]].position;
+        for (u32 c = 0; c < 3; ++c) {
+            min[c] = p[c] < min[c] ? p[c] : min[c];
+            max[c] = p[c] > max[c] ? p[c] : max[c];
+        }
+    }
+
+    f32 radius_sq = 0;
+    for (u32 c = 0; c < 3; ++c) {
+        meshlet->center[c] = (min[c] + max[c]) * 0.5f;
+    }
+    for (u32 i = 0; i < meshlet->vertex_count; ++i) {
+        const f32* p = geometry->vertices[set->vertices[meshlet->vertex_offset + i]].position;
+        f32 dx = p[0] - meshlet->center[0];
+        f32 dy = p[1] - meshlet->center[1];
+        f32 dz = p[2] - meshlet->center[2];
+        f32 d = dx * dx + dy * dy + dz * dz;
+        radius_sq = d > radius_sq ? d : radius_sq;
+    }
+    meshlet->radius = sqrtf(radius_sq);
+}
+
+void meshlets_build(const mesh_geometry* geometry, u32 max_vertices, u32 max_triangles, meshlet_set* out_set) {
+    out_set->meshlets = darray_create(mesh_meshlet);
+    out_set->vertices = darray_create(u32);
+    out_set->triangles = darray_create(u8);
+
+    // Where each vertex sits in the current meshlet, if it is in it.
+    u8* local = kallocate(geometry->vertex_count, MEMORY_TAG_ARRAY);
+    kset_memory(local, MESHLET_NO_LOCAL, geometry->vertex_count);
+
+    mesh_meshlet current;
+    kzero_memory(&current, sizeof(mesh_meshlet));
+
+    for (u32 i = 0; i + 2 < geometry->index_count; i += 3) {
+        const u32* tri = &geometry->indices[i];
+        u32 new_vertices = 0;
+        for (u32 c = 0; c < 3; ++c) {
+            // A degenerate triangle can name one vertex twice, which counts once.
+            b8 repeated = (c > 0 && tri[c] == tri[0]) || (c > 1 && tri[c] == tri[1]);
+            new_vertices += (local[tri[c]] == MESHLET_NO_LOCAL && !repeated) ? 1 : 0;
+        }
+
+        if (current.vertex_count + new_vertices > max_vertices || current.triangle_count + 1 > max_triangles) {
+            // Close the current meshlet.
+            compute_bounds(geometry, out_set, &current);
+            darray_push(out_set->meshlets, current);
+            for (u32 v = 0; v < current.vertex_count; ++v) {
+                local[out_set->vertices[current.vertex_offset + v]] = MESHLET_NO_LOCAL;
+            }
+            kzero_memory(&current, sizeof(mesh_meshlet));
+            current.vertex_offset = (u32)darray_length(out_set->vertices);
+            current.triangle_offset = (u32)darray_length(out_set->triangles) / 3;
+        }
+
+        for (u32 c = 0; c < 3; ++c) {
+            if (local[tri[c]] == MESHLET_NO_LOCAL) {
+                local[tri[c]] = (u8)current.vertex_count++;
+                darray_push(out_set->vertices, tri[c]);
+            }
+            darray_push(out_set->triangles, local[tri[c]]);
+        }
+        current.triangle_count++;
+    }
+
+    if (current.triangle_count > 0) {
+        compute_bounds(geometry, out_set, &current);
+        darray_push(out_set->meshlets, current);
+    }
+
+    kfree(local, geometry->vertex_count, MEMORY_TAG_ARRAY);
+}
+
+void meshlet_set_destroy(meshlet_set* set) {
+    if (set->meshlets) {
+        darray_destroy(set->meshlets);
+        darray_destroy(set->vertices);
+        darray_destroy(set->triangles);
+    }
+    kzero_memory(set, sizeof(meshlet_set));
+}
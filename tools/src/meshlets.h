@@ -0,0 +1,21 @@
+#pragma once
+
+#include <resources/mesh_import.h>
+
+typedef struct meshlet_set {
+    // darrays.
+    mesh_meshlet* meshlets;
+    u32* vertices;
+    // 3 local vertex indices per triangle.
+    u8* triangles;
+} meshlet_set;
+
+/**
+ * Splits a triangle list into meshlets of at most max_vertices vertices and
+ * max_triangles triangles, walking the triangles in index order. Works best
+ * on index buffers already ordered for vertex cache locality.
+ * @param out_set A pointer to hold the meshlets. Free with meshlet_set_destroy.
+ */
+void meshlets_build(const mesh_geometry* geometry, u32 max_vertices, u32 max_triangles, meshlet_set* out_set);
+
+void meshlet_set_destroy(meshlet_set* set);
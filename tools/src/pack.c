@@ -0,0 +1,320 @@
+#include "pack.h"
+#include "file_utils.h"
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <resources/archive.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if KPLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#if KOHI_USE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#if KOHI_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#if KPLATFORM_WINDOWS
+#define file_seek _fseeki64
+#else
+#define file_seek fseeko
+#endif
+
+// An entry is only stored compressed if that saves at least this fraction of it.
+#define PACK_MIN_COMPRESSION_SAVING 0.1
+
+#define PACK_MAX_PATH 512
+
+typedef struct pack_file {
+    // Path relative to the input directory, with forward slashes. This is what the archive stores.
+    char* path;
+    archive_entry entry;
+} pack_file;
+
+static void add_file(pack_file** files, const char* relative_path) {
+    pack_file file;
+    kzero_memory(&file, sizeof(pack_file));
+    file.path = string_duplicate(relative_path);
+    file.entry.path_hash = archive_path_hash(relative_path);
+    darray_push(*files, file);
+}
+
+// Collects every regular file below dir. relative is the part of the path to store.
+static b8 collect_files(const char* dir, const char* relative, pack_file** files) {
+#if KPLATFORM_WINDOWS
+    char pattern[PACK_MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s/*", dir);
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA(pattern, &find_data);
+    if (find == INVALID_HANDLE_VALUE) {
+        KERROR("Unable to read directory '%s'.", dir);
+        return FALSE;
+    }
+    do {
+        const char* name = find_data.cFileName;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+        char full[PACK_MAX_PATH];
+        char rel[PACK_MAX_PATH];
+        snprintf(full, sizeof(full), "%s/%s", dir, name);
+        snprintf(rel, sizeof(rel), relative[0] ? "%s/%s" : "%s%s", relative, name);
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            if (!collect_files(full, rel, files)) {
+                FindClose(find);
+                return FALSE;
+            }
+        } else {
+            add_file(files, rel);
+        }
+    } while (FindNextFileA(find, &find_data));
+    FindClose(find);
+#else
+    DIR* handle = opendir(dir);
+    if (!handle) {
+        KERROR("Unable to read directory '%s'.", dir);
+        return FALSE;
+    }
+    struct dirent* dir_entry;
+    while ((dir_entry = readdir(handle)) != 0) {
+        const char* name = dir_entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+        char full[PACK_MAX_PATH];
+        char rel[PACK_MAX_PATH];
+        snprintf(full, sizeof(full), "%s/%s", dir, name);
+        snprintf(rel, sizeof(rel), relative[0] ? "%s/%s" : "%s%s", relative, name);
+        struct stat file_stat;
+        if (stat(full, &file_stat) != 0) {
+            continue;
+        }
+        if (S_ISDIR(file_stat.st_mode)) {
+            if (!collect_files(full, rel, files)) {
+                closedir(handle);
+                return FALSE;
+            }
+        } else if (S_ISREG(file_stat.st_mode)) {
+            add_file(files, rel);
+        }
+    }
+    closedir(handle);
+#endif
+    return TRUE;
+}
+
+static i32 compare_by_hash(const void* a, const void* b) {
+    u64 hash_a = ((const pack_file*)a)->entry.path_hash;
+    u64 hash_b = ((const pack_file*)b)->entry.path_hash;
+    return hash_a < hash_b ? -1 : (hash_a > hash_b ? 1 : 0);
+}
+
+static u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Compresses data if that is worthwhile. Returns the compressed copy, or 0 to store data as-is.
+static u8* try_compress(u32 compression, const u8* data, u64 size, u64* out_stored_size, u64* out_capacity) {
+    u64 limit = (u64)(size * (1.0 - PACK_MIN_COMPRESSION_SAVING));
+    u8* compressed = 0;
+    u64 compressed_size = 0;
+    *out_capacity = 0;
+
+    switch (compression) {
+#if KOHI_USE_LZ4
+        case ARCHIVE_COMPRESSION_LZ4: {
+            if (size > LZ4_MAX_INPUT_SIZE) {
+                return 0;
+            }
+            *out_capacity = LZ4_compressBound((i32)size);
+            compressed = kallocate(*out_capacity, MEMORY_TAG_ARRAY);
+            compressed_size = LZ4_compress_HC((const char*)data, (char*)compressed, (i32)size, (i32)*out_capacity, LZ4HC_CLEVEL_DEFAULT);
+        } break;
+#endif
+#if KOHI_USE_ZSTD
+        case ARCHIVE_COMPRESSION_ZSTD: {
+            *out_capacity = ZSTD_compressBound(size);
+            compressed = kallocate(*out_capacity, MEMORY_TAG_ARRAY);
+            size_t result = ZSTD_compress(compressed, *out_capacity, data, size, 19);
+            compressed_size = ZSTD_isError(result) ? 0 : result;
+        } break;
+#endif
+        default:
+            return 0;
+    }
+
+    if (compressed_size == 0 || compressed_size > limit) {
+        kfree(compressed, *out_capacity, MEMORY_TAG_ARRAY);
+        return 0;
+    }
+    *out_stored_size = compressed_size;
+    return compressed;
+}
+
+b8 pack_directory(const char* input_dir, const char* output_path, u32 alignment, u32 compression) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        KERROR("Alignment must be a power of two, got %u.", alignment);
+        return FALSE;
+    }
+
+    pack_file* files = darray_create(pack_file);
+    b8 success = FALSE;
+    FILE* out = 0;
+
+    if (!collect_files(input_dir, "", &files)) {
+        goto cleanup;
+    }
+
+    u32 entry_count = (u32)darray_length(files);
+    qsort(files, entry_count, sizeof(pack_file), compare_by_hash);
+    for (u32 i = 1; i < entry_count; ++i) {
+        if (files[i].entry.path_hash == files[i - 1].entry.path_hash) {
+            KERROR("'%s' and '%s' have the same path hash. Rename one of them.", files[i - 1].path, files[i].path);
+            goto cleanup;
+        }
+    }
+
+    // At least one bucket per entry keeps the buckets short.
+    u32 bucket_count = 1;
+    u32 bucket_bits = 0;
+    while (bucket_count < entry_count) {
+        bucket_count <<= 1;
+        bucket_bits++;
+    }
+    u32* buckets = kallocate(sizeof(u32) * (bucket_count + 1), MEMORY_TAG_ARRAY);
+    u32 entry_index = 0;
+    for (u32 b = 0; b < bucket_count; ++b) {
+        while (entry_index < entry_count && bucket_bits > 0 && (files[entry_index].entry.path_hash >> (64 - bucket_bits)) < b) {
+            entry_index++;
+        }
+        buckets[b] = entry_index;
+    }
+    buckets[bucket_count] = entry_count;
+
+    // Everything but the blobs has a known size, so the blobs can be written as they are read.
+    archive_header header;
+    kzero_memory(&header, sizeof(archive_header));
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.entry_count = entry_count;
+    header.bucket_count = bucket_count;
+    header.alignment = alignment;
+    header.entries_offset = sizeof(archive_header);
+    header.buckets_offset = header.entries_offset + sizeof(archive_entry) * entry_count;
+    header.names_offset = header.buckets_offset + sizeof(u32) * (bucket_count + 1);
+    u64 names_size = 0;
+    for (u32 i = 0; i < entry_count; ++i) {
+        files[i].entry.name_offset = (u32)names_size;
+        names_size += string_length(files[i].path) + 1;
+    }
+    header.data_offset = align_up(header.names_offset + names_size, alignment);
+
+    out = fopen(output_path, "wb");
+    if (!out) {
+        KERROR("Unable to create '%s'.", output_path);
+        kfree(buckets, sizeof(u32) * (bucket_count + 1), MEMORY_TAG_ARRAY);
+        goto cleanup;
+    }
+
+    static const u8 zeros[4096] = {0};
+    u64 offset = header.data_offset;
+    u64 total_size = 0;
+    u64 total_stored = 0;
+    file_seek(out, offset, SEEK_SET);
+    for (u32 i = 0; i < entry_count; ++i) {
+        char full_path[PACK_MAX_PATH];
+        snprintf(full_path, sizeof(full_path), "%s/%s", input_dir, files[i].path);
+
+        u8* data = 0;
+        u64 size = 0;
+        if (!file_read_all(full_path, &data, &size)) {
+            kfree(buckets, sizeof(u32) * (bucket_count + 1), MEMORY_TAG_ARRAY);
+            goto cleanup;
+        }
+
+        u64 stored_size = size;
+        u64 compressed_capacity = 0;
+        u8* compressed = try_compress(compression, data, size, &stored_size, &compressed_capacity);
+
+        archive_entry* entry = &files[i].entry;
+        entry->offset = offset;
+        entry->size = size;
+        entry->stored_size = stored_size;
+        entry->compression = compressed ? compression : ARCHIVE_COMPRESSION_NONE;
+
+        fwrite(compressed ? compressed : data, 1, stored_size, out);
+        u64 padding = align_up(offset + stored_size, alignment) - (offset + stored_size);
+        while (padding > 0) {
+            u64 chunk = padding < sizeof(zeros) ? padding : sizeof(zeros);
+            fwrite(zeros, 1, chunk, out);
+            padding -= chunk;
+        }
+        offset = align_up(offset + stored_size, alignment);
+        total_size += size;
+        total_stored += stored_size;
+
+        if (compressed) {
+            kfree(compressed, compressed_capacity, MEMORY_TAG_ARRAY);
+        }
+        file_free(data, size);
+    }
+
+    // Now the offsets are known, write everything in front of the blobs.
+    file_seek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(archive_header), 1, out);
+    for (u32 i = 0; i < entry_count; ++i) {
+        fwrite(&files[i].entry, sizeof(archive_entry), 1, out);
+    }
+    fwrite(buckets, sizeof(u32), bucket_count + 1, out);
+    for (u32 i = 0; i < entry_count; ++i) {
+        fwrite(files[i].path, 1, string_length(files[i].path) + 1, out);
+    }
+    kfree(buckets, sizeof(u32) * (bucket_count + 1), MEMORY_TAG_ARRAY);
+
+    success = ferror(out) == 0;
+    if (success) {
+        KINFO("Packed %u files (%llu bytes, %llu stored) into '%s'.", entry_count, total_size, total_stored, output_path);
+    } else {
+        KERROR("Failed writing '%s'.", output_path);
+    }
+
+cleanup:
+    if (out) {
+        fclose(out);
+    }
+    u64 count = darray_length(files);
+    for (u64 i = 0; i < count; ++i) {
+        kfree(files[i].path, string_length(files[i].path) + 1, MEMORY_TAG_STRING);
+    }
+    darray_destroy(files);
+    return success;
+}
+
+b8 pack_list(const char* archive_path) {
+    archive a;
+    if (!archive_open(archive_path, &a)) {
+        return FALSE;
+    }
+
+    static const char* compression_names[] = {"none", "lz4", "zstd"};
+    for (u32 i = 0; i < a.header->entry_count; ++i) {
+        const archive_entry* entry = &a.entries[i];
+        const char* compression = entry->compression <= ARCHIVE_COMPRESSION_ZSTD ? compression_names[entry->compression] : "?";
+        printf("%016llx %10llu %10llu %-5s %s\n", entry->path_hash, entry->size, entry->stored_size, compression, archive_entry_path(&a, entry));
+    }
+
+    archive_close(&a);
+    return TRUE;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <defines.h>
+
+/**
+ * Packs every file under input_dir into an archive at output_path. See
+ * resources/archive.h for the format.
+ * @param alignment The alignment of each blob in bytes. Must be a power of two.
+ * @param compression One of archive_compression, tried per entry. Entries it does not shrink are stored as-is.
+ * @returns TRUE on success; otherwise FALSE.
+ */
+b8 pack_directory(const char* input_dir, const char* output_path, u32 alignment, u32 compression);
+
+// Prints the contents of an archive.
+b8 pack_list(const char* archive_path);